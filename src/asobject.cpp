@@ -192,15 +192,9 @@ int variables_map::getNextEnumerable(unsigned int start) const
 	if(start>=Variables.size())
 		return -1;
 
-	const_var_iterator it=Variables.begin();
-
-	unsigned int i=0;
-	while (i < start)
-	{
-		++i;
-		++it;
-	}
+	const_var_iterator it=Variables.nth(start);
 
+	unsigned int i=start;
 	while(it->second.kind!=DYNAMIC_TRAIT || !it->second.isenumerable)
 	{
 		++i;
@@ -484,6 +478,361 @@ bool ASObject::isConstructed() const
 {
 	return traitsInitialized && constructIndicator;
 }
+const uint32_t property_map::NPOS;
+const uint32_t property_map::USED_FLAG;
+const uint32_t property_map::HEAD_FLAG;
+const uint32_t property_map::INDEX_EMPTY;
+const uint32_t property_map::INDEX_TOMBSTONE;
+const uint32_t property_map::MIN_INDEX_CAPACITY;
+
+property_map_layout* property_map::newLayout(uint32_t keysCapacity, uint32_t indexCapacity)
+{
+	void* mem=::operator new(sizeof(property_map_layout)+keysCapacity*sizeof(property_map_key)+indexCapacity*sizeof(property_map_slot));
+	property_map_layout* ret=new (mem) property_map_layout;
+	ret->refCount=1;
+	ret->used=0;
+	ret->count=0;
+	ret->freeHead=NPOS;
+	ret->keysCapacity=keysCapacity;
+	ret->mask=indexCapacity-1;
+	ret->fill=0;
+	ret->keys=reinterpret_cast<property_map_key*>(ret+1);
+	ret->slots=reinterpret_cast<property_map_slot*>(ret->keys+keysCapacity);
+	//Sets all the positions to INDEX_EMPTY
+	memset(ret->slots,0xff,indexCapacity*sizeof(property_map_slot));
+	return ret;
+}
+
+void property_map::fillIndex(property_map_layout* l)
+{
+	for(uint32_t i=0;i<l->used;i++)
+	{
+		const property_map_key& k=l->keys[i];
+		if(!isUsed(k) || !isHead(k))
+			continue;
+		uint32_t pos=hashName(k.name)&l->mask;
+		while(l->slots[pos].pos!=INDEX_EMPTY)
+			pos=(pos+1)&l->mask;
+		l->slots[pos].name=k.name;
+		l->slots[pos].pos=i;
+		l->fill++;
+	}
+}
+
+property_map::property_map(const property_map& r):layout(nullptr),values(reinterpret_cast<variable*>(inlineStorage)),capacity(PROPERTY_MAP_INLINE_SIZE),numChunks(0),chunks(nullptr)
+{
+	copyFrom(r);
+}
+
+property_map& property_map::operator=(const property_map& r)
+{
+	if(this!=&r)
+	{
+		destroyValues();
+		releaseLayout();
+		copyFrom(r);
+	}
+	return *this;
+}
+
+property_map::~property_map()
+{
+	destroyValues();
+	releaseLayout();
+	for(uint32_t i=0;i<numChunks;i++)
+		::operator delete(chunks[i]);
+	delete[] chunks;
+	if(values!=reinterpret_cast<variable*>(inlineStorage))
+		::operator delete(values);
+}
+
+variable* property_map::storageAt(uint32_t i)
+{
+	if(i<capacity)
+		return values+i;
+	uint32_t j=i-capacity+4;
+	uint32_t c=29-__builtin_clz(j);
+	if(!chunks)
+		chunks=new variable*[PROPERTY_MAP_MAX_CHUNKS];
+	for(;numChunks<=c;numChunks++)
+		chunks[numChunks]=static_cast<variable*>(::operator new(sizeof(variable)*(4u<<numChunks)));
+	return chunks[c]+(j-(4u<<c));
+}
+
+variable& property_map::chunkEntryAt(uint32_t i)
+{
+	//Chunk c holds 4<<c variables
+	uint32_t j=i-capacity+4;
+	uint32_t c=29-__builtin_clz(j);
+	return chunks[c][j-(4u<<c)];
+}
+
+void property_map::prepareLayout(uint32_t keys, uint32_t indexCapacity)
+{
+	property_map_layout* old=layout;
+	if(old && old->refCount==1 && old->keysCapacity>=keys && old->mask+1==indexCapacity)
+		return;
+	property_map_layout* l=newLayout(keys,indexCapacity);
+	if(old)
+	{
+		assert(keys>=old->used);
+		memcpy(l->keys,old->keys,old->used*sizeof(property_map_key));
+		l->used=old->used;
+		l->count=old->count;
+		l->freeHead=old->freeHead;
+	}
+	if(old && old->mask+1==indexCapacity)
+	{
+		memcpy(l->slots,old->slots,indexCapacity*sizeof(property_map_slot));
+		l->fill=old->fill;
+	}
+	else
+		fillIndex(l);
+	releaseLayout();
+	layout=l;
+}
+
+void property_map::setIndex(uint32_t name, uint32_t oldHead, uint32_t newHead)
+{
+	property_map_layout* l=layout;
+	assert(l->refCount==1);
+	uint32_t pos=hashName(name)&l->mask;
+	if(oldHead!=NPOS)
+	{
+		while(l->slots[pos].pos!=oldHead)
+		{
+			assert(l->slots[pos].pos!=INDEX_EMPTY);
+			pos=(pos+1)&l->mask;
+		}
+		l->slots[pos].pos=(newHead==NPOS) ? INDEX_TOMBSTONE : newHead;
+		return;
+	}
+	while(l->slots[pos].pos!=INDEX_EMPTY && l->slots[pos].pos!=INDEX_TOMBSTONE)
+		pos=(pos+1)&l->mask;
+	if(l->slots[pos].pos==INDEX_EMPTY)
+		l->fill++;
+	l->slots[pos].name=name;
+	l->slots[pos].pos=newHead;
+	//Keep the index at most half full, counting tombstones
+	uint32_t indexCapacity=l->mask+1;
+	if(l->fill*2<=indexCapacity)
+		return;
+	if(l->count*4>indexCapacity)
+		prepareLayout(l->keysCapacity,indexCapacity*2);
+	else
+	{
+		//Only drop the tombstones
+		memset(l->slots,0xff,indexCapacity*sizeof(property_map_slot));
+		l->fill=0;
+		fillIndex(l);
+	}
+}
+
+void property_map::releaseLayout()
+{
+	if(layout && ATOMIC_DECREMENT(layout->refCount)==0)
+	{
+		layout->~property_map_layout();
+		::operator delete(layout);
+	}
+	layout=nullptr;
+}
+
+void property_map::destroyValues()
+{
+	if(!layout)
+		return;
+	for(uint32_t i=0;i<layout->used;i++)
+	{
+		if(isUsed(layout->keys[i]))
+			entryAt(i).~variable();
+	}
+}
+
+void property_map::shareLayout(const property_map& shape)
+{
+	property_map_layout* s=shape.layout;
+	if(!s || !layout || s==layout || layout->used!=s->used || layout->count!=layout->used || s->count!=s->used)
+		return;
+	for(uint32_t i=0;i<s->used;i++)
+	{
+		const property_map_key& k=layout->keys[i];
+		if(k.name!=s->keys[i].name || k.link!=s->keys[i].link)
+			return;
+	}
+	releaseLayout();
+	ATOMIC_INCREMENT(s->refCount);
+	layout=s;
+}
+
+void property_map::copyFrom(const property_map& r)
+{
+	assert(layout==nullptr);
+	property_map_layout* rl=r.layout;
+	if(!rl || rl->count==0)
+		return;
+	//Keep all the variables in a single block, lookups don't need to go through the chunks
+	if(rl->count>capacity && numChunks==0)
+	{
+		if(values!=reinterpret_cast<variable*>(inlineStorage))
+			::operator delete(values);
+		values=static_cast<variable*>(::operator new(rl->count*sizeof(variable)));
+		capacity=rl->count;
+	}
+	if(rl->count==rl->used)
+	{
+		//Without holes the entries keep their position, so the layout of r is valid here too
+		for(uint32_t i=0;i<rl->used;i++)
+			new (storageAt(i)) variable(r.entryAt(i));
+		ATOMIC_INCREMENT(rl->refCount);
+		layout=rl;
+		return;
+	}
+	//Copy the entries without holes, remapping the chains
+	property_map_layout* l=newLayout(rl->count,indexCapacityOf(rl));
+	std::vector<uint32_t> remap(rl->used,NPOS);
+	for(uint32_t i=0;i<rl->used;i++)
+	{
+		if(!isUsed(rl->keys[i]))
+			continue;
+		remap[i]=l->used;
+		new (storageAt(l->used)) variable(r.entryAt(i));
+		l->keys[l->used].name=rl->keys[i].name;
+		l->used++;
+	}
+	for(uint32_t i=0;i<rl->used;i++)
+	{
+		const property_map_key& k=rl->keys[i];
+		if(!isUsed(k))
+			continue;
+		uint32_t next=nextOf(k);
+		l->keys[remap[i]].link=(k.link&(USED_FLAG|HEAD_FLAG))|(next==NPOS ? NPOS : remap[next]);
+	}
+	l->count=l->used;
+	fillIndex(l);
+	layout=l;
+}
+
+property_map::iterator property_map::nth(uint32_t n)
+{
+	if(n>=size())
+		return end();
+	//Fast path, there are no free entries
+	if(layout->count==layout->used)
+		return iterator(this,n,false);
+	iterator it=begin();
+	for(uint32_t i=0;i<n;i++)
+		++it;
+	return it;
+}
+
+property_map::iterator property_map::insert(const std::pair<uint32_t,variable>& v)
+{
+	uint32_t used=layout ? layout->used : 0;
+	uint32_t keys=layout ? layout->keysCapacity : 0;
+	if(!layout || layout->freeHead==NPOS)
+	{
+		if(used>=NPOS)
+			throw RunTimeException("Too many variables");
+		if(used>=keys)
+			keys=keys ? keys*2 : PROPERTY_MAP_INLINE_SIZE;
+	}
+	prepareLayout(keys,indexCapacityOf(layout));
+	property_map_layout* l=layout;
+	uint32_t oldHead=findHead(v.first);
+	uint32_t i=l->freeHead;
+	if(i!=NPOS)
+		l->freeHead=nextOf(l->keys[i]);
+	else
+		i=l->used++;
+	new (storageAt(i)) variable(v.second);
+	//New entries are put in front of their name chain
+	l->keys[i].name=v.first;
+	l->keys[i].link=USED_FLAG|HEAD_FLAG|oldHead;
+	if(oldHead!=NPOS)
+		l->keys[oldHead].link&=~HEAD_FLAG;
+	l->count++;
+	setIndex(v.first,oldHead,i);
+	return iterator(this,i,false);
+}
+
+property_map::iterator property_map::erase(iterator it)
+{
+	uint32_t i=it.idx;
+	prepareLayout(layout->keysCapacity,indexCapacityOf(layout));
+	property_map_layout* l=layout;
+	assert(isUsed(l->keys[i]));
+	iterator ret=it;
+	ret.advance();
+	uint32_t name=l->keys[i].name;
+	uint32_t next=nextOf(l->keys[i]);
+	if(isHead(l->keys[i]))
+	{
+		if(next!=NPOS)
+			l->keys[next].link|=HEAD_FLAG;
+		setIndex(name,i,next);
+	}
+	else
+	{
+		uint32_t prev=findHead(name);
+		while(nextOf(l->keys[prev])!=i)
+			prev=nextOf(l->keys[prev]);
+		property_map_key& p=l->keys[prev];
+		p.link=(p.link&(USED_FLAG|HEAD_FLAG))|next;
+	}
+	entryAt(i).~variable();
+	l->keys[i].link=l->freeHead;
+	l->freeHead=i;
+	l->count--;
+	if(l->count==0)
+	{
+		//Start again from the beginning of the storage
+		l->used=0;
+		l->freeHead=NPOS;
+		memset(l->slots,0xff,(l->mask+1)*sizeof(property_map_slot));
+		l->fill=0;
+		return end();
+	}
+	return ret;
+}
+
+void property_map::clear()
+{
+	destroyValues();
+	if(!layout || layout->refCount!=1)
+	{
+		releaseLayout();
+		return;
+	}
+	layout->used=0;
+	layout->count=0;
+	layout->freeHead=NPOS;
+	memset(layout->slots,0xff,(layout->mask+1)*sizeof(property_map_slot));
+	layout->fill=0;
+}
+
+void property_map::reserve(uint32_t n)
+{
+	if(n==0)
+		return;
+	if(size()==0 && numChunks==0 && n>capacity)
+	{
+		//Nothing is stored yet, keep all the variables in a single block
+		if(values!=reinterpret_cast<variable*>(inlineStorage))
+			::operator delete(values);
+		values=static_cast<variable*>(::operator new(n*sizeof(variable)));
+		capacity=n;
+	}
+	else
+		storageAt(n-1);
+	uint32_t keys=layout ? layout->keysCapacity : 0;
+	uint32_t indexCapacity=indexCapacityOf(layout);
+	while(indexCapacity<n*4)
+		indexCapacity*=2;
+	if(!layout || keys<n || indexCapacity!=indexCapacityOf(layout))
+		prepareLayout(keys<n ? n : keys,indexCapacity);
+}
+
 variables_map::variables_map(MemoryAccount *m):slotcount(0),cloneable(true)
 {
 }
@@ -1419,6 +1768,14 @@ variable* ASObject::findVariableByMultiname(const multiname& name, Class_base* c
 	return obj;
 }
 
+uint32_t ASObject::findVariableIndex(const multiname& name, uint32_t traitKinds)
+{
+	variable* v=varcount ? Variables.findObjVar(getSystemState(),name,traitKinds) : nullptr;
+	if(!v)
+		return property_map::NPOS;
+	return Variables.Variables.indexOf(name.name_s_id,v);
+}
+
 GET_VARIABLE_RESULT ASObject::getVariableByMultinameIntern(asAtom &ret, const multiname& name, Class_base* cls,  GET_VARIABLE_OPTION opt)
 {
 	check();
@@ -1650,6 +2007,18 @@ void variables_map::destroyContents()
 	slotcount=0;
 }
 
+void variables_map::collectReferences(gc_references& refs)
+{
+	for (auto it=Variables.begin();it!=Variables.end();++it)
+	{
+		if (!it->second.isrefcounted)
+			continue;
+		refs.addOwned(it->second.var);
+		refs.addOwned(it->second.setter);
+		refs.addOwned(it->second.getter);
+	}
+}
+
 bool variables_map::cloneInstance(variables_map &map)
 {
 	if (!cloneable)
@@ -1696,6 +2065,12 @@ void ASObject::dumpObjectCounters(uint32_t threshhold)
 	LOG(LOG_INFO,"countall:"<<c);
 }
 #endif
+//Primitive values and classes can't be collected by the cycle collector, so they are never buffered
+static inline bool mayBePartOfCycle(SWFOBJECT_TYPE t)
+{
+	return t==T_OBJECT || t==T_ARRAY || t==T_FUNCTION;
+}
+
 ASObject::ASObject(Class_base* c,SWFOBJECT_TYPE t,CLASS_SUBTYPE st):objfreelist(c && c->getSystemState()->singleworker && c->isReusable ? c->freelist : NULL),Variables((c)?c->memoryAccount:NULL),varcount(0),classdef(c),proxyMultiName(NULL),sys(c?c->sys:NULL),
 	stringId(UINT32_MAX),type(t),subtype(st),traitsInitialized(false),constructIndicator(false),constructorCallComplete(false),implEnable(true)
 {
@@ -1709,6 +2084,8 @@ ASObject::ASObject(Class_base* c,SWFOBJECT_TYPE t,CLASS_SUBTYPE st):objfreelist(
 		objectcounter[c] = x;
 	}
 #endif
+	if (mayBePartOfCycle(t))
+		setCycleCandidate();
 }
 
 ASObject::ASObject(const ASObject& o):objfreelist(o.classdef && o.classdef->getSystemState()->singleworker && o.classdef->isReusable ? o.classdef->freelist : NULL),Variables((o.classdef)?o.classdef->memoryAccount:NULL),varcount(0),classdef(NULL),proxyMultiName(NULL),sys(o.classdef? o.classdef->sys : NULL),
@@ -1719,6 +2096,8 @@ ASObject::ASObject(const ASObject& o):objfreelist(o.classdef && o.classdef->getS
 	initialized=false;
 #endif
 	assert(o.Variables.size()==0);
+	if (mayBePartOfCycle(type))
+		setCycleCandidate();
 }
 
 void ASObject::setClass(Class_base* c)
@@ -1735,6 +2114,28 @@ bool ASObject::destruct()
 	return destructIntern();
 }
 
+bool ASObject::possibleCycleRoot()
+{
+	return sys && sys->cycleCollector.addRoot(this);
+}
+
+void ASObject::removeCycleRoot()
+{
+	if (sys)
+		sys->cycleCollector.removeRoot(this);
+}
+
+void ASObject::collectReferences(gc_references& refs)
+{
+	if (varcount)
+		Variables.collectReferences(refs);
+}
+
+void ASObject::releaseReferences()
+{
+	destroyContents();
+}
+
 bool ASObject::AVM1HandleKeyboardEvent(KeyboardEvent *e) 
 { 
 	if (e->type =="keyDown")
@@ -1917,16 +2318,7 @@ variable* variables_map::getValueAt(unsigned int index)
 {
 	//TODO: CHECK behaviour on overridden methods
 	if(index<Variables.size())
-	{
-		var_iterator it=Variables.begin();
-		uint32_t i = 0;
-		while (i < index)
-		{
-			++i;
-			++it;
-		}
-		return &it->second;
-	}
+		return &Variables.nth(index)->second;
 	else
 		throw RunTimeException("getValueAt out of bounds");
 }
@@ -1954,16 +2346,7 @@ uint32_t variables_map::getNameAt(unsigned int index) const
 {
 	//TODO: CHECK behaviour on overridden methods
 	if(index<Variables.size())
-	{
-		const_var_iterator it=Variables.begin();
-		uint32_t i = 0;
-		while (i < index)
-		{
-			++i;
-			++it;
-		}
-		return it->first;
-	}
+		return Variables.nth(index)->first;
 	else
 		throw RunTimeException("getNameAt out of bounds");
 }
@@ -2954,6 +3337,23 @@ void asAtomHandler::convert_b(asAtom& a, bool refcounted)
 	setBool(a,v);
 }
 
+//String concatenation of add, appends in place to the buffer of a when nothing else uses it
+static ASObject* concatStrings(SystemState* sys, asAtom& a, asAtom& b)
+{
+	//b is converted first, it may be the same string as a
+	tiny_string sb = asAtomHandler::toString(b,sys);
+	ASString* left = (a.uintval&0x7)==ATOM_STRINGPTR ? asAtomHandler::getObject(a)->as<ASString>() : nullptr;
+	tiny_string sa;
+	bool taken = left && left->takeData(sa);
+	if (!taken)
+		sa = asAtomHandler::toString(a,sys);
+	sa += sb;
+	ASObject* res = abstract_s(sys,sa);
+	if (taken)
+		left->setPrefixOf(res->as<ASString>());
+	return res;
+}
+
 bool asAtomHandler::add(asAtom& a,asAtom &v2, SystemState* sys,bool forceint)
 {
 	//Implement ECMA add algorithm, for XML and default (see avm2overview)
@@ -2986,13 +3386,15 @@ bool asAtomHandler::add(asAtom& a,asAtom &v2, SystemState* sys,bool forceint)
 	}
 	else if(isString(a) || isString(v2))
 	{
-		tiny_string sa = toString(a,sys);
-		sa += toString(v2,sys);
 		LOG_CALL("add " << toString(a,sys) << '+' << toString(v2,sys));
 		if (forceint)
+		{
+			tiny_string sa = toString(a,sys);
+			sa += toString(v2,sys);
 			setInt(a,sys,Integer::stringToASInteger(sa.raw_buf(),0));
+		}
 		else
-			a.uintval = (LIGHTSPARK_ATOM_VALTYPE)(abstract_s(sys,sa))|ATOM_STRINGPTR;
+			a.uintval = (LIGHTSPARK_ATOM_VALTYPE)(concatStrings(sys,a,v2))|ATOM_STRINGPTR;
 	}
 	else
 	{
@@ -3098,14 +3500,21 @@ void asAtomHandler::addreplace(asAtom& ret, SystemState* sys,asAtom& v1, asAtom
 	}
 	else if(isString(v1) || isString(v2))
 	{
-		tiny_string sa = toString(v1,sys);
-		sa += toString(v2,sys);
 		LOG_CALL("add " << toString(v1,sys) << '+' << toString(v2,sys));
-		ASATOM_DECREF(ret);
 		if (forceint)
+		{
+			tiny_string sa = toString(v1,sys);
+			sa += toString(v2,sys);
+			ASATOM_DECREF(ret);
 			setInt(ret,sys,Integer::stringToASInteger(sa.raw_buf(),0));
+		}
 		else
-			ret.uintval = (LIGHTSPARK_ATOM_VALTYPE)(abstract_s(sys,sa))|ATOM_STRINGPTR;
+		{
+			//ret may hold the last reference to v1
+			ASObject* res = concatStrings(sys,v1,v2);
+			ASATOM_DECREF(ret);
+			ret.uintval = (LIGHTSPARK_ATOM_VALTYPE)(res)|ATOM_STRINGPTR;
+		}
 	}
 	else
 	{
@@ -290,7 +290,8 @@ struct asfreelist
 
 extern SystemState* getSys();
 enum TRAIT_KIND { NO_CREATE_TRAIT=0, DECLARED_TRAIT=1, DYNAMIC_TRAIT=2, INSTANCE_TRAIT=5, CONSTANT_TRAIT=9 /* constants are also declared traits */ };
-enum GET_VARIABLE_RESULT {GETVAR_NORMAL=0x00, GETVAR_CACHEABLE=0x01, GETVAR_ISGETTER=0x02, GETVAR_ISCONSTANT=0x04};
+//GETVAR_ISNEWOBJECT: ret holds its own reference although NO_INCREF was requested, the caller has to release it
+enum GET_VARIABLE_RESULT {GETVAR_NORMAL=0x00, GETVAR_CACHEABLE=0x01, GETVAR_ISGETTER=0x02, GETVAR_ISCONSTANT=0x04, GETVAR_ISNEWOBJECT=0x08};
 enum GET_VARIABLE_OPTION {NONE=0x00, SKIP_IMPL=0x01, FROM_GETLEX=0x02, DONT_CALL_GETTER=0x04, NO_INCREF=0x08};
 
 #ifdef LIGHTSPARK_64
@@ -339,7 +340,7 @@ enum ATOM_TYPE
 	ATOM_U_INTEGERPTR=0x7
 };
 
-class asAtomHandler
+class DLL_PUBLIC asAtomHandler
 {
 private:
 #define ATOMTYPE_NULL_BIT 0x40
@@ -564,6 +565,23 @@ public:
 #define ASATOM_INCREF_POINTER(a) if (asAtomHandler::isObject(*a)) asAtomHandler::getObjectNoCheck(*a)->incRef()
 #define ASATOM_DECREF(a) if (asAtomHandler::isObject(a)) { ASObject* obj_b = asAtomHandler::getObjectNoCheck(a); if (!obj_b->getConstant() && !obj_b->getInDestruction()) obj_b->decRef(); }
 #define ASATOM_DECREF_POINTER(a) if (asAtomHandler::isObject(*a)) { ASObject* obj_b = asAtomHandler::getObject(*a); if (obj_b && !obj_b->getConstant() && !obj_b->getInDestruction()) obj_b->decRef(); }
+/*
+ * Filled by ASObject::collectReferences for the cycle collector
+ */
+struct gc_references
+{
+	//Objects this object holds a counted reference to, that are dropped by releaseReferences()
+	std::vector<ASObject*> owned;
+	//Objects pointing to this object without a counted reference (like the parent
+	//pointer of a display list child), this object is alive as long as they are
+	std::vector<ASObject*> backrefs;
+	inline void addOwned(const asAtom& a)
+	{
+		if (asAtomHandler::isObject(a))
+			owned.push_back(asAtomHandler::getObjectNoCheck(a));
+	}
+};
+
 struct variable
 {
 	asAtom var;
@@ -620,14 +638,265 @@ struct varName
 	}
 };
 
+/*
+ * Number of variables stored inside the map itself. Maps copied from a
+ * bigger one, like the instances of a class, get a single block for all
+ * of its variables, so more inline variables only make objects bigger.
+ * Other maps spill into heap chunks of doubling size
+ */
+#define PROPERTY_MAP_INLINE_SIZE 2
+#define PROPERTY_MAP_MAX_CHUNKS 30
+
+/*
+ * Name of an entry of a property_map
+ */
+struct property_map_key
+{
+	uint32_t name;
+	/*
+	 * bit 31: the entry is in use
+	 * bit 30: the entry is the first one of its name chain
+	 * bits 0-29: index of the next entry with the same name if in use,
+	 *            next free entry otherwise
+	 */
+	uint32_t link;
+};
+
+/*
+ * Slot of the index of a property_map_layout, the name is kept next to
+ * the position so that probing does not need to read the keys
+ */
+struct property_map_slot
+{
+	uint32_t name;
+	uint32_t pos;
+};
+
+/*
+ * Names of the entries of a property_map and the index on them. Maps
+ * with the same names at the same positions, like the instances built
+ * from the traits of a class, share a single layout and only store their
+ * variables. A map copies the layout before modifying it if it is shared.
+ * The keys and the index are allocated together with the layout.
+ * Even the smallest layouts have an index: scanning the names mispredicts
+ * when looking up random names, and it was already slower than the index
+ * with 4 names in the properties benchmark.
+ */
+struct property_map_layout
+{
+	ATOMIC_INT32(refCount);
+	//Number of allocated entries, including free ones
+	uint32_t used;
+	//Number of entries in use
+	uint32_t count;
+	uint32_t freeHead;
+	uint32_t keysCapacity;
+	//Index mask and used or tombstone slots
+	uint32_t mask;
+	uint32_t fill;
+	property_map_key* keys;
+	property_map_slot* slots;
+};
+
+/*
+ * Flat multimap from name ids to variables.
+ * It mirrors the subset of the std::unordered_multimap interface used
+ * by variables_map: entries with the same name are chained together, so
+ * iterating from find(name) visits all of them before reaching end().
+ * Iterating from begin() visits all the entries in storage order.
+ * Names are kept in a property_map_layout, the map itself only holds
+ * the variables, indexed by the position of their entry. Variables are
+ * never moved once they have been created, so pointers to them stay
+ * valid until they are erased.
+ */
+class DLL_PUBLIC property_map
+{
+public:
+	static const uint32_t NPOS = 0x3fffffff;
+	//What iterators point to, the name and the variable of an entry
+	struct reference
+	{
+		uint32_t first;
+		variable& second;
+		reference* operator->() { return this; }
+	};
+	struct const_reference
+	{
+		uint32_t first;
+		const variable& second;
+		const const_reference* operator->() const { return this; }
+	};
+	struct iterator_base
+	{
+		property_map* map;
+		uint32_t idx;
+		bool byName;
+		iterator_base(property_map* m, uint32_t i, bool n):map(m),idx(i),byName(n) {}
+		void advance()
+		{
+			idx = byName ? map->nextInChain(idx) : map->nextUsed(idx+1);
+		}
+		bool operator==(const iterator_base& r) const { return idx==r.idx; }
+		bool operator!=(const iterator_base& r) const { return idx!=r.idx; }
+	};
+	struct iterator: public iterator_base
+	{
+		iterator(property_map* m=nullptr, uint32_t i=NPOS, bool n=false):iterator_base(m,i,n) {}
+		reference operator*() const { return reference{map->nameAt(idx),map->entryAt(idx)}; }
+		reference operator->() const { return **this; }
+		iterator& operator++() { advance(); return *this; }
+		iterator operator++(int) { iterator ret=*this; advance(); return ret; }
+	};
+	struct const_iterator: public iterator_base
+	{
+		const_iterator(const property_map* m=nullptr, uint32_t i=NPOS, bool n=false):iterator_base(const_cast<property_map*>(m),i,n) {}
+		const_iterator(const iterator& it):iterator_base(it) {}
+		const_reference operator*() const { return const_reference{map->nameAt(idx),map->entryAt(idx)}; }
+		const_reference operator->() const { return **this; }
+		const_iterator& operator++() { advance(); return *this; }
+		const_iterator operator++(int) { const_iterator ret=*this; advance(); return ret; }
+	};
+private:
+	static const uint32_t USED_FLAG = 0x80000000;
+	static const uint32_t HEAD_FLAG = 0x40000000;
+	static const uint32_t INDEX_EMPTY = 0xffffffff;
+	static const uint32_t INDEX_TOMBSTONE = 0xfffffffe;
+	static const uint32_t MIN_INDEX_CAPACITY = 8;
+	property_map_layout* layout;
+	//Variables from 0 to capacity-1, the following ones are in chunks
+	variable* values;
+	uint32_t capacity;
+	uint32_t numChunks;
+	variable** chunks;
+	union
+	{
+		char inlineStorage[PROPERTY_MAP_INLINE_SIZE*sizeof(variable)];
+		//Only used to align the storage
+		uint64_t alignDummy;
+	};
+	static inline uint32_t hashName(uint32_t name)
+	{
+		return name*2654435761u;
+	}
+	static inline uint32_t nextOf(const property_map_key& k) { return k.link&NPOS; }
+	static inline bool isUsed(const property_map_key& k) { return k.link&USED_FLAG; }
+	static inline bool isHead(const property_map_key& k) { return k.link&HEAD_FLAG; }
+	inline uint32_t nameAt(uint32_t i) const { return layout->keys[i].name; }
+	inline uint32_t nextInChain(uint32_t i) const { return nextOf(layout->keys[i]); }
+	inline uint32_t nextUsed(uint32_t i) const
+	{
+		if(!layout)
+			return NPOS;
+		for(;i<layout->used;i++)
+		{
+			if(isUsed(layout->keys[i]))
+				return i;
+		}
+		return NPOS;
+	}
+	uint32_t findHead(uint32_t name) const
+	{
+		const property_map_layout* l=layout;
+		if(!l)
+			return NPOS;
+		uint32_t pos=hashName(name)&l->mask;
+		while(1)
+		{
+			const property_map_slot& s=l->slots[pos];
+			//INDEX_TOMBSTONE and INDEX_EMPTY are the biggest positions
+			if(s.name==name && s.pos<INDEX_TOMBSTONE)
+				return s.pos;
+			if(s.pos==INDEX_EMPTY)
+				return NPOS;
+			pos=(pos+1)&l->mask;
+		}
+	}
+	static property_map_layout* newLayout(uint32_t keysCapacity, uint32_t indexCapacity);
+	//Adds the heads of the chains of l to its empty index
+	static void fillIndex(property_map_layout* l);
+	static inline uint32_t indexCapacityOf(const property_map_layout* l) { return l ? l->mask+1 : MIN_INDEX_CAPACITY; }
+	//Returns a pointer to the storage for variable i, allocating the chunk if needed
+	variable* storageAt(uint32_t i);
+	//Out of line, so that lookups of variables in values don't need to save more registers
+	variable& chunkEntryAt(uint32_t i);
+	//Makes the layout not shared, with room for keys entries and an index of indexCapacity slots
+	void prepareLayout(uint32_t keys, uint32_t indexCapacity);
+	void setIndex(uint32_t name, uint32_t oldHead, uint32_t newHead);
+	void releaseLayout();
+	void destroyValues();
+	void copyFrom(const property_map& r);
+public:
+	property_map():layout(nullptr),values(reinterpret_cast<variable*>(inlineStorage)),capacity(PROPERTY_MAP_INLINE_SIZE),numChunks(0),chunks(nullptr) {}
+	property_map(const property_map& r);
+	property_map& operator=(const property_map& r);
+	~property_map();
+	inline variable& entryAt(uint32_t i)
+	{
+		if(i<capacity)
+			return values[i];
+		return chunkEntryAt(i);
+	}
+	inline const variable& entryAt(uint32_t i) const
+	{
+		return const_cast<property_map*>(this)->entryAt(i);
+	}
+	inline iterator begin() { return iterator(this,nextUsed(0),false); }
+	inline iterator end() { return iterator(this,NPOS,false); }
+	inline const_iterator begin() const { return const_iterator(this,nextUsed(0),false); }
+	inline const_iterator end() const { return const_iterator(this,NPOS,false); }
+	inline const_iterator cbegin() const { return begin(); }
+	inline const_iterator cend() const { return end(); }
+	inline iterator find(uint32_t name) { return iterator(this,findHead(name),true); }
+	inline const_iterator find(uint32_t name) const { return const_iterator(this,findHead(name),true); }
+	/*
+	 * Returns the variable at index i if its entry is in use and has the given name,
+	 * this is used by the inline caches of the interpreter to validate a cached index
+	 */
+	inline variable* usedEntryAt(uint32_t i, uint32_t name)
+	{
+		if(!layout || i>=layout->used)
+			return nullptr;
+		const property_map_key& k=layout->keys[i];
+		return (isUsed(k) && k.name==name) ? &entryAt(i) : nullptr;
+	}
+	inline uint32_t indexOf(uint32_t name, const variable* v) const
+	{
+		for(const_iterator it=find(name);it!=end();++it)
+		{
+			if(&it->second==v)
+				return it.idx;
+		}
+		return NPOS;
+	}
+	/*
+	 * Returns the n-th entry in iteration order, this is O(1) if no
+	 * entry has been erased
+	 */
+	iterator nth(uint32_t n);
+	const_iterator nth(uint32_t n) const { return const_cast<property_map*>(this)->nth(n); }
+	inline uint32_t size() const { return layout ? layout->count : 0; }
+	inline bool empty() const { return size()==0; }
+	iterator insert(const std::pair<uint32_t,variable>& v);
+	inline iterator insert(const_iterator hint, const std::pair<uint32_t,variable>& v) { return insert(v); }
+	iterator erase(iterator it);
+	void clear();
+	void reserve(uint32_t n);
+	/*
+	 * Shares the layout of shape if this map has the same names at the
+	 * same positions, this is used for the instances of a class that
+	 * can't be cloned from its instance factory
+	 */
+	void shareLayout(const property_map& shape);
+};
+
 class variables_map
 {
 public:
 	//Names are represented by strings in the string and namespace pools
-	typedef std::unordered_multimap<uint32_t,variable> mapType;
+	typedef property_map mapType;
 	mapType Variables;
-	typedef std::unordered_multimap<uint32_t,variable>::iterator var_iterator;
-	typedef std::unordered_multimap<uint32_t,variable>::const_iterator const_var_iterator;
+	typedef property_map::iterator var_iterator;
+	typedef property_map::const_iterator const_var_iterator;
 	std::vector<variable*> slots_vars;
 	uint32_t slotcount;
 	// indicates if this map was initialized with no variables with non-primitive values
@@ -732,6 +1001,17 @@ public:
 		return NULL;
 	}
 	
+	/*
+	 * Returns the variable at the given index of the map if it still has the given name and namespace
+	 */
+	FORCE_INLINE variable* findObjVarAt(uint32_t index, uint32_t nameId, const nsNameAndKind& ns)
+	{
+		variable* v=Variables.usedEntryAt(index,nameId);
+		if(v && v->ns==ns)
+			return v;
+		return nullptr;
+	}
+	
 	//Initialize a new variable specifying the type (TODO: add support for const)
 	void initializeVar(multiname &mname, asAtom &obj, multiname *typemname, ABCContext* context, TRAIT_KIND traitKind, ASObject* mainObj, uint32_t slot_id, bool isenumerable);
 	void killObjVar(SystemState* sys, const multiname& mname);
@@ -800,6 +1080,7 @@ public:
 				std::map<const Class_base*, uint32_t>& traitsMap);
 	void dumpVariables();
 	void destroyContents();
+	void collectReferences(gc_references& refs);
 	bool cloneInstance(variables_map& map);
 	void removeAllDeclaredProperties();
 };
@@ -856,8 +1137,12 @@ protected:
 	ASObject(const ASObject& o);
 	virtual ~ASObject()
 	{
+		if (getCycleBuffered())
+			removeCycleRoot();
 		destroy();
 	}
+	bool possibleCycleRoot() override;
+	void removeCycleRoot();
 	uint32_t stringId;
 	SWFOBJECT_TYPE type;
 	CLASS_SUBTYPE subtype;
@@ -910,6 +1195,8 @@ protected:
 
 	FORCE_INLINE bool destructIntern()
 	{
+		if (getCycleBuffered())
+			removeCycleRoot();
 		if (varcount)
 			destroyContents();
 		if (proxyMultiName)
@@ -996,6 +1283,15 @@ public:
 	   The finalize method must be callable multiple time with the same effects (no double frees).
 	*/
 	inline virtual void finalize() {}
+	/*
+	   Used by the cycle collector, see cycle_collector.h
+	   collectReferences adds the objects this object holds a counted reference to,
+	   releaseReferences drops exactly those references. Derived classes keeping
+	   references outside of their variables should extend both and call the base version.
+	   References that are not reported are safe, they just keep their target alive.
+	*/
+	virtual void collectReferences(gc_references& refs);
+	virtual void releaseReferences();
 
 	virtual GET_VARIABLE_RESULT getVariableByMultiname(asAtom& ret, const multiname& name, GET_VARIABLE_OPTION opt=NONE)
 	{
@@ -1024,6 +1320,16 @@ public:
 		return getVariableByMultiname(ret,m,opt);
 	}
 	virtual int32_t getVariableByMultiname_i(const multiname& name);
+	/*
+	 * Support for the inline caches of the interpreter: findVariableIndex returns the index of the
+	 * own variable name resolves to (or property_map::NPOS), getCachedVariable returns the variable
+	 * at this index if it is still the one name resolves to. Only names with a single namespace are supported.
+	 */
+	uint32_t findVariableIndex(const multiname& name, uint32_t traitKinds);
+	FORCE_INLINE variable* getCachedVariable(uint32_t index, const multiname& name)
+	{
+		return varcount ? Variables.findObjVarAt(index,name.name_s_id,name.ns.front()) : nullptr;
+	}
 	/* Simple getter interface for the common case */
 	void getVariableByMultiname(asAtom& ret, const tiny_string& name, std::list<tiny_string> namespaces);
 	/*
@@ -1322,6 +1628,7 @@ class ContextMenuBuiltInItems;
 class ContextMenuEvent;
 class CubeTexture;
 class Date;
+class Dictionary;
 class DisplacementFilter;
 class DisplayObject;
 class DisplayObjectContainer;
@@ -1421,6 +1728,7 @@ template<> inline bool ASObject::is<ContextMenuEvent>() const { return subtype==
 template<> inline bool ASObject::is<ConvolutionFilter>() const { return subtype==SUBTYPE_CONVOLUTIONFILTER; }
 template<> inline bool ASObject::is<CubeTexture>() const { return subtype==SUBTYPE_CUBETEXTURE; }
 template<> inline bool ASObject::is<Date>() const { return subtype==SUBTYPE_DATE; }
+template<> inline bool ASObject::is<Dictionary>() const { return subtype==SUBTYPE_DICTIONARY; }
 template<> inline bool ASObject::is<DisplacementFilter>() const { return subtype==SUBTYPE_DISPLACEMENTFILTER; }
 template<> inline bool ASObject::is<DisplayObject>() const { return subtype==SUBTYPE_DISPLAYOBJECT || subtype==SUBTYPE_INTERACTIVE_OBJECT || subtype==SUBTYPE_TEXTFIELD || subtype==SUBTYPE_BITMAP || subtype==SUBTYPE_DISPLAYOBJECTCONTAINER || subtype==SUBTYPE_STAGE || subtype==SUBTYPE_ROOTMOVIECLIP || subtype==SUBTYPE_SPRITE || subtype == SUBTYPE_MOVIECLIP || subtype == SUBTYPE_TEXTLINE; }
 template<> inline bool ASObject::is<DisplayObjectContainer>() const { return subtype==SUBTYPE_DISPLAYOBJECTCONTAINER || subtype==SUBTYPE_STAGE || subtype==SUBTYPE_ROOTMOVIECLIP || subtype==SUBTYPE_SPRITE || subtype == SUBTYPE_MOVIECLIP || subtype == SUBTYPE_TEXTLINE; }
@@ -22,7 +22,6 @@
 #include "backends/config.h"
 #include <iostream>
 #include "logger.h"
-#include <sys/time.h>
 
 
 using namespace lightspark;
@@ -30,14 +29,10 @@ using namespace std;
 
 uint32_t AudioStream::getPlayedTime()
 {
-	uint32_t ret;
-	struct timeval now;
-	gettimeofday(&now, nullptr);
 	if (!mixingStarted)
 		return playedtime;
 
-	ret = playedtime + (now.tv_sec * 1000 + now.tv_usec / 1000) - (starttime.tv_sec * 1000 + starttime.tv_usec / 1000);
-	return ret;
+	return playedtime + compat_msectiming() - starttime;
 }
 bool AudioStream::init()
 {
@@ -53,7 +48,7 @@ void AudioStream::startMixing()
 	if(mixingStarted)
 		return;
 	mixingStarted=true;
-	gettimeofday(&starttime, nullptr);
+	starttime=compat_msectiming();
 }
 
 void AudioStream::SetPause(bool pause_on)
@@ -69,7 +69,8 @@ private:
 	double curvolume;
 	double unmutevolume;
 	uint64_t playedtime;
-	struct timeval starttime;
+	//compat_msectiming when the mixing started
+	uint64_t starttime;
 	int mixer_channel;
 public:
 	bool init();
@@ -0,0 +1,530 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "backends/bitmapfilters.h"
+#include "threading.h"
+#include "swf.h"
+#include <atomic>
+#include <vector>
+#include <cstring>
+#include <SDL2/SDL_cpuinfo.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define FILTERS_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define FILTERS_NEON 1
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+using namespace lightspark;
+
+namespace
+{
+
+/*
+ * 4 lanes holding the channels of a pixel, lane n is the byte n of the
+ * pixel: blue, green, red and alpha on little endian machines.
+ */
+#if defined(FILTERS_SSE2)
+typedef __m128i lanes_i;
+typedef __m128 lanes_f;
+inline lanes_i unpackPixel(uint32_t p)
+{
+	__m128i z=_mm_setzero_si128();
+	return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(p),z),z);
+}
+inline uint32_t packPixel(lanes_i v)
+{
+	v=_mm_packs_epi32(v,v);
+	return _mm_cvtsi128_si32(_mm_packus_epi16(v,v));
+}
+inline lanes_i loadLanes(const int32_t* p) { return _mm_loadu_si128((const __m128i*)p); }
+inline void storeLanes(int32_t* p, lanes_i v) { _mm_storeu_si128((__m128i*)p,v); }
+inline lanes_i addLanes(lanes_i a, lanes_i b) { return _mm_add_epi32(a,b); }
+inline lanes_i subLanes(lanes_i a, lanes_i b) { return _mm_sub_epi32(a,b); }
+inline lanes_i zeroLanes() { return _mm_setzero_si128(); }
+inline lanes_f toFloat(lanes_i v) { return _mm_cvtepi32_ps(v); }
+inline lanes_i toInt(lanes_f v) { return _mm_cvttps_epi32(v); }
+inline lanes_f loadLanesF(const float* p) { return _mm_loadu_ps(p); }
+inline void storeLanesF(float* p, lanes_f v) { _mm_storeu_ps(p,v); }
+inline lanes_f setLanesF(float x) { return _mm_set1_ps(x); }
+inline lanes_f setLanesF(float x0, float x1, float x2, float x3) { return _mm_set_ps(x3,x2,x1,x0); }
+inline lanes_f addLanesF(lanes_f a, lanes_f b) { return _mm_add_ps(a,b); }
+inline lanes_f mulLanesF(lanes_f a, lanes_f b) { return _mm_mul_ps(a,b); }
+inline lanes_f minLanesF(lanes_f a, lanes_f b) { return _mm_min_ps(a,b); }
+inline lanes_f maxLanesF(lanes_f a, lanes_f b) { return _mm_max_ps(a,b); }
+template<int n> inline lanes_f broadcastLane(lanes_f v) { return _mm_shuffle_ps(v,v,_MM_SHUFFLE(n,n,n,n)); }
+#elif defined(FILTERS_NEON)
+typedef int32x4_t lanes_i;
+typedef float32x4_t lanes_f;
+inline lanes_i unpackPixel(uint32_t p)
+{
+	uint16x8_t w=vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(p)));
+	return vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(w)));
+}
+inline uint32_t packPixel(lanes_i v)
+{
+	int16x4_t s=vqmovn_s32(v);
+	return vget_lane_u32(vreinterpret_u32_u8(vqmovun_s16(vcombine_s16(s,s))),0);
+}
+inline lanes_i loadLanes(const int32_t* p) { return vld1q_s32(p); }
+inline void storeLanes(int32_t* p, lanes_i v) { vst1q_s32(p,v); }
+inline lanes_i addLanes(lanes_i a, lanes_i b) { return vaddq_s32(a,b); }
+inline lanes_i subLanes(lanes_i a, lanes_i b) { return vsubq_s32(a,b); }
+inline lanes_i zeroLanes() { return vdupq_n_s32(0); }
+inline lanes_f toFloat(lanes_i v) { return vcvtq_f32_s32(v); }
+inline lanes_i toInt(lanes_f v) { return vcvtq_s32_f32(v); }
+inline lanes_f loadLanesF(const float* p) { return vld1q_f32(p); }
+inline void storeLanesF(float* p, lanes_f v) { vst1q_f32(p,v); }
+inline lanes_f setLanesF(float x) { return vdupq_n_f32(x); }
+inline lanes_f setLanesF(float x0, float x1, float x2, float x3)
+{
+	const float v[4]={x0,x1,x2,x3};
+	return vld1q_f32(v);
+}
+inline lanes_f addLanesF(lanes_f a, lanes_f b) { return vaddq_f32(a,b); }
+inline lanes_f mulLanesF(lanes_f a, lanes_f b) { return vmulq_f32(a,b); }
+inline lanes_f minLanesF(lanes_f a, lanes_f b) { return vminq_f32(a,b); }
+inline lanes_f maxLanesF(lanes_f a, lanes_f b) { return vmaxq_f32(a,b); }
+template<int n> inline lanes_f broadcastLane(lanes_f v) { return vdupq_n_f32(vgetq_lane_f32(v,n)); }
+#else
+struct lanes_i { int32_t v[4]; };
+struct lanes_f { float v[4]; };
+inline lanes_i unpackPixel(uint32_t p)
+{
+	lanes_i r;
+	for(int i=0;i<4;i++)
+		r.v[i]=(p>>(8*i))&0xff;
+	return r;
+}
+inline uint32_t packPixel(lanes_i v)
+{
+	uint32_t r=0;
+	for(int i=0;i<4;i++)
+		r|=uint32_t(imin(imax(v.v[i],0),255))<<(8*i);
+	return r;
+}
+inline lanes_i loadLanes(const int32_t* p) { lanes_i r; memcpy(r.v,p,sizeof(r.v)); return r; }
+inline void storeLanes(int32_t* p, lanes_i v) { memcpy(p,v.v,sizeof(v.v)); }
+inline lanes_i addLanes(lanes_i a, lanes_i b) { for(int i=0;i<4;i++) a.v[i]+=b.v[i]; return a; }
+inline lanes_i subLanes(lanes_i a, lanes_i b) { for(int i=0;i<4;i++) a.v[i]-=b.v[i]; return a; }
+inline lanes_i zeroLanes() { lanes_i r={{0,0,0,0}}; return r; }
+inline lanes_f toFloat(lanes_i v) { lanes_f r; for(int i=0;i<4;i++) r.v[i]=v.v[i]; return r; }
+inline lanes_i toInt(lanes_f v) { lanes_i r; for(int i=0;i<4;i++) r.v[i]=int32_t(v.v[i]); return r; }
+inline lanes_f loadLanesF(const float* p) { lanes_f r; memcpy(r.v,p,sizeof(r.v)); return r; }
+inline void storeLanesF(float* p, lanes_f v) { memcpy(p,v.v,sizeof(v.v)); }
+inline lanes_f setLanesF(float x) { lanes_f r={{x,x,x,x}}; return r; }
+inline lanes_f setLanesF(float x0, float x1, float x2, float x3) { lanes_f r={{x0,x1,x2,x3}}; return r; }
+inline lanes_f addLanesF(lanes_f a, lanes_f b) { for(int i=0;i<4;i++) a.v[i]+=b.v[i]; return a; }
+inline lanes_f mulLanesF(lanes_f a, lanes_f b) { for(int i=0;i<4;i++) a.v[i]*=b.v[i]; return a; }
+inline lanes_f minLanesF(lanes_f a, lanes_f b) { for(int i=0;i<4;i++) a.v[i]=a.v[i]<b.v[i]?a.v[i]:b.v[i]; return a; }
+inline lanes_f maxLanesF(lanes_f a, lanes_f b) { for(int i=0;i<4;i++) a.v[i]=a.v[i]>b.v[i]?a.v[i]:b.v[i]; return a; }
+template<int n> inline lanes_f broadcastLane(lanes_f v) { return setLanesF(v.v[n]); }
+#endif
+
+//Rounds and clamps the channels to the 0-255 range
+inline uint32_t packPixelF(lanes_f v)
+{
+	v=minLanesF(maxLanesF(v,setLanesF(0.0f)),setLanesF(255.0f));
+	return packPixel(toInt(addLanesF(v,setLanesF(0.5f))));
+}
+
+//Multiplies the color channels by alpha/255, alpha is lane 3
+inline lanes_f premultiply(lanes_f v)
+{
+	const lanes_f scale=setLanesF(1.0f/255.0f,1.0f/255.0f,1.0f/255.0f,0.0f);
+	const lanes_f unit=setLanesF(0.0f,0.0f,0.0f,1.0f);
+	return mulLanesF(v,addLanesF(mulLanesF(broadcastLane<3>(v),scale),unit));
+}
+
+inline lanes_f unpremultiply(uint32_t p)
+{
+	uint32_t a=p>>24;
+	if(a==0)
+		return setLanesF(0.0f);
+	float f=255.0f/a;
+	return mulLanesF(toFloat(unpackPixel(p)),setLanesF(f,f,f,1.0f));
+}
+
+//State shared by the caller of parallelFilterRange and its jobs
+struct filter_range
+{
+	const function<void(int32_t,int32_t)>* f;
+	int32_t count;
+	int32_t grain;
+	atomic<int32_t> next;
+	atomic<int32_t> done;
+	//The caller and the jobs that have not been fenced yet
+	atomic<uint32_t> refs;
+	Mutex mutex;
+	Cond finished;
+	filter_range(const function<void(int32_t,int32_t)>* _f, int32_t c, int32_t g, uint32_t r):f(_f),count(c),grain(g),next(0),done(0),refs(r){}
+	void run()
+	{
+		int32_t begin;
+		while((begin=next.fetch_add(grain))<count)
+		{
+			int32_t end=imin(begin+grain,count);
+			(*f)(begin,end);
+			if(done.fetch_add(end-begin)+(end-begin)==count)
+			{
+				Locker l(mutex);
+				finished.broadcast();
+			}
+		}
+	}
+	void wait()
+	{
+		Locker l(mutex);
+		while(done.load()<count)
+			finished.wait(mutex);
+	}
+	void release()
+	{
+		if(refs.fetch_sub(1)==1)
+			delete this;
+	}
+};
+
+class FilterRangeJob: public IThreadJob
+{
+private:
+	filter_range* range;
+public:
+	FilterRangeJob(filter_range* r):range(r)
+	{
+		jobPriority=THREAD_JOB_PRIORITY_HIGH;
+	}
+	void execute() override
+	{
+		range->run();
+	}
+	void jobFence() override
+	{
+		range->release();
+		delete this;
+	}
+};
+
+void blurRows(const uint32_t* src, uint32_t* dst, int32_t width, int32_t radius, int32_t begin, int32_t end)
+{
+	const lanes_f inv=setLanesF(1.0f/(2*radius+1));
+	const lanes_f half=setLanesF(0.5f);
+	for(int32_t y=begin;y<end;y++)
+	{
+		const uint32_t* in=src+y*width;
+		uint32_t* out=dst+y*width;
+		//Pixels outside of the row are transparent
+		lanes_i acc=zeroLanes();
+		for(int32_t x=0;x<radius && x<width;x++)
+			acc=addLanes(acc,unpackPixel(in[x]));
+		for(int32_t x=0;x<width;x++)
+		{
+			if(x+radius<width)
+				acc=addLanes(acc,unpackPixel(in[x+radius]));
+			if(x-radius-1>=0)
+				acc=subLanes(acc,unpackPixel(in[x-radius-1]));
+			out[x]=packPixel(toInt(addLanesF(mulLanesF(toFloat(acc),inv),half)));
+		}
+	}
+}
+
+inline void accumulateRow(int32_t* acc, const uint32_t* row, int32_t count, bool subtract)
+{
+	int32_t x=0;
+#if defined(__AVX2__)
+	for(;x+2<=count;x+=2)
+	{
+		__m256i a=_mm256_loadu_si256((const __m256i*)(acc+4*x));
+		__m256i p=_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(row+x)));
+		a=subtract ? _mm256_sub_epi32(a,p) : _mm256_add_epi32(a,p);
+		_mm256_storeu_si256((__m256i*)(acc+4*x),a);
+	}
+#endif
+	for(;x<count;x++)
+	{
+		lanes_i a=loadLanes(acc+4*x);
+		lanes_i p=unpackPixel(row[x]);
+		storeLanes(acc+4*x,subtract ? subLanes(a,p) : addLanes(a,p));
+	}
+}
+
+inline void storeAverageRow(uint32_t* row, const int32_t* acc, int32_t count, float inv)
+{
+	int32_t x=0;
+#if defined(__AVX2__)
+	const __m256 inv8=_mm256_set1_ps(inv);
+	const __m256 half8=_mm256_set1_ps(0.5f);
+	for(;x+2<=count;x+=2)
+	{
+		__m256 a=_mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*)(acc+4*x)));
+		__m256i v=_mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(a,inv8),half8));
+		v=_mm256_packs_epi32(v,v);
+		v=_mm256_packus_epi16(v,v);
+		row[x]=_mm_cvtsi128_si32(_mm256_castsi256_si128(v));
+		row[x+1]=_mm_cvtsi128_si32(_mm256_extracti128_si256(v,1));
+	}
+#endif
+	const lanes_f inv4=setLanesF(inv);
+	const lanes_f half=setLanesF(0.5f);
+	for(;x<count;x++)
+		row[x]=packPixel(toInt(addLanesF(mulLanesF(toFloat(loadLanes(acc+4*x)),inv4),half)));
+}
+
+//Blurs the columns [begin, end) a row at a time, so that memory is accessed sequentially
+void blurColumns(const uint32_t* src, uint32_t* dst, int32_t width, int32_t height, int32_t radius, int32_t begin, int32_t end)
+{
+	int32_t count=end-begin;
+	vector<int32_t> acc(4*count,0);
+	float inv=1.0f/(2*radius+1);
+	for(int32_t y=0;y<radius && y<height;y++)
+		accumulateRow(acc.data(),src+y*width+begin,count,false);
+	for(int32_t y=0;y<height;y++)
+	{
+		if(y+radius<height)
+			accumulateRow(acc.data(),src+(y+radius)*width+begin,count,false);
+		if(y-radius-1>=0)
+			accumulateRow(acc.data(),src+(y-radius-1)*width+begin,count,true);
+		storeAverageRow(dst+y*width+begin,acc.data(),count,inv);
+	}
+}
+
+int32_t blurRadius(number_t blur)
+{
+	if(!(blur>0))
+		return 0;
+	return imin(int32_t(blur/2),127);
+}
+
+}
+
+void lightspark::parallelFilterRange(SystemState* sys, int32_t count, const function<void(int32_t,int32_t)>& f, int32_t grain)
+{
+	static const int32_t cpus=imax(SDL_GetCPUCount(),1);
+	int32_t jobs=imin((count+grain-1)/grain,cpus)-1;
+	if(sys==nullptr || jobs<=0)
+	{
+		if(count>0)
+			f(0,count);
+		return;
+	}
+	filter_range* range=new filter_range(&f,count,grain,jobs+1);
+	for(int32_t i=0;i<jobs;i++)
+		sys->addJob(new FilterRangeJob(range));
+	//Jobs that don't get to run soon find nothing left to do
+	range->run();
+	range->wait();
+	range->release();
+}
+
+void lightspark::boxBlurFilter(SystemState* sys, uint32_t* pixels, int32_t width, int32_t height,
+			       number_t blurX, number_t blurY, int32_t passes)
+{
+	int32_t radiusX=blurRadius(blurX);
+	int32_t radiusY=blurRadius(blurY);
+	passes=imin(passes,FILTER_MAX_PASSES);
+	if(width<=0 || height<=0 || passes<=0 || (radiusX==0 && radiusY==0))
+		return;
+	vector<uint32_t> tmp(width*height);
+	for(int32_t i=0;i<passes;i++)
+	{
+		if(radiusX)
+		{
+			parallelFilterRange(sys,height,[&](int32_t begin, int32_t end)
+			{
+				blurRows(pixels,tmp.data(),width,radiusX,begin,end);
+			});
+		}
+		else
+			memcpy(tmp.data(),pixels,width*height*4);
+		if(radiusY)
+		{
+			parallelFilterRange(sys,width,[&](int32_t begin, int32_t end)
+			{
+				blurColumns(tmp.data(),pixels,width,height,radiusY,begin,end);
+			});
+		}
+		else
+			memcpy(pixels,tmp.data(),width*height*4);
+	}
+}
+
+void lightspark::colorMatrixFilter(SystemState* sys, uint32_t* pixels, int32_t width, int32_t height, const float* matrix)
+{
+	//Lane n holds the channel at byte n, the matrix rows and columns are red, green, blue, alpha
+	static const int channel[4]={2,1,0,3};
+	float columns[5][4];
+	for(int lane=0;lane<4;lane++)
+	{
+		for(int c=0;c<5;c++)
+			columns[c][lane]=matrix[channel[lane]*5+c];
+	}
+	lanes_f col[4];
+	for(int lane=0;lane<4;lane++)
+		col[lane]=loadLanesF(columns[channel[lane]]);
+	lanes_f offset=loadLanesF(columns[4]);
+	parallelFilterRange(sys,height,[&](int32_t begin, int32_t end)
+	{
+		for(int32_t i=begin*width;i<end*width;i++)
+		{
+			lanes_f v=unpremultiply(pixels[i]);
+			lanes_f r=addLanesF(offset,mulLanesF(col[0],broadcastLane<0>(v)));
+			r=addLanesF(r,mulLanesF(col[1],broadcastLane<1>(v)));
+			r=addLanesF(r,mulLanesF(col[2],broadcastLane<2>(v)));
+			r=addLanesF(r,mulLanesF(col[3],broadcastLane<3>(v)));
+			r=minLanesF(maxLanesF(r,setLanesF(0.0f)),setLanesF(255.0f));
+			pixels[i]=packPixelF(premultiply(r));
+		}
+	});
+}
+
+void lightspark::convolutionFilter(SystemState* sys, uint32_t* pixels, int32_t width, int32_t height,
+				   const float* matrix, int32_t matrixX, int32_t matrixY,
+				   float divisor, float bias, bool preserveAlpha, bool clamp, uint32_t color)
+{
+	if(width<=0 || height<=0 || matrixX<=0 || matrixY<=0)
+		return;
+	//Unpremultiplied copy of the pixels, with a border for the pixels around the edges
+	int32_t left=matrixX/2;
+	int32_t top=matrixY/2;
+	int32_t paddedWidth=width+matrixX-1;
+	int32_t paddedHeight=height+matrixY-1;
+	vector<float> padded(4*paddedWidth*paddedHeight);
+	lanes_f border=toFloat(unpackPixel(color));
+	parallelFilterRange(sys,paddedHeight,[&](int32_t begin, int32_t end)
+	{
+		for(int32_t y=begin;y<end;y++)
+		{
+			int32_t sy=y-top;
+			for(int32_t x=0;x<paddedWidth;x++)
+			{
+				int32_t sx=x-left;
+				lanes_f v;
+				if(sx>=0 && sx<width && sy>=0 && sy<height)
+					v=unpremultiply(pixels[sy*width+sx]);
+				else if(clamp)
+					v=unpremultiply(pixels[imin(imax(sy,0),height-1)*width+imin(imax(sx,0),width-1)]);
+				else
+					v=border;
+				storeLanesF(&padded[4*(y*paddedWidth+x)],v);
+			}
+		}
+	});
+	vector<int32_t> taps;
+	for(int32_t i=0;i<matrixX*matrixY;i++)
+	{
+		if(matrix[i]!=0)
+			taps.push_back(i);
+	}
+	const lanes_f inv=setLanesF(divisor!=0 ? 1.0f/divisor : 1.0f);
+	const lanes_f offset=setLanesF(bias);
+	parallelFilterRange(sys,height,[&](int32_t begin, int32_t end)
+	{
+		for(int32_t y=begin;y<end;y++)
+		{
+			for(int32_t x=0;x<width;x++)
+			{
+				lanes_f acc=setLanesF(0.0f);
+				for(auto it=taps.begin();it!=taps.end();++it)
+				{
+					int32_t kx=(*it)%matrixX;
+					int32_t ky=(*it)/matrixX;
+					const float* p=&padded[4*((y+ky)*paddedWidth+x+kx)];
+					acc=addLanesF(acc,mulLanesF(setLanesF(matrix[*it]),loadLanesF(p)));
+				}
+				acc=addLanesF(mulLanesF(acc,inv),offset);
+				uint32_t& dst=pixels[y*width+x];
+				if(preserveAlpha)
+				{
+					float a=dst>>24;
+					float c[4];
+					storeLanesF(c,acc);
+					acc=setLanesF(c[0],c[1],c[2],a);
+				}
+				acc=minLanesF(maxLanesF(acc,setLanesF(0.0f)),setLanesF(255.0f));
+				dst=packPixelF(premultiply(acc));
+			}
+		}
+	});
+}
+
+void lightspark::dropShadowFilter(SystemState* sys, uint32_t* pixels, int32_t width, int32_t height,
+				  uint32_t color, number_t alpha, number_t blurX, number_t blurY,
+				  number_t strength, int32_t passes, int32_t offsetX, int32_t offsetY,
+				  bool inner, bool knockout, bool hideObject)
+{
+	if(width<=0 || height<=0)
+		return;
+	//The shadow is built in the alpha channel only, the other channels stay 0
+	vector<uint32_t> shadow(width*height);
+	parallelFilterRange(sys,height,[&](int32_t begin, int32_t end)
+	{
+		for(int32_t y=begin;y<end;y++)
+		{
+			int32_t sy=y-offsetY;
+			for(int32_t x=0;x<width;x++)
+			{
+				int32_t sx=x-offsetX;
+				uint32_t a=0;
+				if(sx>=0 && sx<width && sy>=0 && sy<height)
+					a=pixels[sy*width+sx]>>24;
+				//Inner shadows are cast by the transparent area around the object
+				if(inner)
+					a=255-a;
+				shadow[y*width+x]=a<<24;
+			}
+		}
+	});
+	boxBlurFilter(sys,shadow.data(),width,height,blurX,blurY,passes);
+	float maxAlpha=float(dmin(dmax(alpha,0.0),1.0));
+	float shadowScale=float(strength)*maxAlpha/255.0f;
+	const lanes_f shadowColor=setLanesF((color&0xff)/255.0f,((color>>8)&0xff)/255.0f,((color>>16)&0xff)/255.0f,1.0f);
+	parallelFilterRange(sys,height,[&](int32_t begin, int32_t end)
+	{
+		for(int32_t i=begin*width;i<end*width;i++)
+		{
+			float srcAlpha=(pixels[i]>>24)/255.0f;
+			//strength saturates the shadow before alpha is applied
+			float a=(shadow[i]>>24)*shadowScale;
+			if(a>maxAlpha)
+				a=maxAlpha;
+			float srcFactor;
+			float shadowFactor;
+			if(inner)
+			{
+				//The shadow is drawn atop the object
+				srcFactor=(knockout || hideObject) ? 0.0f : 1.0f-a;
+				shadowFactor=srcAlpha;
+			}
+			else
+			{
+				srcFactor=(knockout || hideObject) ? 0.0f : 1.0f;
+				shadowFactor=hideObject ? 1.0f : 1.0f-srcAlpha;
+			}
+			lanes_f s=mulLanesF(shadowColor,setLanesF(255.0f*a*shadowFactor));
+			lanes_f p=mulLanesF(toFloat(unpackPixel(pixels[i])),setLanesF(srcFactor));
+			pixels[i]=packPixelF(addLanesF(p,s));
+		}
+	});
+}
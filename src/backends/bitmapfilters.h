@@ -0,0 +1,86 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef BACKENDS_BITMAPFILTERS_H
+#define BACKENDS_BITMAPFILTERS_H 1
+
+#include "compat.h"
+#include "swftypes.h"
+#include <functional>
+
+namespace lightspark
+{
+
+class SystemState;
+
+//Number of rows (or columns) a job of a parallel filter pass works on at a time
+#define FILTER_RANGE_GRAIN 32
+//Highest number of box blur passes, BitmapFilterQuality.HIGH is 3
+#define FILTER_MAX_PASSES 15
+
+/*
+ * Pixel kernels of the flash.filters classes.
+ * All of them work in place on tightly packed buffers of premultiplied,
+ * native-endian 32 bit ARGB pixels (the format of BitmapContainer).
+ * The inner loops use SSE2 or NEON when the compiler targets them, AVX2
+ * is used as well for the vertical blur pass when enabled at build time,
+ * and plain C++ otherwise.
+ * If sys is not NULL the work is split across the thread pool.
+ */
+
+/*
+ * Calls f on consecutive subranges of [0, count), at most grain long. The
+ * calling thread works on the subranges too and returns when all of them
+ * are done.
+ */
+DLL_PUBLIC void parallelFilterRange(SystemState* sys, int32_t count, const std::function<void(int32_t,int32_t)>& f,
+			 int32_t grain=FILTER_RANGE_GRAIN);
+
+//Separable box blur, repeated passes times (3 passes look like a gaussian blur)
+DLL_PUBLIC void boxBlurFilter(SystemState* sys, uint32_t* pixels, int32_t width, int32_t height,
+		   number_t blurX, number_t blurY, int32_t passes);
+
+/*
+ * Applies a flash ColorMatrixFilter matrix: 4 rows of 5 elements,
+ * for red, green, blue and alpha. The matrix works on unpremultiplied
+ * values, the offsets are in the 0-255 range.
+ */
+DLL_PUBLIC void colorMatrixFilter(SystemState* sys, uint32_t* pixels, int32_t width, int32_t height, const float* matrix);
+
+/*
+ * Applies a matrixX*matrixY convolution matrix, centered on each pixel.
+ * Pixels outside of the buffer are the nearest edge pixel if clamp is set,
+ * color (unpremultiplied ARGB) otherwise.
+ */
+DLL_PUBLIC void convolutionFilter(SystemState* sys, uint32_t* pixels, int32_t width, int32_t height,
+		       const float* matrix, int32_t matrixX, int32_t matrixY,
+		       float divisor, float bias, bool preserveAlpha, bool clamp, uint32_t color);
+
+/*
+ * Shadow of the alpha channel of the pixels, displaced by (offsetX,offsetY),
+ * blurred and colored with color (RGB). Used for both DropShadowFilter and
+ * GlowFilter.
+ */
+DLL_PUBLIC void dropShadowFilter(SystemState* sys, uint32_t* pixels, int32_t width, int32_t height,
+		      uint32_t color, number_t alpha, number_t blurX, number_t blurY,
+		      number_t strength, int32_t passes, int32_t offsetX, int32_t offsetY,
+		      bool inner, bool knockout, bool hideObject);
+
+};
+#endif /* BACKENDS_BITMAPFILTERS_H */
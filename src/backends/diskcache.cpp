@@ -0,0 +1,236 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <cstring>
+#include "backends/diskcache.h"
+#include "backends/config.h"
+#include "logger.h"
+#include "version.h"
+
+using namespace std;
+using namespace lightspark;
+
+bool DiskCache::enabled=true;
+uint64_t DiskCache::maxSize=32*1024*1024;
+
+namespace
+{
+
+//Magic bytes at the start of every entry
+const char DISK_CACHE_MAGIC[4]={'L','S','D','C'};
+//Length of the names of the entries, see DiskCache::getKey
+const size_t DISK_CACHE_KEY_LENGTH=32;
+
+struct CacheEntryInfo
+{
+	std::string name;
+	time_t lastUse;
+	uint64_t size;
+	bool operator<(const CacheEntryInfo& r) const { return lastUse<r.lastUse; }
+};
+
+//Temporary files of entries being written have longer names and are skipped
+bool isEntryName(const char* name)
+{
+	if(strlen(name)!=DISK_CACHE_KEY_LENGTH)
+		return false;
+	for(size_t i=0;i<DISK_CACHE_KEY_LENGTH;i++)
+	{
+		if(!g_ascii_isxdigit(name[i]))
+			return false;
+	}
+	return true;
+}
+
+//64 bit FNV-1a
+uint64_t fnvHash(uint64_t h, const uint8_t* p, size_t len)
+{
+	for(size_t i=0;i<len;i++)
+		h=(h^p[i])*0x100000001b3ULL;
+	return h;
+}
+
+void appendUInt(vector<uint8_t>& out, uint64_t v, uint32_t bytes)
+{
+	for(uint32_t i=0;i<bytes;i++)
+		out.push_back((v>>(i*8))&0xff);
+}
+
+uint64_t readUInt(const uint8_t* p, uint32_t bytes)
+{
+	uint64_t ret=0;
+	for(uint32_t i=0;i<bytes;i++)
+		ret|=uint64_t(p[i])<<(i*8);
+	return ret;
+}
+
+/*
+ * Header of the entries: magic, format version, length and bytes of the
+ * lightspark version, payload length and hash
+ */
+void buildHeader(vector<uint8_t>& out, uint32_t formatVersion, const vector<uint8_t>& payload)
+{
+	out.insert(out.end(),DISK_CACHE_MAGIC,DISK_CACHE_MAGIC+4);
+	appendUInt(out,formatVersion,4);
+	const uint32_t versionLength=strlen(VERSION);
+	appendUInt(out,versionLength,4);
+	out.insert(out.end(),(const uint8_t*)VERSION,(const uint8_t*)VERSION+versionLength);
+	appendUInt(out,payload.size(),4);
+	appendUInt(out,fnvHash(0xcbf29ce484222325ULL,payload.data(),payload.size()),8);
+}
+
+}
+
+DiskCache::DiskCache(const char* name, uint32_t version):formatVersion(version),valid(false),usedSize(0),usedSizeKnown(false)
+{
+	if(!enabled)
+		return;
+	directory=Config::getConfig()->getCacheDirectory()+G_DIR_SEPARATOR_S+name;
+	if(g_mkdir_with_parents(directory.c_str(),S_IRUSR | S_IWUSR | S_IXUSR))
+	{
+		LOG(LOG_INFO,"DiskCache: could not create "<<directory);
+		return;
+	}
+	valid=true;
+}
+
+string DiskCache::getPath(const string& key) const
+{
+	return directory+G_DIR_SEPARATOR_S+key;
+}
+
+string DiskCache::getKey(const uint8_t* data, uint32_t len, uint32_t variant)
+{
+	//Two hashes with different seeds make collisions of different bytecode unlikely
+	uint64_t h[2]={0xcbf29ce484222325ULL,0x84222325cbf29ce4ULL};
+	char ret[40];
+	for(uint32_t i=0;i<2;i++)
+	{
+		h[i]=fnvHash(h[i],(const uint8_t*)&variant,sizeof(variant));
+		h[i]=fnvHash(h[i],(const uint8_t*)&len,sizeof(len));
+		h[i]=fnvHash(h[i],data,len);
+	}
+	snprintf(ret,sizeof(ret),"%016llx%016llx",(unsigned long long)h[0],(unsigned long long)h[1]);
+	return ret;
+}
+
+bool DiskCache::load(const string& key, vector<uint8_t>& out) const
+{
+	if(!enabled || !valid)
+		return false;
+	gchar* contents=NULL;
+	gsize length=0;
+	if(!g_file_get_contents(getPath(key).c_str(),&contents,&length,NULL))
+		return false;
+	bool ret=false;
+	vector<uint8_t> header;
+	//The expected header is built with an empty payload, the payload fields are checked afterwards
+	buildHeader(header,formatVersion,vector<uint8_t>());
+	const uint32_t headerLength=header.size();
+	const uint8_t* p=(const uint8_t*)contents;
+	if(length>=headerLength && memcmp(p,header.data(),headerLength-12)==0)
+	{
+		const uint32_t payloadLength=readUInt(p+headerLength-12,4);
+		const uint64_t payloadHash=readUInt(p+headerLength-8,8);
+		if(length==headerLength+payloadLength &&
+			fnvHash(0xcbf29ce484222325ULL,p+headerLength,payloadLength)==payloadHash)
+		{
+			out.assign(p+headerLength,p+length);
+			ret=true;
+			//Mark the entry as recently used for evict
+			g_utime(getPath(key).c_str(),NULL);
+		}
+	}
+	if(!ret)
+		LOG(LOG_INFO,"DiskCache: ignoring stale entry "<<key);
+	g_free(contents);
+	return ret;
+}
+
+void DiskCache::store(const string& key, const vector<uint8_t>& data)
+{
+	if(!enabled || !valid)
+		return;
+	vector<uint8_t> entry;
+	buildHeader(entry,formatVersion,data);
+	entry.insert(entry.end(),data.begin(),data.end());
+	if(entry.size()>maxSize)
+		return;
+	//The entry is written to a temporary file and renamed, readers never see partial entries
+	if(!g_file_set_contents(getPath(key).c_str(),(const gchar*)entry.data(),entry.size(),NULL))
+	{
+		LOG(LOG_INFO,"DiskCache: could not write "<<getPath(key));
+		return;
+	}
+	Locker l(sizeMutex);
+	if(!usedSizeKnown)
+	{
+		//The first store computes the size of the directory
+		evict(maxSize);
+	}
+	else
+	{
+		usedSize+=entry.size();
+		//Leave some room, so that not every store has to scan the directory
+		if(usedSize>maxSize)
+			evict(maxSize/4*3);
+	}
+}
+
+void DiskCache::evict(uint64_t target)
+{
+	GDir* dir=g_dir_open(directory.c_str(),0,NULL);
+	if(dir==NULL)
+		return;
+	vector<CacheEntryInfo> entries;
+	uint64_t total=0;
+	const gchar* name;
+	while((name=g_dir_read_name(dir))!=NULL)
+	{
+		if(!isEntryName(name))
+			continue;
+		GStatBuf st;
+		if(g_stat(getPath(name).c_str(),&st)!=0)
+			continue;
+		CacheEntryInfo info;
+		info.name=name;
+		info.lastUse=st.st_mtime;
+		info.size=st.st_size;
+		entries.push_back(info);
+		total+=info.size;
+	}
+	g_dir_close(dir);
+	if(total>target)
+	{
+		sort(entries.begin(),entries.end());
+		for(auto it=entries.begin();it!=entries.end() && total>target;++it)
+		{
+			//Another instance may have removed it already
+			if(g_unlink(getPath(it->name).c_str())==0)
+				total-=it->size;
+		}
+		LOG(LOG_INFO,"DiskCache: evicted entries from "<<directory);
+	}
+	usedSize=total;
+	usedSizeKnown=true;
+}
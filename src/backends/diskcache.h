@@ -0,0 +1,132 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef BACKENDS_DISKCACHE_H
+#define BACKENDS_DISKCACHE_H 1
+
+#include "compat.h"
+#include "threading.h"
+#include "tiny_string.h"
+#include <string>
+#include <vector>
+
+namespace lightspark
+{
+
+/*
+ * Content addressed cache of data derived from the movies, like the
+ * translated shaders ("agal") or the analysis of the ActionScript methods
+ * ("abc"), kept across runs in the cache directory of Config.
+ * Every kind of data has its own subdirectory, entries are named by a
+ * 128 bit hash of the data they are derived from.
+ * An entry is only used if it was written by the same lightspark version
+ * with the same format version of its kind, so changing what is stored
+ * only needs a new format version. Entries are written atomically, many
+ * instances may share the directory.
+ * Loading an entry updates its modification time, when a subdirectory
+ * grows beyond maxSize the entries that were not used for the longest
+ * time are removed.
+ */
+class DLL_PUBLIC DiskCache
+{
+private:
+	std::string directory;
+	uint32_t formatVersion;
+	bool valid;
+	Mutex sizeMutex;
+	//Bytes taken by the entries, as far as this process knows. Other
+	//instances may write to the same directory, so it is recomputed by evict
+	uint64_t usedSize;
+	bool usedSizeKnown;
+	std::string getPath(const std::string& key) const;
+	//Removes the least recently used entries until at most target bytes are left
+	void evict(uint64_t target);
+public:
+	//Set to false to neither read nor write any entry (--disable-disk-cache)
+	static bool enabled;
+	//Bytes every kind of data may take in the cache directory (--disk-cache-size)
+	static uint64_t maxSize;
+	DiskCache(const char* name, uint32_t version);
+	/*
+	 * Name of the entry derived from len bytes of data, variant tells
+	 * apart different results derived from the same data
+	 */
+	static std::string getKey(const uint8_t* data, uint32_t len, uint32_t variant);
+	bool load(const std::string& key, std::vector<uint8_t>& out) const;
+	void store(const std::string& key, const std::vector<uint8_t>& data);
+};
+
+//Little endian encoding of the cached entries
+class DiskCacheWriter
+{
+private:
+	std::vector<uint8_t> data;
+public:
+	void writeUInt(uint32_t v)
+	{
+		for(uint32_t i=0;i<4;i++)
+			data.push_back((v>>(i*8))&0xff);
+	}
+	void writeString(const tiny_string& s)
+	{
+		writeUInt(s.numBytes());
+		data.insert(data.end(),(const uint8_t*)s.raw_buf(),(const uint8_t*)s.raw_buf()+s.numBytes());
+	}
+	const std::vector<uint8_t>& getData() const { return data; }
+};
+
+class DiskCacheReader
+{
+private:
+	const std::vector<uint8_t>& data;
+	uint32_t position;
+	bool failed;
+public:
+	DiskCacheReader(const std::vector<uint8_t>& d):data(d),position(0),failed(false) {}
+	uint32_t readUInt()
+	{
+		if(position+4>data.size())
+		{
+			failed=true;
+			return 0;
+		}
+		uint32_t ret=0;
+		for(uint32_t i=0;i<4;i++)
+			ret|=uint32_t(data[position++])<<(i*8);
+		return ret;
+	}
+	tiny_string readString()
+	{
+		const uint32_t len=readUInt();
+		if(failed || position+len>data.size())
+		{
+			failed=true;
+			return "";
+		}
+		tiny_string ret(std::string((const char*)data.data()+position,len));
+		position+=len;
+		return ret;
+	}
+	bool hasFailed() const { return failed; }
+	//True if all the reads were in bounds and the whole entry was read
+	bool isValid() const { return !failed && position==data.size(); }
+};
+
+};
+#endif /* BACKENDS_DISKCACHE_H */
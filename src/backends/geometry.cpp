@@ -19,6 +19,7 @@
 
 #include <fstream>
 #include <cmath>
+#include <limits>
 #include <algorithm>
 #include "swftypes.h"
 #include "logger.h"
@@ -254,26 +255,26 @@ void ShapesBuilder::outputTokens(const std::list<FILLSTYLE>& styles,const std::l
 			assert(stylesIt!=styles.end());
 		}
 		//Set the fill style
-		tokens.filltokens.emplace_back(_MR(new GeomToken(SET_FILL,*stylesIt)));
+		tokens.setFill(tokens.filltokens,*stylesIt);
 		vector<vector<ShapePathSegment> >& outlinesForColor=it->second;
 		for(unsigned int i=0;i<outlinesForColor.size();i++)
 		{
 			vector<ShapePathSegment>& segments=outlinesForColor[i];
 			assert (segments[0].type == PATH_START);
-			tokens.filltokens.push_back(_MR(new GeomToken(MOVE, getVertex(segments[0].i))));
+			tokens.filltokens.moveTo(getVertex(segments[0].i));
 			for(unsigned int j=1;j<segments.size();j++) {
 				ShapePathSegment segment = segments[j];
 				assert(segment.type != PATH_START);
 				if (segment.type == PATH_STRAIGHT)
-					tokens.filltokens.push_back(_MR(new GeomToken(STRAIGHT, getVertex(segment.i))));
+					tokens.filltokens.lineTo(getVertex(segment.i));
 				if (segment.type == PATH_CURVE_QUADRATIC)
-					tokens.filltokens.push_back(_MR(new GeomToken(CURVE_QUADRATIC, getVertex(segment.i), getVertex(segments[++j].i))));
+					tokens.filltokens.curveTo(getVertex(segment.i), getVertex(segments[++j].i));
 			}
 		}
 	}
 	if (strokeShapesMap.size() > 0)
 	{
-		tokens.stroketokens.emplace_back(_MR(new GeomToken(CLEAR_FILL)));
+		tokens.stroketokens.command(CLEAR_FILL);
 		it=strokeShapesMap.begin();
 		//For each stroke
 		for(;it!=strokeShapesMap.end();++it)
@@ -289,19 +290,19 @@ void ShapesBuilder::outputTokens(const std::list<FILLSTYLE>& styles,const std::l
 			}
 			//Set the line style
 			vector<vector<ShapePathSegment> >& outlinesForStroke=it->second;
-			tokens.stroketokens.emplace_back(_MR(new GeomToken(SET_STROKE,*stylesIt)));
+			tokens.setStroke(tokens.stroketokens,*stylesIt);
 			for(unsigned int i=0;i<outlinesForStroke.size();i++)
 			{
 				vector<ShapePathSegment>& segments=outlinesForStroke[i];
 				assert (segments[0].type == PATH_START);
-				tokens.stroketokens.push_back(_MR(new GeomToken(MOVE, getVertex(segments[0].i))));
+				tokens.stroketokens.moveTo(getVertex(segments[0].i));
 				for(unsigned int j=1;j<segments.size();j++) {
 					ShapePathSegment segment = segments[j];
 					assert(segment.type != PATH_START);
 					if (segment.type == PATH_STRAIGHT)
-						tokens.stroketokens.push_back(_MR(new GeomToken(STRAIGHT, getVertex(segment.i))));
+						tokens.stroketokens.lineTo(getVertex(segment.i));
 					if (segment.type == PATH_CURVE_QUADRATIC)
-						tokens.stroketokens.push_back(_MR(new GeomToken(CURVE_QUADRATIC, getVertex(segment.i), getVertex(segments[++j].i))));
+						tokens.stroketokens.curveTo(getVertex(segment.i), getVertex(segments[++j].i));
 				}
 			}
 		}
@@ -388,26 +389,26 @@ void ShapesBuilder::outputMorphTokens(const std::list<MORPHFILLSTYLE> &styles, c
 				LOG(LOG_NOT_IMPLEMENTED,"morphing for fill style type:"<<stylesIt->FillStyleType);
 				break;
 		}
-		tokens.filltokens.emplace_back(_MR(new GeomToken(SET_FILL,f)));
+		tokens.setFill(tokens.filltokens,f);
 		vector<vector<ShapePathSegment> >& outlinesForColor=it->second;
 		for(unsigned int i=0;i<outlinesForColor.size();i++)
 		{
 			vector<ShapePathSegment>& segments=outlinesForColor[i];
 			assert (segments[0].type == PATH_START);
-			tokens.filltokens.push_back(_MR(new GeomToken(MOVE, getVertex(segments[0].i))));
+			tokens.filltokens.moveTo(getVertex(segments[0].i));
 			for(unsigned int j=1;j<segments.size();j++) {
 				ShapePathSegment segment = segments[j];
 				assert(segment.type != PATH_START);
 				if (segment.type == PATH_STRAIGHT)
-					tokens.filltokens.push_back(_MR(new GeomToken(STRAIGHT, getVertex(segment.i))));
+					tokens.filltokens.lineTo(getVertex(segment.i));
 				if (segment.type == PATH_CURVE_QUADRATIC)
-					tokens.filltokens.push_back(_MR(new GeomToken(CURVE_QUADRATIC, getVertex(segment.i), getVertex(segments[++j].i))));
+					tokens.filltokens.curveTo(getVertex(segment.i), getVertex(segments[++j].i));
 			}
 		}
 	}
 	if (strokeShapesMap.size() > 0)
 	{
-		tokens.stroketokens.emplace_back(_MR(new GeomToken(CLEAR_FILL)));
+		tokens.stroketokens.command(CLEAR_FILL);
 		it=strokeShapesMap.begin();
 		//For each stroke
 		for(;it!=strokeShapesMap.end();++it)
@@ -424,19 +425,19 @@ void ShapesBuilder::outputMorphTokens(const std::list<MORPHFILLSTYLE> &styles, c
 			//Set the line style
 			LOG(LOG_NOT_IMPLEMENTED,"morphing for line styles");
 			vector<vector<ShapePathSegment> >& outlinesForStroke=it->second;
-			tokens.stroketokens.emplace_back(_MR(new GeomToken(SET_STROKE,*stylesIt)));
+			tokens.setStroke(tokens.stroketokens,LINESTYLE2(0xff));
 			for(unsigned int i=0;i<outlinesForStroke.size();i++)
 			{
 				vector<ShapePathSegment>& segments=outlinesForStroke[i];
 				assert (segments[0].type == PATH_START);
-				tokens.stroketokens.push_back(_MR(new GeomToken(MOVE, getVertex(segments[0].i))));
+				tokens.stroketokens.moveTo(getVertex(segments[0].i));
 				for(unsigned int j=1;j<segments.size();j++) {
 					ShapePathSegment segment = segments[j];
 					assert(segment.type != PATH_START);
 					if (segment.type == PATH_STRAIGHT)
-						tokens.stroketokens.push_back(_MR(new GeomToken(STRAIGHT, getVertex(segment.i))));
+						tokens.stroketokens.lineTo(getVertex(segment.i));
 					if (segment.type == PATH_CURVE_QUADRATIC)
-						tokens.stroketokens.push_back(_MR(new GeomToken(CURVE_QUADRATIC, getVertex(segment.i), getVertex(segments[++j].i))));
+						tokens.stroketokens.curveTo(getVertex(segment.i), getVertex(segments[++j].i));
 				}
 			}
 		}
@@ -445,7 +446,158 @@ void ShapesBuilder::outputMorphTokens(const std::list<MORPHFILLSTYLE> &styles, c
 }
 
 
-GeomToken::GeomToken(GEOM_TOKEN_TYPE _t, const MORPHLINESTYLE2& _s):fillStyle(0xff),lineStyle(0xff),type(_t),p1(0,0),p2(0,0),p3(0,0)
+void FlattenedPath::moveTo(const Vector2f& p)
 {
-	
+	closePolygon();
+	points.push_back(p);
+}
+
+void FlattenedPath::lineTo(const Vector2f& p)
+{
+	uint32_t start=polygonEnds.empty() ? 0 : polygonEnds.back();
+	//Like cairo, a line without a current point only moves to its end
+	if(points.size()==start)
+		moveTo(p);
+	else
+		points.push_back(p);
+}
+
+void FlattenedPath::cubicTo(const Vector2f& c1, const Vector2f& c2, const Vector2f& end)
+{
+	uint32_t start=polygonEnds.empty() ? 0 : polygonEnds.back();
+	if(points.size()==start)
+		moveTo(c1);
+	const Vector2f p0=points.back();
+	//The length of the control polygon is an upper bound of the length of the curve
+	number_t length=hypot(c1.x-p0.x,c1.y-p0.y)+hypot(c2.x-c1.x,c2.y-c1.y)+hypot(end.x-c2.x,end.y-c2.y);
+	int32_t count=ceil(length/FLATTEN_SEGMENT_LENGTH);
+	count=max(1,min(count,FLATTEN_MAX_SEGMENTS));
+	for(int32_t i=1;i<count;i++)
+	{
+		number_t t=number_t(i)/count;
+		number_t u=1-t;
+		number_t a=u*u*u;
+		number_t b=3*u*u*t;
+		number_t c=3*u*t*t;
+		number_t d=t*t*t;
+		points.emplace_back(a*p0.x+b*c1.x+c*c2.x+d*end.x,
+				    a*p0.y+b*c1.y+c*c2.y+d*end.y);
+	}
+	points.push_back(end);
+}
+
+void FlattenedPath::closePolygon()
+{
+	uint32_t start=polygonEnds.empty() ? 0 : polygonEnds.back();
+	//Polygons with less than 3 points cover no area
+	if(points.size()-start<3)
+		points.resize(start);
+	else
+		polygonEnds.push_back(points.size());
+}
+
+void FlattenedPath::update(const tokensVector& tokens, float scaleFactor)
+{
+	if(valid && fillVersion==tokens.filltokens.getVersion() &&
+	   strokeVersion==tokens.stroketokens.getVersion() && scaling==scaleFactor)
+		return;
+	fillVersion=tokens.filltokens.getVersion();
+	strokeVersion=tokens.stroketokens.getVersion();
+	scaling=scaleFactor;
+	valid=true;
+	points.clear();
+	polygonEnds.clear();
+
+	//Same path as CairoTokenRenderer::cairoPathFromTokens builds for the fill:
+	//the segments between SET_STROKE and CLEAR_STROKE are only stroked
+	bool instroke=false;
+	const GeomTokenList* lists[2]={&tokens.filltokens,&tokens.stroketokens};
+	for(const GeomTokenList* list: lists)
+	{
+		const uint32_t count=list->size();
+		for(uint32_t i=0;i<count;i++)
+		{
+			const GeomToken& cmd=(*list)[i];
+			const GeomToken* p=&cmd+1;
+			switch(cmd.cmd.type)
+			{
+				case MOVE:
+					if(!instroke)
+						moveTo(Vector2f(p[0].vec.x*scaling,p[0].vec.y*scaling));
+					i++;
+					break;
+				case STRAIGHT:
+					if(!instroke)
+						lineTo(Vector2f(p[0].vec.x*scaling,p[0].vec.y*scaling));
+					i++;
+					break;
+				case CURVE_QUADRATIC:
+					if(!instroke)
+					{
+						uint32_t start=polygonEnds.empty() ? 0 : polygonEnds.back();
+						//Elevated to a cubic from the current point, (0,0) if there is none
+						Vector2f p0=points.size()==start ? Vector2f() : points.back();
+						Vector2f control(p[0].vec.x*scaling,p[0].vec.y*scaling);
+						Vector2f end(p[1].vec.x*scaling,p[1].vec.y*scaling);
+						cubicTo(Vector2f(control.x*(2.0/3.0)+p0.x*(1.0/3.0),control.y*(2.0/3.0)+p0.y*(1.0/3.0)),
+							Vector2f(control.x*(2.0/3.0)+end.x*(1.0/3.0),control.y*(2.0/3.0)+end.y*(1.0/3.0)),
+							end);
+					}
+					i+=2;
+					break;
+				case CURVE_CUBIC:
+					if(!instroke)
+						cubicTo(Vector2f(p[0].vec.x*scaling,p[0].vec.y*scaling),
+							Vector2f(p[1].vec.x*scaling,p[1].vec.y*scaling),
+							Vector2f(p[2].vec.x*scaling,p[2].vec.y*scaling));
+					i+=3;
+					break;
+				case SET_STROKE:
+					instroke=true;
+					break;
+				case CLEAR_STROKE:
+					instroke=false;
+					break;
+				default:
+					break;
+			}
+		}
+	}
+	closePolygon();
+
+	xmin=ymin=numeric_limits<number_t>::infinity();
+	xmax=ymax=-numeric_limits<number_t>::infinity();
+	for(const Vector2f& v: points)
+	{
+		xmin=min(xmin,v.x);
+		xmax=max(xmax,v.x);
+		ymin=min(ymin,v.y);
+		ymax=max(ymax,v.y);
+	}
+}
+
+bool FlattenedPath::contains(number_t x, number_t y) const
+{
+	if(points.empty() || x<xmin || x>xmax || y<ymin || y>ymax)
+		return false;
+	int32_t winding=0;
+	uint32_t start=0;
+	for(uint32_t end: polygonEnds)
+	{
+		for(uint32_t i=start;i<end;i++)
+		{
+			const Vector2f& a=points[i];
+			const Vector2f& b=points[i+1<end ? i+1 : start];
+			number_t side=(b.x-a.x)*(y-a.y)-(x-a.x)*(b.y-a.y);
+			if(a.y<=y)
+			{
+				if(b.y>y && side>0)
+					winding++;
+			}
+			else if(b.y<=y && side<0)
+				winding--;
+		}
+		start=end;
+	}
+	return winding!=0;
 }
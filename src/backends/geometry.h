@@ -65,36 +65,151 @@ public:
 
 enum GEOM_TOKEN_TYPE { STRAIGHT=0, CURVE_QUADRATIC, MOVE, SET_FILL, SET_STROKE, CLEAR_FILL, CLEAR_STROKE, CURVE_CUBIC, FILL_KEEP_SOURCE, FILL_TRANSFORM_TEXTURE };
 
-class GeomToken :public RefCountable
+/*
+ * Element of a GeomTokenList. A command token holds the type and, for
+ * SET_FILL, SET_STROKE and FILL_TRANSFORM_TEXTURE, the index of its style in
+ * the tables of the tokensVector. The points of the command follow it, one
+ * token each.
+ */
+union GeomToken
 {
+	struct
+	{
+		GEOM_TOKEN_TYPE type;
+		uint32_t index;
+	} cmd;
+	struct
+	{
+		int32_t x;
+		int32_t y;
+	} vec;
+	GeomToken(GEOM_TOKEN_TYPE t, uint32_t i) { cmd.type=t; cmd.index=i; }
+	GeomToken(const Vector2& p) { vec.x=p.x; vec.y=p.y; }
+	Vector2 point() const { return Vector2(vec.x,vec.y); }
+};
+
+/*
+ * Packed stream of path commands, stored contiguously without per command
+ * allocations
+ */
+class GeomTokenList
+{
+private:
+	std::vector<GeomToken, reporter_allocator<GeomToken>> tokens;
+	uint32_t version;
 public:
-	FILLSTYLE  fillStyle;
-	LINESTYLE2 lineStyle;
-	MATRIX textureTransform;
-	GEOM_TOKEN_TYPE type;
-	Vector2 p1;
-	Vector2 p2;
-	Vector2 p3;
-	GeomToken(GEOM_TOKEN_TYPE _t):fillStyle(0xff),lineStyle(0xff),type(_t),p1(0,0),p2(0,0),p3(0,0){}
-	GeomToken(GEOM_TOKEN_TYPE _t, const Vector2& _p):fillStyle(0xff),lineStyle(0xff),type(_t),p1(_p),p2(0,0),p3(0,0){}
-	GeomToken(GEOM_TOKEN_TYPE _t, const Vector2& _p1, const Vector2& _p2):fillStyle(0xff),lineStyle(0xff),type(_t),p1(_p1),p2(_p2),p3(0,0){}
-	GeomToken(GEOM_TOKEN_TYPE _t, const Vector2& _p1, const Vector2& _p2, const Vector2& _p3):fillStyle(0xff),lineStyle(0xff),type(_t),
-			p1(_p1),p2(_p2),p3(_p3){}
-	GeomToken(GEOM_TOKEN_TYPE _t, const FILLSTYLE&  _f):fillStyle(_f),lineStyle(0xff),type(_t),p1(0,0),p2(0,0),p3(0,0){}
-	GeomToken(GEOM_TOKEN_TYPE _t, const LINESTYLE2& _s):fillStyle(0xff),lineStyle(_s),type(_t),p1(0,0),p2(0,0),p3(0,0){}
-	GeomToken(GEOM_TOKEN_TYPE _t, const MATRIX _m):fillStyle(0xff),lineStyle(0xff),textureTransform(_m),type(_t),p1(0,0),p2(0,0),p3(0,0){}
-	GeomToken(GEOM_TOKEN_TYPE _t, const MORPHLINESTYLE2& _s);
+	GeomTokenList(reporter_allocator<GeomToken> m):tokens(m),version(0) {}
+	//Number of points following a command of the given type
+	static uint32_t pointCount(GEOM_TOKEN_TYPE type)
+	{
+		switch(type)
+		{
+			case MOVE:
+			case STRAIGHT:
+				return 1;
+			case CURVE_QUADRATIC:
+				return 2;
+			case CURVE_CUBIC:
+				return 3;
+			default:
+				return 0;
+		}
+	}
+	//Appends a command without points
+	void command(GEOM_TOKEN_TYPE type, uint32_t index=0)
+	{
+		tokens.emplace_back(type,index);
+		version++;
+	}
+	void moveTo(const Vector2& p)
+	{
+		tokens.emplace_back(MOVE,0);
+		tokens.emplace_back(p);
+		version++;
+	}
+	void lineTo(const Vector2& p)
+	{
+		tokens.emplace_back(STRAIGHT,0);
+		tokens.emplace_back(p);
+		version++;
+	}
+	void curveTo(const Vector2& control, const Vector2& anchor)
+	{
+		tokens.emplace_back(CURVE_QUADRATIC,0);
+		tokens.emplace_back(control);
+		tokens.emplace_back(anchor);
+		version++;
+	}
+	void cubicCurveTo(const Vector2& control1, const Vector2& control2, const Vector2& anchor)
+	{
+		tokens.emplace_back(CURVE_CUBIC,0);
+		tokens.emplace_back(control1);
+		tokens.emplace_back(control2);
+		tokens.emplace_back(anchor);
+		version++;
+	}
+	void assign(const GeomTokenList& o)
+	{
+		tokens.assign(o.tokens.begin(),o.tokens.end());
+		version++;
+	}
+	const GeomToken& operator[](uint32_t i) const { return tokens[i]; }
+	const GeomToken* data() const { return tokens.data(); }
+	uint32_t size() const { return tokens.size(); }
+	bool empty() const { return tokens.empty(); }
+	void clear()
+	{
+		tokens.clear();
+		version++;
+	}
+	//Changes every time the list is modified
+	uint32_t getVersion() const { return version; }
 };
 
 struct tokensVector
 {
-	std::vector<_NR<GeomToken>, reporter_allocator<_NR<GeomToken>>> filltokens;
-	std::vector<_NR<GeomToken>, reporter_allocator<_NR<GeomToken>>> stroketokens;
-	tokensVector(reporter_allocator<_NR<GeomToken>> m):filltokens(m),stroketokens(m) {}
+	GeomTokenList filltokens;
+	GeomTokenList stroketokens;
+	//Styles of the SET_FILL, SET_STROKE and FILL_TRANSFORM_TEXTURE commands of both lists
+	std::vector<FILLSTYLE, reporter_allocator<FILLSTYLE>> fillStyles;
+	std::vector<LINESTYLE2, reporter_allocator<LINESTYLE2>> lineStyles;
+	std::vector<MATRIX, reporter_allocator<MATRIX>> textureTransforms;
+	tokensVector(reporter_allocator<GeomToken> m):filltokens(m),stroketokens(m),fillStyles(m),lineStyles(m),textureTransforms(m) {}
+	/*
+	 * Append a command using a new style to list, that must be
+	 * filltokens or stroketokens
+	 */
+	void setFill(GeomTokenList& list, const FILLSTYLE& style)
+	{
+		list.command(SET_FILL,fillStyles.size());
+		fillStyles.push_back(style);
+	}
+	void setStroke(GeomTokenList& list, const LINESTYLE2& style)
+	{
+		list.command(SET_STROKE,lineStyles.size());
+		lineStyles.push_back(style);
+	}
+	void transformTexture(GeomTokenList& list, const MATRIX& m)
+	{
+		list.command(FILL_TRANSFORM_TEXTURE,textureTransforms.size());
+		textureTransforms.push_back(m);
+	}
+	//Copies the tokens and styles, keeping the memory accounts of this object
+	void assign(const tokensVector& o)
+	{
+		filltokens.assign(o.filltokens);
+		stroketokens.assign(o.stroketokens);
+		fillStyles.assign(o.fillStyles.begin(),o.fillStyles.end());
+		lineStyles.assign(o.lineStyles.begin(),o.lineStyles.end());
+		textureTransforms.assign(o.textureTransforms.begin(),o.textureTransforms.end());
+	}
 	void clear() 
 	{
 		filltokens.clear();
 		stroketokens.clear();
+		fillStyles.clear();
+		lineStyles.clear();
+		textureTransforms.clear();
 	}
 	uint32_t size() const
 	{
@@ -106,6 +221,40 @@ struct tokensVector
 	}
 };
 
+//Length in pixels of the segments curves are flattened to, at most
+#define FLATTEN_SEGMENT_LENGTH 2.0
+//Highest number of segments a single curve is flattened to
+#define FLATTEN_MAX_SEGMENTS 64
+
+/*
+ * Area covered by the fill of a tokensVector, with the curves flattened to
+ * line segments. Used to hit test shapes without building a cairo path for
+ * every test, it is only flattened again when the tokens change.
+ */
+class FlattenedPath
+{
+private:
+	//Points of the closed polygons, in pixels
+	std::vector<Vector2f> points;
+	//End of each polygon in points, the first starts at 0
+	std::vector<uint32_t> polygonEnds;
+	number_t xmin,xmax,ymin,ymax;
+	uint32_t fillVersion;
+	uint32_t strokeVersion;
+	float scaling;
+	bool valid;
+	void moveTo(const Vector2f& p);
+	void lineTo(const Vector2f& p);
+	void cubicTo(const Vector2f& c1, const Vector2f& c2, const Vector2f& end);
+	void closePolygon();
+public:
+	FlattenedPath():fillVersion(0),strokeVersion(0),scaling(1.0f),valid(false) {}
+	//Flattens the fill of tokens, unless it did not change since the last call
+	void update(const tokensVector& tokens, float scaleFactor);
+	//Nonzero winding rule test of a point in pixels, like cairo_in_fill
+	bool contains(number_t x, number_t y) const;
+};
+
 enum SHAPE_PATH_SEGMENT_TYPE { PATH_START=0, PATH_STRAIGHT, PATH_CURVE_QUADRATIC };
 
 class ShapePathSegment {
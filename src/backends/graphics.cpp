@@ -25,6 +25,8 @@
 #include "exceptions.h"
 #include "backends/rendering.h"
 #include "backends/config.h"
+#include "backends/bitmapfilters.h"
+#include "backends/rastercache.h"
 #include "compat.h"
 #include "scripting/flash/geom/flashgeom.h"
 #include "scripting/flash/text/flashtext.h"
@@ -222,6 +224,7 @@ cairo_pattern_t* CairoTokenRenderer::FILLSTYLEToCairo(const FILLSTYLE& style, do
 			_NR<BitmapContainer> bm(style.bitmap);
 			if(bm.isNull())
 				return NULL;
+			bm->ensureDecoded();
 			if (!style.Matrix.isInvertible())
 				return NULL;
 
@@ -308,18 +311,15 @@ bool CairoTokenRenderer::cairoPathFromTokens(cairo_t* cr, const tokensVector& to
 	int tokentype = 1;
 	while (tokentype)
 	{
-		std::vector<_NR<GeomToken>, reporter_allocator<_NR<GeomToken>>>::const_iterator it;
-		std::vector<_NR<GeomToken>, reporter_allocator<_NR<GeomToken>>>::const_iterator itend;
+		const GeomTokenList* list=nullptr;
 		switch(tokentype)
 		{
 			case 1:
-				it = tokens.filltokens.begin();
-				itend = tokens.filltokens.end();
+				list = &tokens.filltokens;
 				tokentype++;
 				break;
 			case 2:
-				it = tokens.stroketokens.begin();
-				itend = tokens.stroketokens.end();
+				list = &tokens.stroketokens;
 				tokentype++;
 				break;
 			default:
@@ -328,28 +328,36 @@ bool CairoTokenRenderer::cairoPathFromTokens(cairo_t* cr, const tokensVector& to
 		}
 		if (tokentype == 0)
 			break;
-		for (;it != itend; it++)
+		const uint32_t count=list->size();
+		for (uint32_t i=0;i<count;i++)
 		{
-			switch((*it)->type)
+			const GeomToken& cmd=(*list)[i];
+			//The points of the command follow it
+			const GeomToken* p=&cmd+1;
+			switch(cmd.cmd.type)
 			{
 				case MOVE:
-					PATH(cairo_move_to, (*it)->p1.x*scalex, (*it)->p1.y*scaley);
+					PATH(cairo_move_to, p[0].vec.x*scalex, p[0].vec.y*scaley);
+					i++;
 					break;
 				case STRAIGHT:
-					PATH(cairo_line_to, (*it)->p1.x*scalex, (*it)->p1.y*scaley);
+					PATH(cairo_line_to, p[0].vec.x*scalex, p[0].vec.y*scaley);
+					i++;
 					empty = false;
 					break;
 				case CURVE_QUADRATIC:
 					PATH(quadraticBezier,
-					   (*it)->p1.x*scalex, (*it)->p1.y*scaley,
-					   (*it)->p2.x*scalex, (*it)->p2.y*scaley);
+					   p[0].vec.x*scalex, p[0].vec.y*scaley,
+					   p[1].vec.x*scalex, p[1].vec.y*scaley);
+					i+=2;
 					empty = false;
 					break;
 				case CURVE_CUBIC:
 					PATH(cairo_curve_to,
-					   (*it)->p1.x*scalex, (*it)->p1.y*scaley,
-					   (*it)->p2.x*scalex, (*it)->p2.y*scaley,
-					   (*it)->p3.x*scalex, (*it)->p3.y*scaley);
+					   p[0].vec.x*scalex, p[0].vec.y*scaley,
+					   p[1].vec.x*scalex, p[1].vec.y*scaley,
+					   p[2].vec.x*scalex, p[2].vec.y*scaley);
+					i+=3;
 					empty = false;
 					break;
 				case SET_FILL:
@@ -361,7 +369,7 @@ bool CairoTokenRenderer::cairoPathFromTokens(cairo_t* cr, const tokensVector& to
 	
 					cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
 	
-					const FILLSTYLE& style = (*it)->fillStyle;
+					const FILLSTYLE& style = tokens.fillStyles[cmd.cmd.index];
 					if (style.FillStyleType == NON_SMOOTHED_CLIPPED_BITMAP ||
 						style.FillStyleType == NON_SMOOTHED_REPEATING_BITMAP)
 						cairo_set_antialias(cr,CAIRO_ANTIALIAS_NONE);
@@ -383,7 +391,7 @@ bool CairoTokenRenderer::cairoPathFromTokens(cairo_t* cr, const tokensVector& to
 	
 					cairo_stroke(stroke_cr);
 	
-					const LINESTYLE2& style = (*it)->lineStyle;
+					const LINESTYLE2& style = tokens.lineStyles[cmd.cmd.index];
 	
 					cairo_set_operator(stroke_cr, CAIRO_OPERATOR_OVER);
 					if (style.HasFillFlag)
@@ -454,7 +462,7 @@ bool CairoTokenRenderer::cairoPathFromTokens(cairo_t* cr, const tokensVector& to
 	
 					cairo_fill(cr);
 	
-					if((*it)->type==CLEAR_FILL)
+					if(cmd.cmd.type==CLEAR_FILL)
 						// Clear source.
 						cairo_set_operator(cr, CAIRO_OPERATOR_DEST);
 					break;
@@ -478,7 +486,7 @@ bool CairoTokenRenderer::cairoPathFromTokens(cairo_t* cr, const tokensVector& to
 					pattern=cairo_get_source(cr);
 					cairo_pattern_get_matrix(pattern, &origmat);
 	
-					cairo_pattern_set_matrix(pattern, &(*it)->textureTransform);
+					cairo_pattern_set_matrix(pattern, &tokens.textureTransforms[cmd.cmd.index]);
 	
 					cairo_fill(cr);
 	
@@ -537,6 +545,29 @@ void CairoTokenRenderer::executeDraw(cairo_t* cr, float scalex, float scaley)
 	cairoPathFromTokens(cr, tokens, scaleFactor, false,colortransform.getPtr(),scalex, scaley);
 }
 
+void CairoRenderer::drawArea(uint8_t* buf, int32_t x, int32_t y, int32_t w, int32_t h, float scalex, float scaley)
+{
+	//The device offset keeps the coordinates of the whole surface
+	cairo_surface_t* cairoSurface=cairo_image_surface_create_for_data(buf+(y*width+x)*4, CAIRO_FORMAT_ARGB32, w, h, width*4);
+	cairo_surface_set_device_offset(cairoSurface, -x, -y);
+	cairo_t* cr=cairo_create(cairoSurface);
+	cairo_surface_destroy(cairoSurface); /* cr has an reference to it */
+	cairoClean(cr);
+	cairo_set_antialias(cr,smoothing ? CAIRO_ANTIALIAS_DEFAULT : CAIRO_ANTIALIAS_NONE);
+
+	//Apply all the masks to clip the drawn part
+	for(uint32_t i=0;i<masks.size();i++)
+	{
+		if(masks[i].maskMode != HARD_MASK)
+			continue;
+		masks[i].m->applyCairoMask(cr,xOffset,yOffset,scalex,scaley);
+	}
+
+	cairo_set_matrix(cr, &matrix);
+	executeDraw(cr,scalex, scaley);
+	cairo_destroy(cr);
+}
+
 uint8_t* CairoRenderer::getPixelBuffer()
 {
 	if(width==0 || height==0 || !Config::getConfig()->isRenderingEnabled())
@@ -593,23 +624,40 @@ uint8_t* CairoRenderer::getPixelBuffer()
 	if(yOffset >= 0)
 		matrix.y0-=yOffset;
 
-	cairo_surface_t* cairoSurface=allocateSurface(ret);
+	//Surfaces that were drawn before are taken from the raster cache
+	uint64_t contentHash=0;
+	bool cacheable=masks.empty() && getContentHash(contentHash,scalex,scaley);
+	RasterCacheKey cacheKey(contentHash,matrix,width,height);
+	if(cacheable)
+	{
+		ret=sys->rasterCache.lookup(cacheKey);
+		if(ret)
+			return ret;
+	}
 
-	cairo_t* cr=cairo_create(cairoSurface);
-	cairo_surface_destroy(cairoSurface); /* cr has an reference to it */
-	cairoClean(cr);
-	cairo_set_antialias(cr,smoothing ? CAIRO_ANTIALIAS_DEFAULT : CAIRO_ANTIALIAS_NONE);
+	cairo_surface_t* cairoSurface=allocateSurface(ret);
 
-	//Apply all the masks to clip the drawn part
-	for(uint32_t i=0;i<masks.size();i++)
+	int32_t tilesX=(width+CAIRO_TILE_SIZE-1)/CAIRO_TILE_SIZE;
+	int32_t tilesY=(height+CAIRO_TILE_SIZE-1)/CAIRO_TILE_SIZE;
+	if(isTileable() && tilesX*tilesY>1)
 	{
-		if(masks[i].maskMode != HARD_MASK)
-			continue;
-		masks[i].m->applyCairoMask(cr,xOffset,yOffset,scalex,scaley);
+		//Each tile is drawn by its own context directly in the final buffer
+		parallelFilterRange(sys,tilesX*tilesY,[&](int32_t begin, int32_t end)
+		{
+			for(int32_t i=begin;i<end;i++)
+			{
+				int32_t x=(i%tilesX)*CAIRO_TILE_SIZE;
+				int32_t y=(i/tilesX)*CAIRO_TILE_SIZE;
+				drawArea(ret,x,y,imin(CAIRO_TILE_SIZE,width-x),imin(CAIRO_TILE_SIZE,height-y),scalex,scaley);
+			}
+		},1);
 	}
+	else
+		drawArea(ret,0,0,width,height,scalex,scaley);
 
+	cairo_t* cr=cairo_create(cairoSurface);
+	cairo_surface_destroy(cairoSurface); /* cr has an reference to it */
 	cairo_set_matrix(cr, &matrix);
-	executeDraw(cr,scalex, scaley);
 
 	cairo_surface_t* maskSurface = nullptr;
 	uint8_t* maskRawData = nullptr;
@@ -660,29 +708,84 @@ uint8_t* CairoRenderer::getPixelBuffer()
 	}
 
 	cairo_destroy(cr);
+	if(cacheable)
+		sys->rasterCache.insert(cacheKey,ret);
 	return ret;
 }
 
-bool CairoTokenRenderer::hitTest(const tokensVector& tokens, float scaleFactor, number_t x, number_t y)
+static uint64_t hashColor(uint64_t hash, const RGBA& c)
 {
-	cairo_surface_t* cairoSurface=cairo_image_surface_create_for_data(nullptr, CAIRO_FORMAT_ARGB32, 0, 0, 0);
-	cairo_t *cr=cairo_create(cairoSurface);
-	cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
-	cairo_set_fill_rule(cr, CAIRO_FILL_RULE_WINDING);
+	const uint8_t v[4]={c.Red,c.Green,c.Blue,c.Alpha};
+	return rasterHash(hash,v,sizeof(v));
+}
+
+bool CairoTokenRenderer::hashFillStyle(uint64_t& hash, const FILLSTYLE& style)
+{
+	//The contents of bitmaps may change without notice
+	if(style.bitmap)
+		return false;
+	hash=rasterHash(hash,style.FillStyleType);
+	hash=hashColor(hash,style.Color);
+	hash=rasterHash(hash,&style.Matrix,sizeof(cairo_matrix_t));
+	hash=rasterHash(hash,style.Gradient.SpreadMode);
+	hash=rasterHash(hash,style.Gradient.InterpolationMode);
+	for(const GRADRECORD& r: style.Gradient.GradientRecords)
+	{
+		hash=rasterHash(hash,(uint8_t)r.Ratio);
+		hash=hashColor(hash,r.Color);
+	}
+	hash=rasterHash(hash,style.FocalGradient.SpreadMode);
+	hash=rasterHash(hash,style.FocalGradient.InterpolationMode);
+	hash=rasterHash(hash,style.FocalGradient.FocalPoint);
+	for(const GRADRECORD& r: style.FocalGradient.GradientRecords)
+	{
+		hash=rasterHash(hash,(uint8_t)r.Ratio);
+		hash=hashColor(hash,r.Color);
+	}
+	return true;
+}
 
-	bool empty=cairoPathFromTokens(cr, tokens, scaleFactor, true,nullptr,1.0,1.0);
-	bool ret=false;
-	if(!empty)
+bool CairoTokenRenderer::getContentHash(uint64_t& hash, float scalex, float scaley) const
+{
+	hash=RASTER_HASH_SEED;
+	hash=rasterHash(hash,tokens.filltokens.data(),tokens.filltokens.size()*sizeof(GeomToken));
+	hash=rasterHash(hash,tokens.stroketokens.size());
+	hash=rasterHash(hash,tokens.stroketokens.data(),tokens.stroketokens.size()*sizeof(GeomToken));
+	for(const FILLSTYLE& style: tokens.fillStyles)
 	{
-		/* reset the matrix so x and y are not scaled
-		 * by the current cairo transformation
-		 */
-		cairo_identity_matrix(cr);
-		ret=cairo_in_fill(cr, x, y);
+		if(!hashFillStyle(hash,style))
+			return false;
 	}
-	cairo_destroy(cr);
-	cairo_surface_destroy(cairoSurface);
-	return ret;
+	for(const LINESTYLE2& style: tokens.lineStyles)
+	{
+		hash=rasterHash(hash,style.StartCapStyle);
+		hash=rasterHash(hash,style.JointStyle);
+		hash=rasterHash(hash,style.HasFillFlag);
+		hash=rasterHash(hash,style.NoHScaleFlag);
+		hash=rasterHash(hash,style.NoVScaleFlag);
+		hash=rasterHash(hash,style.PixelHintingFlag);
+		hash=rasterHash(hash,(uint32_t)style.NoClose);
+		hash=rasterHash(hash,(uint32_t)style.EndCapStyle);
+		hash=rasterHash(hash,(uint16_t)style.Width);
+		hash=rasterHash(hash,(uint16_t)style.MiterLimitFactor);
+		hash=hashColor(hash,style.Color);
+		if(style.HasFillFlag && !hashFillStyle(hash,style.FillType))
+			return false;
+	}
+	for(const MATRIX& m: tokens.textureTransforms)
+		hash=rasterHash(hash,&m,sizeof(cairo_matrix_t));
+	if(colortransform)
+	{
+		const ColorTransform* ct=colortransform.getPtr();
+		const number_t values[8]={ct->redMultiplier,ct->greenMultiplier,ct->blueMultiplier,ct->alphaMultiplier,
+					  ct->redOffset,ct->greenOffset,ct->blueOffset,ct->alphaOffset};
+		hash=rasterHash(hash,values,sizeof(values));
+	}
+	hash=rasterHash(hash,scaleFactor);
+	hash=rasterHash(hash,scalex);
+	hash=rasterHash(hash,scaley);
+	hash=rasterHash(hash,smoothing);
+	return true;
 }
 
 void CairoTokenRenderer::applyCairoMask(cairo_t* cr,int32_t xOffset,int32_t yOffset, float scalex, float scaley) const
@@ -994,6 +1097,8 @@ void CairoPangoRenderer::applyCairoMask(cairo_t* cr, int32_t xOffset, int32_t yO
 
 AsyncDrawJob::AsyncDrawJob(IDrawable* d, _R<DisplayObject> o,int32_t flushstep):drawable(d),owner(o),surfaceBytes(NULL),uploadNeeded(false)
 {
+	//Rasterization is needed for the next frame, don't wait behind slow jobs
+	jobPriority=THREAD_JOB_PRIORITY_HIGH;
 	o->flushstep = flushstep;
 }
 
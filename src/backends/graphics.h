@@ -21,6 +21,8 @@
 #define BACKENDS_GRAPHICS_H 1
 
 #define CHUNKSIZE 128
+//Side of the tiles large CairoRenderer surfaces are split in to be drawn in parallel
+#define CAIRO_TILE_SIZE 256
 
 #include "compat.h"
 #include <vector>
@@ -42,6 +44,7 @@ class TextureChunk
 {
 friend class GLRenderContext;
 friend class CairoRenderContext;
+friend class SoftwareRenderContext;
 friend class RenderThread;
 private:
 	/*
@@ -49,6 +52,8 @@ private:
 	 * chunks inside such texture.
 	 * For CairoRenderContext texId is an arbitrary id for the texture and chunks is
 	 * not used.
+	 * For SoftwareRenderContext texId is the index of a page in system memory
+	 * and chunks is used like for GLRenderContext.
 	 */
 	uint32_t* chunks;
 	uint32_t texId;
@@ -193,6 +198,18 @@ protected:
 	static void cairoClean(cairo_t* cr);
 	cairo_surface_t* allocateSurface(uint8_t*& buf);
 	virtual void executeDraw(cairo_t* cr, float scalex, float scaley)=0;
+	/*
+	 * True if executeDraw may run concurrently on different parts
+	 * of the surface
+	 */
+	virtual bool isTileable() const { return false; }
+	/*
+	 * Hashes everything but the matrix and the size the pixels depend on.
+	 * Returns false if the drawable must not be taken from the raster cache
+	 */
+	virtual bool getContentHash(uint64_t& hash, float scalex, float scaley) const { return false; }
+	//Draws the area (x,y,w,h) of the surface in buf, applying the hard masks
+	void drawArea(uint8_t* buf, int32_t x, int32_t y, int32_t w, int32_t h, float scalex, float scaley);
 	static void copyRGB15To24(uint32_t& dest, uint8_t* src);
 	static void copyRGB24To24(uint32_t& dest, uint8_t* src);
 public:
@@ -226,6 +243,10 @@ private:
 	 * This is run by CairoRenderer::execute()
 	 */
 	void executeDraw(cairo_t* cr, float scalex, float scaley);
+	//The tokens and styles are only read while drawing
+	bool isTileable() const { return true; }
+	bool getContentHash(uint64_t& hash, float scalex, float scaley) const;
+	static bool hashFillStyle(uint64_t& hash, const FILLSTYLE& style);
 	void applyCairoMask(cairo_t* cr, int32_t offsetX, int32_t offsetY, float scalex, float scaley) const;
 public:
 	/*
@@ -244,15 +265,6 @@ public:
 			int32_t _x, int32_t _y, int32_t _w, int32_t _h,
 		    float _s, float _a, const std::vector<MaskData>& _ms,bool _smoothing,
 			ColorTransform* _ct);
-	/*
-	   Hit testing helper. Uses cairo to find if a point in inside the shape
-
-	   @param tokens The tokens of the shape being tested
-	   @param scaleFactor The scale factor to be applied
-	   @param x The X in local coordinates
-	   @param y The Y in local coordinates
-	*/
-	static bool hitTest(const tokensVector& tokens, float scaleFactor, number_t x, number_t y);
 };
 
 class TextData
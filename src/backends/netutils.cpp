@@ -811,6 +811,8 @@ void LocalDownloader::execute()
 DownloaderThreadBase::DownloaderThreadBase(_NR<URLRequest> request, IDownloaderThreadListener* _listener): listener(_listener), downloader(NULL)
 {
 	assert(listener);
+	//Loaders mostly wait on the network
+	jobPriority=THREAD_JOB_PRIORITY_LOW;
 	if(!request.isNull())
 	{
 		url=request->getRequestURL();
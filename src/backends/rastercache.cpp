@@ -0,0 +1,114 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+
+#include "backends/rastercache.h"
+#include "backends/geometry.h"
+#include "memory_support.h"
+#include "swftypes.h"
+#include <cmath>
+#include <cstring>
+
+using namespace std;
+using namespace lightspark;
+
+static int32_t quantize(double v)
+{
+	return lround(v*RASTER_CACHE_QUANTUM);
+}
+
+RasterCacheKey::RasterCacheKey(uint64_t h, const MATRIX& m, int32_t w, int32_t ht):
+	contentHash(h),xx(quantize(m.xx)),yx(quantize(m.yx)),xy(quantize(m.xy)),yy(quantize(m.yy)),
+	x0(quantize(m.x0)),y0(quantize(m.y0)),width(w),height(ht)
+{
+}
+
+RasterCache::RasterCache():memoryAccount(nullptr),usedBytes(0),hits(0),misses(0)
+{
+}
+
+RasterCache::~RasterCache()
+{
+	for(auto it=entries.begin();it!=entries.end();++it)
+		delete[] it->pixels;
+}
+
+void RasterCache::evictLast()
+{
+	const entry& e=entries.back();
+	uint64_t size=entrySize(e.key);
+	usedBytes-=size;
+#ifdef MEMORY_USAGE_PROFILING
+	if(memoryAccount)
+		memoryAccount->removeBytes(size);
+#endif
+	delete[] e.pixels;
+	index.erase(e.key);
+	entries.pop_back();
+}
+
+uint8_t* RasterCache::lookup(const RasterCacheKey& key)
+{
+	Locker l(mutex);
+	auto it=index.find(key);
+	if(it==index.end())
+	{
+		misses++;
+		return nullptr;
+	}
+	hits++;
+	entries.splice(entries.begin(),entries,it->second);
+	uint64_t size=entrySize(key);
+	uint8_t* ret=new uint8_t[size];
+	memcpy(ret,it->second->pixels,size);
+	return ret;
+}
+
+void RasterCache::insert(const RasterCacheKey& key, const uint8_t* pixels)
+{
+	uint64_t size=entrySize(key);
+	//Surfaces that would flush most of the cache are not worth keeping
+	if(size>RASTER_CACHE_BUDGET/4)
+		return;
+	uint8_t* copy=new uint8_t[size];
+	memcpy(copy,pixels,size);
+	Locker l(mutex);
+	//Another job may have drawn the same surface in the meantime
+	if(index.find(key)!=index.end())
+	{
+		delete[] copy;
+		return;
+	}
+	while(!entries.empty() && usedBytes+size>RASTER_CACHE_BUDGET)
+		evictLast();
+	entries.emplace_front(key,copy);
+	index.emplace(key,entries.begin());
+	usedBytes+=size;
+#ifdef MEMORY_USAGE_PROFILING
+	if(memoryAccount)
+		memoryAccount->addBytes(size);
+#endif
+}
+
+void RasterCache::clear()
+{
+	Locker l(mutex);
+	while(!entries.empty())
+		evictLast();
+}
@@ -0,0 +1,123 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+
+#ifndef BACKENDS_RASTERCACHE_H
+#define BACKENDS_RASTERCACHE_H 1
+
+#include "compat.h"
+#include <list>
+#include <unordered_map>
+#include "threading.h"
+
+namespace lightspark
+{
+
+class MemoryAccount;
+class MATRIX;
+
+//Bytes of pixels kept by the raster cache before the least recently used ones are evicted
+#define RASTER_CACHE_BUDGET (64*1024*1024)
+//Matrix coefficients and subpixel offsets are matched at a precision of 1/RASTER_CACHE_QUANTUM
+#define RASTER_CACHE_QUANTUM 256
+
+//64 bit FNV-1a, used to hash the contents of the drawables
+#define RASTER_HASH_SEED 0xcbf29ce484222325ULL
+inline uint64_t rasterHash(uint64_t h, const void* data, size_t len)
+{
+	const uint8_t* p=(const uint8_t*)data;
+	for(size_t i=0;i<len;i++)
+		h=(h^p[i])*0x100000001b3ULL;
+	return h;
+}
+template<class T>
+inline uint64_t rasterHash(uint64_t h, const T& v)
+{
+	return rasterHash(h,&v,sizeof(T));
+}
+
+/*
+ * Everything the pixels of a rasterized drawable depend on: a hash of its
+ * contents (tokens, styles, color transform, smoothing) and of the
+ * transformation from local to surface coordinates, plus the surface size
+ */
+struct RasterCacheKey
+{
+	uint64_t contentHash;
+	int32_t xx,yx,xy,yy;
+	int32_t x0,y0;
+	int32_t width,height;
+	RasterCacheKey(uint64_t h, const MATRIX& m, int32_t w, int32_t ht);
+	bool operator==(const RasterCacheKey& r) const
+	{
+		return contentHash==r.contentHash && xx==r.xx && yx==r.yx && xy==r.xy && yy==r.yy &&
+			x0==r.x0 && y0==r.y0 && width==r.width && height==r.height;
+	}
+};
+
+struct RasterCacheKeyHash
+{
+	size_t operator()(const RasterCacheKey& k) const
+	{
+		return rasterHash(k.contentHash,&k.xx,sizeof(int32_t)*8);
+	}
+};
+
+/*
+ * LRU cache of the surfaces produced by CairoRenderer, so that objects that
+ * only moved by whole pixels and instances of the same shape are not
+ * rasterized again. It may be used from any thread.
+ */
+class RasterCache
+{
+private:
+	struct entry
+	{
+		RasterCacheKey key;
+		uint8_t* pixels;
+		entry(const RasterCacheKey& k, uint8_t* p):key(k),pixels(p){}
+	};
+	Mutex mutex;
+	//Most recently used first
+	std::list<entry> entries;
+	std::unordered_map<RasterCacheKey,std::list<entry>::iterator,RasterCacheKeyHash> index;
+	MemoryAccount* memoryAccount;
+	uint64_t usedBytes;
+	uint64_t hits;
+	uint64_t misses;
+	static uint64_t entrySize(const RasterCacheKey& key) { return uint64_t(key.width)*key.height*4; }
+	void evictLast();
+public:
+	RasterCache();
+	~RasterCache();
+	void setMemoryAccount(MemoryAccount* m) { memoryAccount=m; }
+	/*
+	 * Returns a copy of the cached pixels allocated with new[], or nullptr
+	 * when the key is not cached
+	 */
+	uint8_t* lookup(const RasterCacheKey& key);
+	//Stores a copy of the width*height ARGB pixels
+	void insert(const RasterCacheKey& key, const uint8_t* pixels);
+	void clear();
+	uint64_t getHits() const { return hits; }
+	uint64_t getMisses() const { return misses; }
+};
+
+};
+#endif /* BACKENDS_RASTERCACHE_H */
@@ -21,6 +21,7 @@
 #include "scripting/class.h"
 #include "parsing/textfile.h"
 #include "backends/rendering.h"
+#include "backends/softwarerendering.h"
 #include "compat.h"
 #include <sstream>
 #include <unistd.h>
@@ -56,8 +57,8 @@ void RenderThread::wait()
 }
 
 RenderThread::RenderThread(SystemState* s):GLRenderContext(),
-	m_sys(s),status(CREATED),
-	prevUploadJob(nullptr),
+	m_sys(s),status(CREATED),stageTexture(0),stageFramebuffer(0),lastBackground(0),softwareContext(nullptr),frameDumpFormat(FRAME_BMP),frameDumpFile(nullptr),dumpedFrames(0),
+	captureNeeded(false),captureRetries(0),captureDone(0),prevUploadJob(nullptr),
 	renderNeeded(false),uploadNeeded(false),resizeNeeded(false),newTextureNeeded(false),event(0),newWidth(0),newHeight(0),scaleX(1),scaleY(1),
 	offsetX(0),offsetY(0),tempBufferAcquired(false),frameCount(0),secsCount(0),initialized(0),screenshotneeded(false),
 	cairoTextureContext(nullptr)
@@ -86,6 +87,8 @@ void RenderThread::stop()
 RenderThread::~RenderThread()
 {
 	wait();
+	if(frameDumpFile)
+		fclose(frameDumpFile);
 	LOG(LOG_INFO,_("~RenderThread this=") << this);
 }
 
@@ -96,7 +99,10 @@ void RenderThread::handleNewTexture()
 	for(uint32_t i=0;i<largeTextures.size();i++)
 	{
 		if(largeTextures[i].id==(uint32_t)-1)
-			largeTextures[i].id=allocateNewGLTexture();
+		{
+			//Software pages are allocated on the first upload
+			largeTextures[i].id=softwareContext?i:allocateNewGLTexture();
+		}
 	}
 	newTextureNeeded=false;
 }
@@ -120,6 +126,15 @@ void RenderThread::handleUpload()
 	assert(u);
 	uint32_t w,h;
 	u->sizeNeeded(w,h);
+	if(softwareContext)
+	{
+		//There are no pixel buffers to wait for, copy right away
+		uint8_t* buf=softwareContext->getUploadBuffer(w,h);
+		u->upload(buf, w, h);
+		loadChunkBGRA(u->getTexture(), w, h, buf);
+		u->uploadFence();
+		return;
+	}
 	engineData->resizePixelBuffers(w,h);
 	
 	uint8_t* buf= engineData->switchCurrentPixBuf(w,h);
@@ -147,6 +162,15 @@ void RenderThread::init()
 	/* This will call initialized.signal() when lighter goes out of scope */
 	SemaphoreLighter lighter(initialized);
 
+	if(EngineData::softwarerendering)
+	{
+		//windowWidth and windowHeight have been set by SystemState
+		largeTextureSize=SOFTWARE_TEXTURE_SIZE;
+		softwareContext=new SoftwareRenderContext(m_sys,largeTextureSize);
+		softwareResize();
+		return;
+	}
+
 	windowWidth=engineData->width;
 	windowHeight=engineData->height;
 
@@ -172,7 +196,8 @@ int RenderThread::worker(void* d)
 		ThreadProfile* profile=th->m_sys->allocateProfiler(RGB(200,0,0));
 		profile->setTag("Render");
 
-		th->engineData->exec_glEnable_GL_TEXTURE_2D();
+		if(!th->softwareContext)
+			th->engineData->exec_glEnable_GL_TEXTURE_2D();
 
 		Chronometer chronometer;
 		while(1)
@@ -201,6 +226,8 @@ int RenderThread::worker(void* d)
 		th->prevUploadJob->uploadFence();
 	for(auto i=th->uploadJobs.begin(); i != th->uploadJobs.end(); ++i)
 		(*i)->uploadFence();
+	//Release a pending captureFrame
+	th->captureDone.signal();
 	return 0;
 }
 bool RenderThread::doRender(ThreadProfile* profile,Chronometer* chronometer)
@@ -221,7 +248,10 @@ bool RenderThread::doRender(ThreadProfile* profile,Chronometer* chronometer)
 		newHeight=0;
 		//End of order critical part
 		LOG(LOG_INFO,_("Window resized to ") << windowWidth << 'x' << windowHeight);
-		commonGLResize();
+		if(softwareContext)
+			softwareResize();
+		else
+			commonGLResize();
 		m_sys->resizeCompleted();
 		if (profile && chronometer)
 			profile->accountTime(chronometer->checkpoint());
@@ -236,6 +266,9 @@ bool RenderThread::doRender(ThreadProfile* profile,Chronometer* chronometer)
 	if(uploadNeeded)
 	{
 		handleUpload();
+		//The captured frame may have been waiting for this upload
+		if(captureNeeded && !uploadNeeded)
+			event.signal();
 		if (profile && chronometer)
 			profile->accountTime(chronometer->checkpoint());
 		return true;
@@ -243,11 +276,14 @@ bool RenderThread::doRender(ThreadProfile* profile,Chronometer* chronometer)
 
 	if(USUALLY_FALSE(m_sys->isOnError()))
 	{
-		renderErrorPage(this, m_sys->standalone);
+		//The software renderer keeps the last frame
+		if(!softwareContext)
+			renderErrorPage(this, m_sys->standalone);
 	}
 	else
 	{
-		if (m_sys->stage->renderStage3D())
+		const bool stage3D=m_sys->stage->renderStage3D();
+		if (!softwareContext && stage3D)
 		{
 			// stage3d rendering is needed, so we ignore the flushsteps
 			coreRendering();
@@ -262,12 +298,14 @@ bool RenderThread::doRender(ThreadProfile* profile,Chronometer* chronometer)
 		}
 		else
 		{
-			if(m_sys->currentflushstep > m_sys->nextflushstep)
+			//The software Stage3D back buffer may change without a flush
+			if(m_sys->currentflushstep > m_sys->nextflushstep && !stage3D)
 			{
 				if (screenshotneeded)
 					generateScreenshot();
 				// no changes since last rendering, so we don't need to do anything
 				renderNeeded=false;
+				finishCapture();
 				return true;
 			}
 			m_sys->currentflushstep = m_sys->nextflushstep;
@@ -275,20 +313,36 @@ bool RenderThread::doRender(ThreadProfile* profile,Chronometer* chronometer)
 			{
 				if (coreRendering())
 				{
+					//A captured frame waits for the objects that are still being drawn
+					if(captureNeeded && captureRetries<CAPTURE_MAX_WAIT)
+					{
+						captureRetries++;
+						compat_msleep(1);
+						event.signal();
+						return true;
+					}
 					renderNeeded=false;
+					finishCapture();
 					return true;
 				}
-				//Call glFlush to offload work on the GPU
-				engineData->exec_glFlush();
+				if(softwareContext && !m_sys->offlineCapture)
+					dumpFrame();
+				else
+				{
+					//Call glFlush to offload work on the GPU
+					engineData->exec_glFlush();
+				}
 			}
 		}
 	}
 	if (screenshotneeded)
 		generateScreenshot();
-	engineData->DoSwapBuffers();
+	if(!softwareContext)
+		engineData->DoSwapBuffers();
 	if (profile && chronometer)
 		profile->accountTime(chronometer->checkpoint());
 	renderNeeded=false;
+	finishCapture();
 	m_sys->currentflushstep++;
 	if (m_sys->currentflushstep==0)
 		m_sys->currentflushstep++;
@@ -296,14 +350,6 @@ bool RenderThread::doRender(ThreadProfile* profile,Chronometer* chronometer)
 }
 void RenderThread::generateScreenshot()
 {
-	char* buf = new char[windowWidth*windowHeight*3];
-	if (!buf)
-	{
-		LOG(LOG_ERROR,"generating screenshot memory failed");
-		return;
-	}
-	engineData->exec_glReadPixels(windowWidth, windowHeight, buf);
-	
 	char* name_used=nullptr;
 	int fd = g_file_open_tmp("lightsparkXXXXXX.bmp",&name_used,nullptr);
 	if(fd == -1)
@@ -311,41 +357,141 @@ void RenderThread::generateScreenshot()
 		LOG(LOG_ERROR,"generating screenshot file failed");
 		return;
 	}
-	
-	unsigned char bmp_file_header[14] = { 'B', 'M', 0, 0, 0, 0, 0, 0, 0, 0, 54, 0, 0, 0, };
-	unsigned char bmp_info_header[40] = { 40, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 24, 0, };
-	size_t size = 54 + windowWidth * windowHeight * 3;
-
-	bmp_file_header[2] = (size)&0xff;
-	bmp_file_header[3] = (size >> 8);
-	bmp_file_header[4] = (size >> 16);
-	bmp_file_header[5] = (size >> 24);
-
-	bmp_info_header[4] = (windowWidth)&0xff;
-	bmp_info_header[5] = (windowWidth >> 8)&0xff;
-	bmp_info_header[6] = (windowWidth >> 16)&0xff;
-	bmp_info_header[7] = (windowWidth >> 24)&0xff;
-
-	bmp_info_header[8] = (windowHeight)&0xff;
-	bmp_info_header[9] = (windowHeight >> 8)&0xff;
-	bmp_info_header[10] = (windowHeight >> 16)&0xff;
-	bmp_info_header[11] = (windowHeight >> 24)&0xff;
-		
-	if (write(fd,bmp_file_header,14)<0)
-		LOG(LOG_INFO,"screenshot header write error");
-	if (write(fd,bmp_info_header,40)<0)
-		LOG(LOG_INFO,"screenshot header write error");
-	if (write(fd,buf,windowWidth * windowHeight * 3)<0)
-		LOG(LOG_INFO,"screenshot write error");
+	if(softwareContext)
+	{
+		vector<uint8_t> bmp;
+		softwareContext->getFrameBMP(bmp);
+		if (write(fd,bmp.data(),bmp.size())<0)
+			LOG(LOG_INFO,"screenshot write error");
+	}
+	else
+	{
+		char* buf = new char[windowWidth*windowHeight*3];
+		engineData->exec_glReadPixels(windowWidth, windowHeight, buf);
+
+		unsigned char bmp_file_header[14] = { 'B', 'M', 0, 0, 0, 0, 0, 0, 0, 0, 54, 0, 0, 0, };
+		unsigned char bmp_info_header[40] = { 40, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 24, 0, };
+		size_t size = 54 + windowWidth * windowHeight * 3;
+
+		bmp_file_header[2] = (size)&0xff;
+		bmp_file_header[3] = (size >> 8);
+		bmp_file_header[4] = (size >> 16);
+		bmp_file_header[5] = (size >> 24);
+
+		bmp_info_header[4] = (windowWidth)&0xff;
+		bmp_info_header[5] = (windowWidth >> 8)&0xff;
+		bmp_info_header[6] = (windowWidth >> 16)&0xff;
+		bmp_info_header[7] = (windowWidth >> 24)&0xff;
+
+		bmp_info_header[8] = (windowHeight)&0xff;
+		bmp_info_header[9] = (windowHeight >> 8)&0xff;
+		bmp_info_header[10] = (windowHeight >> 16)&0xff;
+		bmp_info_header[11] = (windowHeight >> 24)&0xff;
+
+		if (write(fd,bmp_file_header,14)<0)
+			LOG(LOG_INFO,"screenshot header write error");
+		if (write(fd,bmp_info_header,40)<0)
+			LOG(LOG_INFO,"screenshot header write error");
+		if (write(fd,buf,windowWidth * windowHeight * 3)<0)
+			LOG(LOG_INFO,"screenshot write error");
+		delete[] buf;
+	}
 	close(fd);
-	delete[] buf;
 	LOG(LOG_INFO,"screenshot generated:"<<name_used);
 	g_free(name_used);
 	screenshotneeded=false;
 }
 
+void RenderThread::setFrameDump(const string& path, FRAME_FORMAT format)
+{
+	frameDumpPath=path;
+	frameDumpFormat=format;
+	if(g_file_test(path.c_str(),G_FILE_TEST_IS_DIR))
+		return;
+	frameDumpFile=fopen(path.c_str(),"wb");
+	if(!frameDumpFile)
+	{
+		LOG(LOG_ERROR,"opening "<<path<<" for the frames failed");
+		frameDumpPath.clear();
+	}
+}
+
+void RenderThread::dumpFrame()
+{
+	if(frameDumpPath.empty())
+		return;
+	vector<uint8_t> data;
+	const char* ext="bmp";
+	switch(frameDumpFormat)
+	{
+		case FRAME_BMP:
+			softwareContext->getFrameBMP(data);
+			break;
+		case FRAME_PNG:
+			if(!softwareContext->getFramePNG(data))
+				return;
+			ext="png";
+			break;
+		case FRAME_RAW:
+			softwareContext->getFrameRaw(data);
+			ext="raw";
+			break;
+	}
+	dumpedFrames++;
+	if(frameDumpFile)
+	{
+		if(fwrite(data.data(),1,data.size(),frameDumpFile)!=data.size() || fflush(frameDumpFile)!=0)
+		{
+			LOG(LOG_ERROR,"writing frame "<<dumpedFrames<<" to "<<frameDumpPath<<" failed");
+			m_sys->setShutdownFlag();
+		}
+		return;
+	}
+	char name[32];
+	snprintf(name,32,"frame%06u.%s",dumpedFrames-1,ext);
+	gchar* path=g_build_filename(frameDumpPath.c_str(),name,nullptr);
+	GError* err=nullptr;
+	if(!g_file_set_contents(path,(const gchar*)data.data(),data.size(),&err))
+	{
+		LOG(LOG_ERROR,"writing frame "<<path<<" failed:"<<err->message);
+		g_error_free(err);
+	}
+	g_free(path);
+}
+
+bool RenderThread::captureFrame()
+{
+	if(status!=STARTED)
+		return false;
+	captureNeeded=true;
+	draw(true);
+	captureDone.wait();
+	return status==STARTED;
+}
+
+void RenderThread::finishCapture()
+{
+	if(!captureNeeded)
+		return;
+	if(captureRetries>=CAPTURE_MAX_WAIT)
+		LOG(LOG_ERROR,"objects still being drawn after "<<CAPTURE_MAX_WAIT<<"ms, capturing the previous frame");
+	captureNeeded=false;
+	captureRetries=0;
+	if(softwareContext)
+		dumpFrame();
+	captureDone.signal();
+}
+
 void RenderThread::deinit()
 {
+	if(softwareContext)
+	{
+		for(uint32_t i=0;i<largeTextures.size();i++)
+			delete[] largeTextures[i].bitmap;
+		delete softwareContext;
+		softwareContext=nullptr;
+		return;
+	}
 	engineData->exec_glDisable_GL_TEXTURE_2D();
 	commonGLDeinit();
 	engineData->DeinitOpenGL();
@@ -423,6 +569,8 @@ void RenderThread::commonGLDeinit()
 	}
 	engineData->exec_glDeleteBuffers(2,engineData->pixelBuffers);
 	engineData->exec_glDeleteTextures(1, &cairoTextureID);
+	if(stageTexture)
+		engineData->exec_glDeleteTextures(1, &stageTexture);
 }
 
 void RenderThread::commonGLInit(int width, int height)
@@ -462,6 +610,8 @@ void RenderThread::commonGLInit(int width, int height)
 	alphaUniform =engineData->exec_glGetUniformLocation(gpu_program,"alpha");
 	//The uniform that tells to draw directly using the selected color
 	directUniform =engineData->exec_glGetUniformLocation(gpu_program,"direct");
+	//The uniform that tells the texels are not stored in BGRA order
+	rgbaUniform =engineData->exec_glGetUniformLocation(gpu_program,"rgba");
 	//The uniform that contains the coordinate matrix
 	projectionMatrixUniform =engineData->exec_glGetUniformLocation(gpu_program,"ls_ProjectionMatrix");
 	modelviewMatrixUniform =engineData->exec_glGetUniformLocation(gpu_program,"ls_ModelViewMatrix");
@@ -495,6 +645,66 @@ void RenderThread::commonGLResize()
 	lsglTranslatef(offsetX,windowHeight-offsetY,0);
 	lsglScalef(1.0,-1.0,1);
 	setMatrixUniform(LSGL_PROJECTION);
+
+	frameWidth=windowWidth;
+	frameHeight=windowHeight;
+	frameOffsetX=offsetX;
+	frameOffsetY=offsetY;
+	fullDamage=true;
+	if(windowWidth==0 || windowHeight==0)
+		return;
+	if(stageTexture==0)
+		engineData->exec_glGenTextures(1, &stageTexture);
+	engineData->exec_glBindTexture_GL_TEXTURE_2D(stageTexture);
+	engineData->exec_glTexParameteri_GL_TEXTURE_2D_GL_TEXTURE_MIN_FILTER_GL_LINEAR();
+	engineData->exec_glTexParameteri_GL_TEXTURE_2D_GL_TEXTURE_MAG_FILTER_GL_LINEAR();
+	engineData->exec_glTexImage2D_GL_TEXTURE_2D_GL_UNSIGNED_BYTE(0, windowWidth, windowHeight, 0, NULL, true);
+	if(stageFramebuffer==0)
+	{
+		stageFramebuffer=engineData->exec_glGenFramebuffer();
+		engineData->exec_glBindFramebuffer_GL_FRAMEBUFFER(stageFramebuffer);
+		engineData->exec_glFramebufferTexture2D_GL_FRAMEBUFFER(stageTexture);
+		engineData->exec_glBindFramebuffer_GL_FRAMEBUFFER(0);
+	}
+	if(handleGLErrors())
+	{
+		LOG(LOG_ERROR,_("Could not create the stage texture, the whole stage will be drawn every frame"));
+		stageFramebuffer=0;
+	}
+}
+
+void RenderThread::drawStageTexture()
+{
+	//The texture covers the whole window, the projection only offsets the stage
+	lsglLoadIdentity();
+	engineData->exec_glBlendFunc(BLEND_ONE,BLEND_ONE_MINUS_SRC_ALPHA);
+	engineData->exec_glUniform1f(yuvUniform, 0);
+	engineData->exec_glUniform1f(alphaUniform, 1);
+	engineData->exec_glUniform1f(rgbaUniform, 1);
+	setMatrixUniform(LSGL_MODELVIEW);
+	engineData->exec_glBindTexture_GL_TEXTURE_2D(stageTexture);
+
+	const float left=-offsetX;
+	const float right=float(windowWidth)-offsetX;
+	const float top=-offsetY;
+	const float bottom=float(windowHeight)-offsetY;
+	//The rows of the texture are stored bottom to top
+	float vertex_coords[] = {left,top, right,top, left,bottom, right,bottom};
+	float texture_coords[] = {0,1, 1,1, 0,0, 1,0};
+	engineData->exec_glVertexAttribPointer(VERTEX_ATTRIB, 0, vertex_coords,FLOAT_2);
+	engineData->exec_glVertexAttribPointer(TEXCOORD_ATTRIB, 0, texture_coords,FLOAT_2);
+	engineData->exec_glEnableVertexAttribArray(VERTEX_ATTRIB);
+	engineData->exec_glEnableVertexAttribArray(TEXCOORD_ATTRIB);
+	engineData->exec_glDrawArrays_GL_TRIANGLE_STRIP(0, 4);
+	engineData->exec_glDisableVertexAttribArray(VERTEX_ATTRIB);
+	engineData->exec_glDisableVertexAttribArray(TEXCOORD_ATTRIB);
+	engineData->exec_glUniform1f(rgbaUniform, 0);
+}
+
+void RenderThread::softwareResize()
+{
+	m_sys->stageCoordinateMapping(windowWidth, windowHeight, offsetX, offsetY, scaleX, scaleY);
+	softwareContext->resize(windowWidth, windowHeight, offsetX, offsetY);
 }
 
 void RenderThread::requestResize(uint32_t w, uint32_t h, bool force)
@@ -623,18 +833,70 @@ void RenderThread::plotProfilingData()
 bool RenderThread::coreRendering()
 {
 	Locker l(mutexRendering);
-	engineData->exec_glBindFramebuffer_GL_FRAMEBUFFER(0);
+	if(softwareContext)
+	{
+		softwareContext->beginFrame(m_sys->mainClip->getBackground());
+		softwareContext->lsglLoadIdentity();
+		bool ret = m_sys->stage->Render(*softwareContext);
+		//The frame is not shown if some objects are still being drawn
+		if(!ret)
+			softwareContext->endFrame();
+		return ret;
+	}
 	engineData->exec_glFrontFace(false);
-	engineData->exec_glDrawBuffer_GL_BACK();
-	//Clear the back buffer
 	RGB bg=m_sys->mainClip->getBackground();
 	engineData->exec_glClearColor(bg.Red/255.0F,bg.Green/255.0F,bg.Blue/255.0F,1);
-	engineData->exec_glClear_GL_COLOR_BUFFER_BIT();
 	engineData->exec_glUseProgram(gpu_program);
-	lsglLoadIdentity();
-	setMatrixUniform(LSGL_MODELVIEW);
-
-	bool ret = m_sys->stage->Render(*this);
+	bool ret;
+	//Stage3D draws straight to the back buffer
+	if(stageFramebuffer==0 || m_sys->stage->renderStage3D())
+	{
+		engineData->exec_glBindFramebuffer_GL_FRAMEBUFFER(0);
+		engineData->exec_glDrawBuffer_GL_BACK();
+		//Clear the back buffer
+		engineData->exec_glClear_GL_COLOR_BUFFER_BIT();
+		lsglLoadIdentity();
+		setMatrixUniform(LSGL_MODELVIEW);
+		ret = m_sys->stage->Render(*this);
+		//The stage texture was not updated
+		fullDamage=true;
+		uploadedBlocks.clear();
+	}
+	else
+	{
+		if(bg.toUInt()!=lastBackground)
+			fullDamage=true;
+		lastBackground=bg.toUInt();
+		//The quads are only recorded by Render, then drawn in the damaged areas
+		quads.clear();
+		chunkIndices.clear();
+		blendMode=BLENDMODE_NORMAL;
+		lsglLoadIdentity();
+		recordQuads=true;
+		ret = m_sys->stage->Render(*this);
+		recordQuads=false;
+		engineData->exec_glBindFramebuffer_GL_FRAMEBUFFER(stageFramebuffer);
+		//The frame is not shown if some objects are still being drawn
+		if(!ret)
+		{
+			computeDamage();
+			for(auto it=damage.begin();it!=damage.end();++it)
+			{
+				const DamageRegion::rect& r=*it;
+				engineData->exec_glScissor(r.xmin, windowHeight-r.ymax, r.xmax-r.xmin, r.ymax-r.ymin);
+				engineData->exec_glClear_GL_COLOR_BUFFER_BIT();
+				replayQuads(r);
+			}
+			engineData->exec_glDisable_GL_SCISSOR_TEST();
+			fullDamage=false;
+			uploadedBlocks.clear();
+			lastQuads.swap(quads);
+			lastChunkIndices.swap(chunkIndices);
+		}
+		engineData->exec_glBindFramebuffer_GL_FRAMEBUFFER(0);
+		engineData->exec_glDrawBuffer_GL_BACK();
+		drawStageTexture();
+	}
 
 	if(m_sys->showProfilingData)
 		plotProfilingData();
@@ -937,6 +1199,11 @@ void RenderThread::loadChunkBGRA(const TextureChunk& chunk, uint32_t w, uint32_t
 	//Fast bailout if the TextureChunk is not valid
 	if(chunk.chunks==NULL)
 		return;
+	if(softwareContext)
+	{
+		softwareContext->loadChunkBGRA(chunk, w, h, data);
+		return;
+	}
 	engineData->exec_glBindTexture_GL_TEXTURE_2D(largeTextures[chunk.texId].id);
 	//TODO: Detect continuos
 	//The size is ok if doesn't grow over the allocated size
@@ -955,6 +1222,7 @@ void RenderThread::loadChunkBGRA(const TextureChunk& chunk, uint32_t w, uint32_t
 		uint32_t sizeY=min(int(h-curY),CHUNKSIZE);
 		engineData->exec_glPixelStorei_GL_UNPACK_SKIP_PIXELS(curX);
 		engineData->exec_glPixelStorei_GL_UNPACK_SKIP_ROWS(curY);
+		uploadedBlocks.insert(chunk.texId*blocksPerSide*blocksPerSide+chunk.chunks[i]);
 		const uint32_t blockX=((chunk.chunks[i]%blocksPerSide)*CHUNKSIZE);
 		const uint32_t blockY=((chunk.chunks[i]/blocksPerSide)*CHUNKSIZE);
 		engineData->exec_glTexSubImage2D_GL_TEXTURE_2D(0, blockX, blockY, sizeX, sizeY, data,w,curX,curY);
@@ -31,11 +31,17 @@
 namespace lightspark
 {
 class ThreadProfile;
+class SoftwareRenderContext;
+
+//Milliseconds a captured frame waits for the objects that are still being drawn
+#define CAPTURE_MAX_WAIT 1000
 
 class DLL_PUBLIC RenderThread: public ITickJob, public GLRenderContext
 {
 friend class DisplayObject;
 friend class Context3D;
+public:
+	enum FRAME_FORMAT { FRAME_BMP=0, FRAME_PNG, FRAME_RAW };
 private:
 	SystemState* m_sys;
 	SDL_Thread* t;
@@ -47,6 +53,29 @@ private:
 	void commonGLInit(int width, int height);
 	void commonGLResize();
 	void commonGLDeinit();
+	/*
+	 * The stage is drawn in a texture that keeps the previous frame, so
+	 * that only the damaged areas have to be drawn again. The texture is
+	 * then copied to the back buffer
+	 */
+	uint32_t stageTexture;
+	uint32_t stageFramebuffer;
+	uint32_t lastBackground;
+	void drawStageTexture();
+	//Only used when compositing on the CPU (EngineData::softwarerendering)
+	SoftwareRenderContext* softwareContext;
+	void softwareResize();
+	std::string frameDumpPath;
+	FRAME_FORMAT frameDumpFormat;
+	//Set when frameDumpPath is not a directory, the frames are written in sequence
+	FILE* frameDumpFile;
+	uint32_t dumpedFrames;
+	void dumpFrame();
+	//Set by captureFrame until the frame has been written
+	volatile bool captureNeeded;
+	uint32_t captureRetries;
+	Semaphore captureDone;
+	void finishCapture();
 	ITextureUploadable* prevUploadJob;
 	uint32_t allocateNewGLTexture() const;
 	LargeTexture& allocateNewTexture();
@@ -111,6 +140,18 @@ public:
 	void deinit();
 	bool doRender(ThreadProfile *profile=NULL, Chronometer *chronometer=NULL);
 	void generateScreenshot();
+	/*
+	 * Where the software renderer writes every composited frame: numbered
+	 * files if path is a directory, one after the other in the file (e.g. a
+	 * pipe) otherwise
+	 */
+	void setFrameDump(const std::string& path, FRAME_FORMAT format);
+	/*
+	 * Renders the stage and waits until the frame has been written.
+	 * Used by the offline capture (SystemState::offlineCapture), that only
+	 * writes the captured frames. Returns false if the thread is not running
+	 */
+	bool captureFrame();
 
 	/**
 		Allocates a chunk from the shared texture
@@ -145,6 +186,7 @@ public:
 	volatile uint32_t windowHeight;
 	int fragmentTexScaleUniform;
 	int directUniform;
+	int rgbaUniform;
 
 	void renderErrorPage(RenderThread *rt, bool standalone);
 
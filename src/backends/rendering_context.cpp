@@ -28,6 +28,8 @@
 //- the projection of modelview matrix uniforms sent to the shader - only when
 //explicitly calling setMatrixUniform.
 
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
 #include <cstring>
 #include <stack>
@@ -49,6 +51,36 @@ const float RenderContext::lsIdentityMatrix[16] = {
 
 const CachedSurface CairoRenderContext::invalidSurface;
 
+void DamageRegion::add(const rect& r)
+{
+	for(auto it=rects.begin();it!=rects.end();++it)
+	{
+		//Overlapping areas are merged
+		if(r.xmin<=it->xmax && it->xmin<=r.xmax && r.ymin<=it->ymax && it->ymin<=r.ymax)
+		{
+			it->xmin=min(it->xmin,r.xmin);
+			it->ymin=min(it->ymin,r.ymin);
+			it->xmax=max(it->xmax,r.xmax);
+			it->ymax=max(it->ymax,r.ymax);
+			return;
+		}
+	}
+	if(rects.size()<MAX_DAMAGE_RECTS)
+	{
+		rects.push_back(r);
+		return;
+	}
+	rect b=r;
+	for(auto it=rects.begin();it!=rects.end();++it)
+	{
+		b.xmin=min(it->xmin,b.xmin);
+		b.ymin=min(it->ymin,b.ymin);
+		b.xmax=max(it->xmax,b.xmax);
+		b.ymax=max(it->ymax,b.ymax);
+	}
+	rects.assign(1,b);
+}
+
 RenderContext::RenderContext(CONTEXT_TYPE t):contextType(t)
 {
 	lsglLoadIdentity();
@@ -126,6 +158,11 @@ const CachedSurface& GLRenderContext::getCachedSurface(const DisplayObject* d) c
 
 void GLRenderContext::setProperties(AS_BLENDMODE blendmode)
 {
+	if(recordQuads)
+	{
+		blendMode=blendmode;
+		return;
+	}
 	// TODO handle other blend modes ,maybe with shaders ? (see https://github.com/jamieowen/glsl-blend)
 	switch (blendmode)
 	{
@@ -149,6 +186,113 @@ void GLRenderContext::setProperties(AS_BLENDMODE blendmode)
 
 void GLRenderContext::renderTextured(const TextureChunk& chunk, int32_t x, int32_t y, uint32_t w, uint32_t h,
 			float alpha, COLOR_MODE colorMode)
+{
+	if(!recordQuads)
+	{
+		drawQuad(chunk.texId, chunk.chunks, chunk.width, chunk.height, x, y, w, h, alpha, colorMode);
+		return;
+	}
+	if(!chunk.isValid())
+		return;
+	glQuad q;
+	memcpy(q.matrix, lsMVPMatrix, LSGL_MATRIX_SIZE);
+	q.x=x;
+	q.y=y;
+	q.w=w;
+	q.h=h;
+	q.alpha=alpha;
+	q.colorMode=colorMode;
+	q.blendMode=blendMode;
+	q.texId=chunk.texId;
+	q.width=chunk.width;
+	q.height=chunk.height;
+
+	//Bounding box of the transformed quad, the projection only offsets the stage
+	const float ox=(x<0)?0:x;
+	const float oy=(y<0)?0:y;
+	const float quadX[4]={ox, ox+w, ox, ox+w};
+	const float quadY[4]={oy, oy, oy+h, oy+h};
+	float cornersX[4];
+	float cornersY[4];
+	for(int i=0;i<4;i++)
+	{
+		cornersX[i]=frameOffsetX+lsMVPMatrix[0]*quadX[i]+lsMVPMatrix[4]*quadY[i]+lsMVPMatrix[12];
+		cornersY[i]=frameOffsetY+lsMVPMatrix[1]*quadX[i]+lsMVPMatrix[5]*quadY[i]+lsMVPMatrix[13];
+	}
+	q.bounds.xmin=max(int32_t(floorf(*min_element(cornersX,cornersX+4))),0);
+	q.bounds.xmax=min(int32_t(ceilf(*max_element(cornersX,cornersX+4))),int32_t(frameWidth));
+	q.bounds.ymin=max(int32_t(floorf(*min_element(cornersY,cornersY+4))),0);
+	q.bounds.ymax=min(int32_t(ceilf(*max_element(cornersY,cornersY+4))),int32_t(frameHeight));
+	if(q.bounds.xmin>=q.bounds.xmax || q.bounds.ymin>=q.bounds.ymax)
+		return;
+
+	//The chunk may be reallocated before the quad is drawn, keep a copy of its blocks
+	q.firstChunk=chunkIndices.size();
+	chunkIndices.insert(chunkIndices.end(),chunk.chunks,chunk.chunks+chunk.getNumberOfChunks());
+	quads.push_back(q);
+}
+
+bool GLRenderContext::sameQuad(const glQuad& q, const glQuad& last) const
+{
+	if(memcmp(q.matrix,last.matrix,LSGL_MATRIX_SIZE) || q.x!=last.x || q.y!=last.y || q.w!=last.w || q.h!=last.h ||
+	   q.alpha!=last.alpha || q.colorMode!=last.colorMode || q.blendMode!=last.blendMode ||
+	   q.texId!=last.texId || q.width!=last.width || q.height!=last.height)
+		return false;
+	const uint32_t count=((q.width+CHUNKSIZE-1)/CHUNKSIZE)*((q.height+CHUNKSIZE-1)/CHUNKSIZE);
+	return equal(chunkIndices.begin()+q.firstChunk,chunkIndices.begin()+q.firstChunk+count,
+		     lastChunkIndices.begin()+last.firstChunk);
+}
+
+bool GLRenderContext::isUploaded(const glQuad& q) const
+{
+	const uint32_t blocksPerSide=largeTextureSize/CHUNKSIZE;
+	const uint32_t count=((q.width+CHUNKSIZE-1)/CHUNKSIZE)*((q.height+CHUNKSIZE-1)/CHUNKSIZE);
+	for(uint32_t i=0;i<count;i++)
+	{
+		if(uploadedBlocks.count(q.texId*blocksPerSide*blocksPerSide+chunkIndices[q.firstChunk+i]))
+			return true;
+	}
+	return false;
+}
+
+void GLRenderContext::computeDamage()
+{
+	damage.clear();
+	if(fullDamage)
+	{
+		DamageRegion::rect r={0,0,int32_t(frameWidth),int32_t(frameHeight)};
+		damage.add(r);
+		return;
+	}
+	const uint32_t common=min(quads.size(),lastQuads.size());
+	for(uint32_t i=0;i<common;i++)
+	{
+		if(sameQuad(quads[i],lastQuads[i]) && !isUploaded(quads[i]))
+			continue;
+		damage.add(quads[i].bounds);
+		damage.add(lastQuads[i].bounds);
+	}
+	for(uint32_t i=common;i<quads.size();i++)
+		damage.add(quads[i].bounds);
+	for(uint32_t i=common;i<lastQuads.size();i++)
+		damage.add(lastQuads[i].bounds);
+}
+
+void GLRenderContext::replayQuads(const DamageRegion::rect& r)
+{
+	for(auto it=quads.begin();it!=quads.end();++it)
+	{
+		const glQuad& q=*it;
+		if(q.bounds.xmax<=r.xmin || r.xmax<=q.bounds.xmin || q.bounds.ymax<=r.ymin || r.ymax<=q.bounds.ymin)
+			continue;
+		setProperties(q.blendMode);
+		lsglLoadMatrixf(q.matrix);
+		drawQuad(q.texId, chunkIndices.data()+q.firstChunk, q.width, q.height, q.x, q.y, q.w, q.h, q.alpha, q.colorMode);
+	}
+}
+
+void GLRenderContext::drawQuad(uint32_t texId, const uint32_t* chunks, uint32_t chunkWidth, uint32_t chunkHeight,
+			int32_t x, int32_t y, uint32_t w, uint32_t h, float alpha, COLOR_MODE colorMode)
 {
 	//Set color mode
 	engineData->exec_glUniform1f(yuvUniform, (colorMode==YUV_MODE)?1:0);
@@ -157,36 +301,36 @@ void GLRenderContext::renderTextured(const TextureChunk& chunk, int32_t x, int32
 	//Set matrix
 	setMatrixUniform(LSGL_MODELVIEW);
 
-	engineData->exec_glBindTexture_GL_TEXTURE_2D(largeTextures[chunk.texId].id);
+	engineData->exec_glBindTexture_GL_TEXTURE_2D(largeTextures[texId].id);
 	const uint32_t blocksPerSide=largeTextureSize/CHUNKSIZE;
 	uint32_t startX, startY, endX, endY;
-	assert(chunk.getNumberOfChunks()==((chunk.width+CHUNKSIZE-1)/CHUNKSIZE)*((chunk.height+CHUNKSIZE-1)/CHUNKSIZE));
+	const uint32_t numberOfChunks=((chunkWidth+CHUNKSIZE-1)/CHUNKSIZE)*((chunkHeight+CHUNKSIZE-1)/CHUNKSIZE);
 
 	uint32_t curChunk=0;
 	//The 4 corners of each texture are specified as the vertices of 2 triangles,
 	//so there are 6 vertices per quad, two of them duplicated (the diagonal)
 	//Allocate the data on the stack to reduce heap fragmentation
-	float *vertex_coords = g_newa(float,chunk.getNumberOfChunks()*12);
-	float *texture_coords = g_newa(float,chunk.getNumberOfChunks()*12);
-	for(uint32_t i=0, k=0;i<chunk.height;i+=CHUNKSIZE)
+	float *vertex_coords = g_newa(float,numberOfChunks*12);
+	float *texture_coords = g_newa(float,numberOfChunks*12);
+	for(uint32_t i=0, k=0;i<chunkHeight;i+=CHUNKSIZE)
 	{
-		startY=h*i/chunk.height;
-		endY=min(h*(i+CHUNKSIZE)/chunk.height,h);
+		startY=h*i/chunkHeight;
+		endY=min(h*(i+CHUNKSIZE)/chunkHeight,h);
 		//Take yOffset into account
 		startY = (y<0)?startY:y+startY;
 		endY = (y<0)?endY:y+endY;
-		for(uint32_t j=0;j<chunk.width;j+=CHUNKSIZE)
+		for(uint32_t j=0;j<chunkWidth;j+=CHUNKSIZE)
 		{
-			startX=w*j/chunk.width;
-			endX=min(w*(j+CHUNKSIZE)/chunk.width,w);
+			startX=w*j/chunkWidth;
+			endX=min(w*(j+CHUNKSIZE)/chunkWidth,w);
 			//Take xOffset into account
 			startX = (x<0)?startX:x+startX;
 			endX = (x<0)?endX:x+endX;
-			const uint32_t curChunkId=chunk.chunks[curChunk];
+			const uint32_t curChunkId=chunks[curChunk];
 			const uint32_t blockX=((curChunkId%blocksPerSide)*CHUNKSIZE);
 			const uint32_t blockY=((curChunkId/blocksPerSide)*CHUNKSIZE);
-			const uint32_t availX=min(int(chunk.width-j),CHUNKSIZE);
-			const uint32_t availY=min(int(chunk.height-i),CHUNKSIZE);
+			const uint32_t availX=min(int(chunkWidth-j),CHUNKSIZE);
+			const uint32_t availY=min(int(chunkHeight-i),CHUNKSIZE);
 			float startU=blockX;
 			startU/=largeTextureSize;
 			float startV=blockY;
@@ -21,6 +21,8 @@
 #define BACKENDS_RENDERING_CONTEXT_H 1
 
 #include <stack>
+#include <vector>
+#include <unordered_set>
 #include "backends/graphics.h"
 #include "platforms/engineutils.h"
 
@@ -29,6 +31,28 @@ namespace lightspark
 
 enum VertexAttrib { VERTEX_ATTRIB=0, COLOR_ATTRIB, TEXCOORD_ATTRIB};
 
+//Damaged areas beyond this number are merged in their bounding box
+#define MAX_DAMAGE_RECTS 16
+
+/*
+ * Areas of a frame that must be drawn again, in pixels from the top left
+ * corner. Overlapping areas are merged.
+ */
+class DamageRegion
+{
+public:
+	struct rect
+	{
+		int32_t xmin,ymin,xmax,ymax;
+	};
+	void clear() { rects.clear(); }
+	void add(const rect& r);
+	std::vector<rect>::const_iterator begin() const { return rects.begin(); }
+	std::vector<rect>::const_iterator end() const { return rects.end(); }
+private:
+	std::vector<rect> rects;
+};
+
 /*
  * The RenderContext contains all (public) functions that are needed by DisplayObjects to draw themselves.
  */
@@ -42,7 +66,7 @@ protected:
 	~RenderContext(){}
 	void lsglMultMatrixf(const float *m);
 public:
-	enum CONTEXT_TYPE { CAIRO=0, GL };
+	enum CONTEXT_TYPE { CAIRO=0, GL, SOFTWARE };
 	RenderContext(CONTEXT_TYPE t);
 	CONTEXT_TYPE contextType;
 
@@ -92,6 +116,53 @@ protected:
 	};
 	std::vector<LargeTexture> largeTextures;
 
+	/* Partial redraw */
+	struct glQuad
+	{
+		float matrix[16];
+		int32_t x,y;
+		uint32_t w,h;
+		float alpha;
+		COLOR_MODE colorMode;
+		AS_BLENDMODE blendMode;
+		uint32_t texId;
+		uint32_t width;
+		uint32_t height;
+		//Position of the chunk indices in chunkIndices
+		uint32_t firstChunk;
+		//Area of the frame covered by the quad
+		DamageRegion::rect bounds;
+	};
+	//Set while the quads are recorded instead of drawn
+	bool recordQuads;
+	AS_BLENDMODE blendMode;
+	//Size of the frame and position of the stage inside it
+	uint32_t frameWidth;
+	uint32_t frameHeight;
+	int32_t frameOffsetX;
+	int32_t frameOffsetY;
+	std::vector<glQuad> quads;
+	std::vector<uint32_t> chunkIndices;
+	//Quads of the last drawn frame
+	std::vector<glQuad> lastQuads;
+	std::vector<uint32_t> lastChunkIndices;
+	//Blocks uploaded since the last drawn frame, as texId*blocks per texture+block
+	std::unordered_set<uint32_t> uploadedBlocks;
+	DamageRegion damage;
+	//Set when the whole frame must be drawn again
+	bool fullDamage;
+	void drawQuad(uint32_t texId, const uint32_t* chunks, uint32_t chunkWidth, uint32_t chunkHeight,
+			int32_t x, int32_t y, uint32_t w, uint32_t h, float alpha, COLOR_MODE colorMode);
+	bool sameQuad(const glQuad& q, const glQuad& last) const;
+	bool isUploaded(const glQuad& q) const;
+	/*
+	 * Compares the recorded quads with the ones of the last frame and
+	 * collects the areas that changed in damage
+	 */
+	void computeDamage();
+	//Draws the recorded quads touching r
+	void replayQuads(const DamageRegion::rect& r);
+
 	~GLRenderContext(){}
 
 public:
@@ -100,7 +171,8 @@ public:
 	 * Uploads the current matrix as the specified type.
 	 */
 	void setMatrixUniform(LSGL_MATRIX m) const;
-	GLRenderContext() : RenderContext(GL),engineData(NULL), largeTextureSize(0)
+	GLRenderContext() : RenderContext(GL),engineData(NULL), largeTextureSize(0),recordQuads(false),
+		blendMode(BLENDMODE_NORMAL),frameWidth(0),frameHeight(0),frameOffsetX(0),frameOffsetY(0),fullDamage(true)
 	{
 	}
 	void SetEngineData(EngineData* data) { engineData = data;}
@@ -0,0 +1,668 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "backends/softwarerendering.h"
+#include "backends/bitmapfilters.h"
+#include "scripting/flash/display/DisplayObject.h"
+#include "backends/image.h"
+#include "logger.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define COMPOSITE_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define COMPOSITE_NEON 1
+#endif
+
+using namespace std;
+using namespace lightspark;
+
+namespace
+{
+
+/*
+ * All the kernels work on premultiplied, native-endian ARGB pixels,
+ * the alpha of the pixels is expected in the byte 3 by the SIMD versions
+ */
+
+//Exact x*y/255 for x*y in [0,255*255]
+inline int32_t div255(int32_t x)
+{
+	x+=128;
+	return (x+(x>>8))>>8;
+}
+
+//Multiplies all the channels by a/255
+inline uint32_t scalePixel(uint32_t p, uint32_t a)
+{
+	uint32_t rb=(p&0xff00ff)*a+0x800080;
+	rb=((rb+((rb>>8)&0xff00ff))>>8)&0xff00ff;
+	uint32_t ag=((p>>8)&0xff00ff)*a+0x800080;
+	ag=(ag+((ag>>8)&0xff00ff))&0xff00ff00;
+	return rb|ag;
+}
+
+//Linear interpolation between p and q, w is in [0,256]
+inline uint32_t lerpPixel(uint32_t p, uint32_t q, uint32_t w)
+{
+	const uint32_t rb=((p&0xff00ff)*(256-w)+(q&0xff00ff)*w)>>8;
+	const uint32_t ag=(((p>>8)&0xff00ff)*(256-w)+((q>>8)&0xff00ff)*w)>>8;
+	return (rb&0xff00ff)|((ag&0xff00ff)<<8);
+}
+
+inline uint32_t blendNormalPixel(uint32_t d, uint32_t s)
+{
+	return s+scalePixel(d,255-(s>>24));
+}
+
+inline uint32_t blendAddPixel(uint32_t d, uint32_t s)
+{
+	uint32_t ret=0;
+	for(int i=0;i<32;i+=8)
+		ret|=uint32_t(imin(((d>>i)&0xff)+((s>>i)&0xff),255))<<i;
+	return ret;
+}
+
+//W3C hard light on premultiplied channels, overlay is hard light with source and destination swapped
+inline int32_t hardLight(int32_t sc, int32_t sa, int32_t dc, int32_t da)
+{
+	const int32_t r=div255(sc*(255-da))+div255(dc*(255-sa));
+	if(2*sc<=sa)
+		return r+2*div255(sc*dc);
+	return r+div255(sa*da)-2*div255((da-dc)*(sa-sc));
+}
+
+uint32_t blendPixel(uint32_t d, uint32_t s, AS_BLENDMODE mode)
+{
+	const int32_t sa=s>>24;
+	const int32_t da=d>>24;
+	switch(mode)
+	{
+		case BLENDMODE_ADD:
+			return blendAddPixel(d,s);
+		case BLENDMODE_ALPHA:
+			return scalePixel(d,sa);
+		case BLENDMODE_ERASE:
+			return scalePixel(d,255-sa);
+		default:
+			break;
+	}
+	//The inverted background keeps its alpha
+	uint32_t ret=(mode==BLENDMODE_INVERT)?da:sa+da-div255(sa*da);
+	ret<<=24;
+	for(int i=0;i<24;i+=8)
+	{
+		const int32_t sc=(s>>i)&0xff;
+		const int32_t dc=(d>>i)&0xff;
+		int32_t r;
+		switch(mode)
+		{
+			case BLENDMODE_MULTIPLY:
+				r=div255(sc*dc)+div255(sc*(255-da))+div255(dc*(255-sa));
+				break;
+			case BLENDMODE_SCREEN:
+				r=sc+dc-div255(sc*dc);
+				break;
+			case BLENDMODE_LIGHTEN:
+				r=sc+dc-imin(div255(sc*da),div255(dc*sa));
+				break;
+			case BLENDMODE_DARKEN:
+				r=sc+dc-imax(div255(sc*da),div255(dc*sa));
+				break;
+			case BLENDMODE_DIFFERENCE:
+				r=sc+dc-2*imin(div255(sc*da),div255(dc*sa));
+				break;
+			case BLENDMODE_SUBTRACT:
+				r=dc-sc;
+				break;
+			case BLENDMODE_INVERT:
+				r=div255((da-dc)*sa)+div255(dc*(255-sa));
+				break;
+			case BLENDMODE_OVERLAY:
+				r=hardLight(dc,da,sc,sa);
+				break;
+			case BLENDMODE_HARDLIGHT:
+				r=hardLight(sc,sa,dc,da);
+				break;
+			default:
+				r=sc+div255(dc*(255-sa));
+				break;
+		}
+		ret|=uint32_t(imin(imax(r,0),255))<<i;
+	}
+	return ret;
+}
+
+#if defined(COMPOSITE_SSE2)
+//Exact x*y/255 on 16 bit lanes
+inline __m128i mulDiv255(__m128i x, __m128i y)
+{
+	__m128i t=_mm_add_epi16(_mm_mullo_epi16(x,y),_mm_set1_epi16(128));
+	return _mm_srli_epi16(_mm_add_epi16(t,_mm_srli_epi16(t,8)),8);
+}
+//Copies the alpha of each of the 2 pixels in v to all of its lanes
+inline __m128i broadcastAlpha(__m128i v)
+{
+	return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v,_MM_SHUFFLE(3,3,3,3)),_MM_SHUFFLE(3,3,3,3));
+}
+#elif defined(COMPOSITE_NEON)
+//Exact x*y/255 on 8 lanes
+inline uint8x8_t mulDiv255(uint8x8_t x, uint8x8_t y)
+{
+	uint16x8_t t=vmull_u8(x,y);
+	return vraddhn_u16(t,vrshrq_n_u16(t,8));
+}
+#endif
+
+void scaleSpan(uint32_t* p, int32_t count, uint32_t alpha)
+{
+	int32_t i=0;
+#if defined(COMPOSITE_SSE2)
+	const __m128i z=_mm_setzero_si128();
+	const __m128i a=_mm_set1_epi16(alpha);
+	for(;i+4<=count;i+=4)
+	{
+		__m128i v=_mm_loadu_si128((const __m128i*)(p+i));
+		__m128i lo=mulDiv255(_mm_unpacklo_epi8(v,z),a);
+		__m128i hi=mulDiv255(_mm_unpackhi_epi8(v,z),a);
+		_mm_storeu_si128((__m128i*)(p+i),_mm_packus_epi16(lo,hi));
+	}
+#elif defined(COMPOSITE_NEON)
+	const uint8x8_t a=vdup_n_u8(alpha);
+	for(;i+8<=count;i+=8)
+	{
+		uint8x8x4_t v=vld4_u8((const uint8_t*)(p+i));
+		for(int c=0;c<4;c++)
+			v.val[c]=mulDiv255(v.val[c],a);
+		vst4_u8((uint8_t*)(p+i),v);
+	}
+#endif
+	for(;i<count;i++)
+		p[i]=scalePixel(p[i],alpha);
+}
+
+void blendNormalSpan(uint32_t* d, const uint32_t* s, int32_t count)
+{
+	int32_t i=0;
+#if defined(COMPOSITE_SSE2)
+	const __m128i z=_mm_setzero_si128();
+	const __m128i ff=_mm_set1_epi16(255);
+	for(;i+4<=count;i+=4)
+	{
+		__m128i sv=_mm_loadu_si128((const __m128i*)(s+i));
+		//Fully transparent pixels are common around shapes
+		if(_mm_movemask_epi8(_mm_cmpeq_epi32(sv,z))==0xffff)
+			continue;
+		__m128i dv=_mm_loadu_si128((const __m128i*)(d+i));
+		__m128i slo=_mm_unpacklo_epi8(sv,z);
+		__m128i shi=_mm_unpackhi_epi8(sv,z);
+		__m128i dlo=mulDiv255(_mm_unpacklo_epi8(dv,z),_mm_sub_epi16(ff,broadcastAlpha(slo)));
+		__m128i dhi=mulDiv255(_mm_unpackhi_epi8(dv,z),_mm_sub_epi16(ff,broadcastAlpha(shi)));
+		_mm_storeu_si128((__m128i*)(d+i),_mm_packus_epi16(_mm_add_epi16(slo,dlo),_mm_add_epi16(shi,dhi)));
+	}
+#elif defined(COMPOSITE_NEON)
+	for(;i+8<=count;i+=8)
+	{
+		uint8x8x4_t sv=vld4_u8((const uint8_t*)(s+i));
+		uint8x8x4_t dv=vld4_u8((const uint8_t*)(d+i));
+		const uint8x8_t inv=vmvn_u8(sv.val[3]);
+		for(int c=0;c<4;c++)
+			dv.val[c]=vqadd_u8(sv.val[c],mulDiv255(dv.val[c],inv));
+		vst4_u8((uint8_t*)(d+i),dv);
+	}
+#endif
+	for(;i<count;i++)
+		d[i]=blendNormalPixel(d[i],s[i]);
+}
+
+void blendAddSpan(uint32_t* d, const uint32_t* s, int32_t count)
+{
+	int32_t i=0;
+#if defined(COMPOSITE_SSE2)
+	for(;i+4<=count;i+=4)
+	{
+		__m128i sv=_mm_loadu_si128((const __m128i*)(s+i));
+		__m128i dv=_mm_loadu_si128((const __m128i*)(d+i));
+		_mm_storeu_si128((__m128i*)(d+i),_mm_adds_epu8(dv,sv));
+	}
+#elif defined(COMPOSITE_NEON)
+	for(;i+4<=count;i+=4)
+		vst1q_u8((uint8_t*)(d+i),vqaddq_u8(vld1q_u8((const uint8_t*)(d+i)),vld1q_u8((const uint8_t*)(s+i))));
+#endif
+	for(;i<count;i++)
+		d[i]=blendAddPixel(d[i],s[i]);
+}
+
+/*
+ * Blends count pixels of s, multiplied by alpha/255, on d.
+ * s is used as scratch space.
+ */
+void blendSpan(uint32_t* d, uint32_t* s, int32_t count, uint32_t alpha, AS_BLENDMODE mode)
+{
+	if(alpha!=255)
+		scaleSpan(s,count,alpha);
+	switch(mode)
+	{
+		case BLENDMODE_NORMAL:
+		case BLENDMODE_LAYER:
+			blendNormalSpan(d,s,count);
+			break;
+		case BLENDMODE_ADD:
+			blendAddSpan(d,s,count);
+			break;
+		default:
+			for(int32_t i=0;i<count;i++)
+				d[i]=blendPixel(d[i],s[i],mode);
+			break;
+	}
+}
+
+inline void writeLE32(uint8_t* p, uint32_t v)
+{
+	p[0]=v&0xff;
+	p[1]=(v>>8)&0xff;
+	p[2]=(v>>16)&0xff;
+	p[3]=(v>>24)&0xff;
+}
+
+void writePNGData(png_structp pngPtr, png_bytep data, png_size_t length)
+{
+	vector<uint8_t>* out=reinterpret_cast<vector<uint8_t>*>(png_get_io_ptr(pngPtr));
+	out->insert(out->end(),data,data+length);
+}
+
+void flushPNGData(png_structp)
+{
+}
+
+};
+
+SoftwareRenderContext::SoftwareRenderContext(SystemState* s, uint32_t textureSize):RenderContext(SOFTWARE),
+	m_sys(s),pixels(nullptr),width(0),height(0),offsetX(0),offsetY(0),background(0xff000000),
+	pageSize(textureSize),fullDamage(true),blendMode(BLENDMODE_NORMAL)
+{
+}
+
+SoftwareRenderContext::~SoftwareRenderContext()
+{
+	delete[] pixels;
+	for(uint32_t i=0;i<pages.size();i++)
+		delete[] pages[i];
+}
+
+void SoftwareRenderContext::resize(uint32_t w, uint32_t h, int32_t offX, int32_t offY)
+{
+	delete[] pixels;
+	pixels=(w && h)?new uint32_t[w*h]:nullptr;
+	width=pixels?w:0;
+	height=pixels?h:0;
+	offsetX=offX;
+	offsetY=offY;
+	if(pixels)
+		std::fill(pixels,pixels+width*height,background);
+	fullDamage=true;
+}
+
+uint8_t* SoftwareRenderContext::getUploadBuffer(uint32_t w, uint32_t h)
+{
+	if(uploadBuffer.size()<w*h*4)
+		uploadBuffer.resize(w*h*4);
+	return uploadBuffer.data();
+}
+
+void SoftwareRenderContext::loadChunkBGRA(const TextureChunk& chunk, uint32_t w, uint32_t h, const uint8_t* data)
+{
+	if(chunk.chunks==nullptr)
+		return;
+	if(pages.size()<=chunk.texId)
+		pages.resize(chunk.texId+1,nullptr);
+	if(pages[chunk.texId]==nullptr)
+		pages[chunk.texId]=new uint32_t[pageSize*pageSize];
+	uint32_t* page=pages[chunk.texId];
+	//Same layout of the blocks as in RenderThread::loadChunkBGRA
+	const uint32_t numberOfChunks=chunk.getNumberOfChunks();
+	const uint32_t blocksPerSide=pageSize/CHUNKSIZE;
+	const uint32_t blocksW=(w+CHUNKSIZE-1)/CHUNKSIZE;
+	for(uint32_t i=0;i<numberOfChunks;i++)
+	{
+		const uint32_t curX=(i%blocksW)*CHUNKSIZE;
+		const uint32_t curY=(i/blocksW)*CHUNKSIZE;
+		if(curX>=w || curY>=h)
+			continue;
+		const uint32_t sizeX=min<uint32_t>(w-curX,CHUNKSIZE);
+		const uint32_t sizeY=min<uint32_t>(h-curY,CHUNKSIZE);
+		uploadedBlocks.insert(chunk.texId*blocksPerSide*blocksPerSide+chunk.chunks[i]);
+		const uint32_t blockX=((chunk.chunks[i]%blocksPerSide)*CHUNKSIZE);
+		const uint32_t blockY=((chunk.chunks[i]/blocksPerSide)*CHUNKSIZE);
+		for(uint32_t j=0;j<sizeY;j++)
+			memcpy(page+(blockY+j)*pageSize+blockX,data+((curY+j)*w+curX)*4,sizeX*4);
+	}
+}
+
+void SoftwareRenderContext::beginFrame(const RGB& bg)
+{
+	commands.clear();
+	chunkIndices.clear();
+	uint32_t color=0xff000000|(bg.Red<<16)|(bg.Green<<8)|bg.Blue;
+	if(color!=background)
+		fullDamage=true;
+	background=color;
+	blendMode=BLENDMODE_NORMAL;
+}
+
+bool SoftwareRenderContext::sameQuad(const drawCommand& c, const drawCommand& last) const
+{
+	if(c.sx!=last.sx || c.sy!=last.sy || c.s0!=last.s0 || c.tx!=last.tx || c.ty!=last.ty || c.t0!=last.t0 ||
+	   c.xmin!=last.xmin || c.ymin!=last.ymin || c.xmax!=last.xmax || c.ymax!=last.ymax ||
+	   c.texId!=last.texId || c.width!=last.width || c.height!=last.height ||
+	   c.alpha!=last.alpha || c.blendMode!=last.blendMode)
+		return false;
+	const uint32_t count=((c.width+CHUNKSIZE-1)/CHUNKSIZE)*((c.height+CHUNKSIZE-1)/CHUNKSIZE);
+	return equal(chunkIndices.begin()+c.firstChunk,chunkIndices.begin()+c.firstChunk+count,
+		     lastChunkIndices.begin()+last.firstChunk);
+}
+
+bool SoftwareRenderContext::isUploaded(const drawCommand& c) const
+{
+	const uint32_t blocksPerSide=pageSize/CHUNKSIZE;
+	const uint32_t count=((c.width+CHUNKSIZE-1)/CHUNKSIZE)*((c.height+CHUNKSIZE-1)/CHUNKSIZE);
+	for(uint32_t i=0;i<count;i++)
+	{
+		if(uploadedBlocks.count(c.texId*blocksPerSide*blocksPerSide+chunkIndices[c.firstChunk+i]))
+			return true;
+	}
+	return false;
+}
+
+/*
+ * The pixels covered by a quad only change if the quad itself or one of the
+ * quads drawn at the same position in the previous frame differ
+ */
+void SoftwareRenderContext::computeDamage()
+{
+	damage.clear();
+	if(fullDamage)
+	{
+		DamageRegion::rect r={0,0,int32_t(width),int32_t(height)};
+		damage.add(r);
+		return;
+	}
+	const uint32_t common=min(commands.size(),lastCommands.size());
+	for(uint32_t i=0;i<common;i++)
+	{
+		if(sameQuad(commands[i],lastCommands[i]) && !isUploaded(commands[i]))
+			continue;
+		damage.add(commands[i].bounds());
+		damage.add(lastCommands[i].bounds());
+	}
+	for(uint32_t i=common;i<commands.size();i++)
+		damage.add(commands[i].bounds());
+	for(uint32_t i=common;i<lastCommands.size();i++)
+		damage.add(lastCommands[i].bounds());
+}
+
+void SoftwareRenderContext::endFrame()
+{
+	if(pixels==nullptr)
+		return;
+	computeDamage();
+	for(auto it=damage.begin();it!=damage.end();++it)
+	{
+		const DamageRegion::rect& r=*it;
+		parallelFilterRange(m_sys,r.ymax-r.ymin,[this,&r](int32_t begin, int32_t end)
+		{
+			compositeRows(r,r.ymin+begin,r.ymin+end);
+		});
+	}
+	fullDamage=false;
+	uploadedBlocks.clear();
+	lastCommands.swap(commands);
+	lastChunkIndices.swap(chunkIndices);
+}
+
+void SoftwareRenderContext::renderTextured(const TextureChunk& chunk, int32_t x, int32_t y, uint32_t w, uint32_t h,
+			float alpha, COLOR_MODE colorMode)
+{
+	if (colorMode != RGB_MODE)
+	{
+		LOG(LOG_NOT_IMPLEMENTED,"SoftwareRenderContext.renderTextured colorMode not implemented:"<<(int)colorMode);
+		return;
+	}
+	if(pixels==nullptr || !chunk.isValid() || chunk.texId>=pages.size() || pages[chunk.texId]==nullptr)
+		return;
+	drawCommand c;
+	c.alpha=imin(imax(int32_t(alpha*255.0f+0.5f),0),255);
+	if(c.alpha==0)
+		return;
+	//The quad is placed as in GLRenderContext::renderTextured
+	const float ox=(x<0)?0:x;
+	const float oy=(y<0)?0:y;
+	const float kx=float(w)/chunk.width;
+	const float ky=float(h)/chunk.height;
+	//Texture to framebuffer transformation, the projection only offsets the stage
+	const float a=lsMVPMatrix[0]*kx;
+	const float b=lsMVPMatrix[4]*ky;
+	const float cc=lsMVPMatrix[1]*kx;
+	const float d=lsMVPMatrix[5]*ky;
+	const float e=offsetX+lsMVPMatrix[0]*ox+lsMVPMatrix[4]*oy+lsMVPMatrix[12];
+	const float f=offsetY+lsMVPMatrix[1]*ox+lsMVPMatrix[5]*oy+lsMVPMatrix[13];
+	const float det=a*d-b*cc;
+	if(fabs(det)<1e-6f)
+		return;
+	c.sx=d/det;
+	c.sy=-b/det;
+	c.s0=(b*f-d*e)/det;
+	c.tx=-cc/det;
+	c.ty=a/det;
+	c.t0=(cc*e-a*f)/det;
+	c.translateOnly=(a==1 && d==1 && b==0 && cc==0 && e==floorf(e) && f==floorf(f));
+	c.offsetX=int32_t(e);
+	c.offsetY=int32_t(f);
+
+	//Bounding box of the transformed quad
+	const float cornersX[4]={e, a*chunk.width+e, b*chunk.height+e, a*chunk.width+b*chunk.height+e};
+	const float cornersY[4]={f, cc*chunk.width+f, d*chunk.height+f, cc*chunk.width+d*chunk.height+f};
+	c.xmin=imax(int32_t(floorf(*min_element(cornersX,cornersX+4))),0);
+	c.xmax=imin(int32_t(ceilf(*max_element(cornersX,cornersX+4))),width);
+	c.ymin=imax(int32_t(floorf(*min_element(cornersY,cornersY+4))),0);
+	c.ymax=imin(int32_t(ceilf(*max_element(cornersY,cornersY+4))),height);
+	if(c.xmin>=c.xmax || c.ymin>=c.ymax)
+		return;
+
+	c.texId=chunk.texId;
+	c.width=chunk.width;
+	c.height=chunk.height;
+	//The chunk may be reallocated before the frame is composited, keep a copy of its blocks
+	c.firstChunk=chunkIndices.size();
+	chunkIndices.insert(chunkIndices.end(),chunk.chunks,chunk.chunks+chunk.getNumberOfChunks());
+	c.blendMode=blendMode;
+	commands.push_back(c);
+}
+
+const CachedSurface& SoftwareRenderContext::getCachedSurface(const DisplayObject* d) const
+{
+	return d->cachedSurface;
+}
+
+void SoftwareRenderContext::setProperties(AS_BLENDMODE blendmode)
+{
+	blendMode=blendmode;
+}
+
+const uint32_t& SoftwareRenderContext::getTexel(const drawCommand& c, int32_t s, int32_t t) const
+{
+	const uint32_t blocksW=(c.width+CHUNKSIZE-1)/CHUNKSIZE;
+	const uint32_t blocksPerSide=pageSize/CHUNKSIZE;
+	const uint32_t block=chunkIndices[c.firstChunk+(t/CHUNKSIZE)*blocksW+s/CHUNKSIZE];
+	const uint32_t px=(block%blocksPerSide)*CHUNKSIZE+s%CHUNKSIZE;
+	const uint32_t py=(block/blocksPerSide)*CHUNKSIZE+t%CHUNKSIZE;
+	return pages[c.texId][py*pageSize+px];
+}
+
+void SoftwareRenderContext::fetchSpan(const drawCommand& c, int32_t y, int32_t xmin, int32_t xmax, uint32_t* span) const
+{
+	if(c.translateOnly)
+	{
+		const int32_t t=y-c.offsetY;
+		int32_t x=xmin;
+		while(x<xmax)
+		{
+			const int32_t s=x-c.offsetX;
+			if(t<0 || t>=int32_t(c.height) || s<0 || s>=int32_t(c.width))
+			{
+				span[x-xmin]=0;
+				x++;
+				continue;
+			}
+			//Copy up to the end of the block
+			const int32_t run=imin(imin(CHUNKSIZE-s%CHUNKSIZE,int32_t(c.width)-s),xmax-x);
+			memcpy(span+x-xmin,&getTexel(c,s,t),run*4);
+			x+=run;
+		}
+		return;
+	}
+	const float fy=y+0.5f;
+	for(int32_t x=xmin;x<xmax;x++)
+	{
+		const float fx=x+0.5f;
+		const float s=c.sx*fx+c.sy*fy+c.s0;
+		const float t=c.tx*fx+c.ty*fy+c.t0;
+		if(s<0 || t<0 || s>=c.width || t>=c.height)
+		{
+			span[x-xmin]=0;
+			continue;
+		}
+		//Bilinear filtering like GL_LINEAR, clamped to the edges of the chunk
+		const float ss=s-0.5f;
+		const float tt=t-0.5f;
+		int32_t s0=int32_t(floorf(ss));
+		int32_t t0=int32_t(floorf(tt));
+		const uint32_t ws=(ss-s0)*256;
+		const uint32_t wt=(tt-t0)*256;
+		const int32_t s1=imin(s0+1,int32_t(c.width)-1);
+		const int32_t t1=imin(t0+1,int32_t(c.height)-1);
+		s0=imax(s0,0);
+		t0=imax(t0,0);
+		span[x-xmin]=lerpPixel(lerpPixel(getTexel(c,s0,t0),getTexel(c,s1,t0),ws),
+				       lerpPixel(getTexel(c,s0,t1),getTexel(c,s1,t1),ws),wt);
+	}
+}
+
+void SoftwareRenderContext::compositeRows(const DamageRegion::rect& r, int32_t begin, int32_t end)
+{
+	uint32_t* span=g_newa(uint32_t,width);
+	for(int32_t y=begin;y<end;y++)
+		std::fill(pixels+y*width+r.xmin,pixels+y*width+r.xmax,background);
+	//Each band of rows draws all the quads touching it, in order
+	for(auto it=commands.begin();it!=commands.end();++it)
+	{
+		const drawCommand& c=*it;
+		const int32_t y0=imax(begin,c.ymin);
+		const int32_t y1=imin(end,c.ymax);
+		const int32_t x0=imax(r.xmin,c.xmin);
+		const int32_t x1=imin(r.xmax,c.xmax);
+		if(x0>=x1)
+			continue;
+		for(int32_t y=y0;y<y1;y++)
+		{
+			fetchSpan(c,y,x0,x1,span);
+			blendSpan(pixels+y*width+x0,span,x1-x0,c.alpha,c.blendMode);
+		}
+	}
+}
+
+void SoftwareRenderContext::getFrameBMP(vector<uint8_t>& out) const
+{
+	const uint32_t dataSize=width*height*4;
+	out.resize(54+dataSize);
+	uint8_t* p=out.data();
+	memset(p,0,54);
+	p[0]='B';
+	p[1]='M';
+	writeLE32(p+2,54+dataSize);
+	writeLE32(p+10,54);
+	writeLE32(p+14,40);
+	writeLE32(p+18,width);
+	//A negative height stores the rows top to bottom
+	writeLE32(p+22,uint32_t(-int32_t(height)));
+	p[26]=1;
+	p[28]=32;
+	writeLE32(p+34,dataSize);
+	p+=54;
+	for(uint32_t i=0;i<width*height;i++,p+=4)
+		writeLE32(p,pixels[i]);
+}
+
+void SoftwareRenderContext::getFrameRaw(vector<uint8_t>& out) const
+{
+	out.resize(width*height*4);
+	uint8_t* p=out.data();
+	for(uint32_t i=0;i<width*height;i++,p+=4)
+		writeLE32(p,pixels[i]);
+}
+
+bool SoftwareRenderContext::getFramePNG(vector<uint8_t>& out) const
+{
+	out.clear();
+	png_structp pngPtr=png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+	if(!pngPtr)
+	{
+		LOG(LOG_ERROR,"Couldn't initialize png write struct");
+		return false;
+	}
+	png_infop infoPtr=png_create_info_struct(pngPtr);
+	if(!infoPtr)
+	{
+		LOG(LOG_ERROR,"Couldn't initialize png info struct");
+		png_destroy_write_struct(&pngPtr, (png_infopp)0);
+		return false;
+	}
+	vector<uint8_t> row(width*3);
+	if(setjmp(png_jmpbuf(pngPtr)))
+	{
+		png_destroy_write_struct(&pngPtr, &infoPtr);
+		LOG(LOG_ERROR,"error during writing of the png file");
+		return false;
+	}
+	png_set_write_fn(pngPtr,&out,writePNGData,flushPNGData);
+	//The frame is composited on the opaque background, so the alpha channel is not stored
+	png_set_IHDR(pngPtr,infoPtr,width,height,8,PNG_COLOR_TYPE_RGB,PNG_INTERLACE_NONE,
+		     PNG_COMPRESSION_TYPE_DEFAULT,PNG_FILTER_TYPE_DEFAULT);
+	//Frames are written at the frame rate, favour speed over size
+	png_set_compression_level(pngPtr,1);
+	png_write_info(pngPtr,infoPtr);
+	for(uint32_t y=0;y<height;y++)
+	{
+		const uint32_t* src=pixels+y*width;
+		for(uint32_t x=0;x<width;x++)
+		{
+			row[x*3]=(src[x]>>16)&0xff;
+			row[x*3+1]=(src[x]>>8)&0xff;
+			row[x*3+2]=src[x]&0xff;
+		}
+		png_write_row(pngPtr,row.data());
+	}
+	png_write_end(pngPtr,infoPtr);
+	png_destroy_write_struct(&pngPtr, &infoPtr);
+	return true;
+}
@@ -0,0 +1,134 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef BACKENDS_SOFTWARERENDERING_H
+#define BACKENDS_SOFTWARERENDERING_H 1
+
+#include "backends/rendering_context.h"
+#include <vector>
+#include <unordered_set>
+
+namespace lightspark
+{
+
+class SystemState;
+
+//Side of the texture pages the chunks of the software renderer are allocated in
+#define SOFTWARE_TEXTURE_SIZE 2048
+
+/*
+ * RenderContext that composites the cached surfaces of the DisplayObjects
+ * in a framebuffer in system memory, used when rendering without OpenGL.
+ * The texture chunks are allocated by the RenderThread as usual, their
+ * pixels are kept in pages of SOFTWARE_TEXTURE_SIZE*SOFTWARE_TEXTURE_SIZE
+ * premultiplied ARGB pixels.
+ * renderTextured only records the quads, endFrame blends them in bands of
+ * rows that are split across the thread pool.
+ * The framebuffer is kept between frames: endFrame compares the quads with
+ * the ones of the previous frame and only composites again the areas
+ * covered by the quads that were added, removed, changed or uploaded again.
+ */
+class SoftwareRenderContext: public RenderContext
+{
+private:
+	struct drawCommand
+	{
+		//Texture coordinates of the framebuffer pixel (x,y) are
+		//(sx*x+sy*y+s0, tx*x+ty*y+t0)
+		float sx,sy,s0;
+		float tx,ty,t0;
+		//Integer offset of the texture when it is not scaled or rotated
+		int32_t offsetX,offsetY;
+		bool translateOnly;
+		//Area of the framebuffer covered by the quad
+		int32_t xmin,ymin,xmax,ymax;
+		uint32_t texId;
+		uint32_t width;
+		uint32_t height;
+		//Position of the chunk indices in chunkIndices
+		uint32_t firstChunk;
+		//0-255
+		uint32_t alpha;
+		AS_BLENDMODE blendMode;
+		DamageRegion::rect bounds() const
+		{
+			DamageRegion::rect r={xmin,ymin,xmax,ymax};
+			return r;
+		}
+	};
+	SystemState* m_sys;
+	uint32_t* pixels;
+	uint32_t width;
+	uint32_t height;
+	int32_t offsetX;
+	int32_t offsetY;
+	uint32_t background;
+	uint32_t pageSize;
+	std::vector<uint32_t*> pages;
+	std::vector<drawCommand> commands;
+	std::vector<uint32_t> chunkIndices;
+	std::vector<uint8_t> uploadBuffer;
+	//Quads of the last composited frame
+	std::vector<drawCommand> lastCommands;
+	std::vector<uint32_t> lastChunkIndices;
+	//Blocks uploaded since the last composited frame, as texId*blocks per page+block
+	std::unordered_set<uint32_t> uploadedBlocks;
+	DamageRegion damage;
+	//Set when the whole framebuffer must be composited again
+	bool fullDamage;
+	AS_BLENDMODE blendMode;
+	const uint32_t& getTexel(const drawCommand& c, int32_t s, int32_t t) const;
+	void fetchSpan(const drawCommand& c, int32_t y, int32_t xmin, int32_t xmax, uint32_t* span) const;
+	bool sameQuad(const drawCommand& c, const drawCommand& last) const;
+	bool isUploaded(const drawCommand& c) const;
+	void computeDamage();
+	void compositeRows(const DamageRegion::rect& r, int32_t begin, int32_t end);
+public:
+	SoftwareRenderContext(SystemState* s, uint32_t textureSize);
+	virtual ~SoftwareRenderContext();
+	/*
+	 * Resizes the framebuffer, the stage is drawn at (offX,offY)
+	 */
+	void resize(uint32_t w, uint32_t h, int32_t offX, int32_t offY);
+	uint32_t getWidth() const { return width; }
+	uint32_t getHeight() const { return height; }
+	const uint32_t* getPixels() const { return pixels; }
+	/*
+	 * Returns a buffer large enough for an upload of w*h pixels
+	 */
+	uint8_t* getUploadBuffer(uint32_t w, uint32_t h);
+	void loadChunkBGRA(const TextureChunk& chunk, uint32_t w, uint32_t h, const uint8_t* data);
+	void beginFrame(const RGB& bg);
+	//Composites the quads recorded since beginFrame
+	void endFrame();
+	//Encodes the framebuffer as a 32 bit BMP file
+	void getFrameBMP(std::vector<uint8_t>& out) const;
+	//Copies the framebuffer as rows of 32 bit BGRA pixels, top to bottom
+	void getFrameRaw(std::vector<uint8_t>& out) const;
+	//Encodes the framebuffer as a 24 bit PNG file, returns false on errors
+	bool getFramePNG(std::vector<uint8_t>& out) const;
+
+	void renderTextured(const TextureChunk& chunk, int32_t x, int32_t y, uint32_t w, uint32_t h,
+			float alpha, COLOR_MODE colorMode);
+	const CachedSurface& getCachedSurface(const DisplayObject* obj) const;
+	void setProperties(AS_BLENDMODE blendmode);
+};
+
+};
+#endif /* BACKENDS_SOFTWARERENDERING_H */
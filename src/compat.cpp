@@ -23,6 +23,7 @@
 #include <cstdlib>
 #include "logger.h"
 #include <unistd.h>
+#include <atomic>
 
 #ifdef _WIN32
 #	ifndef NOMINMAX
@@ -44,8 +45,36 @@
 
 using namespace std;
 
+static bool virtualClock=false;
+static atomic<int64_t> virtualTime(0);
+
+void compat_enable_virtual_clock()
+{
+	virtualClock=true;
+}
+
+bool compat_virtual_clock_enabled()
+{
+	return virtualClock;
+}
+
+void compat_advance_virtual_clock(int64_t time)
+{
+	int64_t cur=virtualTime.load();
+	while(cur<time && !virtualTime.compare_exchange_weak(cur,time));
+}
+
+int64_t compat_usectiming()
+{
+	if(virtualClock)
+		return virtualTime.load();
+	return g_get_monotonic_time();
+}
+
 uint64_t compat_msectiming()
 {
+	if(virtualClock)
+		return virtualTime.load()/1000;
 #ifdef _WIN32
 	return GetTickCount(); //TODO: use GetTickCount64
 #else
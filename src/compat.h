@@ -163,6 +163,17 @@ inline T maxTmpl(T a, T b)
 /* timing */
 
 uint64_t compat_msectiming();
+//Monotonic time in microseconds
+int64_t compat_usectiming();
+/*
+ * Switches the timing functions to a simulated clock, starting at 0, that
+ * only moves with compat_advance_virtual_clock. Used by the offline capture,
+ * it has to be enabled before any thread is started.
+ */
+void compat_enable_virtual_clock();
+bool compat_virtual_clock_enabled();
+//Moves the simulated clock to time (in microseconds) if it is later
+void compat_advance_virtual_clock(int64_t time);
 void compat_msleep(unsigned int time);
 uint64_t compat_get_thread_cputime_us();
 
@@ -0,0 +1,318 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "cycle_collector.h"
+#include "asobject.h"
+#include "logger.h"
+#include "memory_support.h"
+#include "scripting/toplevel/toplevel.h"
+#include "swf.h"
+#include "scripting/flash/display/DisplayObject.h"
+
+using namespace std;
+using namespace lightspark;
+
+CycleCollector::node::node(ASObject* o):obj(o),count(o->getRefCount()-1),black(false),claimed(false)
+{
+}
+
+CycleCollector::CycleCollector():nextBuffer(0),memoryAccount(nullptr),collectedCount(0),enabled(true)
+{
+}
+
+void CycleCollector::setEnabled(bool e)
+{
+	enabled=e;
+	if(enabled)
+		return;
+	vector<ASObject*> released;
+	for(uint32_t i=0;i<CYCLE_COLLECTOR_BUFFERS;i++)
+	{
+		Locker l(buffers[i].mutex);
+		for(auto it=buffers[i].roots.begin();it!=buffers[i].roots.end();++it)
+		{
+			if(*it)
+			{
+				(*it)->setCycleRootSlot(CYCLE_ROOT_NONE);
+				released.push_back(*it);
+			}
+		}
+		buffers[i].roots.clear();
+	}
+	//Outside of the locks, destroying an object may remove other roots
+	for(auto it=released.begin();it!=released.end();++it)
+		(*it)->decRefNoCycleRoot();
+}
+
+//The buffer of the current thread, for the last collector it used
+static thread_local const CycleCollector* threadCollector=nullptr;
+static thread_local uint32_t threadBuffer=0;
+
+uint32_t CycleCollector::getThreadBuffer()
+{
+	if(threadCollector!=this)
+	{
+		threadCollector=this;
+		threadBuffer=nextBuffer.fetch_add(1,std::memory_order_relaxed)%CYCLE_COLLECTOR_BUFFERS;
+	}
+	return threadBuffer;
+}
+
+bool CycleCollector::addRoot(ASObject* o)
+{
+	if(!enabled || !o->claimCycleRootSlot())
+		return false;
+	uint32_t b=getThreadBuffer();
+	root_buffer& buffer=buffers[b];
+	Locker l(buffer.mutex);
+	uint32_t index=buffer.roots.size();
+	if(index>=(1u<<CYCLE_COLLECTOR_INDEX_BITS))
+	{
+		//Full, the object is buffered again the next time it loses a reference
+		o->setCycleRootSlot(CYCLE_ROOT_NONE);
+		return false;
+	}
+	buffer.roots.push_back(o);
+	o->setCycleRootSlot((b<<CYCLE_COLLECTOR_INDEX_BITS)|index);
+	return true;
+}
+
+/*
+ * Only reached when a buffered object is destroyed without losing its
+ * references, like in the forced cleanup at exit. The reference of the
+ * buffer goes away with the object. Pending roots are owned by a thread
+ * adding them or by the current batch, so they can't be destroyed.
+ */
+void CycleCollector::removeRoot(ASObject* o)
+{
+	uint32_t slot=o->getCycleRootSlot();
+	if(slot==CYCLE_ROOT_NONE || slot==CYCLE_ROOT_PENDING)
+		return;
+	root_buffer& buffer=buffers[slot>>CYCLE_COLLECTOR_INDEX_BITS];
+	Locker l(buffer.mutex);
+	//The collector may have taken the root in the meantime
+	if(o->getCycleRootSlot()!=slot)
+		return;
+	buffer.roots[slot&((1u<<CYCLE_COLLECTOR_INDEX_BITS)-1)]=nullptr;
+	o->setCycleRootSlot(CYCLE_ROOT_NONE);
+}
+
+void CycleCollector::takeRoots()
+{
+	batch.clear();
+	for(uint32_t i=0;i<CYCLE_COLLECTOR_BUFFERS && batch.size()<CYCLE_COLLECTOR_BATCH_SIZE;i++)
+	{
+		root_buffer& buffer=buffers[i];
+		Locker l(buffer.mutex);
+		//Taking from the back keeps the slots of the remaining roots valid
+		while(!buffer.roots.empty() && batch.size()<CYCLE_COLLECTOR_BATCH_SIZE)
+		{
+			ASObject* o=buffer.roots.back();
+			buffer.roots.pop_back();
+			if(o)
+			{
+				//The batch takes over the reference of the buffer
+				o->setCycleRootSlot(CYCLE_ROOT_PENDING);
+				batch.push_back(o);
+			}
+		}
+	}
+}
+
+bool CycleCollector::isCollectable(ASObject* o)
+{
+	if(o->getConstant() || o->getCached() || o->getInDestruction() || o->getActivationCount()!=1)
+		return false;
+	switch(o->getObjectType())
+	{
+		case T_OBJECT:
+		case T_ARRAY:
+		case T_FUNCTION:
+			break;
+		default:
+			return false;
+	}
+	//Scopes keep their own bookkeeping of references
+	if(o->is<Global>() || o->is<Activation_object>())
+		return false;
+	//Methods are owned by their class
+	if(o->is<IFunction>() && o->as<IFunction>()->inClass && !o->as<IFunction>()->isCloned)
+		return false;
+	//The render thread may still be looking at objects on the stage
+	if(o->is<DisplayObject>() && o->as<DisplayObject>()->isOnStage())
+		return false;
+	return true;
+}
+
+uint32_t CycleCollector::getNode(ASObject* o)
+{
+	auto it=nodeIndex.find(o);
+	if(it!=nodeIndex.end())
+		return it->second;
+	uint32_t ret=UINT32_MAX;
+	if(isCollectable(o))
+	{
+		ret=nodes.size();
+		o->incRef();
+		nodes.emplace_back(o);
+		//Dropping references during the batch must not buffer the object with its reference
+		nodes.back().claimed=o->claimCycleRootSlot();
+	}
+	nodeIndex.insert(make_pair(o,ret));
+	return ret;
+}
+
+bool CycleCollector::markGray(gc_references& refs)
+{
+	//nodes grows while it is visited
+	for(uint32_t i=0;i<nodes.size();i++)
+	{
+		if(nodes.size()>CYCLE_COLLECTOR_MAX_NODES)
+			return false;
+		refs.owned.clear();
+		refs.backrefs.clear();
+		nodes[i].obj->collectReferences(refs);
+		for(auto it=refs.owned.begin();it!=refs.owned.end();++it)
+		{
+			uint32_t n=getNode(*it);
+			if(n==UINT32_MAX)
+				continue;
+			nodes[n].count--;
+			nodes[i].next.push_back(n);
+		}
+		for(auto it=refs.backrefs.begin();it!=refs.backrefs.end();++it)
+		{
+			uint32_t n=getNode(*it);
+			//We can't tell if an object we don't know about is alive
+			if(n==UINT32_MAX)
+				nodes[i].black=true;
+			else
+				nodes[n].next.push_back(i);
+		}
+	}
+	return true;
+}
+
+void CycleCollector::scan()
+{
+	vector<uint32_t> pending;
+	for(uint32_t i=0;i<nodes.size();i++)
+	{
+		//A negative count means some reported reference was not counted, keep the object to be safe
+		if(nodes[i].count!=0 || nodes[i].black)
+		{
+			nodes[i].black=true;
+			pending.push_back(i);
+		}
+	}
+	while(!pending.empty())
+	{
+		uint32_t i=pending.back();
+		pending.pop_back();
+		for(auto it=nodes[i].next.begin();it!=nodes[i].next.end();++it)
+		{
+			if(!nodes[*it].black)
+			{
+				nodes[*it].black=true;
+				pending.push_back(*it);
+			}
+		}
+	}
+}
+
+uint32_t CycleCollector::collectWhite()
+{
+	//The references of the collector keep the garbage alive until the references
+	//between the objects are dropped, then they are the last ones
+	uint32_t ret=0;
+	for(auto it=nodes.begin();it!=nodes.end();++it)
+	{
+		if(!it->black)
+		{
+			it->obj->releaseReferences();
+			ret++;
+		}
+	}
+	return ret;
+}
+
+void CycleCollector::releaseBatch()
+{
+	//Reset all the slots first, objects destroyed below may drop references to the others
+	for(auto it=nodes.begin();it!=nodes.end();++it)
+	{
+		if(it->claimed)
+			it->obj->setCycleRootSlot(CYCLE_ROOT_NONE);
+	}
+	for(auto it=batch.begin();it!=batch.end();++it)
+		(*it)->setCycleRootSlot(CYCLE_ROOT_NONE);
+	for(auto it=nodes.begin();it!=nodes.end();++it)
+		it->obj->decRefNoCycleRoot();
+	for(auto it=batch.begin();it!=batch.end();++it)
+		(*it)->decRefNoCycleRoot();
+	nodes.clear();
+	nodeIndex.clear();
+	batch.clear();
+}
+
+uint32_t CycleCollector::collectBatch(gc_references& refs)
+{
+	for(auto it=batch.begin();it!=batch.end();++it)
+	{
+		//The reference owned by the batch is not an external one
+		uint32_t n=getNode(*it);
+		if(n!=UINT32_MAX)
+			nodes[n].count--;
+	}
+	uint32_t ret=0;
+	if(markGray(refs))
+	{
+		scan();
+		ret=collectWhite();
+	}
+	releaseBatch();
+	return ret;
+}
+
+void CycleCollector::collectSlice()
+{
+	if(!enabled)
+		return;
+	uint64_t start=compat_get_thread_cputime_us();
+	gc_references refs;
+	uint32_t collected=0;
+	do
+	{
+		takeRoots();
+		if(batch.empty())
+			break;
+		collected+=collectBatch(refs);
+	}
+	while(compat_get_thread_cputime_us()-start<CYCLE_COLLECTOR_SLICE_US);
+
+	if(collected)
+	{
+		collectedCount+=collected;
+		LOG(LOG_CALLS,"cycle collector released "<<collected<<" objects");
+#ifdef MEMORY_USAGE_PROFILING
+		if(memoryAccount)
+			memoryAccount->addCollectedObjects(collected);
+#endif
+	}
+}
@@ -0,0 +1,122 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef CYCLE_COLLECTOR_H
+#define CYCLE_COLLECTOR_H 1
+
+#include "compat.h"
+#include <vector>
+#include <unordered_map>
+#include "threading.h"
+
+namespace lightspark
+{
+
+class ASObject;
+class MemoryAccount;
+struct gc_references;
+
+//Number of possible roots examined together
+#define CYCLE_COLLECTOR_BATCH_SIZE 256
+//Batches reaching more objects than this are given up
+#define CYCLE_COLLECTOR_MAX_NODES 16384
+//CPU time a single slice may use, in microseconds
+#define CYCLE_COLLECTOR_SLICE_US 2000
+//Threads are spread over this many root buffers, at most 256
+#define CYCLE_COLLECTOR_BUFFERS 16
+//The slot of a buffered root is the buffer index followed by the index in the buffer
+#define CYCLE_COLLECTOR_INDEX_BITS 24
+
+/*
+ * Trial deletion cycle collector (Bacon and Rajan) for ASObjects.
+ * Objects whose reference count is decremented without reaching zero are
+ * buffered as possible roots of a garbage cycle. Every slice takes batches of
+ * roots, and subtracts from the reference counts of the objects reachable
+ * from them the references reported by ASObject::collectReferences. Objects
+ * left without external references and not reachable from an object that
+ * has some only keep each other alive, so their references are released.
+ * Counted references that are not reported just keep their target alive.
+ * The roots may be added and removed from any thread, slices must run in
+ * the vm thread between events. Every thread adds roots to one of a few
+ * buffers with their own lock, so dropping references from different
+ * threads doesn't contend, and objects remember their slot so that they
+ * can be removed when they are destroyed.
+ * A buffered root owns the reference whose drop buffered it, and the
+ * collector references the objects of a batch until it is over, so other
+ * threads can't free them while they are examined.
+ */
+class CycleCollector
+{
+private:
+	struct node
+	{
+		ASObject* obj;
+		//Reference count minus the references coming from other nodes and from the collector
+		int32_t count;
+		//Set when the object is known to be reachable from outside the graph
+		bool black;
+		//Set when the batch claimed the root slot of the object, so that it isn't buffered meanwhile
+		bool claimed;
+		//Nodes that are reachable from this one
+		std::vector<uint32_t> next;
+		node(ASObject* o);
+	};
+	struct root_buffer
+	{
+		Mutex mutex;
+		//Removed roots are left as NULL, so that the slots of the others stay valid
+		std::vector<ASObject*> roots;
+	};
+	root_buffer buffers[CYCLE_COLLECTOR_BUFFERS];
+	//Used to assign a buffer to each thread
+	std::atomic<uint32_t> nextBuffer;
+	std::vector<ASObject*> batch;
+	std::vector<node> nodes;
+	std::unordered_map<ASObject*,uint32_t> nodeIndex;
+	MemoryAccount* memoryAccount;
+	uint64_t collectedCount;
+	std::atomic<bool> enabled;
+	uint32_t getThreadBuffer();
+	//Moves up to CYCLE_COLLECTOR_BATCH_SIZE roots to batch
+	void takeRoots();
+	static bool isCollectable(ASObject* o);
+	uint32_t getNode(ASObject* o);
+	bool markGray(gc_references& refs);
+	void scan();
+	uint32_t collectWhite();
+	//Drops the references of the collector to the roots and the nodes of the batch
+	void releaseBatch();
+	uint32_t collectBatch(gc_references& refs);
+public:
+	CycleCollector();
+	void setMemoryAccount(MemoryAccount* m) { memoryAccount=m; }
+	void setEnabled(bool e);
+	//Returns true if o is buffered, the buffer then owns the reference that was being dropped
+	bool addRoot(ASObject* o);
+	void removeRoot(ASObject* o);
+	/*
+	 * Examines buffered roots until they are exhausted or the time budget
+	 * of the slice is used
+	 */
+	void collectSlice();
+	uint64_t getCollectedCount() const { return collectedCount; }
+};
+
+};
+#endif /* CYCLE_COLLECTOR_H */
@@ -6,6 +6,8 @@ uniform sampler2D g_tex1, g_tex2;
 uniform float yuv;
 uniform float alpha;
 uniform float direct;
+//Set when sampling a texture drawn by the shaders, that is already in RGBA order
+uniform float rgba;
 varying vec4 ls_TexCoords[2];
 varying vec4 ls_FrontColor;
 
@@ -18,7 +20,8 @@ void main()
 	//Tranform the value from YUV to RGB
 	vec4 vbase = texture2D(g_tex1,ls_TexCoords[0].xy);
 #ifdef GL_ES
-	vbase.rgb = vbase.bgr;
+	if (rgba == 0.0)
+		vbase.rgb = vbase.bgr;
 #endif
 	vbase *= alpha;
 	vec4 val = vbase.bgra-vec4(0,0.5,0.5,0);
@@ -21,9 +21,12 @@
 #include "version.h"
 #include "backends/security.h"
 #include "backends/config.h"
+#include "backends/diskcache.h"
 #include "swf.h"
+#include "parsing/streams.h"
 #include "logger.h"
 #include "platforms/engineutils.h"
+#include "backends/rendering.h"
 #include "compat.h"
 #include <SDL2/SDL.h>
 #include "flash/utils/ByteArray.h"
@@ -245,10 +248,15 @@ int main(int argc, char* argv[])
 	char* profilingFileName=NULL;
 #endif
 	char *HTTPcookie=NULL;
+	char* frameDumpPath=NULL;
+	RenderThread::FRAME_FORMAT frameFormat=RenderThread::FRAME_BMP;
+	bool offlineCapture=false;
+	uint32_t captureFrameCount=0;
 	SecurityManager::SANDBOXTYPE sandboxType=SecurityManager::LOCAL_WITH_FILE;
 	bool useInterpreter=true;
 	bool useFastInterpreter=false;
 	bool useJit=false;
+	bool useTieredJit=false;
 	bool ignoreUnhandledExceptions = false;
 	SystemState::ERROR_TYPE exitOnError=SystemState::ERROR_PARSING;
 	LOG_LEVEL log_level=LOG_INFO;
@@ -289,6 +297,11 @@ int main(int argc, char* argv[])
 			useFastInterpreter=true;
 		else if(strcmp(argv[i],"-j")==0 || strcmp(argv[i],"--enable-jit")==0)
 			useJit=true;
+		else if(strcmp(argv[i],"-tj")==0 || strcmp(argv[i],"--enable-tiered-jit")==0)
+		{
+			useJit=true;
+			useTieredJit=true;
+		}
 		else if(strcmp(argv[i],"-ne")==0 || strcmp(argv[i],"--ignore-unhandled-exceptions")==0)
 			ignoreUnhandledExceptions=true;
 		else if(strcmp(argv[i],"-l")==0 || strcmp(argv[i],"--log-level")==0)
@@ -357,6 +370,78 @@ int main(int argc, char* argv[])
 		{
 			EngineData::enablerendering = false;
 		}
+		else if(strcmp(argv[i],"--software-rendering")==0)
+		{
+			EngineData::softwarerendering = true;
+		}
+		else if(strcmp(argv[i],"--disable-disk-cache")==0)
+		{
+			DiskCache::enabled = false;
+		}
+		else if(strcmp(argv[i],"--disk-cache-size")==0)
+		{
+			i++;
+			if(i==argc)
+			{
+				fileName=NULL;
+				break;
+			}
+			DiskCache::maxSize=uint64_t(max(0, atoi(argv[i])))*1024*1024;
+		}
+		else if(strcmp(argv[i],"--dump-frames")==0)
+		{
+			i++;
+			if(i==argc)
+			{
+				fileName=NULL;
+				break;
+			}
+			//Frames can only be dumped by the software renderer
+			EngineData::softwarerendering = true;
+			frameDumpPath=argv[i];
+		}
+		else if(strcmp(argv[i],"--capture")==0)
+		{
+			i++;
+			if(i==argc)
+			{
+				fileName=NULL;
+				break;
+			}
+			EngineData::softwarerendering = true;
+			offlineCapture=true;
+			frameDumpPath=argv[i];
+		}
+		else if(strcmp(argv[i],"--capture-frames")==0)
+		{
+			i++;
+			if(i==argc)
+			{
+				fileName=NULL;
+				break;
+			}
+			captureFrameCount=max(0, atoi(argv[i]));
+		}
+		else if(strcmp(argv[i],"--frame-format")==0)
+		{
+			i++;
+			if(i==argc)
+			{
+				fileName=NULL;
+				break;
+			}
+			if(strcmp(argv[i],"png")==0)
+				frameFormat=RenderThread::FRAME_PNG;
+			else if(strcmp(argv[i],"raw")==0)
+				frameFormat=RenderThread::FRAME_RAW;
+			else if(strcmp(argv[i],"bmp")==0)
+				frameFormat=RenderThread::FRAME_BMP;
+			else
+			{
+				fileName=NULL;
+				break;
+			}
+		}
 		
 		else if(strcmp(argv[i],"--HTTP-cookies")==0)
 		{
@@ -385,10 +470,13 @@ int main(int argc, char* argv[])
 		LOG(LOG_ERROR, "Usage: " << argv[0] << " [--url|-u http://loader.url/file.swf]" <<
 			" [--disable-interpreter|-ni] [--enable-fast-interpreter|-fi]" <<
 #ifdef LLVM_ENABLED
-			" [--enable-jit|-j]" <<
+			" [--enable-jit|-j] [--enable-tiered-jit|-tj]" <<
 #endif
 			" [--log-level|-l 0-4] [--parameters-file|-p params-file] [--security-sandbox|-s sandbox]" <<
 			" [--exit-on-error] [--HTTP-cookies cookie] [--air] [--avmplus] [--disable-rendering]" <<
+			" [--software-rendering] [--disable-disk-cache] [--disk-cache-size megabytes]" <<
+			" [--dump-frames frames-directory|file]" <<
+			" [--capture frames-directory|file] [--capture-frames count] [--frame-format bmp|png|raw]" <<
 #ifdef PROFILING_SUPPORT
 			" [--profiling-output|-o profiling-file]" <<
 #endif
@@ -399,18 +487,24 @@ int main(int argc, char* argv[])
 	}
 
 	Log::setLogLevel(log_level);
-	ifstream f(fileName, ios::in|ios::binary);
-	f.seekg(0, ios::end);
-	uint32_t fileSize=f.tellg();
-	f.seekg(0, ios::beg);
-	if(!f)
+	ifstream file(fileName, ios::in|ios::binary);
+	file.seekg(0, ios::end);
+	uint32_t fileSize=file.tellg();
+	file.seekg(0, ios::beg);
+	if(!file)
 	{
 		LOG(LOG_ERROR, argv[0] << ": " << fileName << ": No such file or directory");
 		exit(2);
 	}
+	//The file is parsed from a mapping if possible, tags keep views into it instead of copies
+	mapped_buf* mapping=mapped_buf::mapFile(fileName);
+	istream f(mapping ? (streambuf*)mapping : file.rdbuf());
 	f.exceptions ( istream::eofbit | istream::failbit | istream::badbit );
 	cout.exceptions( ios::failbit | ios::badbit);
 	cerr.exceptions( ios::failbit | ios::badbit);
+	//The clock has to be switched before any thread reads it
+	if(offlineCapture)
+		compat_enable_virtual_clock();
 	SystemState::staticInit();
 	if (!EngineData::startSDLMain())
 	{
@@ -465,6 +559,7 @@ int main(int argc, char* argv[])
 	sys->useInterpreter=useInterpreter;
 	sys->useFastInterpreter=useFastInterpreter;
 	sys->useJit=useJit;
+	sys->useTieredJit=useTieredJit;
 	sys->ignoreUnhandledExceptions=ignoreUnhandledExceptions;
 	sys->exitOnError=exitOnError;
 	if(paramsFileName)
@@ -475,6 +570,10 @@ int main(int argc, char* argv[])
 #endif
 	if(HTTPcookie)
 		sys->setCookies(HTTPcookie);
+	sys->offlineCapture=offlineCapture;
+	sys->captureFrameCount=captureFrameCount;
+	if(frameDumpPath)
+		sys->getRenderThread()->setFrameDump(frameDumpPath,frameFormat);
 
 	sys->setParamsAndEngine(new StandaloneEngineData(), true);
 
@@ -506,6 +605,8 @@ int main(int argc, char* argv[])
 
 	delete pt;
 	delete sys;
+	if(mapping)
+		mapping->release();
 
 	SystemState::staticDeinit();
 	
@@ -19,6 +19,8 @@
 
 #include "memory_support.h"
 #include "swf.h"
+#include <cstring>
+#include <new>
 
 using namespace lightspark;
 #ifdef MEMORY_USAGE_PROFILING
@@ -30,3 +32,257 @@ MemoryAccount* lightspark::getUnaccountedMemoryAccount()
 		return NULL;
 }
 #endif
+
+struct FreeBlock
+{
+	FreeBlock* next;
+};
+
+//Stored in the first block of every chunk. Chunks are aligned to their
+//size, so the header of any block is found by masking its address
+struct ChunkHeader
+{
+	//Blocks of this chunk in the shared list of its class
+	uint32_t sharedFree;
+	//Links the chunks that are released by a sweep
+	ChunkHeader* nextReleased;
+};
+
+static_assert(sizeof(ChunkHeader)<=SLAB_GRANULARITY, "chunk header must fit in the smallest block");
+
+static inline ChunkHeader* chunkOf(FreeBlock* b)
+{
+	return reinterpret_cast<ChunkHeader*>(uintptr_t(b)&~uintptr_t(SLAB_CHUNK_SIZE-1));
+}
+
+static inline uint32_t blocksPerChunk(uint32_t c)
+{
+	return SLAB_CHUNK_SIZE/((c+1)*SLAB_GRANULARITY)-1;
+}
+
+//Objects of one size class shared between the threads
+struct SlabClass
+{
+	Mutex mutex;
+	FreeBlock* head;
+	uint32_t count;
+	//Chunks that have all their blocks in the list
+	uint32_t freeChunks;
+	SlabClass():head(nullptr),count(0),freeChunks(0) {}
+	void sweep(uint32_t c);
+};
+
+void SlabClass::sweep(uint32_t c)
+{
+	const uint32_t n=blocksPerChunk(c);
+	ChunkHeader* released=nullptr;
+	FreeBlock** prev=&head;
+	while(*prev)
+	{
+		FreeBlock* b=*prev;
+		ChunkHeader* h=chunkOf(b);
+		if(h->sharedFree==n)
+		{
+			//No thread uses any block of this chunk. The released chunks are
+			//linked through their headers, the last one points to itself
+			if(h->nextReleased==nullptr)
+			{
+				h->nextReleased=released ? released : h;
+				released=h;
+			}
+			*prev=b->next;
+			count--;
+		}
+		else
+			prev=&b->next;
+	}
+	while(released)
+	{
+		ChunkHeader* next=released->nextReleased;
+		aligned_free(released);
+		released=(next==released) ? nullptr : next;
+	}
+	freeChunks=0;
+}
+
+struct SlabPool
+{
+	SlabClass classes[SLAB_CLASS_COUNT];
+};
+
+//Never destroyed, threads may release objects while the process exits
+static SlabPool& getSlabPool()
+{
+	static SlabPool* pool=new SlabPool();
+	return *pool;
+}
+
+struct ThreadCache
+{
+	FreeBlock* head[SLAB_CLASS_COUNT];
+	uint32_t count[SLAB_CLASS_COUNT];
+#ifdef MEMORY_USAGE_PROFILING
+	MemoryAccount* account;
+	int32_t pendingBytes;
+#endif
+	ThreadCache();
+	~ThreadCache();
+	void refill(uint32_t c);
+	void release(uint32_t c, uint32_t n);
+};
+
+static thread_local ThreadCache threadCache;
+
+ThreadCache::ThreadCache()
+{
+	memset(head,0,sizeof(head));
+	memset(count,0,sizeof(count));
+#ifdef MEMORY_USAGE_PROFILING
+	account=nullptr;
+	pendingBytes=0;
+#endif
+}
+
+ThreadCache::~ThreadCache()
+{
+	for(uint32_t c=0;c<SLAB_CLASS_COUNT;c++)
+	{
+		if(count[c])
+			release(c,count[c]);
+	}
+#ifdef MEMORY_USAGE_PROFILING
+	SlabAllocator::flushAccounting();
+#endif
+}
+
+void ThreadCache::refill(uint32_t c)
+{
+	SlabClass& s=getSlabPool().classes[c];
+	{
+		Locker l(s.mutex);
+		if(s.head)
+		{
+			//Take at most a batch from the shared list
+			const uint32_t perChunk=blocksPerChunk(c);
+			FreeBlock* first=s.head;
+			FreeBlock* last=first;
+			if(chunkOf(last)->sharedFree--==perChunk)
+				s.freeChunks--;
+			uint32_t n=1;
+			while(n<SLAB_TRANSFER_BATCH && last->next)
+			{
+				last=last->next;
+				if(chunkOf(last)->sharedFree--==perChunk)
+					s.freeChunks--;
+				n++;
+			}
+			s.head=last->next;
+			s.count-=n;
+			last->next=head[c];
+			head[c]=first;
+			count[c]+=n;
+			return;
+		}
+	}
+	//Split a new chunk, the first block holds its header
+	const size_t blockSize=(c+1)*SLAB_GRANULARITY;
+	const uint32_t n=blocksPerChunk(c);
+	void* mem=nullptr;
+	aligned_malloc(&mem,SLAB_CHUNK_SIZE,SLAB_CHUNK_SIZE);
+	ChunkHeader* h=static_cast<ChunkHeader*>(mem);
+	h->sharedFree=0;
+	h->nextReleased=nullptr;
+	char* chunk=static_cast<char*>(mem)+blockSize;
+	for(uint32_t i=0;i<n;i++)
+	{
+		FreeBlock* b=reinterpret_cast<FreeBlock*>(chunk+i*blockSize);
+		b->next=head[c];
+		head[c]=b;
+	}
+	count[c]+=n;
+}
+
+void ThreadCache::release(uint32_t c, uint32_t n)
+{
+	const uint32_t perChunk=blocksPerChunk(c);
+	FreeBlock* first=head[c];
+	SlabClass& s=getSlabPool().classes[c];
+	Locker l(s.mutex);
+	FreeBlock* last=first;
+	if(++chunkOf(last)->sharedFree==perChunk)
+		s.freeChunks++;
+	for(uint32_t i=1;i<n;i++)
+	{
+		last=last->next;
+		if(++chunkOf(last)->sharedFree==perChunk)
+			s.freeChunks++;
+	}
+	head[c]=last->next;
+	count[c]-=n;
+	last->next=s.head;
+	s.head=first;
+	s.count+=n;
+	//Give the free chunks back to the system once they are a good part of
+	//the list, so the cost of walking it is spread over the released blocks.
+	//Waiting for a second free chunk avoids freeing and allocating one over and over
+	if(s.freeChunks>1 && s.freeChunks*perChunk>=s.count/4)
+		s.sweep(c);
+}
+
+void* SlabAllocator::allocate(size_t size)
+{
+	if(size>SLAB_MAX_SIZE)
+		return malloc(size);
+	const uint32_t c=size ? (size-1)/SLAB_GRANULARITY : 0;
+	ThreadCache& t=threadCache;
+	if(t.head[c]==nullptr)
+		t.refill(c);
+	FreeBlock* b=t.head[c];
+	t.head[c]=b->next;
+	t.count[c]--;
+	return b;
+}
+
+void SlabAllocator::deallocate(void* p, size_t size)
+{
+	if(p==nullptr)
+		return;
+	if(size>SLAB_MAX_SIZE)
+	{
+		free(p);
+		return;
+	}
+	const uint32_t c=size ? (size-1)/SLAB_GRANULARITY : 0;
+	ThreadCache& t=threadCache;
+	FreeBlock* b=static_cast<FreeBlock*>(p);
+	b->next=t.head[c];
+	t.head[c]=b;
+	//Keep a batch around so alternating allocations don't move objects back and forth
+	if(++t.count[c]>=2*SLAB_TRANSFER_BATCH)
+		t.release(c,SLAB_TRANSFER_BATCH);
+}
+
+#ifdef MEMORY_USAGE_PROFILING
+void SlabAllocator::addBytes(MemoryAccount* m, int32_t b)
+{
+	if(m==nullptr)
+		return;
+	ThreadCache& t=threadCache;
+	if(t.account!=m)
+	{
+		flushAccounting();
+		t.account=m;
+	}
+	t.pendingBytes+=b;
+	if(t.pendingBytes>=SLAB_ACCOUNTING_BATCH || t.pendingBytes<=-SLAB_ACCOUNTING_BATCH)
+		flushAccounting();
+}
+
+void SlabAllocator::flushAccounting()
+{
+	ThreadCache& t=threadCache;
+	if(t.account && t.pendingBytes)
+		ATOMIC_ADD(t.account->bytes,t.pendingBytes);
+	t.pendingBytes=0;
+}
+#endif
@@ -27,8 +27,41 @@
 namespace lightspark
 {
 
-#ifdef MEMORY_USAGE_PROFILING
 class MemoryAccount;
+
+//Objects up to this size are served from slabs, bigger ones directly by malloc
+#define SLAB_MAX_SIZE 512
+//Slab object sizes are multiples of this, it is also their alignment
+#define SLAB_GRANULARITY 16
+#define SLAB_CLASS_COUNT (SLAB_MAX_SIZE/SLAB_GRANULARITY)
+//Size and alignment of the memory blocks that are split into objects, a power of two
+#define SLAB_CHUNK_SIZE (64*1024)
+//Number of objects moved at once between a thread cache and the shared lists
+#define SLAB_TRANSFER_BATCH 64
+//Accounted bytes are applied to the MemoryAccount once this many are pending
+#define SLAB_ACCOUNTING_BATCH (16*1024)
+
+/*
+ * Size class allocator for small objects.
+ * Every thread keeps a free list per size class that is refilled from and
+ * returned to shared lists in batches, so the common case takes no lock.
+ * Chunks whose objects are all back in a shared list are given back to the
+ * system when that list grows. deallocate must get the size passed to allocate.
+ */
+class DLL_PUBLIC SlabAllocator
+{
+public:
+	static void* allocate(size_t size);
+	static void deallocate(void* p, size_t size);
+#ifdef MEMORY_USAGE_PROFILING
+	//The change is applied to the account once enough bytes are pending in the current thread
+	static void addBytes(MemoryAccount* m, int32_t b);
+	//Applies the pending changes of the current thread
+	static void flushAccounting();
+#endif
+};
+
+#ifdef MEMORY_USAGE_PROFILING
 DLL_PUBLIC MemoryAccount* getUnaccountedMemoryAccount();
 
 class MemoryAccount
@@ -36,10 +69,12 @@ class MemoryAccount
 public:
 	tiny_string name;
 	ATOMIC_INT32(bytes);
+	//Objects released by the cycle collector
+	ATOMIC_INT32(collectedObjects);
 	/*
 	 * The name pointer is not copied and must survive
 	 */
-	MemoryAccount(const tiny_string& n):name(n),bytes(0){}
+	MemoryAccount(const tiny_string& n):name(n),bytes(0),collectedObjects(0){}
 	void addBytes(uint32_t b)
 	{
 		ATOMIC_ADD(this->bytes, b);
@@ -48,6 +83,10 @@ public:
 	{
 		ATOMIC_SUB(this->bytes, b);
 	}
+	void addCollectedObjects(uint32_t n)
+	{
+		ATOMIC_ADD(this->collectedObjects, n);
+	}
 };
 
 //Since global overloaded delete can't be called explicitly, memory reporting is only
@@ -75,20 +114,20 @@ public:
 		//Prepend some internal data.
 		//Adding the data to the object itself would not work
 		//since it can be reset by the constructors
-		objData* ret=reinterpret_cast<objData*>(malloc(size+sizeof(objData)));
+		objData* ret=reinterpret_cast<objData*>(SlabAllocator::allocate(size+sizeof(objData)));
 		if(!m)
 			m = getUnaccountedMemoryAccount();
-		m->addBytes(size);
+		SlabAllocator::addBytes(m,size);
 		ret->objSize = size;
 		ret->memoryAccount = m;
 		return ret+1;
 	}
-	inline void operator delete( void* obj )
+	inline void operator delete( void* obj, size_t )
 	{
 		//Get back the metadata
 		objData* th=reinterpret_cast<objData*>(obj)-1;
-		th->memoryAccount->removeBytes(th->objSize);
-		free(th);
+		SlabAllocator::addBytes(th->memoryAccount,-int32_t(th->objSize));
+		SlabAllocator::deallocate(th,th->objSize+sizeof(objData));
 	}
 };
 
@@ -128,13 +167,13 @@ public:
 	{
 		if(memoryAccount==NULL)
 			memoryAccount=getUnaccountedMemoryAccount();
-		memoryAccount->addBytes(n*sizeof(T));
-		return (pointer)malloc(n*sizeof(T));
+		SlabAllocator::addBytes(memoryAccount,n*sizeof(T));
+		return (pointer)SlabAllocator::allocate(n*sizeof(T));
 	}
 	void deallocate(pointer p, size_type n)
 	{
-		memoryAccount->removeBytes(n*sizeof(T));
-		free(p);
+		SlabAllocator::addBytes(memoryAccount,-int32_t(n*sizeof(T)));
+		SlabAllocator::deallocate(p,n*sizeof(T));
 	}
 	template<class... args>
 	void construct(pointer p, args&&... vals)
@@ -167,8 +206,6 @@ bool operator!=(const reporter_allocator<T>& a,
 
 #else //MEMORY_USAGE_PROFILING
 
-class MemoryAccount;
-
 class memory_reporter
 {
 public:
@@ -183,11 +220,12 @@ public:
 	//Regular allocator
 	inline void* operator new( size_t size, MemoryAccount* m)
 	{
-		return malloc(size);
+		return SlabAllocator::allocate(size);
 	}
-	inline void operator delete( void* obj )
+	//The size of the most derived object is passed since the destructors are virtual
+	inline void operator delete( void* obj, size_t size )
 	{
-		free(obj);
+		SlabAllocator::deallocate(obj,size);
 	}
 };
 
@@ -195,6 +233,8 @@ template<class T>
 class reporter_allocator: public std::allocator<T>
 {
 public:
+	typedef typename std::allocator<T>::size_type size_type;
+	typedef typename std::allocator<T>::pointer pointer;
 	template<class U>
 	struct rebind
 	{
@@ -207,6 +247,14 @@ public:
 	reporter_allocator(const reporter_allocator<U>& o):std::allocator<T>(o)
 	{
 	}
+	pointer allocate(size_type n, std::allocator<void>::const_pointer hint=0)
+	{
+		return (pointer)SlabAllocator::allocate(n*sizeof(T));
+	}
+	void deallocate(pointer p, size_type n)
+	{
+		SlabAllocator::deallocate(p,n*sizeof(T));
+	}
 };
 
 #endif //MEMORY_USAGE_PROFILING
@@ -26,6 +26,12 @@
 #include <cstdlib>
 #include <cstring>
 #include <assert.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 
 extern lightspark::SystemState* getSys();
@@ -64,6 +70,128 @@ streampos uncompressing_filter::seekoff(off_type off, ios_base::seekdir dir,ios_
 	return ret;
 }
 
+class pipelined_filter_job: public lightspark::IThreadJob
+{
+private:
+	pipelined_filter* filter;
+public:
+	pipelined_filter_job(pipelined_filter* f):filter(f) {}
+	void execute()
+	{
+		filter->produce();
+	}
+	void threadAbort()
+	{
+		filter->stop();
+	}
+	void jobFence()
+	{
+		filter->jobDone.signal();
+		delete this;
+	}
+};
+
+pipelined_filter::pipelined_filter(streambuf* s, lightspark::SystemState* sys):source(s),ring(RING_SIZE*BUFFER_LENGTH),
+	produced(0),released(0),reading(false),finished(false),stopping(false),jobDone(0),consumed(0)
+{
+	setg(ring.data(),ring.data(),ring.data());
+	consumed=source->pubseekoff(0, ios_base::cur, ios_base::in);
+	sys->addJob(new pipelined_filter_job(this));
+}
+
+pipelined_filter::~pipelined_filter()
+{
+	stop();
+	jobDone.wait();
+}
+
+void pipelined_filter::stop()
+{
+	lightspark::Locker l(mutex);
+	stopping=true;
+	cond.broadcast();
+}
+
+void pipelined_filter::produce()
+{
+	while(true)
+	{
+		mutex.lock();
+		while(produced-released==RING_SIZE && !stopping)
+			cond.wait(mutex);
+		if(stopping)
+		{
+			mutex.unlock();
+			return;
+		}
+		uint32_t slot=produced%RING_SIZE;
+		mutex.unlock();
+
+		streamsize n=0;
+		string e;
+		try
+		{
+			n=source->sgetn(ring.data()+slot*BUFFER_LENGTH,BUFFER_LENGTH);
+		}
+		catch(lightspark::LightsparkException& ex)
+		{
+			e=ex.cause;
+		}
+		catch(std::exception& ex)
+		{
+			e=ex.what();
+		}
+
+		lightspark::Locker l(mutex);
+		lengths[slot]=n>0 ? n : 0;
+		if(lengths[slot])
+			produced++;
+		else
+		{
+			error=e;
+			finished=true;
+		}
+		cond.broadcast();
+		if(finished)
+			return;
+	}
+}
+
+int pipelined_filter::underflow()
+{
+	assert(gptr()==egptr());
+	lightspark::Locker l(mutex);
+	if(reading)
+	{
+		//The current buffer has been read completely, give it back to the producer
+		consumed+=(egptr()-eback());
+		setg(ring.data(),ring.data(),ring.data());
+		released++;
+		reading=false;
+		cond.broadcast();
+	}
+	while(released==produced && !finished && !stopping)
+		cond.wait(mutex);
+	if(released==produced)
+	{
+		if(!error.empty())
+			throw lightspark::ParseException(error);
+		return -1;
+	}
+	char* buffer=ring.data()+(released%RING_SIZE)*BUFFER_LENGTH;
+	setg(buffer,buffer,buffer+lengths[released%RING_SIZE]);
+	reading=true;
+	//Cast to unsigned, otherwise 0xff would become eof
+	return (unsigned char)buffer[0];
+}
+
+streampos pipelined_filter::seekoff(off_type off, ios_base::seekdir dir,ios_base::openmode mode)
+{
+	assert(off==0);
+	assert(dir==ios_base::cur);
+	return consumed+(gptr()-eback());
+}
+
 zlib_filter::zlib_filter(streambuf* b):uncompressing_filter(b)
 {
 	strm.zalloc = Z_NULL;
@@ -128,6 +256,101 @@ bytes_buf::pos_type bytes_buf::seekoff(off_type off, ios_base::seekdir dir,ios_b
 	return ret;
 }
 
+mapped_buf::mapped_buf(char* d, size_t l):data(d),length(l),refs(1)
+{
+	setg(data,data,data+length);
+}
+
+mapped_buf::~mapped_buf()
+{
+#ifndef _WIN32
+	munmap(data,length);
+#endif
+}
+
+mapped_buf* mapped_buf::mapFile(const char* path)
+{
+#ifndef _WIN32
+	int fd=open(path,O_RDONLY);
+	if(fd<0)
+		return NULL;
+	struct stat st;
+	void* d=MAP_FAILED;
+	if(fstat(fd,&st)==0 && S_ISREG(st.st_mode) && st.st_size>0)
+		d=mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+	//The mapping stays valid after closing the file
+	close(fd);
+	if(d==MAP_FAILED)
+		return NULL;
+	return new mapped_buf((char*)d,st.st_size);
+#else
+	return NULL;
+#endif
+}
+
+void mapped_buf::release()
+{
+	if(--refs==0)
+		delete this;
+}
+
+mapped_buf::pos_type mapped_buf::seekoff(off_type off, ios_base::seekdir dir, ios_base::openmode mode)
+{
+	off_type pos=off;
+	if(dir==ios_base::cur)
+		pos+=gptr()-data;
+	else if(dir==ios_base::end)
+		pos+=length;
+	if(pos<0 || size_t(pos)>length)
+		return pos_type(off_type(-1));
+	setg(data,data+pos,data+length);
+	return pos;
+}
+
+mapped_buf::pos_type mapped_buf::seekpos(pos_type pos, ios_base::openmode mode)
+{
+	return seekoff(off_type(pos),ios_base::beg,mode);
+}
+
+const char* mapped_buf::view(size_t len)
+{
+	size_t pos=gptr()-data;
+	if(pos+len>length)
+		return NULL;
+	setg(data,data+pos+len,data+length);
+	return data+pos;
+}
+
+void mapped_bytes::read(istream& in, uint32_t l)
+{
+	clear();
+	mapped_buf* m=dynamic_cast<mapped_buf*>(in.rdbuf());
+	const char* v=m ? m->view(l) : NULL;
+	if(v)
+	{
+		m->addRef();
+		mapping=m;
+		bytes=(const uint8_t*)v;
+	}
+	else
+	{
+		copy.resize(l);
+		in.read((char*)copy.data(),l);
+		bytes=copy.data();
+	}
+	len=l;
+}
+
+void mapped_bytes::clear()
+{
+	if(mapping)
+		mapping->release();
+	mapping=NULL;
+	vector<uint8_t>().swap(copy);
+	bytes=NULL;
+	len=0;
+}
+
 liblzma_filter::liblzma_filter(streambuf* b):uncompressing_filter(b)
 {
 	strm = LZMA_STREAM_INIT;
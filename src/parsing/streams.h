@@ -23,8 +23,10 @@
 #include "compat.h"
 #include "abctypes.h"
 #include "swftypes.h"
+#include "threading.h"
 #include <streambuf>
 #include <fstream>
+#include <vector>
 #include <cinttypes>
 #include <zlib.h>
 #include <lzma.h>
@@ -80,6 +82,46 @@ public:
 	~liblzma_filter();
 };
 
+namespace lightspark
+{
+class SystemState;
+}
+
+// Reads a filter in the thread pool ahead of the consumer, so that
+// decompressing the data and parsing it overlap. The decompressed data
+// goes through a ring of buffers, exceptions of the filter are thrown
+// again when the consumer reaches them.
+class pipelined_filter: public std::streambuf
+{
+friend class pipelined_filter_job;
+private:
+	static const unsigned int RING_SIZE = 8;
+	static const unsigned int BUFFER_LENGTH = 65536;
+	std::streambuf* source;
+	std::vector<char> ring;
+	uint32_t lengths[RING_SIZE];
+	// Buffers filled and released by the consumer so far
+	uint32_t produced;
+	uint32_t released;
+	bool reading;
+	bool finished;
+	bool stopping;
+	std::string error;
+	lightspark::Mutex mutex;
+	lightspark::Cond cond;
+	lightspark::Semaphore jobDone;
+	// Total number of bytes read before the current buffer
+	int consumed;
+	void produce();
+	void stop();
+protected:
+	virtual int underflow();
+	virtual std::streampos seekoff(off_type, std::ios_base::seekdir, std::ios_base::openmode);
+public:
+	pipelined_filter(std::streambuf* s, lightspark::SystemState* sys);
+	~pipelined_filter();
+};
+
 class bytes_buf:public std::streambuf
 {
 private:
@@ -90,6 +132,51 @@ public:
 	virtual pos_type seekoff(off_type, std::ios_base::seekdir, std::ios_base::openmode);
 };
 
+// A streambuf reading from a memory mapping of a file. Tags may keep
+// views into it instead of copying their data (see mapped_bytes), so the
+// mapping is reference counted and only unmapped by the last release().
+class mapped_buf:public std::streambuf
+{
+private:
+	char* data;
+	size_t length;
+	ATOMIC_INT32(refs);
+	mapped_buf(char* d, size_t l);
+	~mapped_buf();
+protected:
+	virtual pos_type seekoff(off_type, std::ios_base::seekdir, std::ios_base::openmode);
+	virtual pos_type seekpos(pos_type, std::ios_base::openmode);
+public:
+	// Maps a whole file, returns NULL if it can not be mapped
+	static mapped_buf* mapFile(const char* path);
+	// Returns the next len bytes and skips them, NULL if they are not available
+	const char* view(size_t len);
+	void addRef() { ++refs; }
+	void release();
+};
+
+// Data of a tag, a view into the input when it is a mapped_buf, otherwise
+// a copy. The pages of a file mapping can be dropped and read back from
+// the file, so a view doesn't keep the data resident
+class mapped_bytes
+{
+private:
+	std::vector<uint8_t> copy;
+	mapped_buf* mapping;
+	const uint8_t* bytes;
+	uint32_t len;
+	mapped_bytes(const mapped_bytes&);
+	mapped_bytes& operator=(const mapped_bytes&);
+public:
+	mapped_bytes():mapping(NULL),bytes(NULL),len(0) {}
+	~mapped_bytes() { clear(); }
+	void read(std::istream& in, uint32_t l);
+	void clear();
+	const uint8_t* data() const { return bytes; }
+	uint32_t size() const { return len; }
+	bool empty() const { return len==0; }
+};
+
 // A lightweight, istream-like interface for reading from a memory
 // buffer.
 // 
@@ -1075,21 +1075,106 @@ ASObject* DefineFont4Tag::instance(Class_base* c)
 	return ret;
 }
 
-BitmapTag::BitmapTag(RECORDHEADER h,RootMovieClip* root):DictionaryTag(h,root),bitmap(_MR(new BitmapContainer(root->getSystemState()->tagsMemory)))
+namespace lightspark
 {
+/*
+ * Decodes a BitmapTag in the thread pool. The job is shared with the tag
+ * and freed by the last of them, a tag deleted before the job is executed
+ * only detaches itself.
+ */
+class BitmapDecodeJob: public IThreadJob
+{
+private:
+	Mutex mutex;
+	BitmapTag* tag;
+	ATOMIC_INT32(refs);
+	void release()
+	{
+		if(ATOMIC_DECREMENT(refs)==0)
+			delete this;
+	}
+public:
+	BitmapDecodeJob(BitmapTag* t, THREAD_JOB_PRIORITY priority):tag(t),refs(2)
+	{
+		jobPriority=priority;
+	}
+	void execute()
+	{
+		Locker l(mutex);
+		if(tag)
+			tag->ensureDecoded();
+	}
+	void jobFence()
+	{
+		release();
+	}
+	void detach()
+	{
+		mutex.lock();
+		tag=NULL;
+		mutex.unlock();
+		release();
+	}
+};
+}
+
+BitmapTag::BitmapTag(RECORDHEADER h,RootMovieClip* root):DictionaryTag(h,root),decoded(false),decodeJob(NULL),
+	bitmap(_MR(new BitmapContainer(root->getSystemState()->tagsMemory)))
+{
+	bitmap->setDecoder(this);
+}
+
+BitmapTag::~BitmapTag()
+{
+	stopDecoding();
 }
 
-_R<BitmapContainer> BitmapTag::getBitmap() const {
+void BitmapTag::stopDecoding()
+{
+	//Fill styles may keep the container after the tag is gone
+	bitmap->setDecoder(NULL);
+	//Waits for the job if it is decoding right now
+	if(decodeJob)
+		decodeJob->detach();
+	decodeJob=NULL;
+}
+
+void BitmapTag::readRawData(istream& in, int len)
+{
+	if(len<=0)
+		return;
+	rawData.read(in,len);
+}
+
+void BitmapTag::ensureDecoded()
+{
+	Locker l(decodeMutex);
+	if(decoded)
+		return;
+	decode();
+	decoded=true;
+	rawData.clear();
+}
+
+void BitmapTag::startDecoding(THREAD_JOB_PRIORITY priority)
+{
+	assert(!decodeJob);
+	decodeJob=new BitmapDecodeJob(this,priority);
+	loadedFrom->getSystemState()->addJob(decodeJob);
+}
+
+_R<BitmapContainer> BitmapTag::getUndecodedBitmap()
+{
 	return bitmap;
 }
-void BitmapTag::loadBitmap(uint8_t* inData, int datasize, const uint8_t *tablesData, int tablesLen)
+void BitmapTag::loadBitmap(const uint8_t* inData, int datasize, const uint8_t *tablesData, int tablesLen)
 {
 	if (datasize < 4)
 		return;
 	else if((inData[0]&0x80) && inData[1]=='P' && inData[2]=='N' && inData[3]=='G')
-		bitmap->fromPNG(inData,datasize);
+		bitmap->fromPNG((uint8_t*)inData,datasize);
 	else if(inData[0]==0xff && inData[1]==0xd8 && inData[2]==0xff)
-		bitmap->fromJPEG(inData,datasize,tablesData,tablesLen);
+		bitmap->fromJPEG((uint8_t*)inData,datasize,tablesData,tablesLen);
 	else if(inData[0]=='G' && inData[1]=='I' && inData[2]=='F' && inData[3]=='8')
 		LOG(LOG_ERROR,"GIF image found, not yet supported, ID :"<<getId());
 	else if(inData[0]==0xff && inData[1]==0xd9)
@@ -1100,7 +1185,7 @@ void BitmapTag::loadBitmap(uint8_t* inData, int datasize, const uint8_t *tablesD
 	else
 		LOG(LOG_ERROR,"unknown image format for ID "<<getId());
 }
-DefineBitsLosslessTag::DefineBitsLosslessTag(RECORDHEADER h, istream& in, int version, RootMovieClip* root):BitmapTag(h,root),BitmapColorTableSize(0)
+DefineBitsLosslessTag::DefineBitsLosslessTag(RECORDHEADER h, istream& in, int v, RootMovieClip* root):BitmapTag(h,root),BitmapColorTableSize(0),version(v)
 {
 	int dest=in.tellg();
 	dest+=h.getLength();
@@ -1109,12 +1194,13 @@ DefineBitsLosslessTag::DefineBitsLosslessTag(RECORDHEADER h, istream& in, int ve
 	if(BitmapFormat==LOSSLESS_BITMAP_PALETTE)
 		in >> BitmapColorTableSize;
 
-	string cData;
-	size_t cSize = dest-in.tellg(); //rest of this tag
-	cData.resize(cSize);
-	in.read(&cData[0], cSize);
-	istringstream cDataStream(cData);
-	zlib_filter zf(cDataStream.rdbuf());
+	readRawData(in,dest-in.tellg()); //rest of this tag
+}
+
+void DefineBitsLosslessTag::decode()
+{
+	bytes_buf cData(rawData.data(),rawData.size());
+	zlib_filter zf(&cData);
 	istream zfstream(&zf);
 
 	if (BitmapFormat == LOSSLESS_BITMAP_RGB15 ||
@@ -1170,6 +1256,7 @@ ASObject* BitmapTag::instance(Class_base* c)
 {
 	//Flex imports bitmaps using BitmapAsset as the base class, which is derived from bitmap
 	//Also BitmapData is used in the wild though, so support both cases
+	ensureDecoded();
 
 	Class_base* realClass=(c)?c:bindedTo;
 	Class_base* classRet = Class<BitmapData>::getClass(loadedFrom->getSystemState());
@@ -1654,7 +1741,7 @@ void PlaceObject2Tag::execute(DisplayObjectContainer* parent, bool inskipping)
 			if (it->EventFlags.ClipEventConstruct)
 			{
 				AVM1context context;
-				ACTIONRECORD::executeActions(currchar ,&context,it->actions,it->startactionpos,m);
+				ACTIONRECORD::executeActions(currchar ,&context,it->actions.getPtr(),m);
 			}
 		}
 	}
@@ -1667,7 +1754,7 @@ void PlaceObject2Tag::execute(DisplayObjectContainer* parent, bool inskipping)
 			if (it->EventFlags.ClipEventInitialize)
 			{
 				AVM1context context;
-				ACTIONRECORD::executeActions(currchar ,&context,it->actions,it->startactionpos,m);
+				ACTIONRECORD::executeActions(currchar ,&context,it->actions.getPtr(),m);
 			}
 		}
 	}
@@ -1933,14 +2020,15 @@ DefineButtonTag::DefineButtonTag(RECORDHEADER h, std::istream& in, int version,
 	{
 		BUTTONCONDACTION a;
 		a.CondOverDownToOverUp=true; // clicked indicator
-		a.startactionpos=0;
-		a.actions.resize(len+ (datatag ? datatag->numbytes+datatagskipbytes : 0)+1,0);
+		uint32_t startactionpos=0;
+		std::vector<uint8_t> actions(len+ (datatag ? datatag->numbytes+datatagskipbytes : 0)+1,0);
 		if (datatag)
 		{
-			a.startactionpos=datatag->numbytes+datatagskipbytes;
-			memcpy(a.actions.data(),datatag->bytes,datatag->numbytes);
+			startactionpos=datatag->numbytes+datatagskipbytes;
+			memcpy(actions.data(),datatag->bytes,datatag->numbytes);
 		}
-		in.read((char*)a.actions.data()+a.startactionpos,len);
+		in.read((char*)actions.data()+startactionpos,len);
+		a.actions=_MR(new AVM1Program(actions,startactionpos));
 		condactions.push_back(a);
 	}
 	else if(ActionOffset)
@@ -1955,14 +2043,15 @@ DefineButtonTag::DefineButtonTag(RECORDHEADER h, std::istream& in, int version,
 			len -= (((int)in.tellg())-pos);
 			pos = in.tellg();
 			int codesize = (r.CondActionSize ? r.CondActionSize-4 : len);
-			r.actions.resize(codesize+ (datatag ? datatag->numbytes+datatagskipbytes+4 : 0)+1,0);
-			r.startactionpos=0;
+			uint32_t startactionpos=0;
+			std::vector<uint8_t> actions(codesize+ (datatag ? datatag->numbytes+datatagskipbytes+4 : 0)+1,0);
 			if (datatag)
 			{
-				r.startactionpos=datatag->numbytes+datatagskipbytes+4;
-				memcpy(r.actions.data(),datatag->bytes,datatag->numbytes);
+				startactionpos=datatag->numbytes+datatagskipbytes+4;
+				memcpy(actions.data(),datatag->bytes,datatag->numbytes);
 			}
-			in.read((char*)r.actions.data()+r.startactionpos,codesize);
+			in.read((char*)actions.data()+startactionpos,codesize);
+			r.actions=_MR(new AVM1Program(actions,startactionpos));
 			datatagskipbytes+= codesize+4;
 			len -= (((int)in.tellg())-pos);
 			condactions.push_back(r);
@@ -2088,15 +2177,13 @@ DefineBinaryDataTag::DefineBinaryDataTag(RECORDHEADER h,std::istream& s,RootMovi
 	int size=h.getLength();
 	s >> Tag >> Reserved;
 	size -= sizeof(Tag)+sizeof(Reserved);
-	bytes=new uint8_t[size];
-	len=size;
-	s.read((char*)bytes,size);
+	bytes.read(s,size);
 }
 
 ASObject* DefineBinaryDataTag::instance(Class_base* c)
 {
-	uint8_t* b = new uint8_t[len];
-	memcpy(b,bytes,len);
+	uint8_t* b = new uint8_t[bytes.size()];
+	memcpy(b,bytes.data(),bytes.size());
 
 	Class_base* classRet = NULL;
 	if(c)
@@ -2106,7 +2193,7 @@ ASObject* DefineBinaryDataTag::instance(Class_base* c)
 	else
 		classRet=Class<ByteArray>::getClass(loadedFrom->getSystemState());
 
-	ByteArray* ret=new (classRet->memoryAccount) ByteArray(classRet, b, len);
+	ByteArray* ret=new (classRet->memoryAccount) ByteArray(classRet, b, bytes.size());
 	return ret;
 }
 
@@ -2420,11 +2507,12 @@ DefineBitsTag::DefineBitsTag(RECORDHEADER h, std::istream& in,RootMovieClip* roo
 
 	in >> CharacterId;
 	//Read image data
-	int dataSize=Header.getLength()-2;
-	uint8_t *inData=new(nothrow) uint8_t[dataSize];
-	in.read((char*)inData,dataSize);
-	loadBitmap(inData,dataSize,JPEGTablesTag::getJPEGTables(),JPEGTablesTag::getJPEGTableSize());
-	delete[] inData;
+	readRawData(in,Header.getLength()-2);
+}
+
+void DefineBitsTag::decode()
+{
+	loadBitmap(rawData.data(),rawData.size(),JPEGTablesTag::getJPEGTables(),JPEGTablesTag::getJPEGTableSize());
 }
 
 DefineBitsJPEG2Tag::DefineBitsJPEG2Tag(RECORDHEADER h, std::istream& in, RootMovieClip* root):BitmapTag(h,root)
@@ -2432,58 +2520,54 @@ DefineBitsJPEG2Tag::DefineBitsJPEG2Tag(RECORDHEADER h, std::istream& in, RootMov
 	LOG(LOG_TRACE,_("DefineBitsJPEG2Tag Tag"));
 	in >> CharacterId;
 	//Read image data
-	int dataSize=Header.getLength()-2;
-	uint8_t* inData=new(nothrow) uint8_t[dataSize];
-	in.read((char*)inData,dataSize);
-	loadBitmap(inData,dataSize);
-	delete[] inData;
+	readRawData(in,Header.getLength()-2);
+}
+
+void DefineBitsJPEG2Tag::decode()
+{
+	loadBitmap(rawData.data(),rawData.size());
 }
 
-DefineBitsJPEG3Tag::DefineBitsJPEG3Tag(RECORDHEADER h, std::istream& in, RootMovieClip* root):BitmapTag(h,root),alphaData(NULL)
+DefineBitsJPEG3Tag::DefineBitsJPEG3Tag(RECORDHEADER h, std::istream& in, RootMovieClip* root):BitmapTag(h,root)
 {
 	LOG(LOG_TRACE,_("DefineBitsJPEG3Tag Tag"));
 	UI32_SWF dataSize;
 	in >> CharacterId >> dataSize;
 	//Read image data
-	uint8_t* inData=new(nothrow) uint8_t[dataSize];
-	in.read((char*)inData,dataSize);
-
-	loadBitmap(inData,dataSize);
-	delete[] inData;
+	readRawData(in,dataSize);
 
 	//Read alpha data (if any)
 	int alphaSize=Header.getLength()-dataSize-6;
 	if(alphaSize>0) //If less that 0 the consistency check on tag size will stop later
-	{
-		//Create a zlib filter
-		string alphaData;
-		alphaData.resize(alphaSize);
-		in.read(&alphaData[0], alphaSize);
-		istringstream alphaStream(alphaData);
-		zlib_filter zf(alphaStream.rdbuf());
-		istream zfstream(&zf);
-		zfstream.exceptions ( istream::eofbit | istream::failbit | istream::badbit );
+		alphaData.read(in,alphaSize);
+}
 
-		//Catch the exception if the stream ends
-		try
-		{
-			//Set alpha
-			for(int32_t i=0;i<bitmap->getHeight();i++)
-			{
-				for(int32_t j=0;j<bitmap->getWidth();j++)
-					bitmap->setAlpha(j, i, zfstream.get());
-			}
-		}
-		catch(std::exception& e)
+void DefineBitsJPEG3Tag::decode()
+{
+	loadBitmap(rawData.data(),rawData.size());
+	if(alphaData.empty())
+		return;
+
+	//Create a zlib filter
+	bytes_buf alphaStream(alphaData.data(),alphaData.size());
+	zlib_filter zf(&alphaStream);
+	istream zfstream(&zf);
+	zfstream.exceptions ( istream::eofbit | istream::failbit | istream::badbit );
+
+	//Catch the exception if the stream ends
+	try
+	{
+		//Set alpha
+		for(int32_t i=0;i<bitmap->getHeight();i++)
 		{
-			LOG(LOG_ERROR, "Exception while parsing Alpha data in DefineBitsJPEG3");
+			for(int32_t j=0;j<bitmap->getWidth();j++)
+				bitmap->setAlpha(j, i, zfstream.get());
 		}
 	}
-}
-
-DefineBitsJPEG3Tag::~DefineBitsJPEG3Tag()
-{
-	delete[] alphaData;
+	catch(std::exception& e)
+	{
+		LOG(LOG_ERROR, "Exception while parsing Alpha data in DefineBitsJPEG3");
+	}
 }
 
 DefineSceneAndFrameLabelDataTag::DefineSceneAndFrameLabelDataTag(RECORDHEADER h, std::istream& in):ControlTag(h)
@@ -2604,20 +2688,23 @@ AVM1ActionTag::AVM1ActionTag(RECORDHEADER h, istream &s, RootMovieClip *root, Ad
 		skip(s);
 		return; 
 	}
-	startactionpos=0;
-	actions.resize(Header.getLength()+ (datatag ? datatag->numbytes+Header.getHeaderSize() : 0)+1,0);
+	uint32_t startactionpos=0;
+	std::vector<uint8_t> a(Header.getLength()+ (datatag ? datatag->numbytes+Header.getHeaderSize() : 0)+1,0);
 	if (datatag)
 	{
 		startactionpos=datatag->numbytes+Header.getHeaderSize();
-		memcpy(actions.data(),datatag->bytes,datatag->numbytes);
+		memcpy(a.data(),datatag->bytes,datatag->numbytes);
 	}
-	s.read((char*)actions.data()+startactionpos,Header.getLength());
+	s.read((char*)a.data()+startactionpos,Header.getLength());
+	actions=_MR(new AVM1Program(a,startactionpos));
 }
 
 void AVM1ActionTag::execute(MovieClip* clip, AVM1context* context)
 {
+	if (actions.isNull())
+		return;
 	std::map<uint32_t,asAtom> m;
-	ACTIONRECORD::executeActions(clip,context,actions, startactionpos,m);
+	ACTIONRECORD::executeActions(clip,context,actions.getPtr(),m);
 }
 
 AVM1InitActionTag::AVM1InitActionTag(RECORDHEADER h, istream &s, RootMovieClip *root, AdditionalDataTag* datatag):ControlTag(h)
@@ -2628,20 +2715,22 @@ AVM1InitActionTag::AVM1InitActionTag(RECORDHEADER h, istream &s, RootMovieClip *
 		skip(s);
 		return; 
 	}
-	startactionpos=0;
-	actions.resize(Header.getLength()+ (datatag ? datatag->numbytes+Header.getHeaderSize()+2 : 0)+1,0);
+	uint32_t startactionpos=0;
+	std::vector<uint8_t> a(Header.getLength()+ (datatag ? datatag->numbytes+Header.getHeaderSize()+2 : 0)+1,0);
 	if (datatag)
 	{
 		startactionpos=datatag->numbytes+Header.getHeaderSize()+2;// 2 bytes for SpriteID
-		memcpy(actions.data(),datatag->bytes,datatag->numbytes);
+		memcpy(a.data(),datatag->bytes,datatag->numbytes);
 	}
 	s >> SpriteId;
-	s.read((char*)actions.data()+startactionpos,Header.getLength()-2);
+	s.read((char*)a.data()+startactionpos,Header.getLength()-2);
+	actions=_MR(new AVM1Program(a,startactionpos));
 }
 
 void AVM1InitActionTag::execute(RootMovieClip *root) const
 {
-	
+	if (actions.isNull())
+		return;
 	DefineSpriteTag* sprite = dynamic_cast<DefineSpriteTag*>(root->dictionaryLookup(SpriteId));
 	if (!sprite)
 	{
@@ -2649,7 +2738,7 @@ void AVM1InitActionTag::execute(RootMovieClip *root) const
 		return;
 	}
 	MovieClip* o = sprite->instance(nullptr)->as<MovieClip>();
-	getVm(root->getSystemState())->addEvent(NullRef,_MR(new (root->getSystemState()->unaccountedMemory) AVM1InitActionEvent(sprite,actions,startactionpos,_MR(o))));
+	getVm(root->getSystemState())->addEvent(NullRef,_MR(new (root->getSystemState()->unaccountedMemory) AVM1InitActionEvent(sprite,actions,_MR(o))));
 }
 
 AdditionalDataTag::AdditionalDataTag(RECORDHEADER h, istream &in):Tag(h)
@@ -24,6 +24,7 @@
 #include <vector>
 #include <iostream>
 #include "swftypes.h"
+#include "parsing/streams.h"
 #include "backends/geometry.h"
 #include "backends/decoder.h"
 #include "scripting/flash/display/flashdisplay.h"
@@ -35,6 +36,7 @@ class RootMovieClip;
 class DisplayObjectContainer;
 class DefineSpriteTag;
 class AdditionalDataTag;
+class BitmapDecodeJob;
 
 enum TAGTYPE {TAG=0,DISPLAY_LIST_TAG,SHOW_TAG,CONTROL_TAG,DICT_TAG,FRAMELABEL_TAG,SYMBOL_CLASS_TAG,ACTION_TAG,ABC_TAG,END_TAG,AVM1ACTION_TAG,AVM1INITACTION_TAG};
 
@@ -88,6 +90,11 @@ public:
 	virtual int getId() const=0;
 	virtual ASObject* instance(Class_base* c=NULL) { return NULL; }
 	virtual MATRIX MapToBounds(const MATRIX& mat) { return mat; }
+	/*
+	   Called by the ParseThread once the tag is in the dictionary, tags
+	   that defer decoding their data may start it in the background here
+	*/
+	virtual void startDecoding(THREAD_JOB_PRIORITY priority) {}
 };
 
 /*
@@ -116,25 +123,23 @@ public:
 class AVM1ActionTag: public Tag
 {
 private:
-	std::vector<uint8_t> actions;
-	uint32_t startactionpos;
+	_NR<AVM1Program> actions;
 public:
 	AVM1ActionTag(RECORDHEADER h, std::istream& s,RootMovieClip* root, AdditionalDataTag* datatag);
 	TAGTYPE getType() const override { return AVM1ACTION_TAG; }
 	void execute(MovieClip* clip, AVM1context *context);
-	bool empty() { return actions.empty(); }
+	bool empty() { return actions.isNull() || actions->empty(); }
 };
 class AVM1InitActionTag: public ControlTag
 {
 private:
 	UI16_SWF SpriteId;
-	std::vector<uint8_t> actions;
-	uint32_t startactionpos;
+	_NR<AVM1Program> actions;
 public:
 	AVM1InitActionTag(RECORDHEADER h, std::istream& s,RootMovieClip* root, AdditionalDataTag* datatag);
 	TAGTYPE getType() const override { return AVM1INITACTION_TAG; }
 	void execute(RootMovieClip* root) const override;
-	bool empty() { return actions.empty(); }
+	bool empty() { return actions.isNull() || actions->empty(); }
 };
 
 class DefineShapeTag: public DictionaryTag
@@ -432,11 +437,9 @@ class DefineBinaryDataTag: public DictionaryTag
 private:
 	UI16_SWF Tag;
 	UI32_SWF Reserved;
-	uint8_t* bytes;
-	uint32_t len;
+	mapped_bytes bytes;
 public:
 	DefineBinaryDataTag(RECORDHEADER h,std::istream& s,RootMovieClip* root);
-	~DefineBinaryDataTag() { delete[] bytes; }
 	virtual int getId() const {return Tag;}
 	ASObject* instance(Class_base* c=NULL);
 };
@@ -596,15 +599,36 @@ public:
 
 class BitmapContainer;
 
+/*
+ * The image data of bitmap tags is only copied while parsing, it is
+ * decoded by the first user of the bitmap or before by a job started
+ * in startDecoding
+ */
 class BitmapTag: public DictionaryTag
 {
+private:
+	Mutex decodeMutex;
+	bool decoded;
+	BitmapDecodeJob* decodeJob;
 protected:
-        _R<BitmapContainer> bitmap;
-    void loadBitmap(uint8_t* inData, int datasize, const uint8_t *tablesData=NULL, int tablesLen=0);
+	_R<BitmapContainer> bitmap;
+	//Image data of the tag, released once decoded
+	mapped_bytes rawData;
+	void readRawData(std::istream& in, int len);
+	void loadBitmap(const uint8_t* inData, int datasize, const uint8_t *tablesData=NULL, int tablesLen=0);
+	//Fills bitmap from rawData, called only once
+	virtual void decode()=0;
+	//Must be called by the destructors of subclasses, decode uses their members
+	void stopDecoding();
 public:
 	BitmapTag(RECORDHEADER h,RootMovieClip* root);
-	ASObject* instance(Class_base* c=NULL);
-        _R<BitmapContainer> getBitmap() const;
+	~BitmapTag();
+	//Blocks until the bitmap has been decoded
+	void ensureDecoded();
+	void startDecoding(THREAD_JOB_PRIORITY priority) override;
+	ASObject* instance(Class_base* c=NULL) override;
+	//The container is filled by its first ensureDecoded()
+	_R<BitmapContainer> getUndecodedBitmap();
 };
 
 class JPEGTablesTag: public Tag
@@ -627,8 +651,11 @@ private:
 	UI16_SWF BitmapHeight;
 	UI8 BitmapColorTableSize;
 	//ZlibBitmapData;
+	int version;
+	void decode() override;
 public:
 	DefineBitsLosslessTag(RECORDHEADER h, std::istream& in, int version, RootMovieClip* root);
+	~DefineBitsLosslessTag() { stopDecoding(); }
 	int getId() const{ return CharacterId; }
 };
 
@@ -636,8 +663,10 @@ class DefineBitsTag: public BitmapTag
 {
 private:
 	UI16_SWF CharacterId;
+	void decode() override;
 public:
 	DefineBitsTag(RECORDHEADER h, std::istream& in, RootMovieClip* root);
+	~DefineBitsTag() { stopDecoding(); }
 	int getId() const{ return CharacterId; }
 };
 
@@ -645,8 +674,10 @@ class DefineBitsJPEG2Tag: public BitmapTag
 {
 private:
 	UI16_SWF CharacterId;
+	void decode() override;
 public:
 	DefineBitsJPEG2Tag(RECORDHEADER h, std::istream& in, RootMovieClip* root);
+	~DefineBitsJPEG2Tag() { stopDecoding(); }
 	int getId() const{ return CharacterId; }
 };
 
@@ -654,10 +685,12 @@ class DefineBitsJPEG3Tag: public BitmapTag
 {
 private:
 	UI16_SWF CharacterId;
-	uint8_t* alphaData;
+	//zlib compressed alpha values
+	mapped_bytes alphaData;
+	void decode() override;
 public:
 	DefineBitsJPEG3Tag(RECORDHEADER h, std::istream& in, RootMovieClip* root);
-	~DefineBitsJPEG3Tag();
+	~DefineBitsJPEG3Tag() { stopDecoding(); }
 	int getId() const{ return CharacterId; }
 };
 
@@ -47,6 +47,7 @@ SDL_Thread* EngineData::mainLoopThread = nullptr;
 bool EngineData::mainthread_running = false;
 bool EngineData::sdl_needinit = true;
 bool EngineData::enablerendering = true;
+bool EngineData::softwarerendering = false;
 Semaphore EngineData::mainthread_initialized(0);
 EngineData::EngineData() : contextmenu(nullptr),contextmenurenderer(nullptr),sdleventtickjob(nullptr),incontextmenu(false),incontextmenupreparing(false), currentPixelBuffer(0),currentPixelBufferOffset(0),currentPixelBufPtr(NULL),pixelBufferWidth(0),pixelBufferHeight(0),widget(0), width(0), height(0),needrenderthread(true),supportPackedDepthStencil(false),hasExternalFontRenderer(false)
 {
@@ -145,7 +146,7 @@ static int mainloop_runner(void*)
 	
 	if (EngineData::sdl_needinit)
 	{
-		if (!EngineData::enablerendering)
+		if (!EngineData::enablerendering || EngineData::softwarerendering)
 		{
 			if (SDL_WasInit(0)) // some part of SDL already was initialized
 				sdl_available = true;
@@ -1224,6 +1225,10 @@ void EngineData::exec_glScissor(int32_t x, int32_t y, int32_t width, int32_t hei
 	glEnable(GL_SCISSOR_TEST);
 	glScissor(x,y,width,height);
 }
+void EngineData::exec_glDisable_GL_SCISSOR_TEST()
+{
+	glDisable(GL_SCISSOR_TEST);
+}
 
 void EngineData::exec_glColorMask(bool red, bool green, bool blue, bool alpha)
 {
@@ -156,6 +156,8 @@ public:
 
 	static bool sdl_needinit;
 	static bool enablerendering;
+	//Composite the frames on the CPU, without a window or OpenGL
+	static bool softwarerendering;
 	static bool mainthread_running;
 	static Semaphore mainthread_initialized;
 	static bool startSDLMain();
@@ -279,6 +281,7 @@ public:
 	virtual void exec_glTexParameteri_GL_TEXTURE_CUBE_MAP_GL_TEXTURE_MAG_FILTER_GL_LINEAR();
 	virtual void exec_glTexImage2D_GL_TEXTURE_CUBE_MAP_POSITIVE_X_GL_UNSIGNED_BYTE(uint32_t side, int32_t level,int32_t width, int32_t height,int32_t border, const void* pixels);
 	virtual void exec_glScissor(int32_t x, int32_t y, int32_t width, int32_t height);
+	virtual void exec_glDisable_GL_SCISSOR_TEST();
 	virtual void exec_glColorMask(bool red, bool green, bool blue, bool alpha);
 
 	// Audio handling
@@ -1378,6 +1378,8 @@ ABCContext::ABCContext(_R<RootMovieClip> r, istream& in, ABCVm* vm):scriptsdecla
 	scripts(reporter_allocator<script_info>(vm->vmDataMemory)),
 	method_body(reporter_allocator<method_body_info>(vm->vmDataMemory))
 {
+	for (uint32_t i = 0; i < INLINE_CACHE_KIND_COUNT; i++)
+		megamorphicCaches[i]=nullptr;
 	in >> minor >> major;
 	LOG(LOG_CALLS,_("ABCVm version ") << major << '.' << minor);
 	in >> constant_pool;
@@ -1530,6 +1532,44 @@ ABCContext::ABCContext(_R<RootMovieClip> r, istream& in, ABCVm* vm):scriptsdecla
 
 ABCContext::~ABCContext()
 {
+	for (uint32_t i = 0; i < INLINE_CACHE_KIND_COUNT; i++)
+		delete[] megamorphicCaches[i];
+}
+
+polymorphic_cache* ABCContext::newPolymorphicCache(INLINE_CACHE_KIND kind)
+{
+	polymorphicCaches.emplace_back(kind);
+	return &polymorphicCaches.back();
+}
+
+inline_cache_entry* ABCContext::addInlineCache(polymorphic_cache* cache, Class_base* type, const multiname* name)
+{
+	inline_cache_entry* e = nullptr;
+	if (!cache->megamorphic)
+	{
+		for (uint32_t i = 0; i < cache->count; i++)
+		{
+			// the entry for this type is outdated
+			if (cache->entries[i].type == type)
+				e = &cache->entries[i];
+		}
+		if (!e && cache->count < POLYMORPHIC_CACHE_SIZE)
+			e = &cache->entries[cache->count++];
+		if (!e)
+		{
+			// too many receiver types, move the known entries to the stub cache
+			cache->megamorphic = true;
+			for (uint32_t i = 0; i < cache->count; i++)
+				*megamorphicEntry(cache->kind,cache->entries[i].type,cache->entries[i].name) = cache->entries[i];
+		}
+	}
+	if (!e)
+		e = megamorphicEntry(cache->kind,type,name);
+	e->type = type;
+	e->name = name;
+	e->target = nullptr;
+	e->index = 0;
+	return e;
 }
 
 #ifdef PROFILING_SUPPORT
@@ -1575,6 +1615,10 @@ ABCVm::ABCVm(SystemState* s, MemoryAccount* m):m_sys(s),status(CREATED),isIdle(t
 	limits.script_timeout = 20;
 	m_sys=s;
 	stacktrace=new stacktrace_entry[256];
+#ifdef LLVM_ENABLED
+	jitJob=nullptr;
+	jitShutdown=false;
+#endif
 }
 
 void ABCVm::start()
@@ -1598,6 +1642,111 @@ void ABCVm::shutdown()
 	}
 }
 
+#ifdef LLVM_ENABLED
+/*
+ * Compiles the queued methods one after the other, so the llvm module
+ * and execution engine are never used by more than one thread
+ */
+class ABCVm::JitCompileJob: public IThreadJob
+{
+private:
+	ABCVm* vm;
+public:
+	JitCompileJob(ABCVm* v):vm(v)
+	{
+		jobPriority=THREAD_JOB_PRIORITY_LOW;
+	}
+	void execute() override
+	{
+		vm->compileQueuedMethods(this);
+	}
+	void jobFence() override
+	{
+		vm->jitJobFinished(threadAborting);
+		delete this;
+	}
+};
+
+void ABCVm::requestJitCompilation(method_info* mi)
+{
+	assert(mi->jitRequest==nullptr);
+	jitRequests.emplace_back(mi);
+	mi->jitRequest=&jitRequests.back();
+	try
+	{
+		//The multiname cache of the context is only filled by the vm thread
+		mi->resolveStaticMultinames();
+	}
+	catch(LightsparkException& e)
+	{
+		//The method just stays interpreted
+		LOG(LOG_ERROR,"background compilation not possible:"<<e.cause);
+		return;
+	}
+	Locker l(jitMutex);
+	if(jitShutdown)
+		return;
+	jitQueue.push_back(mi->jitRequest);
+	if(jitJob==nullptr)
+	{
+		jitJob=new JitCompileJob(this);
+		m_sys->addJob(jitJob);
+	}
+}
+
+void ABCVm::compileQueuedMethods(IThreadJob* job)
+{
+	setTLSSys(m_sys);
+	while(!job->threadAborting)
+	{
+		jit_request* r;
+		{
+			Locker l(jitMutex);
+			if(jitQueue.empty())
+				return;
+			r=jitQueue.front();
+			jitQueue.pop_front();
+		}
+		SyntheticFunction::synt_function code=nullptr;
+		try
+		{
+			code=r->mi->synt_method(m_sys);
+		}
+		catch(LightsparkException& e)
+		{
+			//The method just stays interpreted
+			LOG(LOG_ERROR,"background compilation failed:"<<e.cause);
+		}
+		if(code)
+			RELEASE_WRITE(r->code,code);
+	}
+}
+
+void ABCVm::jitJobFinished(bool aborted)
+{
+	Locker l(jitMutex);
+	jitJob=nullptr;
+	//Methods may have been queued after the job saw an empty queue
+	if(!aborted && !jitShutdown && !jitQueue.empty())
+	{
+		jitJob=new JitCompileJob(this);
+		m_sys->addJob(jitJob);
+	}
+	jitJobDone.broadcast();
+}
+
+void ABCVm::stopJitCompilation()
+{
+	Locker l(jitMutex);
+	jitShutdown=true;
+	jitQueue.clear();
+	if(jitJob)
+		jitJob->threadAborting=true;
+	while(jitJob)
+		jitJobDone.wait(jitMutex);
+}
+#endif
+
 void ABCVm::finalize()
 {
 	//The event queue may be not empty if the VM has been been started
@@ -1918,6 +2067,8 @@ void ABCVm::handleEvent(std::pair<_NR<EventDispatcher>, _R<Event> > e)
 			}
 			case IDLE_EVENT:
 			{
+				//The frame is done, look for garbage cycles before handling input
+				m_sys->cycleCollector.collectSlice();
 				Locker l(event_queue_mutex);
 				while (!idleevents_queue.empty())
 				{
@@ -2448,6 +2599,8 @@ int ABCVm::Run(void* d)
 #ifdef LLVM_ENABLED
 	if(th->m_sys->useJit)
 	{
+		//The module must not be in use by a background compilation
+		th->stopJitCompilation();
 		th->ex->clearAllGlobalMappings();
 		delete th->module;
 	}
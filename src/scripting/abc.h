@@ -26,6 +26,7 @@
 #include "logger.h"
 #include <vector>
 #include <deque>
+#include <list>
 #include <map>
 #include <set>
 #include "swf.h"
@@ -75,6 +76,20 @@ inline stack_entry make_stack_entry(llvm::Value* v, STACK_TYPE t)
 
 bool isVmThread();
 
+#ifdef LLVM_ENABLED
+/*
+ * A hot method queued for background compilation in tiered mode.
+ * The compiled code is published with a release store, callers
+ * keep interpreting the method until they observe it
+ */
+struct jit_request
+{
+	method_info* mi;
+	ACQUIRE_RELEASE_VARIABLE(SyntheticFunction::synt_function, code);
+	jit_request(method_info* m):mi(m),code(nullptr) {}
+};
+#endif
+
 class method_info
 {
 friend std::istream& operator>>(std::istream& in, method_info& v);
@@ -112,6 +127,9 @@ public:
 	method_body_info* body;
 #ifdef LLVM_ENABLED
 	SyntheticFunction::synt_function synt_method(SystemState* sys);
+	//Set by the vm when the method is queued for background compilation
+	jit_request* jitRequest;
+	void resolveStaticMultinames();
 #endif
 	bool needsArgs() { return info.needsArgs(); }
 	bool needsActivation() { return info.needsActivation(); }
@@ -135,7 +153,7 @@ public:
 	call_context cc;
 	method_info():
 #ifdef LLVM_ENABLED
-		llvmf(nullptr),
+		llvmf(nullptr),jitRequest(nullptr),
 #endif
 #ifdef PROFILING_SUPPORT
 		profTime(0),
@@ -194,6 +212,7 @@ enum OPERANDTYPES {
 #define ABC_OP_NOTCACHEABLE 0x20000000 
 #define ABC_OP_COERCED 0x40000000 //indicates that the method call doesn't have to coerce the arguments to the expected type
 #define ABC_OP_FORCEINT 0x10000000 // forces the result of the arithmetic operation to be coerced to int
+#define ABC_OP_POLYMORPHIC 0x80000000 // the site uses the polymorphic_cache stored in polycache
 #define ABC_OP_AVAILABLEBITS 0x0fffffff
 
 struct typed_opcode_handler
@@ -306,6 +325,39 @@ public:
 #ifdef PROFILING_SUPPORT
 	void dumpProfilingData(std::ostream& f) const;
 #endif
+private:
+	std::deque<polymorphic_cache> polymorphicCaches;
+	// megamorphic stub caches for calls and property accesses, allocated on first use
+	inline_cache_entry* megamorphicCaches[INLINE_CACHE_KIND_COUNT];
+	inline inline_cache_entry* megamorphicEntry(INLINE_CACHE_KIND kind, Class_base* type, const multiname* name)
+	{
+		if (!megamorphicCaches[kind])
+			megamorphicCaches[kind] = new inline_cache_entry[1<<MEGAMORPHIC_CACHE_BITS];
+		uintptr_t h = (uintptr_t(type)>>4) ^ (uintptr_t(name)>>3);
+		return &megamorphicCaches[kind][(uint32_t(h)*2654435761u)>>(32-MEGAMORPHIC_CACHE_BITS)];
+	}
+public:
+	polymorphic_cache* newPolymorphicCache(INLINE_CACHE_KIND kind);
+	// returns the entry of the cache for receivers of the given type, or nullptr on a cache miss
+	inline inline_cache_entry* findInlineCache(polymorphic_cache* cache, Class_base* type, const multiname* name)
+	{
+		if (!cache->megamorphic)
+		{
+			for (uint32_t i = 0; i < cache->count; i++)
+			{
+				if (cache->entries[i].type == type)
+					return &cache->entries[i];
+			}
+			return nullptr;
+		}
+		inline_cache_entry* e = megamorphicEntry(cache->kind,type,name);
+		return (e->type == type && e->name == name) ? e : nullptr;
+	}
+	/*
+	 * returns the entry of the cache to be filled for receivers of the given type
+	 * the call site switches to the megamorphic stub cache if all entries are used
+	 */
+	inline_cache_entry* addInlineCache(polymorphic_cache* cache, Class_base* type, const multiname* name);
 };
 
 struct BasicBlock;
@@ -1174,6 +1226,21 @@ private:
 
 	static void abc_invalidinstruction(call_context* context);
 
+#ifdef LLVM_ENABLED
+	//Background compilation of hot methods in tiered mode
+	class JitCompileJob;
+	Mutex jitMutex;
+	Cond jitJobDone;
+	//Requests are owned by the vm, jitQueue only holds the ones not compiled yet
+	std::list<jit_request> jitRequests;
+	std::deque<jit_request*> jitQueue;
+	JitCompileJob* jitJob;
+	bool jitShutdown;
+	void compileQueuedMethods(IThreadJob* job);
+	void jitJobFinished(bool aborted);
+	void stopJitCompilation();
+#endif
+
 public:
 	static abc_function abcfunctions[];
 	call_context* currentCallContext;
@@ -1190,6 +1257,7 @@ public:
 	llvm::FunctionPassManager* FPM;
 #endif
 	llvm::LLVMContext& llvm_context();
+	void requestJitCompilation(method_info* mi);
 #endif
 
 	ABCVm(SystemState* s, MemoryAccount* m) DLL_PUBLIC;
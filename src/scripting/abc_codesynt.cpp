@@ -793,6 +793,151 @@ void method_info::consumeStackForRTMultiname(static_stack_types_vector& stack, i
 	}
 }
 
+/*
+ * Resolves the static parts of the multinames used by the method, so that
+ * synt_method doesn't fill the multiname cache of the context while it
+ * runs in the background. Must be called from the vm thread.
+ */
+void method_info::resolveStaticMultinames()
+{
+	stringstream code(body->code);
+	while(1)
+	{
+		u8 opcode;
+		code >> opcode;
+		if(code.eof())
+			break;
+		switch(opcode)
+		{
+			case 0x04: //getsuper
+			case 0x05: //setsuper
+			case 0x59: //getdescendants
+			case 0x5d: //findpropstrict
+			case 0x5e: //findproperty
+			case 0x5f: //finddef
+			case 0x60: //getlex
+			case 0x61: //setproperty
+			case 0x66: //getproperty
+			case 0x68: //initproperty
+			case 0x6a: //deleteproperty
+			case 0x80: //coerce
+			case 0x86: //astype
+			case 0xb2: //istype
+			case 0x45: //callsuper
+			case 0x46: //callproperty
+			case 0x4a: //constructprop
+			case 0x4c: //callproplex
+			case 0x4e: //callsupervoid
+			case 0x4f: //callpropvoid
+			{
+				u30 t;
+				code >> t;
+				if(context->getMultinameRTData(t)==0)
+					context->getMultinameImpl(asAtomHandler::nullAtom,nullptr,t,false);
+				if(opcode==0x45 || opcode==0x46 || opcode==0x4a || opcode==0x4c || opcode==0x4e || opcode==0x4f)
+				{
+					u30 argcount;
+					code >> argcount;
+				}
+				break;
+			}
+			case 0x32: //hasnext2
+			case 0x43: //callmethod
+			case 0x44: //callstatic
+			{
+				u30 t,t2;
+				code >> t >> t2;
+				break;
+			}
+			case 0x06: //dxns
+			case 0x08: //kill
+			case 0x25: //pushshort
+			case 0x2c: //pushstring
+			case 0x2d: //pushint
+			case 0x2e: //pushuint
+			case 0x2f: //pushdouble
+			case 0x31: //pushnamespace
+			case 0x40: //newfunction
+			case 0x41: //call
+			case 0x42: //construct
+			case 0x49: //constructsuper
+			case 0x53: //applytype
+			case 0x55: //newobject
+			case 0x56: //newarray
+			case 0x58: //newclass
+			case 0x5a: //newcatch
+			case 0x62: //getlocal
+			case 0x63: //setlocal
+			case 0x65: //getscopeobject
+			case 0x6c: //getslot
+			case 0x6d: //setslot
+			case 0x6e: //getglobalslot
+			case 0x6f: //setglobalslot
+			case 0x92: //inclocal
+			case 0x94: //declocal
+			case 0xc2: //inclocal_i
+			case 0xc3: //declocal_i
+			case 0xf0: //debugline
+			case 0xf1: //debugfile
+			{
+				u30 t;
+				code >> t;
+				break;
+			}
+			case 0x24: //pushbyte
+			{
+				int8_t t;
+				code.read((char*)&t,1);
+				break;
+			}
+			case 0x0c: //ifnlt
+			case 0x0d: //ifnle
+			case 0x0e: //ifngt
+			case 0x0f: //ifnge
+			case 0x10: //jump
+			case 0x11: //iftrue
+			case 0x12: //iffalse
+			case 0x13: //ifeq
+			case 0x14: //ifne
+			case 0x15: //iflt
+			case 0x16: //ifle
+			case 0x17: //ifge
+			case 0x18: //ifgt
+			case 0x19: //ifstricteq
+			case 0x1a: //ifstrictne
+			{
+				s24 t;
+				code >> t;
+				break;
+			}
+			case 0x1b: //lookupswitch
+			{
+				s24 t;
+				code >> t;
+				u30 count;
+				code >> count;
+				for(unsigned int i=0;i<count+1;i++)
+					code >> t;
+				break;
+			}
+			case 0xef: //debug
+			{
+				uint8_t debug_type;
+				u30 index;
+				uint8_t reg;
+				u30 extra;
+				code.read((char*)&debug_type,1);
+				code >> index;
+				code.read((char*)&reg,1);
+				code >> extra;
+				break;
+			}
+			default:
+				break;
+		}
+	}
+}
+
 /* Implements ECMA's ToNumber algorith */
 static llvm::Value* llvm_ToNumber(llvm::Module* module, llvm::IRBuilder<>& Builder, stack_entry& e)
 {
@@ -819,7 +964,8 @@ inline llvm::Value* getMultiname(llvm::Module* module,llvm::IRBuilder<>& Builder
 	llvm::Value* name = 0;
 	if(rtdata==0)
 	{
-		//Multinames without runtime date persist
+		//Multinames without runtime date persist, for background compilation
+		//they were resolved by resolveStaticMultinames
 		asAtom atom=asAtomHandler::invalidAtom;
 		multiname* mname = ABCContext::s_getMultiname(abccontext,atom,NULL,multinameIndex);
 		name = llvm::ConstantExpr::getIntToPtr(llvm::ConstantInt::get(ptr_type, (intptr_t)mname),voidptr_type);
@@ -4777,7 +4923,9 @@ SyntheticFunction::synt_function method_info::synt_method(SystemState* sys)
 #endif
 	f=(SyntheticFunction::synt_function)getVm(sys)->ex->getFunctionAddress(llvmf->getName());
 	//llvmf->print(llvm::dbgs()); llvm::dbgs()<<'\n'; //dump after optimization
-	body->codeStatus = method_body_info::JITTED;
+	//In tiered mode the interpreter may still be running the preloaded code
+	if(!sys->useTieredJit)
+		body->codeStatus = method_body_info::JITTED;
 	return f;
 }
 
@@ -26,6 +26,7 @@
 #include "scripting/toplevel/RegExp.h"
 #include "scripting/toplevel/Vector.h"
 #include "parsing/streams.h"
+#include "backends/diskcache.h"
 #include <string>
 #include <sstream>
 
@@ -2239,6 +2240,181 @@ void removetypestack(std::vector<typestackentry>& typestack,int n)
 	}
 	
 }
+// the results of the first pass of preloadFunction are kept in the disk cache, so the same content doesn't analyze its methods again on every start
+// version of the cached first pass results, has to be incremented whenever the first pass changes
+#define PRELOAD_CACHE_VERSION 1
+// shorter method bodies are analyzed faster than their cache entry is read
+#define PRELOAD_CACHE_MIN_CODE_LENGTH 2048
+// Class_base pointers are only valid in one run, so the cache stores how the first pass found a type
+enum PRELOAD_CACHE_TYPE { PRELOAD_TYPE_NONE=0, PRELOAD_TYPE_STRING, PRELOAD_TYPE_INTEGER, PRELOAD_TYPE_UINTEGER, PRELOAD_TYPE_NUMBER, PRELOAD_TYPE_BOOLEAN, PRELOAD_TYPE_NAMESPACE, PRELOAD_TYPE_COERCE };
+static DiskCache& getPreloadCache()
+{
+	static DiskCache cache("abc",PRELOAD_CACHE_VERSION);
+	return cache;
+}
+static std::string getPreloadCacheKey(method_info* mi)
+{
+	// the first pass also depends on the exception targets and the number of required arguments
+	std::string data = mi->body->code;
+	uint32_t requiredargs = mi->numArgs()-mi->numOptions();
+	data.append((const char*)&requiredargs,sizeof(requiredargs));
+	for (auto it = mi->body->exceptions.begin(); it != mi->body->exceptions.end(); it++)
+		data.append((const char*)&it->target,sizeof(it->target));
+	return DiskCache::getKey((const uint8_t*)data.data(),data.size(),mi->body->exceptions.size());
+}
+static bool writePreloadType(DiskCacheWriter& w, SystemState* sys, method_info* mi, Class_base* c, const std::map<Class_base*,uint32_t>& coercetypes)
+{
+	if (c == nullptr)
+		w.writeUInt(PRELOAD_TYPE_NONE);
+	else if (c == Class<ASString>::getRef(sys).getPtr())
+		w.writeUInt(PRELOAD_TYPE_STRING);
+	else if (c == Class<Integer>::getRef(sys).getPtr())
+		w.writeUInt(PRELOAD_TYPE_INTEGER);
+	else if (c == Class<UInteger>::getRef(sys).getPtr())
+		w.writeUInt(PRELOAD_TYPE_UINTEGER);
+	else if (c == Class<Number>::getRef(sys).getPtr())
+		w.writeUInt(PRELOAD_TYPE_NUMBER);
+	else if (c == Class<Boolean>::getRef(sys).getPtr())
+		w.writeUInt(PRELOAD_TYPE_BOOLEAN);
+	else if (c == Class<Namespace>::getRef(sys).getPtr())
+		w.writeUInt(PRELOAD_TYPE_NAMESPACE);
+	else
+	{
+		auto it = coercetypes.find(c);
+		if (it == coercetypes.end())
+			return false;
+		// the name makes sure that the multiname at this index is the same in the ABC loading the entry
+		w.writeUInt(PRELOAD_TYPE_COERCE);
+		w.writeUInt(it->second);
+		w.writeString(mi->context->getMultinameImpl(asAtomHandler::nullAtom,nullptr,it->second,false)->qualifiedString(sys));
+	}
+	return true;
+}
+static Class_base* readPreloadType(DiskCacheReader& r, SystemState* sys, method_info* mi, bool& valid)
+{
+	switch (r.readUInt())
+	{
+		case PRELOAD_TYPE_NONE:
+			return nullptr;
+		case PRELOAD_TYPE_STRING:
+			return Class<ASString>::getRef(sys).getPtr();
+		case PRELOAD_TYPE_INTEGER:
+			return Class<Integer>::getRef(sys).getPtr();
+		case PRELOAD_TYPE_UINTEGER:
+			return Class<UInteger>::getRef(sys).getPtr();
+		case PRELOAD_TYPE_NUMBER:
+			return Class<Number>::getRef(sys).getPtr();
+		case PRELOAD_TYPE_BOOLEAN:
+			return Class<Boolean>::getRef(sys).getPtr();
+		case PRELOAD_TYPE_NAMESPACE:
+			return Class<Namespace>::getRef(sys).getPtr();
+		case PRELOAD_TYPE_COERCE:
+		{
+			uint32_t t = r.readUInt();
+			tiny_string name = r.readString();
+			if (r.hasFailed() || t >= mi->context->constant_pool.multinames.size())
+				break;
+			multiname* m = mi->context->getMultinameImpl(asAtomHandler::nullAtom,nullptr,t,false);
+			if (!m->isStatic || m->qualifiedString(sys) != name)
+				break;
+			// resolved like the coerce case of the first pass
+			return (Class_base*)dynamic_cast<const Class_base*>(Type::getTypeFromMultiname(m, mi->context));
+		}
+		default:
+			break;
+	}
+	valid = false;
+	return nullptr;
+}
+static bool loadPreloadCache(const std::string& key, SystemState* sys, method_info* mi, preloadstate& state, std::set<uint32_t>& skippablekills, uint32_t& simple_getter_opcode_pos, uint32_t& simple_setter_opcode_pos)
+{
+	std::vector<uint8_t> entry;
+	if (!getPreloadCache().load(key,entry))
+		return false;
+	DiskCacheReader r(entry);
+	bool valid = true;
+	std::map<int32_t,int32_t> jumptargets;
+	uint32_t count = r.readUInt();
+	for (uint32_t i = 0; i < count && !r.hasFailed(); i++)
+	{
+		int32_t p = r.readUInt();
+		jumptargets[p] = r.readUInt();
+	}
+	std::map<int32_t,Class_base*> jumptargeteresulttypes;
+	count = r.readUInt();
+	for (uint32_t i = 0; i < count && !r.hasFailed() && valid; i++)
+	{
+		int32_t p = r.readUInt();
+		Class_base* c = readPreloadType(r,sys,mi,valid);
+		if (c)
+			jumptargeteresulttypes[p] = c;
+	}
+	std::set<int32_t> unchangedlocals;
+	count = r.readUInt();
+	for (uint32_t i = 0; i < count && !r.hasFailed(); i++)
+		unchangedlocals.insert(r.readUInt());
+	std::set<uint32_t> kills;
+	count = r.readUInt();
+	for (uint32_t i = 0; i < count && !r.hasFailed(); i++)
+		kills.insert(r.readUInt());
+	// the types stored into the locals are set again like the first pass does, the default types of the arguments may differ between runs.
+	// the result doesn't depend on the order of the calls
+	std::set<std::pair<uint32_t,Class_base*>> localtypecalls;
+	count = r.readUInt();
+	for (uint32_t i = 0; i < count && !r.hasFailed() && valid; i++)
+	{
+		uint32_t t = r.readUInt();
+		localtypecalls.insert(make_pair(t,readPreloadType(r,sys,mi,valid)));
+	}
+	uint32_t getterpos = r.readUInt();
+	uint32_t setterpos = r.readUInt();
+	if (!valid || !r.isValid())
+		return false;
+	state.jumptargets.swap(jumptargets);
+	state.jumptargeteresulttypes.swap(jumptargeteresulttypes);
+	state.unchangedlocals.swap(unchangedlocals);
+	skippablekills.swap(kills);
+	for (auto it = localtypecalls.begin(); it != localtypecalls.end(); it++)
+		setdefaultlocaltype(state,it->first,it->second);
+	simple_getter_opcode_pos = getterpos;
+	simple_setter_opcode_pos = setterpos;
+	return true;
+}
+static void storePreloadCache(const std::string& key, SystemState* sys, method_info* mi, preloadstate& state, const std::set<uint32_t>& skippablekills, uint32_t simple_getter_opcode_pos, uint32_t simple_setter_opcode_pos,
+							  const std::set<std::pair<uint32_t,Class_base*>>& localtypecalls, const std::map<Class_base*,uint32_t>& coercetypes)
+{
+	DiskCacheWriter w;
+	w.writeUInt(state.jumptargets.size());
+	for (auto it = state.jumptargets.begin(); it != state.jumptargets.end(); it++)
+	{
+		w.writeUInt(it->first);
+		w.writeUInt(it->second);
+	}
+	w.writeUInt(state.jumptargeteresulttypes.size());
+	for (auto it = state.jumptargeteresulttypes.begin(); it != state.jumptargeteresulttypes.end(); it++)
+	{
+		w.writeUInt(it->first);
+		if (!writePreloadType(w,sys,mi,it->second,coercetypes))
+			return;
+	}
+	w.writeUInt(state.unchangedlocals.size());
+	for (auto it = state.unchangedlocals.begin(); it != state.unchangedlocals.end(); it++)
+		w.writeUInt(*it);
+	w.writeUInt(skippablekills.size());
+	for (auto it = skippablekills.begin(); it != skippablekills.end(); it++)
+		w.writeUInt(*it);
+	w.writeUInt(localtypecalls.size());
+	for (auto it = localtypecalls.begin(); it != localtypecalls.end(); it++)
+	{
+		w.writeUInt(it->first);
+		if (!writePreloadType(w,sys,mi,it->second,coercetypes))
+			return;
+	}
+	w.writeUInt(simple_getter_opcode_pos);
+	w.writeUInt(simple_setter_opcode_pos);
+	getPreloadCache().store(key,w.getData());
+}
+
 void ABCVm::preloadFunction(SyntheticFunction* function)
 {
 	method_info* mi=function->mi;
@@ -2307,8 +2483,19 @@ void ABCVm::preloadFunction(SyntheticFunction* function)
 				0x47, //returnvoid
 				0x00
 			};
+	// the first pass is skipped if its results are in the disk cache
+	std::string cachekey;
+	bool cached=false;
+	if (DiskCache::enabled && code_len >= PRELOAD_CACHE_MIN_CODE_LENGTH)
+	{
+		cachekey = getPreloadCacheKey(mi);
+		cached = loadPreloadCache(cachekey,function->getSystemState(),mi,state,skippablekills,simple_getter_opcode_pos,simple_setter_opcode_pos);
+	}
+	// types stored into the locals and classes found by coerce, to write the results to the disk cache
+	std::set<std::pair<uint32_t,Class_base*>> localtypecalls;
+	std::map<Class_base*,uint32_t> coercetypes;
 	Class_base* currenttype=nullptr;
-	memorystream codejumps(mi->body->code.data(), code_len);
+	memorystream codejumps(mi->body->code.data(), cached ? 0 : code_len);
 	uint8_t opcode=0;
 	while(!codejumps.atend())
 	{
@@ -2386,6 +2573,8 @@ void ABCVm::preloadFunction(SyntheticFunction* function)
 					const Type* tp = Type::getTypeFromMultiname(name, mi->context);
 					const Class_base* cls =dynamic_cast<const Class_base*>(tp);
 					currenttype = (Class_base*)cls;
+					if (cls)
+						coercetypes[currenttype]=t;
 				}
 				else
 					currenttype=nullptr;
@@ -2438,6 +2627,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function)
 				uint32_t t = codejumps.readu30();
 				state.unchangedlocals.erase(t);
 				setdefaultlocaltype(state,t,currenttype);
+				localtypecalls.insert(make_pair(t,currenttype));
 				currenttype=nullptr;
 				break;
 			}
@@ -2447,6 +2637,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function)
 			case 0xd7://setlocal_3
 				state.unchangedlocals.erase(opcode-0xd4);
 				setdefaultlocaltype(state,opcode-0xd4,currenttype);
+				localtypecalls.insert(make_pair(opcode-0xd4,currenttype));
 				currenttype=nullptr;
 				break;
 			case 0x92://inclocal
@@ -2455,6 +2646,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function)
 				uint32_t t = codejumps.readu30();
 				state.unchangedlocals.erase(t);
 				setdefaultlocaltype(state,t,Class<Number>::getRef(function->getSystemState()).getPtr());
+				localtypecalls.insert(make_pair(t,Class<Number>::getRef(function->getSystemState()).getPtr()));
 				currenttype=nullptr;
 				break;
 			}
@@ -2468,6 +2660,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function)
 				uint32_t t = codejumps.readu30();
 				state.unchangedlocals.erase(t);
 				setdefaultlocaltype(state,t,Class<Integer>::getRef(function->getSystemState()).getPtr());
+				localtypecalls.insert(make_pair(t,Class<Integer>::getRef(function->getSystemState()).getPtr()));
 				currenttype=nullptr;
 				break;
 			}
@@ -2696,6 +2889,8 @@ void ABCVm::preloadFunction(SyntheticFunction* function)
 		}
 		it++;
 	}
+	if (!cached && !cachekey.empty())
+		storePreloadCache(cachekey,function->getSystemState(),mi,state,skippablekills,simple_getter_opcode_pos,simple_setter_opcode_pos,localtypecalls,coercetypes);
 	// second pass: use optimized opcode version if it doesn't interfere with a jump target
 	
 	std::vector<typestackentry> typestack; // contains the type or the global object of the arguments currently on the stack
@@ -1078,10 +1078,31 @@ FORCE_INLINE void callprop_intern(call_context* context,asAtom& ret,asAtom& obj,
 		}
 		else
 		{
-			if (cacheptr->cacheobj3 && cacheptr->cacheobj3->is<Function>() && cacheptr->cacheobj3->as<IFunction>()->isCloned)
-				cacheptr->cacheobj3->decRef();
-			cacheptr->data |= ABC_OP_NOTCACHEABLE;
-			cacheptr->data &= ~ABC_OP_CACHED;
+			// a second receiver class was seen, switch to a polymorphic cache
+			Class_base* cachedtype = (Class_base*)cacheptr->cacheobj1;
+			ASObject* cachedfunc = cacheptr->cacheobj3;
+			cacheptr->polycache = context->mi->context->newPolymorphicCache(INLINE_CACHE_CALL);
+			cacheptr->cacheobj3 = nullptr;
+			if (cachedfunc && cachedfunc->is<Function>() && cachedfunc->as<IFunction>()->isCloned)
+				cachedfunc->decRef();
+			else
+				context->mi->context->addInlineCache(cacheptr->polycache,cachedtype,name)->target = cachedfunc;
+			cacheptr->data |= ABC_OP_POLYMORPHIC;
+			// the skipped coercion was only checked against the parameter types of the first target
+			cacheptr->data &= ~(ABC_OP_CACHED|ABC_OP_COERCED);
+			coercearguments = true;
+		}
+	}
+	else if ((cacheptr->data&ABC_OP_POLYMORPHIC) && asAtomHandler::isObject(obj))
+	{
+		inline_cache_entry* e = context->mi->context->findInlineCache(cacheptr->polycache,asAtomHandler::getClass(obj,context->mi->context->root->getSystemState()),name);
+		if (e)
+		{
+			asAtom o = asAtomHandler::fromObjectNoPrimitive(e->target);
+			LOG_CALL( "callProperty from polymorphic cache:"<<*name<<" "<<asAtomHandler::toDebugString(obj)<<" "<<asAtomHandler::toDebugString(o)<<" "<<coercearguments);
+			asAtomHandler::callFunction(o,ret,obj,args,argsnum,refcounted,needreturn && coercearguments,coercearguments);
+			LOG_CALL("End of calling cached property "<<*name<<" "<<asAtomHandler::toDebugString(ret));
+			return;
 		}
 	}
 	if(asAtomHandler::is<Null>(obj))
@@ -1135,25 +1156,34 @@ FORCE_INLINE void callprop_intern(call_context* context,asAtom& ret,asAtom& obj,
 					&& asAtomHandler::getObject(o)
 					&& ((asAtomHandler::is<Class_base>(obj) && asAtomHandler::as<IFunction>(o)->inClass == asAtomHandler::as<Class_base>(obj)) || (asAtomHandler::as<IFunction>(o)->inClass && asAtomHandler::getClass(obj,context->mi->context->root->getSystemState())->isSubClass(asAtomHandler::as<IFunction>(o)->inClass))))
 			{
-				// cache method if multiname is static and it is a method of a sealed class
-				cacheptr->data |= ABC_OP_CACHED;
-				if (argsnum==2 && asAtomHandler::is<SyntheticFunction>(o) && cacheptr->cacheobj1 && cacheptr->cacheobj3) // special case 2 parameters with known parameter types: check if coercion can be skipped
+				if (cacheptr->data & ABC_OP_POLYMORPHIC)
+				{
+					// cloned methods are not owned by the class, so they can't be shared between receivers
+					if (!asAtomHandler::as<IFunction>(o)->isCloned)
+						context->mi->context->addInlineCache(cacheptr->polycache,asAtomHandler::getClass(obj,context->mi->context->root->getSystemState()),name)->target = asAtomHandler::getObject(o);
+				}
+				else
 				{
-					SyntheticFunction* f = asAtomHandler::as<SyntheticFunction>(o);
-					if (!f->getMethodInfo()->returnType)
-						f->checkParamTypes();
-					if (f->getMethodInfo()->paramTypes.size()==2 &&
-						f->canSkipCoercion(0,(Class_base*)cacheptr->cacheobj1) &&
-						f->canSkipCoercion(1,(Class_base*)cacheptr->cacheobj3))
+					// cache method if multiname is static and it is a method of a sealed class
+					cacheptr->data |= ABC_OP_CACHED;
+					if (argsnum==2 && asAtomHandler::is<SyntheticFunction>(o) && cacheptr->cacheobj1 && cacheptr->cacheobj3) // special case 2 parameters with known parameter types: check if coercion can be skipped
 					{
-						cacheptr->data |= ABC_OP_COERCED;
+						SyntheticFunction* f = asAtomHandler::as<SyntheticFunction>(o);
+						if (!f->getMethodInfo()->returnType)
+							f->checkParamTypes();
+						if (f->getMethodInfo()->paramTypes.size()==2 &&
+							f->canSkipCoercion(0,(Class_base*)cacheptr->cacheobj1) &&
+							f->canSkipCoercion(1,(Class_base*)cacheptr->cacheobj3))
+						{
+							cacheptr->data |= ABC_OP_COERCED;
+						}
 					}
+					cacheptr->cacheobj1 = asAtomHandler::getClass(obj,context->mi->context->root->getSystemState());
+					cacheptr->cacheobj3 = asAtomHandler::getObject(o);
+					LOG_CALL("caching callproperty:"<<*name<<" "<<cacheptr->cacheobj1->toDebugString()<<" "<<cacheptr->cacheobj3->toDebugString());
 				}
-				cacheptr->cacheobj1 = asAtomHandler::getClass(obj,context->mi->context->root->getSystemState());
-				cacheptr->cacheobj3 = asAtomHandler::getObject(o);
-				LOG_CALL("caching callproperty:"<<*name<<" "<<cacheptr->cacheobj1->toDebugString()<<" "<<cacheptr->cacheobj3->toDebugString());
 			}
-			else
+			else if (!(cacheptr->data & ABC_OP_POLYMORPHIC))
 			{
 				cacheptr->data |= ABC_OP_NOTCACHEABLE;
 				cacheptr->data &= ~ABC_OP_CACHED;
@@ -1988,6 +2018,91 @@ void ABCVm::abc_getlex_localresult(call_context* context)
 	}
 	++(context->exec_pos);
 }
+// inline caches for getproperty/setproperty with static names
+// they are only used for instances of actionscript classes that don't override the property lookup
+FORCE_INLINE bool canCacheProperty(ASObject* obj, multiname* name, bool forset)
+{
+	return name->isStatic
+			&& name->name_type == multiname::NAME_STRING
+			&& name->ns.size() == 1
+			&& !name->hasBuiltinNS
+			&& (!name->hasEmptyNS || name->ns.front().hasEmptyName())
+			&& obj->getObjectType() == T_OBJECT
+			&& obj->getClass()
+			&& obj->getClass()->is<Class_inherit>()
+			&& !obj->is<Proxy>()
+			&& !obj->is<ByteArray>()
+			&& !obj->is<Dictionary>()
+			&& (!forset || !obj->is<DisplayObject>());
+}
+// returns the cached variable of obj, if it is still the one that name resolves to
+FORCE_INLINE variable* getCachedProperty(call_context* context, preloadedcodedata* cacheptr, ASObject* obj, multiname* name, uint32_t traitKinds)
+{
+	if ((cacheptr->data&ABC_OP_POLYMORPHIC) == 0)
+		return nullptr;
+	inline_cache_entry* e = context->mi->context->findInlineCache(cacheptr->polycache,obj->getClass(),name);
+	// the name may have been replaced by the name of a simple getter/setter
+	if (!e || e->index == property_map::NPOS || e->name != name)
+		return nullptr;
+	variable* v = obj->getCachedVariable(e->index,*name);
+	if (!v
+			|| !(v->kind & traitKinds)
+			|| asAtomHandler::isValid(v->getter)
+			|| asAtomHandler::isValid(v->setter)
+			|| asAtomHandler::isInvalid(v->var))
+		return nullptr;
+	return v;
+}
+// stores the index of the variable name resolves to in the cache, to be called after the property was accessed through the normal lookup
+FORCE_INLINE void cacheProperty(call_context* context, preloadedcodedata* cacheptr, ASObject* obj, multiname* name, uint32_t traitKinds, bool forset)
+{
+	if (cacheptr->data & ABC_OP_NOTCACHEABLE)
+		return;
+	if (!canCacheProperty(obj,name,forset))
+		return;
+	ABCContext* abccontext = context->mi->context;
+	if (cacheptr->data & ABC_OP_POLYMORPHIC)
+	{
+		// the property is not an own variable of this class, don't look it up again
+		inline_cache_entry* e = abccontext->findInlineCache(cacheptr->polycache,obj->getClass(),name);
+		if (e && e->index == property_map::NPOS && e->name == name)
+			return;
+	}
+	else
+	{
+		cacheptr->polycache = abccontext->newPolymorphicCache(forset ? INLINE_CACHE_SETPROPERTY : INLINE_CACHE_PROPERTY);
+		cacheptr->data |= ABC_OP_POLYMORPHIC;
+	}
+	abccontext->addInlineCache(cacheptr->polycache,obj->getClass(),name)->index = obj->findVariableIndex(*name,traitKinds);
+}
+FORCE_INLINE uint32_t getPropertyTraitKinds(multiname* name)
+{
+	// see ASObject::getVariableByMultinameIntern
+	return name->hasEmptyNS ? DECLARED_TRAIT|DYNAMIC_TRAIT : DECLARED_TRAIT;
+}
+// setproperty/initproperty with a static name, the name and the cache are stored in the instruction following the opcode
+FORCE_INLINE multiname* setprop_intern(call_context* context, ASObject* o, multiname* name, asAtom& value)
+{
+	preloadedcodedata* cacheptr = context->exec_pos;
+	if (!asAtomHandler::is<SyntheticFunction>(value))
+	{
+		variable* v = getCachedProperty(context,cacheptr,o,name,DECLARED_TRAIT|DYNAMIC_TRAIT);
+		// constants may only be written by initproperty, setproperty has to throw
+		if (v && (v->kind != CONSTANT_TRAIT || cacheptr->local_pos3 == 0x68))
+		{
+			LOG_CALL("setProperty from cache " << *name);
+			v->setVar(value,o);
+			return nullptr;
+		}
+	}
+	multiname* simplesettername = nullptr;
+	if (cacheptr->local_pos3 == 0x68)//initproperty
+		simplesettername =o->setVariableByMultiname(*name,value,ASObject::CONST_ALLOWED);
+	else//Do not allow to set contant traits
+		simplesettername =o->setVariableByMultiname(*name,value,ASObject::CONST_NOT_ALLOWED);
+	cacheProperty(context,cacheptr,o,name,DECLARED_TRAIT|DYNAMIC_TRAIT,true);
+	return simplesettername;
+}
 void ABCVm::abc_setPropertyStaticName(call_context* context)
 {
 	(++(context->exec_pos));
@@ -2009,11 +2124,7 @@ void ABCVm::abc_setPropertyStaticName(call_context* context)
 	}
 
 	ASObject* o = asAtomHandler::toObject(*obj,context->mi->context->root->getSystemState());
-	multiname* simplesettername = nullptr;
-	if (context->exec_pos->local_pos3 == 0x68)//initproperty
-		simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_ALLOWED);
-	else//Do not allow to set contant traits
-		simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_NOT_ALLOWED);
+	multiname* simplesettername = setprop_intern(context,o,name,*value);
 	if (simplesettername)
 		context->exec_pos->cachedmultiname2 = simplesettername;
 	++(context->exec_pos);
@@ -2040,11 +2151,7 @@ void ABCVm::abc_setPropertyStaticName_constant_constant(call_context* context)
 	}
 
 	ASObject* o = asAtomHandler::toObject(*obj,context->mi->context->root->getSystemState());
-	multiname* simplesettername = nullptr;
-	if (context->exec_pos->local_pos3 == 0x68)//initproperty
-		simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_ALLOWED);
-	else//Do not allow to set contant traits
-		simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_NOT_ALLOWED);
+	multiname* simplesettername = setprop_intern(context,o,name,*value);
 	if (simplesettername)
 		context->exec_pos->cachedmultiname2 = simplesettername;
 	++(context->exec_pos);
@@ -2070,11 +2177,7 @@ void ABCVm::abc_setPropertyStaticName_local_constant(call_context* context)
 		throwError<TypeError>(kConvertUndefinedToObjectError);
 	}
 	ASObject* o = asAtomHandler::toObject(*obj,context->mi->context->root->getSystemState());
-	multiname* simplesettername = nullptr;
-	if (context->exec_pos->local_pos3 == 0x68)//initproperty
-		simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_ALLOWED);
-	else//Do not allow to set contant traits
-		simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_NOT_ALLOWED);
+	multiname* simplesettername = setprop_intern(context,o,name,*value);
 	if (simplesettername)
 		context->exec_pos->cachedmultiname2 = simplesettername;
 	++(context->exec_pos);
@@ -2101,11 +2204,7 @@ void ABCVm::abc_setPropertyStaticName_constant_local(call_context* context)
 	}
 	ASObject* o = asAtomHandler::toObject(*obj,context->mi->context->root->getSystemState());
 	ASATOM_INCREF_POINTER(value);
-	multiname* simplesettername = nullptr;
-	if (context->exec_pos->local_pos3 == 0x68)//initproperty
-		simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_ALLOWED);
-	else//Do not allow to set contant traits
-		simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_NOT_ALLOWED);
+	multiname* simplesettername = setprop_intern(context,o,name,*value);
 	if (simplesettername)
 		context->exec_pos->cachedmultiname2 = simplesettername;
 	++(context->exec_pos);
@@ -2132,11 +2231,7 @@ void ABCVm::abc_setPropertyStaticName_local_local(call_context* context)
 	}
 	ASObject* o = asAtomHandler::toObject(*obj,context->mi->context->root->getSystemState());
 	ASATOM_INCREF_POINTER(value);
-	multiname* simplesettername = nullptr;
-	if (context->exec_pos->local_pos3 == 0x68)//initproperty
-		simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_ALLOWED);
-	else//Do not allow to set contant traits
-		simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_NOT_ALLOWED);
+	multiname* simplesettername = setprop_intern(context,o,name,*value);
 	if (simplesettername)
 		context->exec_pos->cachedmultiname2 = simplesettername;
 	++(context->exec_pos);
@@ -2753,6 +2848,7 @@ void ABCVm::abc_getProperty_local_constant_localresult(call_context* context)
 	preloadedcodedata* instrptr = context->exec_pos;
 	uint32_t t = (++(context->exec_pos))->data;
 	asAtom prop=asAtomHandler::invalidAtom;
+	bool ownsprop=false;
 	if (asAtomHandler::isInteger(*instrptr->arg2_constant)
 			&& asAtomHandler::is<Array>(CONTEXT_GETLOCAL(context,instrptr->local_pos1))
 			&& asAtomHandler::getInt(*instrptr->arg2_constant) > 0
@@ -2766,14 +2862,15 @@ void ABCVm::abc_getProperty_local_constant_localresult(call_context* context)
 		multiname* name=context->mi->context->getMultinameImpl(*instrptr->arg2_constant,NULL,t,false);
 		ASObject* obj= asAtomHandler::toObject(CONTEXT_GETLOCAL(context,instrptr->local_pos1),context->mi->context->root->getSystemState());
 		LOG_CALL( _("getProperty_lcl ") << *name << ' ' << obj->toDebugString() << ' '<<obj->isInitialized());
-		obj->getVariableByMultiname(prop,*name,GET_VARIABLE_OPTION::NO_INCREF);
+		ownsprop = obj->getVariableByMultiname(prop,*name,GET_VARIABLE_OPTION::NO_INCREF) & GET_VARIABLE_RESULT::GETVAR_ISNEWOBJECT;
 		if(asAtomHandler::isInvalid(prop))
 			checkPropertyException(obj,name,prop);
 		name->resetNameIfObject();
 	}
 	ASObject* o = asAtomHandler::getObject(CONTEXT_GETLOCAL(context,instrptr->local_pos3-1));
 	asAtomHandler::set(CONTEXT_GETLOCAL(context,instrptr->local_pos3-1),prop);
-	ASATOM_INCREF(CONTEXT_GETLOCAL(context,instrptr->local_pos3-1));
+	if (!ownsprop)
+		ASATOM_INCREF(CONTEXT_GETLOCAL(context,instrptr->local_pos3-1));
 	if (o)
 		o->decRef();
 	++(context->exec_pos);
@@ -2786,13 +2883,14 @@ void ABCVm::abc_getProperty_constant_local_localresult(call_context* context)
 	ASObject* obj= asAtomHandler::toObject(*instrptr->arg1_constant,context->mi->context->root->getSystemState(),true);
 	LOG_CALL( _("getProperty_cll ") << *name << ' ' << obj->toDebugString() << ' '<<obj->isInitialized());
 	asAtom prop=asAtomHandler::invalidAtom;
-	obj->getVariableByMultiname(prop,*name,GET_VARIABLE_OPTION::NO_INCREF);
+	bool ownsprop = obj->getVariableByMultiname(prop,*name,GET_VARIABLE_OPTION::NO_INCREF) & GET_VARIABLE_RESULT::GETVAR_ISNEWOBJECT;
 	if(asAtomHandler::isInvalid(prop))
 		checkPropertyException(obj,name,prop);
 	name->resetNameIfObject();
 	ASObject* o = asAtomHandler::getObject(CONTEXT_GETLOCAL(context,instrptr->local_pos3-1));
 	asAtomHandler::set(CONTEXT_GETLOCAL(context,instrptr->local_pos3-1),prop);
-	ASATOM_INCREF(CONTEXT_GETLOCAL(context,instrptr->local_pos3-1));
+	if (!ownsprop)
+		ASATOM_INCREF(CONTEXT_GETLOCAL(context,instrptr->local_pos3-1));
 	if (o)
 		o->decRef();
 	++(context->exec_pos);
@@ -2802,6 +2900,7 @@ void ABCVm::abc_getProperty_local_local_localresult(call_context* context)
 	preloadedcodedata* instrptr = context->exec_pos;
 	uint32_t t = (++(context->exec_pos))->data;
 	asAtom prop=asAtomHandler::invalidAtom;
+	bool ownsprop=false;
 	if (asAtomHandler::isInteger(CONTEXT_GETLOCAL(context,instrptr->local_pos2))
 			&& asAtomHandler::is<Array>(CONTEXT_GETLOCAL(context,instrptr->local_pos1))
 			&& asAtomHandler::getInt(CONTEXT_GETLOCAL(context,instrptr->local_pos2)) > 0
@@ -2815,14 +2914,15 @@ void ABCVm::abc_getProperty_local_local_localresult(call_context* context)
 		multiname* name=context->mi->context->getMultinameImpl(CONTEXT_GETLOCAL(context,instrptr->local_pos2),NULL,t,false);
 		ASObject* obj= asAtomHandler::toObject(CONTEXT_GETLOCAL(context,instrptr->local_pos1),context->mi->context->root->getSystemState());
 		LOG_CALL( _("getProperty_lll ") << *name << ' ' << obj->toDebugString() << ' '<<obj->isInitialized());
-		obj->getVariableByMultiname(prop,*name,GET_VARIABLE_OPTION::NO_INCREF);
+		ownsprop = obj->getVariableByMultiname(prop,*name,GET_VARIABLE_OPTION::NO_INCREF) & GET_VARIABLE_RESULT::GETVAR_ISNEWOBJECT;
 		if(asAtomHandler::isInvalid(prop))
 			checkPropertyException(obj,name,prop);
 		name->resetNameIfObject();
 	}
 	ASObject* o = asAtomHandler::getObject(CONTEXT_GETLOCAL(context,instrptr->local_pos3-1));
 	asAtomHandler::set(CONTEXT_GETLOCAL(context,instrptr->local_pos3-1),prop);
-	ASATOM_INCREF(CONTEXT_GETLOCAL(context,instrptr->local_pos3-1));
+	if (!ownsprop)
+		ASATOM_INCREF(CONTEXT_GETLOCAL(context,instrptr->local_pos3-1));
 	if (o)
 		o->decRef();
 	++(context->exec_pos);
@@ -2930,12 +3030,13 @@ void ABCVm::abc_getPropertyInteger_local_constant_localresult(call_context* cont
 		obj= asAtomHandler::toObject(CONTEXT_GETLOCAL(context,instrptr->local_pos1),context->mi->context->root->getSystemState());
 	LOG_CALL( _("getPropertyInteger_lcl ") << index << ' ' << obj->toDebugString() << ' '<<obj->isInitialized());
 	asAtom prop=asAtomHandler::invalidAtom;
-	obj->getVariableByInteger(prop,index,GET_VARIABLE_OPTION::NO_INCREF);
+	bool ownsprop = obj->getVariableByInteger(prop,index,GET_VARIABLE_OPTION::NO_INCREF) & GET_VARIABLE_RESULT::GETVAR_ISNEWOBJECT;
 	if(asAtomHandler::isInvalid(prop))
 		checkPropertyExceptionInteger(obj,index,prop);
 	ASObject* o = asAtomHandler::getObject(CONTEXT_GETLOCAL(context,instrptr->local_pos3-1));
 	asAtomHandler::set(CONTEXT_GETLOCAL(context,instrptr->local_pos3-1),prop);
-	ASATOM_INCREF(CONTEXT_GETLOCAL(context,instrptr->local_pos3-1));
+	if (!ownsprop)
+		ASATOM_INCREF(CONTEXT_GETLOCAL(context,instrptr->local_pos3-1));
 	if (o)
 		o->decRef();
 	++(context->exec_pos);
@@ -2949,12 +3050,13 @@ void ABCVm::abc_getPropertyInteger_constant_local_localresult(call_context* cont
 		obj= asAtomHandler::toObject(*instrptr->arg1_constant,context->mi->context->root->getSystemState(),true);
 	LOG_CALL( _("getPropertyInteger_cll ") << index << ' ' << obj->toDebugString() << ' '<<obj->isInitialized());
 	asAtom prop=asAtomHandler::invalidAtom;
-	obj->getVariableByInteger(prop,index,GET_VARIABLE_OPTION::NO_INCREF);
+	bool ownsprop = obj->getVariableByInteger(prop,index,GET_VARIABLE_OPTION::NO_INCREF) & GET_VARIABLE_RESULT::GETVAR_ISNEWOBJECT;
 	if(asAtomHandler::isInvalid(prop))
 		checkPropertyExceptionInteger(obj,index,prop);
 	ASObject* o = asAtomHandler::getObject(CONTEXT_GETLOCAL(context,instrptr->local_pos3-1));
 	asAtomHandler::set(CONTEXT_GETLOCAL(context,instrptr->local_pos3-1),prop);
-	ASATOM_INCREF(CONTEXT_GETLOCAL(context,instrptr->local_pos3-1));
+	if (!ownsprop)
+		ASATOM_INCREF(CONTEXT_GETLOCAL(context,instrptr->local_pos3-1));
 	if (o)
 		o->decRef();
 	++(context->exec_pos);
@@ -2968,12 +3070,13 @@ void ABCVm::abc_getPropertyInteger_local_local_localresult(call_context* context
 		obj= asAtomHandler::toObject(CONTEXT_GETLOCAL(context,instrptr->local_pos1),context->mi->context->root->getSystemState());
 	LOG_CALL( _("getPropertyInteger_lll ") << index << ' ' << obj->toDebugString() << ' '<<obj->isInitialized());
 	asAtom prop=asAtomHandler::invalidAtom;
-	obj->getVariableByInteger(prop,index,GET_VARIABLE_OPTION::NO_INCREF);
+	bool ownsprop = obj->getVariableByInteger(prop,index,GET_VARIABLE_OPTION::NO_INCREF) & GET_VARIABLE_RESULT::GETVAR_ISNEWOBJECT;
 	if(asAtomHandler::isInvalid(prop))
 		checkPropertyExceptionInteger(obj,index,prop);
 	ASObject* o = asAtomHandler::getObject(CONTEXT_GETLOCAL(context,instrptr->local_pos3-1));
 	asAtomHandler::set(CONTEXT_GETLOCAL(context,instrptr->local_pos3-1),prop);
-	ASATOM_INCREF(CONTEXT_GETLOCAL(context,instrptr->local_pos3-1));
+	if (!ownsprop)
+		ASATOM_INCREF(CONTEXT_GETLOCAL(context,instrptr->local_pos3-1));
 	if (o)
 		o->decRef();
 	++(context->exec_pos);
@@ -3031,9 +3134,16 @@ void ABCVm::abc_getPropertyStaticName_local(call_context* context)
 	{
 		ASObject* obj= asAtomHandler::toObject(CONTEXT_GETLOCAL(context,instrptr->local_pos1),context->mi->context->root->getSystemState());
 		LOG_CALL( _("getProperty_sl ") << *name << ' ' << obj->toDebugString() << ' '<<obj->isInitialized());
-		if(asAtomHandler::isInvalid(prop))
+		variable* v = getCachedProperty(context,context->exec_pos,obj,name,getPropertyTraitKinds(name));
+		if (v)
+		{
+			asAtomHandler::set(prop,v->var);
+			ASATOM_INCREF(prop);
+		}
+		else
 		{
 			bool isgetter = obj->getVariableByMultiname(prop,*name,GET_VARIABLE_OPTION::DONT_CALL_GETTER) & GET_VARIABLE_RESULT::GETVAR_ISGETTER;
+			cacheProperty(context,context->exec_pos,obj,name,getPropertyTraitKinds(name),false);
 			if (isgetter)
 			{
 				//Call the getter
@@ -3068,7 +3178,8 @@ void ABCVm::abc_getPropertyStaticName_constant_localresult(call_context* context
 	asAtom prop=asAtomHandler::invalidAtom;
 	if(asAtomHandler::isInvalid(prop))
 	{
-		bool isgetter = obj->getVariableByMultiname(prop,*name,(GET_VARIABLE_OPTION)(GET_VARIABLE_OPTION::NO_INCREF | GET_VARIABLE_OPTION::DONT_CALL_GETTER)) & GET_VARIABLE_RESULT::GETVAR_ISGETTER;
+		GET_VARIABLE_RESULT res = obj->getVariableByMultiname(prop,*name,(GET_VARIABLE_OPTION)(GET_VARIABLE_OPTION::NO_INCREF | GET_VARIABLE_OPTION::DONT_CALL_GETTER));
+		bool isgetter = res & GET_VARIABLE_RESULT::GETVAR_ISGETTER;
 		if (isgetter)
 		{
 			//Call the getter
@@ -3085,7 +3196,7 @@ void ABCVm::abc_getPropertyStaticName_constant_localresult(call_context* context
 			}
 			LOG_CALL("End of getter"<< ' ' << f->toDebugString()<<" result:"<<asAtomHandler::toDebugString(prop));
 		}
-		else
+		else if (!(res & GET_VARIABLE_RESULT::GETVAR_ISNEWOBJECT))
 			ASATOM_INCREF(prop);
 	}
 	if(asAtomHandler::isInvalid(prop))
@@ -3103,50 +3214,6 @@ void ABCVm::abc_getPropertyStaticName_local_localresult(call_context* context)
 	(++(context->exec_pos));
 	multiname* name=instrptr->cachedmultiname2;
 
-	if ((context->exec_pos->data&ABC_OP_CACHED) == ABC_OP_CACHED)
-	{
-		ASObject* obj= asAtomHandler::toObject(CONTEXT_GETLOCAL(context,instrptr->local_pos1),context->mi->context->root->getSystemState());
-		if (context->exec_pos->cacheobj1 == obj)
-		{
-			asAtom prop=asAtomHandler::invalidAtom;
-			LOG_CALL( _("getProperty_sll_c ") << *name << ' ' << obj->toDebugString());
-
-			variable* v = context->exec_pos->cachedvar2;
-			if (asAtomHandler::isValid(v->getter))
-			{
-				asAtomHandler::set(prop,v->getter);
-				//Call the getter
-				LOG_CALL("Calling the getter for " << *name << " on " << obj->toDebugString());
-				assert(asAtomHandler::isFunction(prop));
-				IFunction* f = asAtomHandler::as<IFunction>(prop);
-				ASObject* closure = asAtomHandler::getClosure(prop);
-				prop = asAtom();
-				f->callGetter(prop,closure ? closure : obj);
-				LOG_CALL("End of getter"<< ' ' << f->toDebugString()<<" result:"<<asAtomHandler::toDebugString(prop));
-			}
-			else
-			{
-				ASATOM_INCREF(prop);
-				asAtomHandler::set(prop,v->var);
-			}
-
-			if(asAtomHandler::isInvalid(prop))
-			{
-				checkPropertyException(obj,name,prop);
-			}
-			if(asAtomHandler::isInvalid(prop))
-				checkPropertyException(obj,name,prop);
-			ASObject* o = asAtomHandler::getObject(CONTEXT_GETLOCAL(context,instrptr->local_pos3-1));
-			asAtomHandler::set(CONTEXT_GETLOCAL(context,instrptr->local_pos3-1),prop);
-			if (o)
-				o->decRef();
-			++(context->exec_pos);
-			return;
-		}
-		else
-			context->exec_pos->data = ABC_OP_NOTCACHEABLE;
-	}
-
 	if (name->name_type == multiname::NAME_INT
 			&& asAtomHandler::is<Array>(CONTEXT_GETLOCAL(context,instrptr->local_pos1))
 			&& name->name_i > 0
@@ -3159,41 +3226,18 @@ void ABCVm::abc_getPropertyStaticName_local_localresult(call_context* context)
 	{
 		ASObject* obj= asAtomHandler::toObject(CONTEXT_GETLOCAL(context,instrptr->local_pos1),context->mi->context->root->getSystemState());
 		asAtom prop=asAtomHandler::invalidAtom;
-// TODO caching doesn't work until we find a way to detect if obj is a reused object
-// that has been destroyed since the last call
-//		if (((context->exec_pos->data&ABC_OP_NOTCACHEABLE) == 0)
-//				&& ((obj->is<Class_base>() && obj->as<Class_base>()->isSealed) ||
-//					(obj->getClass()
-//					 && (obj->getClass()->isSealed
-//						 || (obj->getClass() == Class<Array>::getRef(obj->getSystemState()).getPtr())))))
-//		{
-//			variable* v = obj->findVariableByMultiname(*name,obj->getClass());
-//			if (v)
-//			{
-//				context->exec_pos->data |= ABC_OP_CACHED;
-//				context->exec_pos->cachedvar2=v;
-//				context->exec_pos->cacheobj1=obj;
-//				if (asAtomHandler::isValid(v->getter))
-//				{
-//					asAtomHandler::set(prop,v->getter);
-//					//Call the getter
-//					LOG_CALL("Calling the getter for " << *name << " on " << obj->toDebugString());
-//					assert(asAtomHandler::isFunction(prop));
-//					IFunction* f = asAtomHandler::as<IFunction>(prop);
-//					ASObject* closure = asAtomHandler::getClosure(prop);
-//					f->callGetter(prop,closure ? closure : obj);
-//					LOG_CALL("End of getter"<< ' ' << f->toDebugString()<<" result:"<<asAtomHandler::toDebugString(prop));
-//				}
-//				else
-//				{
-//					asAtomHandler::set(prop,v->var);
-//					ASATOM_INCREF(prop);
-//				}
-//			}
-//		}
-		if(asAtomHandler::isInvalid(prop))
+		variable* v = getCachedProperty(context,context->exec_pos,obj,name,getPropertyTraitKinds(name));
+		if (v)
+		{
+			LOG_CALL("getProperty_sll from cache " << *name << ' ' << obj->toDebugString());
+			asAtomHandler::set(prop,v->var);
+			ASATOM_INCREF(prop);
+		}
+		else
 		{
-			bool isgetter = obj->getVariableByMultiname(prop,*name,(GET_VARIABLE_OPTION)(GET_VARIABLE_OPTION::NO_INCREF| GET_VARIABLE_OPTION::DONT_CALL_GETTER)) & GET_VARIABLE_RESULT::GETVAR_ISGETTER;
+			GET_VARIABLE_RESULT res = obj->getVariableByMultiname(prop,*name,(GET_VARIABLE_OPTION)(GET_VARIABLE_OPTION::NO_INCREF| GET_VARIABLE_OPTION::DONT_CALL_GETTER));
+			bool isgetter = res & GET_VARIABLE_RESULT::GETVAR_ISGETTER;
+			cacheProperty(context,context->exec_pos,obj,name,getPropertyTraitKinds(name),false);
 			if (isgetter)
 			{
 				//Call the getter
@@ -3213,7 +3257,8 @@ void ABCVm::abc_getPropertyStaticName_local_localresult(call_context* context)
 			else
 			{
 				LOG_CALL("getProperty_sll " << *name << ' ' << obj->toDebugString());
-				ASATOM_INCREF(prop);
+				if (!(res & GET_VARIABLE_RESULT::GETVAR_ISNEWOBJECT))
+					ASATOM_INCREF(prop);
 			}
 
 		}
@@ -3235,9 +3280,17 @@ void ABCVm::abc_getPropertyStaticName_localresult(call_context* context)
 	RUNTIME_STACK_POP_CREATE_ASOBJECT(context,obj,context->mi->context->root->getSystemState());
 	LOG_CALL( _("getProperty_sll ") << *name << ' ' << obj->toDebugString() << ' '<<obj->isInitialized());
 	asAtom prop=asAtomHandler::invalidAtom;
-	if(asAtomHandler::isInvalid(prop))
+	variable* v = getCachedProperty(context,context->exec_pos,obj,name,getPropertyTraitKinds(name));
+	if (v)
+	{
+		asAtomHandler::set(prop,v->var);
+		ASATOM_INCREF(prop);
+	}
+	else
 	{
-		bool isgetter = obj->getVariableByMultiname(prop,*name,(GET_VARIABLE_OPTION)(GET_VARIABLE_OPTION::NO_INCREF | GET_VARIABLE_OPTION::DONT_CALL_GETTER)) & GET_VARIABLE_RESULT::GETVAR_ISGETTER;
+		GET_VARIABLE_RESULT res = obj->getVariableByMultiname(prop,*name,(GET_VARIABLE_OPTION)(GET_VARIABLE_OPTION::NO_INCREF | GET_VARIABLE_OPTION::DONT_CALL_GETTER));
+		bool isgetter = res & GET_VARIABLE_RESULT::GETVAR_ISGETTER;
+		cacheProperty(context,context->exec_pos,obj,name,getPropertyTraitKinds(name),false);
 		if (isgetter)
 		{
 			//Call the getter
@@ -3254,7 +3307,7 @@ void ABCVm::abc_getPropertyStaticName_localresult(call_context* context)
 			}
 			LOG_CALL("End of getter"<< ' ' << f->toDebugString()<<" result:"<<asAtomHandler::toDebugString(prop));
 		}
-		else
+		else if (!(res & GET_VARIABLE_RESULT::GETVAR_ISNEWOBJECT))
 			ASATOM_INCREF(prop);
 	}
 	if(asAtomHandler::isInvalid(prop))
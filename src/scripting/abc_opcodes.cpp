@@ -355,10 +355,33 @@ void ABCVm::callPropIntern(call_context *th, int n, int m, bool keepReturn, bool
 		}
 		else
 		{
-			if (instrptr->cacheobj2 && instrptr->cacheobj2->is<Function>() && instrptr->cacheobj2->as<IFunction>()->isCloned)
-				instrptr->cacheobj2->decRef();
-			instrptr->data |= ABC_OP_NOTCACHEABLE;
-			instrptr->data &= ~ABC_OP_CACHED;
+			// a second receiver class was seen, switch to a polymorphic cache
+			Class_base* cachedtype = (Class_base*)instrptr->cacheobj1;
+			ASObject* cachedfunc = instrptr->cacheobj2;
+			instrptr->polycache = th->mi->context->newPolymorphicCache(INLINE_CACHE_CALL);
+			if (cachedfunc && cachedfunc->is<Function>() && cachedfunc->as<IFunction>()->isCloned)
+				cachedfunc->decRef();
+			else
+				th->mi->context->addInlineCache(instrptr->polycache,cachedtype,th->mi->context->getMultiname(n,th))->target = cachedfunc;
+			instrptr->data |= ABC_OP_POLYMORPHIC;
+			instrptr->data &= ~(ABC_OP_CACHED|ABC_OP_COERCED);
+		}
+	}
+	else if (instrptr && (instrptr->data&ABC_OP_POLYMORPHIC))
+	{
+		RUNTIME_STACK_POP(th,obj);
+		if (asAtomHandler::isObject(obj))
+		{
+			inline_cache_entry* e = th->mi->context->findInlineCache(instrptr->polycache,asAtomHandler::getClass(obj,th->mi->context->root->getSystemState()),th->mi->context->getMultiname(n,th));
+			if (e)
+			{
+				asAtom o = asAtomHandler::fromObject(e->target);
+				ASATOM_INCREF(o);
+				LOG_CALL( (callproplex ? (keepReturn ? "callPropLex " : "callPropLexVoid") : (keepReturn ? "callProperty " : "callPropVoid")) << "from polymorphic cache:"<<*th->mi->context->getMultiname(n,th)<<" "<<asAtomHandler::toDebugString(obj)<<" "<<asAtomHandler::toDebugString(o));
+				callImpl(th, o, obj, args, m, keepReturn);
+				LOG_CALL("End of calling cached property "<<*th->mi->context->getMultiname(n,th));
+				return;
+			}
 		}
 	}
 	
@@ -430,12 +453,24 @@ void ABCVm::callPropIntern(call_context *th, int n, int m, bool keepReturn, bool
 				&& asAtomHandler::getObject(o) 
 				&& (asAtomHandler::is<Class_base>(obj) || asAtomHandler::as<IFunction>(o)->inClass == asAtomHandler::getClass(obj,th->mi->context->root->getSystemState())))
 		{
-			// cache method if multiname is static and it is a method of a sealed class
-			instrptr->data |= ABC_OP_CACHED;
-			instrptr->cacheobj1 = asAtomHandler::getClass(obj,th->mi->context->root->getSystemState());
-			instrptr->cacheobj2 = asAtomHandler::getObject(o);
-			instrptr->cacheobj2->incRef();
-			LOG_CALL("caching callproperty:"<<*name<<" "<<instrptr->cacheobj1->toDebugString()<<" "<<instrptr->cacheobj2->toDebugString());
+			if (instrptr->data & ABC_OP_POLYMORPHIC)
+			{
+				// cloned methods are not owned by the class, so they can't be shared between receivers
+				if (!asAtomHandler::as<IFunction>(o)->isCloned)
+				{
+					th->mi->context->addInlineCache(instrptr->polycache,asAtomHandler::getClass(obj,th->mi->context->root->getSystemState()),name)->target = asAtomHandler::getObject(o);
+					LOG_CALL("caching polymorphic callproperty:"<<*name<<" "<<asAtomHandler::toDebugString(obj));
+				}
+			}
+			else
+			{
+				// cache method if multiname is static and it is a method of a sealed class
+				instrptr->data |= ABC_OP_CACHED;
+				instrptr->cacheobj1 = asAtomHandler::getClass(obj,th->mi->context->root->getSystemState());
+				instrptr->cacheobj2 = asAtomHandler::getObject(o);
+				instrptr->cacheobj2->incRef();
+				LOG_CALL("caching callproperty:"<<*name<<" "<<instrptr->cacheobj1->toDebugString()<<" "<<instrptr->cacheobj2->toDebugString());
+			}
 		}
 //		else
 //			LOG(LOG_ERROR,"callprop caching failed:"<<canCache<<" "<<*name<<" "<<name->isStatic<<" "<<asAtomHandler::toDebugString(obj));
@@ -29,6 +29,7 @@ class memorystream;
 namespace lightspark
 {
 struct variable;
+class Class_base;
 
 class u8
 {
@@ -265,6 +266,35 @@ struct method_info_simple
 #define OPCODE_SIZE 10 // number of bits used for opcodes
 typedef void (*abc_function)(struct call_context*);
 
+/*
+ * Inline caches for callproperty/getproperty/setproperty sites.
+ * A call site starts monomorphic (ABC_OP_CACHED), switches to a polymorphic_cache
+ * (ABC_OP_POLYMORPHIC) when it sees more than one receiver class and uses the
+ * megamorphic stub cache of its ABCContext when the polymorphic cache is full.
+ */
+#define POLYMORPHIC_CACHE_SIZE 4
+#define MEGAMORPHIC_CACHE_BITS 10
+// setproperty sites have their own kind, entries stored by getproperty sites skip the checks done for writing
+enum INLINE_CACHE_KIND { INLINE_CACHE_CALL=0, INLINE_CACHE_PROPERTY, INLINE_CACHE_SETPROPERTY, INLINE_CACHE_KIND_COUNT };
+struct inline_cache_entry
+{
+	Class_base* type;
+	const multiname* name;
+	// the method to call for INLINE_CACHE_CALL
+	ASObject* target;
+	// the index of the variable in the property map of the receiver for INLINE_CACHE_PROPERTY and INLINE_CACHE_SETPROPERTY
+	uint32_t index;
+	inline_cache_entry():type(nullptr),name(nullptr),target(nullptr),index(0){}
+};
+struct polymorphic_cache
+{
+	inline_cache_entry entries[POLYMORPHIC_CACHE_SIZE];
+	uint32_t count;
+	INLINE_CACHE_KIND kind;
+	bool megamorphic;
+	polymorphic_cache(INLINE_CACHE_KIND k):count(0),kind(k),megamorphic(false){}
+};
+
 struct preloadedcodedata
 {
 	abc_function func;
@@ -287,6 +317,7 @@ struct preloadedcodedata
 	union
 	{
 		ASObject* cacheobj1;
+		polymorphic_cache* polycache;
 		asAtom* arg1_constant;
 		uint32_t local_pos1;
 		int32_t arg1_int;
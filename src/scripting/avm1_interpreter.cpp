@@ -27,13 +27,50 @@
 using namespace std;
 using namespace lightspark;
 
-void ACTIONRECORD::PushStack(std::stack<asAtom> &stack, const asAtom &a)
+namespace
+{
+/*
+ * Operand stack of an action block. It starts in a buffer on the C stack that
+ * is large enough for the straight-line code of the block, and only moves to
+ * the heap if loops push more values than that
+ */
+class AVM1Stack
+{
+private:
+	asAtom* values;
+	uint32_t size;
+	uint32_t capacity;
+	std::vector<asAtom> heap;
+public:
+	AVM1Stack(asAtom* buf, uint32_t c):values(buf),size(0),capacity(c) {}
+	bool empty() const { return size==0; }
+	const asAtom& top() const { return values[size-1]; }
+	void pop() { size--; }
+	void push(const asAtom& a)
+	{
+		if (size==capacity)
+		{
+			if (heap.empty())
+				heap.assign(values,values+size);
+			capacity*=2;
+			heap.resize(capacity);
+			values=heap.data();
+		}
+		values[size++]=a;
+	}
+};
+}
+
+//Stack space reserved on the C stack for an action block
+#define AVM1_MAX_PREALLOCATED_STACK 256
+
+static void PushStack(AVM1Stack& stack, const asAtom &a)
 {
 	ASATOM_INCREF(a);
 	stack.push(a);
 }
 
-asAtom ACTIONRECORD::PopStack(std::stack<asAtom>& stack)
+static asAtom PopStack(AVM1Stack& stack)
 {
 	if (stack.empty())
 		return asAtomHandler::undefinedAtom;
@@ -41,31 +78,352 @@ asAtom ACTIONRECORD::PopStack(std::stack<asAtom>& stack)
 	stack.pop();
 	return ret;
 }
-asAtom ACTIONRECORD::PeekStack(std::stack<asAtom>& stack)
+static asAtom PeekStack(AVM1Stack& stack)
 {
 	if (stack.empty())
 		throw RunTimeException("AVM1: empty stack");
 	return stack.top();
 }
 
-void ACTIONRECORD::executeActions(DisplayObject *clip, AVM1context* context, const std::vector<uint8_t> &actionlist, uint32_t startactionpos, std::map<uint32_t, asAtom> &scopevariables, asAtom* result, asAtom* obj, asAtom *args, uint32_t num_args, const std::vector<uint32_t>& paramnames, const std::vector<uint8_t>& paramregisternumbers,
+AVM1Program::AVM1Program(std::vector<uint8_t>& a, uint32_t startpos):startactionpos(startpos),hasconstants(false),numregisters(0),stacksize(0),decoded(false)
+{
+	actions.swap(a);
+}
+
+uint32_t AVM1Program::decodeAction(SystemState* sys, uint32_t pos, instruction& ins)
+{
+	const uint32_t size = actions.size();
+	ins.pos = pos;
+	ins.next = size;
+	ins.target = size;
+	ins.arg = 0;
+	ins.arg2 = 0;
+	ins.opcode = actions[pos];
+	if (ins.opcode == 0x00)
+		return size;
+	if (ins.opcode < 0x80)
+		return pos+1;
+	if (pos+3 > size)
+	{
+		LOG(LOG_ERROR,"AVM1: action "<<hex<<(int)ins.opcode<<dec<<" at "<<pos<<" exceeds the actions");
+		ins.opcode = 0x00;
+		return size;
+	}
+	uint32_t len = uint32_t(actions[pos+1]) | (uint32_t(actions[pos+2])<<8);
+	uint32_t p = pos+3;
+	uint32_t end = p+len;
+	if (end > size)
+	{
+		LOG(LOG_ERROR,"AVM1: action "<<hex<<(int)ins.opcode<<dec<<" at "<<pos<<" exceeds the actions");
+		ins.opcode = 0x00;
+		return size;
+	}
+	auto readUI16 = [&]() -> uint32_t
+	{
+		uint32_t v = p+1 < size ? uint32_t(actions[p]) | (uint32_t(actions[p+1])<<8) : 0;
+		p += 2;
+		return v;
+	};
+	auto readUI8 = [&]() -> uint32_t
+	{
+		return p < size ? actions[p++] : 0;
+	};
+	auto readString = [&]() -> tiny_string
+	{
+		if (p >= size)
+			return tiny_string();
+		// the actions always end with a 0 byte, see the parsing in tags.cpp
+		tiny_string s((const char*)&actions[p],true);
+		p += s.numBytes()+1;
+		return s;
+	};
+	auto branchTarget = [&](int32_t skip) -> uint32_t
+	{
+		int64_t target = int64_t(p)+skip;
+		if (target < 0 || target > size)
+		{
+			LOG(LOG_ERROR,"AVM1: invalid skip target:"<<skip<<" "<<p<<" "<<size);
+			return target < 0 ? 0 : size;
+		}
+		return target;
+	};
+	switch (ins.opcode)
+	{
+		case 0x81: // ActionGotoFrame
+			ins.arg = readUI16();
+			break;
+		case 0x83: // ActionGetURL
+			ins.arg = sys->getUniqueStringId(readString());
+			ins.arg2 = sys->getUniqueStringId(readString());
+			break;
+		case 0x87: // ActionStoreRegister
+			ins.arg = readUI8();
+			numregisters = max(numregisters,ins.arg+1);
+			break;
+		case 0x88: // ActionConstantPool
+		{
+			uint32_t c = readUI16();
+			std::vector<uint32_t> pool;
+			for (uint32_t i = 0; i < c; i++)
+				pool.push_back(sys->getUniqueStringId(readString()));
+			ins.arg = constantpools.size();
+			constantpools.push_back(pool);
+			break;
+		}
+		case 0x8a: // ActionWaitForFrame
+			ins.arg = readUI16();
+			ins.arg2 = readUI8();
+			break;
+		case 0x8b: // ActionSetTarget
+		case 0x8c: // ActionGotoLabel
+			ins.arg = sys->getUniqueStringId(readString());
+			break;
+		case 0x8e: // ActionDefineFunction2
+		case 0x9b: // ActionDefineFunction
+		{
+			function f;
+			f.nameID = sys->getUniqueStringId(readString().lowercase());
+			uint32_t paramcount = readUI16();
+			f.flags = 0;
+			f.preloadGlobal = false;
+			if (ins.opcode == 0x8e)
+			{
+				readUI8(); //register count not used
+				f.flags = readUI8();
+				f.preloadGlobal = readUI8()&0x01;
+			}
+			for (uint32_t i=0; i < paramcount; i++)
+			{
+				if (ins.opcode == 0x8e)
+					f.paramregisternumbers.push_back(readUI8());
+				f.paramnames.push_back(sys->getUniqueStringId(readString().lowercase()));
+			}
+			uint32_t codesize = readUI16();
+			// the function body follows the action
+			if (p+codesize > size)
+			{
+				LOG(LOG_ERROR,"AVM1: function body exceeds the actions:"<<codesize<<" "<<p<<" "<<size);
+				codesize = p < size ? size-p : 0;
+			}
+			std::vector<uint8_t> body(actions.begin()+min(p,size),actions.begin()+min(p,size)+codesize);
+			body.push_back(0);
+			f.code = _MR(new AVM1Program(body,0));
+			ins.arg = functions.size();
+			functions.push_back(f);
+			return p+codesize;
+		}
+		case 0x94: // ActionWith
+		{
+			uint32_t codesize = readUI16();
+			// the With body follows the action, arg is the position where the scope ends
+			ins.arg = p+codesize;
+			break;
+		}
+		case 0x96: // ActionPush
+		{
+			ins.arg = pushvalues.size();
+			while (p < end)
+			{
+				pushvalue v;
+				v.value = 0;
+				v.number = nullptr;
+				uint8_t type = actions[p++];
+				switch (type)
+				{
+					case 0:
+						v.type = PUSH_STRING;
+						v.value = sys->getUniqueStringId(readString());
+						break;
+					case 1:
+					{
+						if (p+4 > size)
+						{
+							p = end;
+							continue;
+						}
+						FLOAT f;
+						f.read(&actions[p]);
+						p += 4;
+						v.type = PUSH_NUMBER;
+						v.number = abstract_d_constant(sys,f);
+						break;
+					}
+					case 2:
+						v.type = PUSH_NULL;
+						break;
+					case 3:
+						v.type = PUSH_UNDEFINED;
+						break;
+					case 4:
+						v.type = PUSH_REGISTER;
+						v.value = readUI8();
+						numregisters = max(numregisters,v.value+1);
+						break;
+					case 5:
+						v.type = PUSH_BOOL;
+						v.value = readUI8();
+						break;
+					case 6:
+					{
+						if (p+8 > size)
+						{
+							p = end;
+							continue;
+						}
+						DOUBLE d;
+						d.read(&actions[p]);
+						p += 8;
+						v.type = PUSH_NUMBER;
+						v.number = abstract_d_constant(sys,d);
+						break;
+					}
+					case 7:
+					{
+						v.type = PUSH_INT;
+						uint32_t low = readUI16();
+						v.value = low | (readUI16()<<16);
+						break;
+					}
+					case 8:
+						v.type = PUSH_CONSTANT;
+						v.value = readUI8();
+						break;
+					case 9:
+						v.type = PUSH_CONSTANT;
+						v.value = readUI16();
+						break;
+					default:
+						LOG(LOG_NOT_IMPLEMENTED,"AVM1: ActionPush type "<<(int)type);
+						p = end;
+						continue;
+				}
+				pushvalues.push_back(v);
+			}
+			ins.arg2 = pushvalues.size()-ins.arg;
+			break;
+		}
+		case 0x99: // ActionJump
+		case 0x9d: // ActionIf
+			ins.target = branchTarget(int16_t(readUI16()));
+			break;
+		case 0x9a: // ActionGetURL2
+			ins.arg = readUI8();
+			break;
+		case 0x9f: // ActionGotoFrame2
+			ins.arg = readUI8();
+			if (ins.arg&0x02)
+				ins.arg2 = readUI16();
+			break;
+		default:
+			break;
+	}
+	return end;
+}
+
+void AVM1Program::resolveConstants()
+{
+	// The constants can be resolved here if the program always works with the same constant pool,
+	// that is the one it inherits from the defining block or the one set by its first action
+	const std::vector<uint32_t>* pool = hasconstants ? &constants : nullptr;
+	for (auto it = code.begin(); it != code.end(); it++)
+	{
+		if (it->opcode != 0x88)
+			continue;
+		if (it == code.begin() && constantpools.size()==1)
+			pool = &constantpools[it->arg];
+		else
+		{
+			pool = nullptr;
+			break;
+		}
+	}
+	if (!pool)
+		return;
+	for (auto it = pushvalues.begin(); it != pushvalues.end(); it++)
+	{
+		if (it->type == PUSH_CONSTANT && it->value < pool->size())
+		{
+			it->type = PUSH_STRING;
+			it->value = (*pool)[it->value];
+		}
+	}
+	for (auto it = functions.begin(); it != functions.end(); it++)
+	{
+		it->code->constants = *pool;
+		it->code->hasconstants = true;
+	}
+}
+
+void AVM1Program::decode(SystemState* sys)
+{
+	// Actions are decoded starting from startactionpos and from all the branch targets,
+	// as jumps may lead anywhere in the actions (even before startactionpos)
+	const uint32_t size = actions.size();
+	std::map<uint32_t,uint32_t> indexes;
+	std::vector<uint32_t> pending;
+	pending.push_back(startactionpos);
+	while (!pending.empty())
+	{
+		uint32_t pos = pending.back();
+		pending.pop_back();
+		if (pos >= size || indexes.find(pos) != indexes.end())
+			continue;
+		instruction ins;
+		uint32_t next = decodeAction(sys,pos,ins);
+		ins.next = next;
+		indexes[pos] = code.size();
+		code.push_back(ins);
+		if (ins.opcode == 0x99 || ins.opcode == 0x9d)
+			pending.push_back(ins.target);
+		pending.push_back(next);
+	}
+	// the end of the actions
+	instruction end;
+	end.pos = size;
+	end.next = end.target = code.size();
+	end.arg = end.arg2 = 0;
+	end.opcode = 0x00;
+	indexes[size] = code.size();
+	code.push_back(end);
+	// actions were decoded depth first, the first one is the one at startactionpos
+	for (auto it = code.begin(); it != code.end()-1; it++)
+	{
+		it->next = indexes[min(it->next,size)];
+		it->target = indexes[min(it->target,size)];
+	}
+	resolveConstants();
+	// every action pushes at most one value, except ActionPush
+	stacksize = max(uint32_t(code.size()+pushvalues.size()),1u);
+	stacksize = min(stacksize,uint32_t(AVM1_MAX_PREALLOCATED_STACK));
+	std::vector<uint8_t>().swap(actions);
+	decoded = true;
+}
+
+void ACTIONRECORD::executeActions(DisplayObject *clip, AVM1context* context, AVM1Program* program, std::map<uint32_t, asAtom> &scopevariables, asAtom* result, asAtom* obj, asAtom *args, uint32_t num_args, const std::vector<uint32_t>& paramnames, const std::vector<uint8_t>& paramregisternumbers,
 								  bool preloadParent, bool preloadRoot, bool suppressSuper, bool preloadSuper, bool suppressArguments, bool preloadArguments, bool suppressThis, bool preloadThis, bool preloadGlobal,AVM1Function *caller, AVM1Function *callee)
 {
 	Log::calls_indent++;
-	LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" executeActions "<<preloadParent<<preloadRoot<<suppressSuper<<preloadSuper<<suppressArguments<<preloadArguments<<suppressThis<<preloadThis<<preloadGlobal<<" "<<startactionpos);
+	LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" executeActions "<<preloadParent<<preloadRoot<<suppressSuper<<preloadSuper<<suppressArguments<<preloadArguments<<suppressThis<<preloadThis<<preloadGlobal<<" "<<program->startactionpos);
 	if (result)
 		asAtomHandler::setUndefined(*result);
-	std::stack<asAtom> stack;
+	if (!program->decoded)
+		program->decode(clip->getSystemState());
+	const AVM1Program::instruction* code = program->code.data();
+	AVM1Stack stack(g_newa(asAtom, program->stacksize),program->stacksize);
 	asAtom registers[256];
-	std::fill_n(registers,256,asAtomHandler::undefinedAtom);
+	// only the registers used by the program and the ones set below can be read
+	uint32_t numregisters = max(program->numregisters,8u);
+	for (uint32_t i = 0; i < paramregisternumbers.size(); i++)
+		numregisters = max(numregisters,uint32_t(paramregisternumbers[i])+1);
+	std::fill_n(registers,numregisters,asAtomHandler::undefinedAtom);
 	std::map<uint32_t,asAtom> locals;
 	int curdepth = 0;
 	int maxdepth= clip->getSystemState()->mainClip->version < 6 ? 8 : 16;
 	asAtom* scopestack = g_newa(asAtom, maxdepth);
 	scopestack[0] = obj ? *obj : asAtomHandler::fromObject(clip);
 	ASATOM_INCREF(scopestack[0]);
-	std::vector<uint8_t>::const_iterator* scopestackstop = g_newa(std::vector<uint8_t>::const_iterator, maxdepth);
-	scopestackstop[0] = actionlist.end();
+	uint32_t* scopestackstop = g_newa(uint32_t, maxdepth);
+	scopestackstop[0] = UINT32_MAX;
 	uint32_t currRegister = 1; // spec is not clear, but gnash starts at register 1
 	if (!suppressThis)
 	{
@@ -165,10 +523,12 @@ void ACTIONRECORD::executeActions(DisplayObject *clip, AVM1context* context, con
 	}
 
 	DisplayObject *originalclip = clip;
-	auto it = actionlist.begin()+startactionpos;
-	while (it != actionlist.end())
+	uint32_t ip = 0;
+	while (code[ip].opcode != 0x00)
 	{
-		if (curdepth > 0 && it == scopestackstop[curdepth])
+		const AVM1Program::instruction& ins = code[ip];
+		ip = ins.next;
+		while (curdepth > 0 && ins.pos == scopestackstop[curdepth])
 		{
 			LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" end with "<<asAtomHandler::toDebugString(scopestack[curdepth]));
 			if (asAtomHandler::is<DisplayObject>(scopestack[curdepth]))
@@ -176,23 +536,18 @@ void ACTIONRECORD::executeActions(DisplayObject *clip, AVM1context* context, con
 			curdepth--;
 			Log::calls_indent--;
 		}
+		uint8_t opcode = ins.opcode;
 		if (!clip
-				&& *it != 0x20 // ActionSetTarget2
-				&& *it != 0x8b // ActionSetTarget
+				&& opcode != 0x20 // ActionSetTarget2
+				&& opcode != 0x8b // ActionSetTarget
 				)
 		{
 			// we are in a target that was not found during ActionSetTarget(2), so these actions are ignored
 			continue;
 		}
-		LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<< " "<<(it-actionlist.begin())<< " action code:"<<hex<<(int)*it);
-		uint8_t opcode = *it++;
-		if (opcode > 0x80)
-			it+=2; // skip length
+		LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<< " "<<ins.pos<< " action code:"<<hex<<(int)opcode);
 		switch (opcode)
 		{
-			case 0x00:
-				it = actionlist.end(); // force quit loop;
-				break;
 			case 0x04: // ActionNextFrame
 			{
 				if (!clip->is<MovieClip>())
@@ -1623,17 +1978,15 @@ void ACTIONRECORD::executeActions(DisplayObject *clip, AVM1context* context, con
 					LOG(LOG_ERROR,"AVM1:"<<clip->getTagID()<<" no MovieClip for ActionGotoFrame "<<clip->toDebugString());
 					break;
 				}
-				uint32_t frame = uint32_t(*it++) | ((*it++)<<8);
+				uint32_t frame = ins.arg;
 				LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" ActionGotoFrame "<<frame);
 				clip->as<MovieClip>()->AVM1gotoFrame(frame,true,true);
 				break;
 			}
 			case 0x83: // ActionGetURL
 			{
-				tiny_string s1((const char*)&(*it));
-				it += s1.numBytes()+1;
-				tiny_string s2((const char*)&(*it));
-				it += s2.numBytes()+1;
+				tiny_string s1 = clip->getSystemState()->getStringFromUniqueId(ins.arg);
+				tiny_string s2 = clip->getSystemState()->getStringFromUniqueId(ins.arg2);
 				LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" ActionGetURL "<<s1<<" "<<s2);
 				clip->getSystemState()->openPageInBrowser(s1,s2);
 				break;
@@ -1642,22 +1995,16 @@ void ACTIONRECORD::executeActions(DisplayObject *clip, AVM1context* context, con
 			{
 				asAtom a = PeekStack(stack);
 				ASATOM_INCREF(a);
-				uint8_t num = *it++;
+				uint32_t num = ins.arg;
 				LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" ActionStoreRegister "<<(int)num<<" "<<asAtomHandler::toDebugString(a));
 				registers[num] = a;
 				break;
 			}
 			case 0x88: // ActionConstantPool
 			{
-				uint32_t c = uint32_t(*it++) | ((*it++)<<8);
-				context->AVM1ClearConstants();
-				for (uint32_t i = 0; i < c; i++)
-				{
-					tiny_string s((const char*)&(*it),true);
-					it += s.numBytes()+1;
-					context->AVM1AddConstant(clip->getSystemState()->getUniqueStringId(s));
-				}
-				LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" ActionConstantPool "<<c);
+				const std::vector<uint32_t>& pool = program->constantpools[ins.arg];
+				context->AVM1SetConstants(pool);
+				LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" ActionConstantPool "<<pool.size());
 				break;
 			}
 			case 0x8a: // ActionWaitForFrame
@@ -1667,32 +2014,26 @@ void ACTIONRECORD::executeActions(DisplayObject *clip, AVM1context* context, con
 					LOG(LOG_ERROR,"AVM1:"<<clip->getTagID()<<" no MovieClip for ActionWaitForFrame "<<clip->toDebugString());
 					break;
 				}
-				uint32_t frame = uint32_t(*it++) | ((*it++)<<8);
-				uint32_t skipcount = (uint32_t)(*it++);
+				uint32_t frame = ins.arg;
+				uint32_t skipcount = ins.arg2;
 				LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" ActionWaitForFrame "<<frame<<"/"<<clip->as<MovieClip>()->getFramesLoaded()<<" skip "<<skipcount);
 				if (clip->as<MovieClip>()->getFramesLoaded() <= frame && !clip->as<MovieClip>()->hasFinishedLoading())
 				{
 					// frame not yet loaded, skip actions
-					while (skipcount && it != actionlist.end())
+					while (skipcount && code[ip].opcode != 0x00)
 					{
-						it++;
-						if (*it > 0x80)
-						{
-							uint32_t c = uint32_t(*it++) | ((*it++)<<8);
-							it+=c;
-						}
+						ip = code[ip].next;
 						skipcount--;
 					}
 				}
 				break;
 			}
 			case 0x08: // ActionToggleQuality
-				LOG(LOG_NOT_IMPLEMENTED,"AVM1:"<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" SWF3 DoActionTag ActionToggleQuality "<<hex<<(int)*it);
+				LOG(LOG_NOT_IMPLEMENTED,"AVM1:"<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" SWF3 DoActionTag ActionToggleQuality "<<hex<<(int)opcode);
 				break;
 			case 0x8b: // ActionSetTarget
 			{
-				tiny_string s((const char*)&(*it));
-				it += s.numBytes()+1;
+				tiny_string s = originalclip->getSystemState()->getStringFromUniqueId(ins.arg);
 				if (!clip)
 				{
 					LOG_CALL("AVM1: ActionSetTarget: setting target from undefined value to "<<s);
@@ -1718,203 +2059,105 @@ void ACTIONRECORD::executeActions(DisplayObject *clip, AVM1context* context, con
 					LOG(LOG_ERROR,"AVM1:"<<clip->getTagID()<<" no MovieClip for ActionGotoLabel "<<clip->toDebugString());
 					break;
 				}
-				tiny_string s((const char*)&(*it));
-				it += s.numBytes()+1;
+				tiny_string s = clip->getSystemState()->getStringFromUniqueId(ins.arg);
 				LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" ActionGotoLabel "<<s);
 				clip->as<MovieClip>()->AVM1gotoFrameLabel(s);
 				break;
 			}
 			case 0x8e: // ActionDefineFunction2
 			{
-				tiny_string name((const char*)&(*it),true);
-				it += name.numBytes()+1;
-				uint32_t paramcount = uint32_t(*it++) | ((*it++)<<8);
-				*it++; //register count not used
-				uint8_t flags = *it++;
-				bool flag1 = flags&0x80;//PreloadParent
-				bool flag2 = flags&0x40;//PreloadRoot
-				bool flag3 = flags&0x20;//SuppressSuper
-				bool flag4 = flags&0x10;//PreloadSuper
-				bool flag5 = flags&0x08;//SuppressArguments
-				bool flag6 = flags&0x04;//PreloadArguments
-				bool flag7 = flags&0x02;//SuppressThis
-				bool flag8 = flags&0x01;//PreloadThis
-				bool flag9 = (*it++)&0x01;//PreloadGlobal
-				std::vector<uint32_t> paramnames;
-				std::vector<uint8_t> registernumber;
-				for (uint16_t i=0; i < paramcount; i++)
-				{
-					uint8_t regnum = *it++;
-					tiny_string n((const char*)&(*it),true);
-					it += n.numBytes()+1;
-					paramnames.push_back(clip->getSystemState()->getUniqueStringId(n.lowercase()));
-					registernumber.push_back(regnum);
-				}
-				uint32_t codesize = uint32_t(*it++) | ((*it++)<<8);
-				vector<uint8_t> code;
-				code.assign(it,it+codesize);
-				it += codesize;
-				LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" ActionDefineFunction2 "<<name<<" "<<paramcount<<" "<<flag1<<flag2<<flag3<<flag4<<flag5<<flag6<<flag7<<flag8<<flag9<<" "<<codesize);
-				AVM1Function* f = Class<IFunction>::getAVM1Function(clip->getSystemState(),clip,context,paramnames,code,locals,registernumber,flag1, flag2, flag3, flag4, flag5, flag6, flag7, flag8, flag9);
+				const AVM1Program::function& fn = program->functions[ins.arg];
+				bool flag1 = fn.flags&0x80;//PreloadParent
+				bool flag2 = fn.flags&0x40;//PreloadRoot
+				bool flag3 = fn.flags&0x20;//SuppressSuper
+				bool flag4 = fn.flags&0x10;//PreloadSuper
+				bool flag5 = fn.flags&0x08;//SuppressArguments
+				bool flag6 = fn.flags&0x04;//PreloadArguments
+				bool flag7 = fn.flags&0x02;//SuppressThis
+				bool flag8 = fn.flags&0x01;//PreloadThis
+				bool flag9 = fn.preloadGlobal;//PreloadGlobal
+				LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" ActionDefineFunction2 "<<clip->getSystemState()->getStringFromUniqueId(fn.nameID)<<" "<<fn.paramnames.size()<<" "<<flag1<<flag2<<flag3<<flag4<<flag5<<flag6<<flag7<<flag8<<flag9);
+				AVM1Function* f = Class<IFunction>::getAVM1Function(clip->getSystemState(),clip,context,fn.paramnames,fn.code,locals,fn.paramregisternumbers,flag1, flag2, flag3, flag4, flag5, flag6, flag7, flag8, flag9);
 				//Create the prototype object
 				f->prototype = _MR(new_asobject(f->getSystemState()));
-				if (name == "")
+				if (fn.nameID == BUILTIN_STRINGS::EMPTY)
 				{
 					asAtom a = asAtomHandler::fromObject(f);
 					PushStack(stack,a);
 				}
 				else
-				{
-					uint32_t nameID = clip->getSystemState()->getUniqueStringId(name.lowercase());
-					clip->AVM1SetFunction(nameID,_MR(f));
-				}
+					clip->AVM1SetFunction(fn.nameID,_MR(f));
 				break;
 			}
 			case 0x94: // ActionWith
 			{
 				asAtom obj = PopStack(stack);
-				uint32_t codesize = uint32_t(*it++) | ((*it++)<<8);
-				auto itend = it;
-				itend+=codesize;
 				if (curdepth >= maxdepth)
 				{
-					it = itend;
+					// skip the body
+					while (code[ip].opcode != 0x00 && code[ip].pos < ins.arg)
+						ip = code[ip].next;
 					LOG(LOG_ERROR,"AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" ActionWith depth exceeds maxdepth");
 					break;
 				}
 				Log::calls_indent++;
-				LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" ActionWith "<<codesize<<" "<<asAtomHandler::toDebugString(obj));
+				LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" ActionWith "<<ins.arg<<" "<<asAtomHandler::toDebugString(obj));
 				++curdepth;
 				if (asAtomHandler::is<DisplayObject>(obj))
 					clip = asAtomHandler::as<DisplayObject>(obj);
 				scopestack[curdepth] = obj;
-				scopestackstop[curdepth] = itend;
+				scopestackstop[curdepth] = ins.arg;
 				break;
 			}
 			case 0x96: // ActionPush
 			{
-				uint32_t len = ((*(it-1))<<8) | (*(it-2));
-				while (len > 0)
+				const AVM1Program::pushvalue* v = program->pushvalues.data()+ins.arg;
+				for (uint32_t i = 0; i < ins.arg2; i++,v++)
 				{
-					uint8_t type = *it++;
-					len--;
-					switch (type)
+					asAtom a = asAtomHandler::invalidAtom;
+					switch (v->type)
 					{
-						case 0:
-						{
-							tiny_string val((const char*)&(*it),true);
-							len -= val.numBytes()+1;
-							it += val.numBytes()+1;
-							asAtom a = asAtomHandler::fromStringID(clip->getSystemState()->getUniqueStringId(val));
-							PushStack(stack,a);
-							LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" ActionPush 0 "<<asAtomHandler::toDebugString(a));
+						case AVM1Program::PUSH_STRING:
+							a = asAtomHandler::fromStringID(v->value);
 							break;
-						}
-						case 1:
-						{
-							FLOAT f;
-							f.read((const uint8_t*)&(*it));
-							it+=4;
-							len-=4;
-							asAtom a = asAtomHandler::fromNumber(clip->getSystemState(),f,false);
-							PushStack(stack,a);
-							LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" ActionPush 1 "<<asAtomHandler::toDebugString(a));
-							break;
-						}
-						case 2:
-							PushStack(stack,asAtomHandler::nullAtom);
-							LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" ActionPush 2 "<<asAtomHandler::toDebugString(asAtomHandler::nullAtom));
+						case AVM1Program::PUSH_NUMBER:
+							a = asAtomHandler::fromObject(v->number);
 							break;
-						case 3:
-							PushStack(stack,asAtomHandler::undefinedAtom);
-							LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" ActionPush 3 "<<asAtomHandler::toDebugString(asAtomHandler::undefinedAtom));
-							break;
-						case 4:
-						{
-							uint32_t reg = *it++;
-							len--;
-							asAtom a = registers[reg];
-							PushStack(stack,a);
-							LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" ActionPush 4 register "<<reg<<" "<<asAtomHandler::toDebugString(a));
-							break;
-						}
-						case 5:
-						{
-							asAtom a = asAtomHandler::fromBool((bool)*it++);
-							len--;
-							PushStack(stack,a);
-							LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" ActionPush 5 "<<asAtomHandler::toDebugString(a));
+						case AVM1Program::PUSH_INT:
+							a = asAtomHandler::fromInt((int32_t)v->value);
 							break;
-						}
-						case 6:
-						{
-							DOUBLE d;
-							d.read((const uint8_t*)&(*it));
-							it+=8;
-							len-=8;
-							asAtom a = asAtomHandler::fromNumber(clip->getSystemState(),d,false);
-							PushStack(stack,a);
-							LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" ActionPush 6 "<<asAtomHandler::toDebugString(a));
+						case AVM1Program::PUSH_BOOL:
+							a = asAtomHandler::fromBool(v->value);
 							break;
-						}
-						case 7:
-						{
-							uint32_t d=GUINT32_FROM_LE(*(uint32_t*)&(*it));
-							it+=4;
-							len-=4;
-							asAtom a = asAtomHandler::fromInt((int32_t)d);
-							PushStack(stack,a);
-							LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" ActionPush 7 "<<asAtomHandler::toDebugString(a));
+						case AVM1Program::PUSH_NULL:
+							a = asAtomHandler::nullAtom;
 							break;
-						}
-						case 8:
-						{
-							uint32_t index = (*it++);
-							len--;
-							asAtom a = context->AVM1GetConstant(index);
-							PushStack(stack,a);
-							LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" ActionPush 8 "<<index<<" "<<asAtomHandler::toDebugString(a));
+						case AVM1Program::PUSH_UNDEFINED:
+							a = asAtomHandler::undefinedAtom;
 							break;
-						}
-						case 9:
-						{
-							uint32_t index = uint32_t(*it++) | ((*it++)<<8);
-							len-=2;
-							asAtom a = context->AVM1GetConstant(index);
-							PushStack(stack,a);
-							LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" ActionPush 9 "<<index<<" "<<asAtomHandler::toDebugString(a));
+						case AVM1Program::PUSH_REGISTER:
+							a = registers[v->value];
 							break;
-						}
-						default:
-							LOG(LOG_NOT_IMPLEMENTED,"AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" SWF4 DoActionTag push type "<<(int)type);
+						case AVM1Program::PUSH_CONSTANT:
+							a = context->AVM1GetConstant(v->value);
 							break;
 					}
+					PushStack(stack,a);
+					LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" ActionPush "<<(int)v->type<<" "<<v->value<<" "<<asAtomHandler::toDebugString(a));
 				}
 				break;
 			}
 			case 0x99: // ActionJump
 			{
-				int32_t skip = int16_t((*it++) | ((*it++)<<8));
-				LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" ActionJump "<<skip<<" "<< (it-actionlist.begin()));
-				if (skip < 0 && it-actionlist.begin() < -skip)
-				{
-					LOG(LOG_ERROR,"ActionJump: invalid skip target:"<< skip<<" "<<(it-actionlist.begin())<<" "<<actionlist.size());
-					it = actionlist.begin();
-				}
-				if (skip >=0 && skip + (it-actionlist.begin()) > (int)actionlist.size())
-				{
-					LOG(LOG_ERROR,"ActionJump: invalid skip target:"<< skip<<" "<<(it-actionlist.begin())<<" "<<actionlist.size());
-					it = actionlist.end();
-				}
-				else
-					it+= skip;
+				LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" ActionJump "<<code[ins.target].pos);
+				ip = ins.target;
 				break;
 			}
 			case 0x9a: // ActionGetURL2
 			{
 				asAtom at=PopStack(stack);
 				asAtom au=PopStack(stack);
-				uint8_t b = *it++;
+				uint8_t b = ins.arg;
 				uint8_t method = b&0xc0>>6;
 				bool loadtarget = b&0x02;
 				bool loadvars = b&0x01;
@@ -1947,56 +2190,26 @@ void ACTIONRECORD::executeActions(DisplayObject *clip, AVM1context* context, con
 			}
 			case 0x9b: // ActionDefineFunction
 			{
-				tiny_string name((const char*)&(*it),true);
-				it += name.numBytes()+1;
-				uint32_t paramcount = uint32_t(*it++) | ((*it++)<<8);
-				std::vector<uint32_t> paramnames;
-				for (uint16_t i=0; i < paramcount; i++)
-				{
-					tiny_string n((const char*)&(*it),true);
-					it += n.numBytes()+1;
-					paramnames.push_back(clip->getSystemState()->getUniqueStringId(n.lowercase()));
-				}
-				uint32_t codesize = uint32_t(*it++) | ((*it++)<<8);
-				vector<uint8_t> code;
-				code.assign(it,it+codesize);
-				it += codesize;
-				LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" ActionDefineFunction "<<name<<" "<<paramcount);
-				AVM1Function* f = Class<IFunction>::getAVM1Function(clip->getSystemState(),clip,context,paramnames,code,locals);
+				const AVM1Program::function& fn = program->functions[ins.arg];
+				LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" ActionDefineFunction "<<clip->getSystemState()->getStringFromUniqueId(fn.nameID)<<" "<<fn.paramnames.size());
+				AVM1Function* f = Class<IFunction>::getAVM1Function(clip->getSystemState(),clip,context,fn.paramnames,fn.code,locals);
 				//Create the prototype object
 				f->prototype = _MR(new_asobject(f->getSystemState()));
-				if (name == "")
+				if (fn.nameID == BUILTIN_STRINGS::EMPTY)
 				{
 					asAtom a = asAtomHandler::fromObject(f);
 					PushStack(stack,a);
 				}
 				else
-				{
-					uint32_t nameID = clip->getSystemState()->getUniqueStringId(name.lowercase());
-					clip->AVM1SetFunction(nameID,_MR(f));
-				}
+					clip->AVM1SetFunction(fn.nameID,_MR(f));
 				break;
 			}
 			case 0x9d: // ActionIf
 			{
-				int32_t skip = int16_t((*it++) | ((*it++)<<8));
 				asAtom a = PopStack(stack);
-				LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" ActionIf "<<asAtomHandler::toDebugString(a)<<" "<<skip);
+				LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" ActionIf "<<asAtomHandler::toDebugString(a)<<" "<<code[ins.target].pos);
 				if (asAtomHandler::toInt(a))
-				{
-					if (skip < 0 && it-actionlist.begin() < -skip)
-					{
-						LOG(LOG_ERROR,"ActionIf: invalid skip target:"<< skip<<" "<<(it-actionlist.begin())<<" "<<actionlist.size());
-						it = actionlist.begin();
-					}
-					if (skip >=0 && skip + (it-actionlist.begin()) > (int)actionlist.size())
-					{
-						LOG(LOG_ERROR,"ActionIf: invalid skip target:"<< skip<<" "<<(it-actionlist.begin())<<" "<<actionlist.size());
-						it = actionlist.end();
-					}
-					else
-						it += skip;
-				}
+					ip = ins.target;
 				break;
 			}
 			case 0x9e: // ActionCall
@@ -2023,14 +2236,8 @@ void ACTIONRECORD::executeActions(DisplayObject *clip, AVM1context* context, con
 			}
 			case 0x9f: // ActionGotoFrame2
 			{
-				
-				bool biasflag = (*it)&0x02;
-				bool playflag = (*it)&0x01;
-				it++;
-				uint32_t biasframe = 0;
-				if (biasflag)
-					biasframe = uint32_t(*it++) | ((*it++)<<8);
-				
+				bool playflag = ins.arg&0x01;
+				uint32_t biasframe = ins.arg2;
 				asAtom a = PopStack(stack);
 				if (!clip->is<MovieClip>())
 				{
@@ -2064,11 +2271,6 @@ void ACTIONRECORD::executeActions(DisplayObject *clip, AVM1context* context, con
 			case 0x37: // ActionMBAsciiToChar
 			case 0x8d: // ActionWaitForFrame2
 				LOG(LOG_NOT_IMPLEMENTED,"AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" SWF4 DoActionTag "<<hex<<(int)opcode);
-				if(opcode >= 0x80)
-				{
-					uint32_t len = ((*(it-1))<<8) | (*(it-2));
-					it+=len;
-				}
 				break;
 			case 0x45: // ActionTargetPath
 			case 0x46: // ActionEnumerate
@@ -2081,11 +2283,6 @@ void ACTIONRECORD::executeActions(DisplayObject *clip, AVM1context* context, con
 			case 0x2c: // ActionImplementsOp
 			case 0x8f: // ActionTry
 				LOG(LOG_NOT_IMPLEMENTED,"AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" SWF7 DoActionTag "<<hex<<(int)opcode);
-				if(opcode >= 0x80)
-				{
-					uint32_t len = ((*(it-1))<<8) | (*(it-2));
-					it+=len;
-				}
 				break;
 			default:
 				LOG(LOG_NOT_IMPLEMENTED,"AVM1:"<<clip->getTagID()<<" "<<(clip->is<MovieClip>() ? clip->as<MovieClip>()->state.FP : 0)<<" invalid DoActionTag "<<hex<<(int)opcode);
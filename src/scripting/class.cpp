@@ -150,10 +150,18 @@ void Class_inherit::setupDeclaredTraits(ASObject *target, bool checkclone)
 			//HACK: suppress implementation handling of variables just now
 			bool bak=target->implEnable;
 			target->implEnable=false;
+			bool sharedLayout=!instancefactory.isNull() && instancefactory->isInitialized();
+			//Keep the variables in a single block, like the ones of cloned instances
+			if (sharedLayout)
+				target->Variables.Variables.reserve(instancefactory->Variables.Variables.size());
 			recursiveBuild(target);
 			
 			//And restore it
 			target->implEnable=bak;
+
+			//Instances of the same class share the names of their variables
+			if (sharedLayout)
+				target->Variables.Variables.shareLayout(instancefactory->Variables.Variables);
 		}
 
 	#ifndef NDEBUG
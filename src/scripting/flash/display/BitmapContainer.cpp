@@ -22,15 +22,31 @@
 #include "scripting/flash/display/flashdisplay.h"
 #include "backends/rendering_context.h"
 #include "backends/image.h"
+#include "parsing/tags.h"
 
 using namespace std;
 using namespace lightspark;
 
 BitmapContainer::BitmapContainer(MemoryAccount* m):stride(0),width(0),height(0),
-	data(reporter_allocator<uint8_t>(m))
+	data(reporter_allocator<uint8_t>(m)),decoder(NULL)
 {
 }
 
+void BitmapContainer::setDecoder(BitmapTag* t)
+{
+	Locker l(decoderMutex);
+	decoder=t;
+}
+
+void BitmapContainer::ensureDecoded()
+{
+	//The tag can not be destroyed while the lock is held, see ~BitmapTag
+	Locker l(decoderMutex);
+	if(decoder)
+		decoder->ensureDecoded();
+	decoder=NULL;
+}
+
 bool BitmapContainer::fromRGB(uint8_t* rgb, uint32_t w, uint32_t h, BITMAP_FORMAT format, bool frompng)
 {
 	if(!rgb)
@@ -465,3 +481,17 @@ std::vector<uint32_t> BitmapContainer::getPixelVector(const RECT& inputRect) con
 
 	return result;
 }
+
+void BitmapContainer::setPixelVector(const RECT& rect, const std::vector<uint32_t>& pixels)
+{
+	int32_t rowWidth = rect.Xmax - rect.Xmin;
+	if (rowWidth <= 0)
+		return;
+	assert(pixels.size() >= size_t(rowWidth*(rect.Ymax - rect.Ymin)));
+	for (int32_t y=rect.Ymin; y<rect.Ymax; y++)
+	{
+		memcpy(getDataNoBoundsChecking(rect.Xmin, y),
+		       &pixels[(y-rect.Ymin)*rowWidth],
+		       4*rowWidth);
+	}
+}
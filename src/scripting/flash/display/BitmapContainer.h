@@ -24,11 +24,14 @@
 #include "memory_support.h"
 #include "smartrefs.h"
 #include "swftypes.h"
+#include "threading.h"
 #include <vector>
 
 namespace lightspark
 {
 
+class BitmapTag;
+
 class BitmapContainer : public RefCountable
 {
 public:
@@ -44,8 +47,15 @@ protected:
 	// buffer to contain the 
 	std::vector<uint8_t> data_colortransformed;
 	uint32_t *getDataNoBoundsChecking(int32_t x, int32_t y) const;
+	// The tag still decoding into this container, see ensureDecoded
+	Mutex decoderMutex;
+	BitmapTag* decoder;
 public:
 	BitmapContainer(MemoryAccount* m);
+	// Containers of bitmap tags are handed out before the image is
+	// decoded, renderers call this before reading the pixels
+	void setDecoder(BitmapTag* t);
+	void ensureDecoded();
 	uint8_t* getData() { return &data[0]; }
 	const uint8_t* getData() const { return &data[0]; }
 	uint8_t* getDataColorTransformed() 
@@ -72,6 +82,9 @@ public:
 	void setPixel(int32_t x, int32_t y, uint32_t color, bool setAlpha, bool ispremultiplied=true);
 	uint32_t getPixel(int32_t x, int32_t y, bool premultiplied=true) const;
 	std::vector<uint32_t> getPixelVector(const RECT& rect) const;
+	// Store pixels (in the format of getPixelVector) in rect, that
+	// must be inside this BitmapContainer
+	void setPixelVector(const RECT& rect, const std::vector<uint32_t>& pixels);
 	void copyRectangle(_R<BitmapContainer> source, 
 			   const RECT& sourceRect,
 			   int32_t destX, int32_t destY,
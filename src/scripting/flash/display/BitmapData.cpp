@@ -820,8 +820,7 @@ ASFUNCTIONBODY_ATOM(BitmapData,setVector)
 			if (i >= inputVector->size())
 				throwError<RangeError>(kParamRangeError);
 
-			asAtom v = inputVector->at(i);
-			uint32_t pixel = asAtomHandler::toUInt(v);
+			uint32_t pixel = inputVector->getUInt(i);
 			th->pixels->setPixel(x, y, pixel, th->transparent);
 			i++;
 		}
@@ -937,12 +936,49 @@ ASFUNCTIONBODY_ATOM(BitmapData,compare)
 
 ASFUNCTIONBODY_ATOM(BitmapData,applyFilter)
 {
+	BitmapData* th = asAtomHandler::as<BitmapData>(obj);
 	_NR<BitmapData> sourceBitmapData;
 	_NR<Rectangle> sourceRect;
 	_NR<Point> destPoint;
 	_NR<BitmapFilter> filter;
 	ARG_UNPACK_ATOM (sourceBitmapData)(sourceRect)(destPoint)(filter);
-	LOG(LOG_NOT_IMPLEMENTED,"BitmapData.applyFilter not implemented");
+
+	if(th->pixels.isNull())
+		throw Class<ArgumentError>::getInstanceS(sys,"Disposed BitmapData", 2015);
+	if (sourceBitmapData.isNull())
+		throwError<TypeError>(kNullPointerError, "sourceBitmapData");
+	if (sourceBitmapData->pixels.isNull())
+		throw Class<ArgumentError>::getInstanceS(sys,"Disposed BitmapData", 2015);
+	if (sourceRect.isNull())
+		throwError<TypeError>(kNullPointerError, "sourceRect");
+	if (destPoint.isNull())
+		throwError<TypeError>(kNullPointerError, "destPoint");
+	if (filter.isNull())
+		throwError<TypeError>(kNullPointerError, "filter");
+
+	RECT clippedSourceRect;
+	int32_t destX;
+	int32_t destY;
+	th->pixels->clipRect(sourceBitmapData->pixels, sourceRect->getRect(),
+			     destPoint->getX(), destPoint->getY(),
+			     clippedSourceRect, destX, destY);
+	int32_t width = clippedSourceRect.Xmax - clippedSourceRect.Xmin;
+	int32_t height = clippedSourceRect.Ymax - clippedSourceRect.Ymin;
+	if (width <= 0 || height <= 0)
+		return;
+
+	// The filter works on a copy, source and destination may be the same bitmap
+	vector<uint32_t> pixelvec = sourceBitmapData->pixels->getPixelVector(clippedSourceRect);
+	filter->applyFilter(&pixelvec[0], width, height);
+	if (!th->transparent)
+	{
+		// The premultiplied colors are the result over a black background
+		for (auto it = pixelvec.begin(); it != pixelvec.end(); ++it)
+			*it |= 0xff000000;
+	}
+	RECT destRect(destX, destX+width, destY, destY+height);
+	th->pixels->setPixelVector(destRect, pixelvec);
+	th->notifyUsers();
 }
 
 ASFUNCTIONBODY_ATOM(BitmapData,noise)
@@ -526,10 +526,17 @@ IDrawable* DisplayObject::invalidate(DisplayObject* target, const MATRIX& initia
 
 void DisplayObject::requestInvalidation(InvalidateQueue* q)
 {
+	geometryChanged();
 	//Let's invalidate also the mask
 	if(!mask.isNull())
 		mask->requestInvalidation(q);
 }
+void DisplayObject::geometryChanged()
+{
+	//The bounds of all the ancestors may depend on the ones of this object
+	for(DisplayObjectContainer* p=parent;p;p=p->getParent())
+		ATOMIC_INCREMENT(p->childrenGeometryEpoch);
+}
 //TODO: Fix precision issues, Adobe seems to do the matrix mult with twips and rounds the results, 
 //this way they have less pb with precision.
 void DisplayObject::localToGlobal(number_t xin, number_t yin, number_t& xout, number_t& yout) const
@@ -41,6 +41,7 @@ class DisplayObject: public EventDispatcher, public IBitmapDrawable
 {
 friend class TokenContainer;
 friend class GLRenderContext;
+friend class SoftwareRenderContext;
 friend class AsyncDrawJob;
 friend class Transform;
 friend class ParseThread;
@@ -171,6 +172,8 @@ public:
 	 */
 	virtual IDrawable* invalidate(DisplayObject* target, const MATRIX& initialMatrix, bool smoothing);
 	virtual void requestInvalidation(InvalidateQueue* q);
+	//Tells the ancestors that the matrix or the bounds of this object may have changed
+	void geometryChanged();
 	MATRIX getConcatenatedMatrix() const;
 	void localToGlobal(number_t xin, number_t yin, number_t& xout, number_t& yout) const;
 	void globalToLocal(number_t xin, number_t yin, number_t& xout, number_t& yout) const;
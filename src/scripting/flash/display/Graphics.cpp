@@ -101,8 +101,8 @@ ASFUNCTIONBODY_ATOM(Graphics,moveTo)
 	th->movex = x;
 	th->movey = y;
 	if (th->inFilling)
-		th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(MOVE, Vector2(x, y))));
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(MOVE, Vector2(x, y))));
+		th->owner->tokens.filltokens.moveTo(Vector2(x, y));
+	th->owner->tokens.stroketokens.moveTo(Vector2(x, y));
 }
 
 ASFUNCTIONBODY_ATOM(Graphics,lineTo)
@@ -115,8 +115,8 @@ ASFUNCTIONBODY_ATOM(Graphics,lineTo)
 	int y=asAtomHandler::toInt(args[1]);
 
 	if (th->inFilling)
-		th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(STRAIGHT, Vector2(x, y))));
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(STRAIGHT, Vector2(x, y))));
+		th->owner->tokens.filltokens.lineTo(Vector2(x, y));
+	th->owner->tokens.stroketokens.lineTo(Vector2(x, y));
 	th->hasChanged = true;
 	if (!th->inFilling)
 		th->dorender(false);
@@ -135,12 +135,10 @@ ASFUNCTIONBODY_ATOM(Graphics,curveTo)
 	int anchorY=asAtomHandler::toInt(args[3]);
 
 	if (th->inFilling)
-		th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(CURVE_QUADRATIC,
-	                        Vector2(controlX, controlY),
-	                        Vector2(anchorX, anchorY))));
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(CURVE_QUADRATIC,
-								Vector2(controlX, controlY),
-								Vector2(anchorX, anchorY))));
+		th->owner->tokens.filltokens.curveTo(Vector2(controlX, controlY),
+	                        Vector2(anchorX, anchorY));
+	th->owner->tokens.stroketokens.curveTo(Vector2(controlX, controlY),
+								Vector2(anchorX, anchorY));
 	th->hasChanged = true;
 	if (!th->inFilling)
 		th->dorender(false);
@@ -162,14 +160,12 @@ ASFUNCTIONBODY_ATOM(Graphics,cubicCurveTo)
 	int anchorY=asAtomHandler::toInt(args[5]);
 
 	if (th->inFilling)
-		th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(CURVE_CUBIC,
-	                        Vector2(control1X, control1Y),
+		th->owner->tokens.filltokens.cubicCurveTo(Vector2(control1X, control1Y),
 	                        Vector2(control2X, control2Y),
-	                        Vector2(anchorX, anchorY))));
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(CURVE_CUBIC,
-								Vector2(control1X, control1Y),
+	                        Vector2(anchorX, anchorY));
+	th->owner->tokens.stroketokens.cubicCurveTo(Vector2(control1X, control1Y),
 								Vector2(control2X, control2Y),
-								Vector2(anchorX, anchorY))));
+								Vector2(anchorX, anchorY));
 	th->hasChanged = true;
 	if (!th->inFilling)
 		th->dorender(false);
@@ -223,82 +219,74 @@ ASFUNCTIONBODY_ATOM(Graphics,drawRoundRect)
 	if (th->inFilling)
 	{
 		// D
-		th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(MOVE, Vector2(x+width, y+height-ellipseHeight))));
+		th->owner->tokens.filltokens.moveTo(Vector2(x+width, y+height-ellipseHeight));
 	
 		// D -> E
-		th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(CURVE_CUBIC,
-								Vector2(x+width, y+height-ellipseHeight+kappaH),
+		th->owner->tokens.filltokens.cubicCurveTo(Vector2(x+width, y+height-ellipseHeight+kappaH),
 								Vector2(x+width-ellipseWidth+kappaW, y+height),
-								Vector2(x+width-ellipseWidth, y+height))));
+								Vector2(x+width-ellipseWidth, y+height));
 	
 		// E -> F
-		th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(STRAIGHT, Vector2(x+ellipseWidth, y+height))));
+		th->owner->tokens.filltokens.lineTo(Vector2(x+ellipseWidth, y+height));
 	
 		// F -> G
-		th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(CURVE_CUBIC,
-								Vector2(x+ellipseWidth-kappaW, y+height),
+		th->owner->tokens.filltokens.cubicCurveTo(Vector2(x+ellipseWidth-kappaW, y+height),
 								Vector2(x, y+height-kappaH),
-								Vector2(x, y+height-ellipseHeight))));
+								Vector2(x, y+height-ellipseHeight));
 	
 		// G -> H
-		th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(STRAIGHT, Vector2(x, y+ellipseHeight))));
+		th->owner->tokens.filltokens.lineTo(Vector2(x, y+ellipseHeight));
 	
 		// H -> A
-		th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(CURVE_CUBIC,
-								Vector2(x, y+ellipseHeight-kappaH),
+		th->owner->tokens.filltokens.cubicCurveTo(Vector2(x, y+ellipseHeight-kappaH),
 								Vector2(x+ellipseWidth-kappaW, y),
-								Vector2(x+ellipseWidth, y))));
+								Vector2(x+ellipseWidth, y));
 	
 		// A -> B
-		th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(STRAIGHT, Vector2(x+width-ellipseWidth, y))));
+		th->owner->tokens.filltokens.lineTo(Vector2(x+width-ellipseWidth, y));
 	
 		// B -> C
-		th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(CURVE_CUBIC,
-								Vector2(x+width-ellipseWidth+kappaW, y),
+		th->owner->tokens.filltokens.cubicCurveTo(Vector2(x+width-ellipseWidth+kappaW, y),
 								Vector2(x+width, y+kappaH),
-								Vector2(x+width, y+ellipseHeight))));
+								Vector2(x+width, y+ellipseHeight));
 	
 		// C -> D
-		th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(STRAIGHT, Vector2(x+width, y+height-ellipseHeight))));
+		th->owner->tokens.filltokens.lineTo(Vector2(x+width, y+height-ellipseHeight));
 	}
 	// D
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(MOVE, Vector2(x+width, y+height-ellipseHeight))));
+	th->owner->tokens.stroketokens.moveTo(Vector2(x+width, y+height-ellipseHeight));
 
 	// D -> E
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(CURVE_CUBIC,
-							Vector2(x+width, y+height-ellipseHeight+kappaH),
+	th->owner->tokens.stroketokens.cubicCurveTo(Vector2(x+width, y+height-ellipseHeight+kappaH),
 							Vector2(x+width-ellipseWidth+kappaW, y+height),
-							Vector2(x+width-ellipseWidth, y+height))));
+							Vector2(x+width-ellipseWidth, y+height));
 
 	// E -> F
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(STRAIGHT, Vector2(x+ellipseWidth, y+height))));
+	th->owner->tokens.stroketokens.lineTo(Vector2(x+ellipseWidth, y+height));
 
 	// F -> G
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(CURVE_CUBIC,
-							Vector2(x+ellipseWidth-kappaW, y+height),
+	th->owner->tokens.stroketokens.cubicCurveTo(Vector2(x+ellipseWidth-kappaW, y+height),
 							Vector2(x, y+height-kappaH),
-							Vector2(x, y+height-ellipseHeight))));
+							Vector2(x, y+height-ellipseHeight));
 
 	// G -> H
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(STRAIGHT, Vector2(x, y+ellipseHeight))));
+	th->owner->tokens.stroketokens.lineTo(Vector2(x, y+ellipseHeight));
 
 	// H -> A
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(CURVE_CUBIC,
-							Vector2(x, y+ellipseHeight-kappaH),
+	th->owner->tokens.stroketokens.cubicCurveTo(Vector2(x, y+ellipseHeight-kappaH),
 							Vector2(x+ellipseWidth-kappaW, y),
-							Vector2(x+ellipseWidth, y))));
+							Vector2(x+ellipseWidth, y));
 
 	// A -> B
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(STRAIGHT, Vector2(x+width-ellipseWidth, y))));
+	th->owner->tokens.stroketokens.lineTo(Vector2(x+width-ellipseWidth, y));
 
 	// B -> C
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(CURVE_CUBIC,
-							Vector2(x+width-ellipseWidth+kappaW, y),
+	th->owner->tokens.stroketokens.cubicCurveTo(Vector2(x+width-ellipseWidth+kappaW, y),
 							Vector2(x+width, y+kappaH),
-							Vector2(x+width, y+ellipseHeight))));
+							Vector2(x+width, y+ellipseHeight));
 
 	// C -> D
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(STRAIGHT, Vector2(x+width, y+height-ellipseHeight))));
+	th->owner->tokens.stroketokens.lineTo(Vector2(x+width, y+height-ellipseHeight));
 	th->hasChanged = true;
 	th->dorender(true);
 }
@@ -322,17 +310,17 @@ ASFUNCTIONBODY_ATOM(Graphics,drawRoundRectComplex)
 
 	if (th->inFilling)
 	{
-		th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(MOVE, a)));
-		th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(STRAIGHT, b)));
-		th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(STRAIGHT, c)));
-		th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(STRAIGHT, d)));
-		th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(STRAIGHT, a)));
+		th->owner->tokens.filltokens.moveTo(a);
+		th->owner->tokens.filltokens.lineTo(b);
+		th->owner->tokens.filltokens.lineTo(c);
+		th->owner->tokens.filltokens.lineTo(d);
+		th->owner->tokens.filltokens.lineTo(a);
 	}	
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(MOVE, a)));
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(STRAIGHT, b)));
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(STRAIGHT, c)));
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(STRAIGHT, d)));
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(STRAIGHT, a)));
+	th->owner->tokens.stroketokens.moveTo(a);
+	th->owner->tokens.stroketokens.lineTo(b);
+	th->owner->tokens.stroketokens.lineTo(c);
+	th->owner->tokens.stroketokens.lineTo(d);
+	th->owner->tokens.stroketokens.lineTo(a);
 	th->hasChanged = true;
 	th->dorender(true);
 }
@@ -352,58 +340,50 @@ ASFUNCTIONBODY_ATOM(Graphics,drawCircle)
 	if (th->inFilling)
 	{
 		// right
-		th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(MOVE, Vector2(x+radius, y))));
+		th->owner->tokens.filltokens.moveTo(Vector2(x+radius, y));
 	
 		// bottom
-		th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(CURVE_CUBIC,
-								Vector2(x+radius, y+kappa ),
+		th->owner->tokens.filltokens.cubicCurveTo(Vector2(x+radius, y+kappa ),
 								Vector2(x+kappa , y+radius),
-								Vector2(x       , y+radius))));
+								Vector2(x       , y+radius));
 	
 		// left
-		th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(CURVE_CUBIC,
-								Vector2(x-kappa , y+radius),
+		th->owner->tokens.filltokens.cubicCurveTo(Vector2(x-kappa , y+radius),
 								Vector2(x-radius, y+kappa ),
-								Vector2(x-radius, y       ))));
+								Vector2(x-radius, y       ));
 	
 		// top
-		th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(CURVE_CUBIC,
-								Vector2(x-radius, y-kappa ),
+		th->owner->tokens.filltokens.cubicCurveTo(Vector2(x-radius, y-kappa ),
 								Vector2(x-kappa , y-radius),
-								Vector2(x       , y-radius))));
+								Vector2(x       , y-radius));
 	
 		// back to right
-		th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(CURVE_CUBIC,
-								Vector2(x+kappa , y-radius),
+		th->owner->tokens.filltokens.cubicCurveTo(Vector2(x+kappa , y-radius),
 								Vector2(x+radius, y-kappa ),
-								Vector2(x+radius, y       ))));
+								Vector2(x+radius, y       ));
 	}
 	// right
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(MOVE, Vector2(x+radius, y))));
+	th->owner->tokens.stroketokens.moveTo(Vector2(x+radius, y));
 
 	// bottom
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(CURVE_CUBIC,
-							Vector2(x+radius, y+kappa ),
+	th->owner->tokens.stroketokens.cubicCurveTo(Vector2(x+radius, y+kappa ),
 							Vector2(x+kappa , y+radius),
-							Vector2(x       , y+radius))));
+							Vector2(x       , y+radius));
 
 	// left
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(CURVE_CUBIC,
-							Vector2(x-kappa , y+radius),
+	th->owner->tokens.stroketokens.cubicCurveTo(Vector2(x-kappa , y+radius),
 							Vector2(x-radius, y+kappa ),
-							Vector2(x-radius, y       ))));
+							Vector2(x-radius, y       ));
 
 	// top
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(CURVE_CUBIC,
-							Vector2(x-radius, y-kappa ),
+	th->owner->tokens.stroketokens.cubicCurveTo(Vector2(x-radius, y-kappa ),
 							Vector2(x-kappa , y-radius),
-							Vector2(x       , y-radius))));
+							Vector2(x       , y-radius));
 
 	// back to right
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(CURVE_CUBIC,
-							Vector2(x+kappa , y-radius),
+	th->owner->tokens.stroketokens.cubicCurveTo(Vector2(x+kappa , y-radius),
 							Vector2(x+radius, y-kappa ),
-							Vector2(x+radius, y       ))));
+							Vector2(x+radius, y       ));
 	th->hasChanged = true;
 	th->dorender(true);
 }
@@ -425,58 +405,50 @@ ASFUNCTIONBODY_ATOM(Graphics,drawEllipse)
 	if (th->inFilling)
 	{
 		// right
-		th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(MOVE, Vector2(left+width, top+height/2.0))));
+		th->owner->tokens.filltokens.moveTo(Vector2(left+width, top+height/2.0));
 		
 		// bottom
-		th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(CURVE_CUBIC,
-								Vector2(left+width , top+height/2.0+ykappa),
+		th->owner->tokens.filltokens.cubicCurveTo(Vector2(left+width , top+height/2.0+ykappa),
 								Vector2(left+width/2.0+xkappa, top+height),
-								Vector2(left+width/2.0, top+height))));
+								Vector2(left+width/2.0, top+height));
 	
 		// left
-		th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(CURVE_CUBIC,
-								Vector2(left+width/2.0-xkappa, top+height),
+		th->owner->tokens.filltokens.cubicCurveTo(Vector2(left+width/2.0-xkappa, top+height),
 								Vector2(left, top+height/2.0+ykappa),
-								Vector2(left, top+height/2.0))));
+								Vector2(left, top+height/2.0));
 	
 		// top
-		th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(CURVE_CUBIC,
-								Vector2(left, top+height/2.0-ykappa),
+		th->owner->tokens.filltokens.cubicCurveTo(Vector2(left, top+height/2.0-ykappa),
 								Vector2(left+width/2.0-xkappa, top),
-								Vector2(left+width/2.0, top))));
+								Vector2(left+width/2.0, top));
 	
 		// back to right
-		th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(CURVE_CUBIC,
-								Vector2(left+width/2.0+xkappa, top),
+		th->owner->tokens.filltokens.cubicCurveTo(Vector2(left+width/2.0+xkappa, top),
 								Vector2(left+width, top+height/2.0-ykappa),
-								Vector2(left+width, top+height/2.0))));
+								Vector2(left+width, top+height/2.0));
 	}
 	// right
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(MOVE, Vector2(left+width, top+height/2.0))));
+	th->owner->tokens.stroketokens.moveTo(Vector2(left+width, top+height/2.0));
 	
 	// bottom
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(CURVE_CUBIC,
-							Vector2(left+width , top+height/2.0+ykappa),
+	th->owner->tokens.stroketokens.cubicCurveTo(Vector2(left+width , top+height/2.0+ykappa),
 							Vector2(left+width/2.0+xkappa, top+height),
-							Vector2(left+width/2.0, top+height))));
+							Vector2(left+width/2.0, top+height));
 
 	// left
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(CURVE_CUBIC,
-							Vector2(left+width/2.0-xkappa, top+height),
+	th->owner->tokens.stroketokens.cubicCurveTo(Vector2(left+width/2.0-xkappa, top+height),
 							Vector2(left, top+height/2.0+ykappa),
-							Vector2(left, top+height/2.0))));
+							Vector2(left, top+height/2.0));
 
 	// top
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(CURVE_CUBIC,
-							Vector2(left, top+height/2.0-ykappa),
+	th->owner->tokens.stroketokens.cubicCurveTo(Vector2(left, top+height/2.0-ykappa),
 							Vector2(left+width/2.0-xkappa, top),
-							Vector2(left+width/2.0, top))));
+							Vector2(left+width/2.0, top));
 
 	// back to right
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(CURVE_CUBIC,
-							Vector2(left+width/2.0+xkappa, top),
+	th->owner->tokens.stroketokens.cubicCurveTo(Vector2(left+width/2.0+xkappa, top),
 							Vector2(left+width, top+height/2.0-ykappa),
-							Vector2(left+width, top+height/2.0))));
+							Vector2(left+width, top+height/2.0));
 	th->hasChanged = true;
 	th->dorender(true);
 }
@@ -499,17 +471,17 @@ ASFUNCTIONBODY_ATOM(Graphics,drawRect)
 
 	if (th->inFilling)
 	{
-		th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(MOVE, a)));
-		th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(STRAIGHT, b)));
-		th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(STRAIGHT, c)));
-		th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(STRAIGHT, d)));
-		th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(STRAIGHT, a)));
+		th->owner->tokens.filltokens.moveTo(a);
+		th->owner->tokens.filltokens.lineTo(b);
+		th->owner->tokens.filltokens.lineTo(c);
+		th->owner->tokens.filltokens.lineTo(d);
+		th->owner->tokens.filltokens.lineTo(a);
 	}
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(MOVE, a)));
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(STRAIGHT, b)));
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(STRAIGHT, c)));
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(STRAIGHT, d)));
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(STRAIGHT, a)));
+	th->owner->tokens.stroketokens.moveTo(a);
+	th->owner->tokens.stroketokens.lineTo(b);
+	th->owner->tokens.stroketokens.lineTo(c);
+	th->owner->tokens.stroketokens.lineTo(d);
+	th->owner->tokens.stroketokens.lineTo(a);
 	th->hasChanged = true;
 	th->dorender(true);
 }
@@ -535,7 +507,7 @@ ASFUNCTIONBODY_ATOM(Graphics,drawPath)
 }
 
 void Graphics::pathToTokens(_NR<Vector> commands, _NR<Vector> data,
-			    tiny_string winding, std::vector<_NR<GeomToken>, reporter_allocator<_NR<GeomToken>>>& tokens)
+			    tiny_string winding, GeomTokenList& tokens)
 {
 	if (commands.isNull() || data.isNull())
 		return;
@@ -543,90 +515,67 @@ void Graphics::pathToTokens(_NR<Vector> commands, _NR<Vector> data,
 	if (winding != "evenOdd")
 		LOG(LOG_NOT_IMPLEMENTED, "Only event-odd winding implemented in Graphics.drawPath");
 
-	asAtom zero = asAtomHandler::fromInt(0);
-
 	int k = 0;
 	for (unsigned int i=0; i<commands->size(); i++)
 	{
-		asAtom c = commands->at(i);
-		switch (asAtomHandler::toInt(c))
+		switch (commands->getInt(i))
 		{
 			case GraphicsPathCommand::MOVE_TO:
 			{
-				asAtom ax = data->at(k++, zero);
-				asAtom ay = data->at(k++, zero);
-				number_t x = asAtomHandler::toNumber(ax);
-				number_t y = asAtomHandler::toNumber(ay);
-				tokens.emplace_back(_MR(new GeomToken(MOVE, Vector2(x, y))));
+				number_t x = data->getNumber(k++, 0);
+				number_t y = data->getNumber(k++, 0);
+				tokens.moveTo(Vector2(x, y));
 				break;
 			}
 
 			case GraphicsPathCommand::LINE_TO:
 			{
-				asAtom ax = data->at(k++, zero);
-				asAtom ay = data->at(k++, zero);
-				number_t x = asAtomHandler::toNumber(ax);
-				number_t y = asAtomHandler::toNumber(ay);
-				tokens.emplace_back(_MR(new GeomToken(STRAIGHT, Vector2(x, y))));
+				number_t x = data->getNumber(k++, 0);
+				number_t y = data->getNumber(k++, 0);
+				tokens.lineTo(Vector2(x, y));
 				break;
 			}
 
 			case GraphicsPathCommand::CURVE_TO:
 			{
-				asAtom acx = data->at(k++, zero);
-				asAtom acy = data->at(k++, zero);
-				number_t cx = asAtomHandler::toNumber(acx);
-				number_t cy = asAtomHandler::toNumber(acy);
-				asAtom ax = data->at(k++, zero);
-				asAtom ay = data->at(k++, zero);
-				number_t x = asAtomHandler::toNumber(ax);
-				number_t y = asAtomHandler::toNumber(ay);
-				tokens.emplace_back(_MR(new GeomToken(CURVE_QUADRATIC,
-							      Vector2(cx, cy),
-							      Vector2(x, y))));
+				number_t cx = data->getNumber(k++, 0);
+				number_t cy = data->getNumber(k++, 0);
+				number_t x = data->getNumber(k++, 0);
+				number_t y = data->getNumber(k++, 0);
+				tokens.curveTo(Vector2(cx, cy),
+							      Vector2(x, y));
 				break;
 			}
 
 			case GraphicsPathCommand::WIDE_MOVE_TO:
 			{
 				k+=2;
-				asAtom ax = data->at(k++, zero);
-				asAtom ay = data->at(k++, zero);
-				number_t x = asAtomHandler::toNumber(ax);
-				number_t y = asAtomHandler::toNumber(ay);
-				tokens.emplace_back(_MR(new GeomToken(MOVE, Vector2(x, y))));
+				number_t x = data->getNumber(k++, 0);
+				number_t y = data->getNumber(k++, 0);
+				tokens.moveTo(Vector2(x, y));
 				break;
 			}
 
 			case GraphicsPathCommand::WIDE_LINE_TO:
 			{
 				k+=2;
-				asAtom ax = data->at(k++, zero);
-				asAtom ay = data->at(k++, zero);
-				number_t x = asAtomHandler::toNumber(ax);
-				number_t y = asAtomHandler::toNumber(ay);
-				tokens.emplace_back(_MR(new GeomToken(STRAIGHT, Vector2(x, y))));
+				number_t x = data->getNumber(k++, 0);
+				number_t y = data->getNumber(k++, 0);
+				tokens.lineTo(Vector2(x, y));
 				break;
 			}
 
 			case GraphicsPathCommand::CUBIC_CURVE_TO:
 			{
-				asAtom ac1x = data->at(k++, zero);
-				asAtom ac1y = data->at(k++, zero);
-				asAtom ac2x = data->at(k++, zero);
-				asAtom ac2y = data->at(k++, zero);
-				number_t c1x = asAtomHandler::toNumber(ac1x);
-				number_t c1y = asAtomHandler::toNumber(ac1y);
-				number_t c2x = asAtomHandler::toNumber(ac2x);
-				number_t c2y = asAtomHandler::toNumber(ac2y);
-				asAtom ax = data->at(k++, zero);
-				asAtom ay = data->at(k++, zero);
-				number_t x = asAtomHandler::toNumber(ax);
-				number_t y = asAtomHandler::toNumber(ay);
-				tokens.emplace_back(_MR(new GeomToken(CURVE_CUBIC,
-							      Vector2(c1x, c1y),
+				number_t c1x = data->getNumber(k++, 0);
+				number_t c1y = data->getNumber(k++, 0);
+				number_t c2x = data->getNumber(k++, 0);
+				number_t c2y = data->getNumber(k++, 0);
+				number_t x = data->getNumber(k++, 0);
+				number_t y = data->getNumber(k++, 0);
+				tokens.cubicCurveTo(Vector2(c1x, c1y),
 							      Vector2(c2x, c2y),
-							      Vector2(x, y))));
+							      Vector2(x, y));
 				break;
 			}
 
@@ -682,8 +631,8 @@ void Graphics::dorender(bool closepath)
 	{
 		if (inFilling && closepath)
 		{
-			owner->tokens.filltokens.emplace_back(_MR(new GeomToken(STRAIGHT, Vector2(movex, movey))));
-			owner->tokens.filltokens.emplace_back(_MR(new GeomToken(CLEAR_FILL)));
+			owner->tokens.filltokens.lineTo(Vector2(movex, movey));
+			owner->tokens.filltokens.command(CLEAR_FILL);
 		}
 		owner->owner->hasChanged=true;
 		owner->owner->requestInvalidation(getSystemState());
@@ -703,14 +652,14 @@ ASFUNCTIONBODY_ATOM(Graphics,drawTriangles)
 	ARG_UNPACK_ATOM (vertices) (indices, NullRef) (uvtData, NullRef) (culling, "none");
 
 	if (th->inFilling)
-		drawTrianglesToTokens(vertices, indices, uvtData, culling, th->owner->tokens.filltokens);
-	drawTrianglesToTokens(vertices, indices, uvtData, culling, th->owner->tokens.stroketokens);
+		drawTrianglesToTokens(vertices, indices, uvtData, culling, th->owner->tokens, th->owner->tokens.filltokens);
+	drawTrianglesToTokens(vertices, indices, uvtData, culling, th->owner->tokens, th->owner->tokens.stroketokens);
 	th->hasChanged = true;
 	if (!th->inFilling)
 		th->dorender(true);
 }
 
-void Graphics::drawTrianglesToTokens(_NR<Vector> vertices, _NR<Vector> indices, _NR<Vector> uvtData, tiny_string culling, std::vector<_NR<GeomToken>, reporter_allocator<_NR<GeomToken>> > &tokens)
+void Graphics::drawTrianglesToTokens(_NR<Vector> vertices, _NR<Vector> indices, _NR<Vector> uvtData, tiny_string culling, tokensVector& tokens, GeomTokenList& list)
 {
 	if (culling != "none")
 		LOG(LOG_NOT_IMPLEMENTED, "Graphics.drawTriangles doesn't support culling");
@@ -755,12 +704,12 @@ void Graphics::drawTrianglesToTokens(_NR<Vector> vertices, _NR<Vector> indices,
 			throwError<ArgumentError>(kInvalidParamError);
 		}
 
-		TokenContainer::getTextureSize(tokens, &texturewidth, &textureheight);
+		TokenContainer::getTextureSize(tokens, list, &texturewidth, &textureheight);
 	}
 
 	// According to testing, drawTriangles first fills the current
 	// path and creates a new path, but keeps the source.
-	tokens.emplace_back(_MR(new GeomToken(FILL_KEEP_SOURCE)));
+	list.command(FILL_KEEP_SOURCE);
 
 	if (has_uvt && (texturewidth==0 || textureheight==0))
 		return;
@@ -776,21 +725,16 @@ void Graphics::drawTrianglesToTokens(_NR<Vector> vertices, _NR<Vector> indices,
 				vertex=3*i+j;
 			else
 			{
-				asAtom a =indices->at(3*i+j);
-				vertex=asAtomHandler::toInt(a);
+				vertex=indices->getInt(3*i+j);
 			}
 
-			asAtom ax = vertices->at(2*vertex);
-			x[j]=asAtomHandler::toNumber(ax);
-			asAtom ay = vertices->at(2*vertex+1);
-			y[j]=asAtomHandler::toNumber(ay);;
+			x[j]=vertices->getNumber(2*vertex);
+			y[j]=vertices->getNumber(2*vertex+1);
 
 			if (has_uvt)
 			{
-				asAtom au = uvtData->at(vertex*uvtElemSize);
-				u[j]=asAtomHandler::toNumber(au)*texturewidth;
-				asAtom av = uvtData->at(vertex*uvtElemSize+1);
-				v[j]=asAtomHandler::toNumber(av)*textureheight;
+				u[j]=uvtData->getNumber(vertex*uvtElemSize)*texturewidth;
+				v[j]=uvtData->getNumber(vertex*uvtElemSize+1)*textureheight;
 			}
 		}
 		
@@ -798,10 +742,10 @@ void Graphics::drawTrianglesToTokens(_NR<Vector> vertices, _NR<Vector> indices,
 		Vector2 b(x[1], y[1]);
 		Vector2 c(x[2], y[2]);
 
-		tokens.emplace_back(_MR(new GeomToken(MOVE, a)));
-		tokens.emplace_back(_MR(new GeomToken(STRAIGHT, b)));
-		tokens.emplace_back(_MR(new GeomToken(STRAIGHT, c)));
-		tokens.emplace_back(_MR(new GeomToken(STRAIGHT, a)));
+		list.moveTo(a);
+		list.lineTo(b);
+		list.lineTo(c);
+		list.lineTo(a);
 
 		if (has_uvt)
 		{
@@ -823,7 +767,7 @@ void Graphics::drawTrianglesToTokens(_NR<Vector> vertices, _NR<Vector> indices,
 					   v[0], v[1], v[2], &t[3]);
 
 			MATRIX m(t[1], t[5], t[4], t[2], t[0], t[3]);
-			tokens.emplace_back(_MR(new GeomToken(FILL_TRANSFORM_TEXTURE, m)));
+			tokens.transformTexture(list, m);
 		}
 	}
 }
@@ -845,7 +789,7 @@ ASFUNCTIONBODY_ATOM(Graphics,drawGraphicsData)
 			continue;
 		}
 
-		graphElement->appendToTokens(th->owner->tokens.filltokens);
+		graphElement->appendToTokens(th->owner->tokens);
 	}
 	th->hasChanged = true;
 	if (!th->inFilling)
@@ -859,7 +803,7 @@ ASFUNCTIONBODY_ATOM(Graphics,lineStyle)
 
 	if (argslen == 0)
 	{
-		th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(CLEAR_STROKE)));
+		th->owner->tokens.stroketokens.command(CLEAR_STROKE);
 		return;
 	}
 	number_t thickness;
@@ -913,7 +857,7 @@ ASFUNCTIONBODY_ATOM(Graphics,lineStyle)
 	else if (joints == "miter")
 		style.JointStyle = 2;
 	style.MiterLimitFactor = miterLimit;
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(SET_STROKE, style)));
+	th->owner->tokens.setStroke(th->owner->tokens.stroketokens, style);
 }
 
 ASFUNCTIONBODY_ATOM(Graphics,lineBitmapStyle)
@@ -934,7 +878,7 @@ ASFUNCTIONBODY_ATOM(Graphics,lineBitmapStyle)
 	style.HasFillFlag = true;
 	style.FillType = createBitmapFill(bitmap, matrix, repeat, smooth);
 	
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(SET_STROKE, style)));
+	th->owner->tokens.setStroke(th->owner->tokens.stroketokens, style);
 }
 
 ASFUNCTIONBODY_ATOM(Graphics,lineGradientStyle)
@@ -960,7 +904,7 @@ ASFUNCTIONBODY_ATOM(Graphics,lineGradientStyle)
 					    spreadMethod, interpolationMethod,
 					    focalPointRatio);
 
-	th->owner->tokens.stroketokens.emplace_back(_MR(new GeomToken(SET_STROKE, style)));
+	th->owner->tokens.setStroke(th->owner->tokens.stroketokens, style);
 }
 
 ASFUNCTIONBODY_ATOM(Graphics,beginGradientFill)
@@ -993,7 +937,7 @@ ASFUNCTIONBODY_ATOM(Graphics,beginGradientFill)
 					     spreadMethod, interpolationMethod,
 					     focalPointRatio);
 	th->inFilling=true;
-	th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(SET_FILL, style)));
+	th->owner->tokens.setFill(th->owner->tokens.filltokens, style);
 }
 
 FILLSTYLE Graphics::createGradientFill(const tiny_string& type,
@@ -1112,7 +1056,7 @@ ASFUNCTIONBODY_ATOM(Graphics,beginBitmapFill)
 	th->inFilling=true;
 
 	FILLSTYLE style=createBitmapFill(bitmap, matrix, repeat, smooth);
-	th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(SET_FILL, style)));
+	th->owner->tokens.setFill(th->owner->tokens.filltokens, style);
 }
 
 ASFUNCTIONBODY_ATOM(Graphics,beginFill)
@@ -1128,7 +1072,7 @@ ASFUNCTIONBODY_ATOM(Graphics,beginFill)
 		alpha=(uint8_t(asAtomHandler::toNumber(args[1])*0xff));
 	th->inFilling=true;
 	FILLSTYLE style = Graphics::createSolidFill(color, alpha);
-	th->owner->tokens.filltokens.emplace_back(_MR(new GeomToken(SET_FILL, style)));
+	th->owner->tokens.setFill(th->owner->tokens.filltokens, style);
 }
 
 ASFUNCTIONBODY_ATOM(Graphics,endFill)
@@ -1150,9 +1094,6 @@ ASFUNCTIONBODY_ATOM(Graphics,copyFrom)
 	if (source.isNull())
 		return;
 
-	th->owner->tokens.filltokens.assign(source->owner->tokens.filltokens.begin(),
-				 source->owner->tokens.filltokens.end());
-	th->owner->tokens.stroketokens.assign(source->owner->tokens.stroketokens.begin(),
-				 source->owner->tokens.stroketokens.end());
+	th->owner->tokens.assign(source->owner->tokens);
 	th->hasChanged = true;
 }
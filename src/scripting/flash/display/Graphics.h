@@ -74,12 +74,13 @@ public:
 	static void pathToTokens(_NR<Vector> commands,
 				 _NR<Vector> data,
 				 tiny_string windings,
-				 std::vector<_NR<GeomToken>, reporter_allocator<_NR<GeomToken>> > &tokens);
+				 GeomTokenList& tokens);
 	static void drawTrianglesToTokens(_NR<Vector> vertices,
 					  _NR<Vector> indices,
 					  _NR<Vector> uvtData,
 					  tiny_string culling,
-					  std::vector<_NR<GeomToken>, reporter_allocator<_NR<GeomToken>>> &tokens);
+					  tokensVector& tokens,
+					  GeomTokenList& list);
 	ASFUNCTION_ATOM(_constructor);
 	ASFUNCTION_ATOM(lineBitmapStyle);
 	ASFUNCTION_ATOM(lineGradientStyle);
@@ -61,8 +61,8 @@ FILLSTYLE GraphicsBitmapFill::toFillStyle()
 	return Graphics::createBitmapFill(bitmapData, matrix, repeat, smooth);
 }
 
-void GraphicsBitmapFill::appendToTokens(std::vector<_NR<GeomToken>, reporter_allocator<_NR<GeomToken>> > &tokens)
+void GraphicsBitmapFill::appendToTokens(tokensVector& tokens)
 {
 
-	tokens.emplace_back(_MR(new GeomToken(SET_FILL, toFillStyle())));
+	tokens.setFill(tokens.filltokens, toFillStyle());
 }
@@ -33,7 +33,7 @@ public:
 	GraphicsEndFill(Class_base* c);
 	static void sinit(Class_base* c);
 		FILLSTYLE toFillStyle();
-		void appendToTokens(std::vector<_NR<GeomToken>, reporter_allocator<_NR<GeomToken> > > &tokens);
+		void appendToTokens(tokensVector& tokens);
 };
 
 };
@@ -88,7 +88,7 @@ FILLSTYLE GraphicsGradientFill::toFillStyle()
 		matrix, spreadMethod, interpolationMethod, focalPointRatio);
 }
 
-void GraphicsGradientFill::appendToTokens(std::vector<_NR<GeomToken>, reporter_allocator<_NR<GeomToken>> > &tokens)
+void GraphicsGradientFill::appendToTokens(tokensVector& tokens)
 {
-	tokens.emplace_back(_MR(new GeomToken(SET_FILL, toFillStyle())));
+	tokens.setFill(tokens.filltokens, toFillStyle());
 }
@@ -34,8 +34,8 @@ protected:
 	virtual ~IGraphicsData() {}
 public:
 	static void linkTraits(Class_base* c) {}
-	// Appends GeomTokens for drawing this object into tokens
-	virtual void appendToTokens(std::vector<_NR<GeomToken>, reporter_allocator<_NR<GeomToken>>>& tokens) = 0;
+	// Appends the commands for drawing this object to tokens.filltokens
+	virtual void appendToTokens(tokensVector& tokens) = 0;
 };
 
 };
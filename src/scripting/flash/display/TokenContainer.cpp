@@ -34,8 +34,7 @@ TokenContainer::TokenContainer(DisplayObject* _o, MemoryAccount* _m, const token
 	owner(_o), tokens(reporter_allocator<GeomToken>(_m)), scaling(_scaling)
 
 {
-	tokens.filltokens.assign(_tokens.filltokens.begin(),_tokens.filltokens.end());
-	tokens.stroketokens.assign(_tokens.stroketokens.begin(),_tokens.stroketokens.end());
+	tokens.assign(_tokens);
 }
 
 bool TokenContainer::renderImpl(RenderContext& ctxt) const
@@ -240,7 +239,9 @@ _NR<DisplayObject> TokenContainer::hitTestImpl(_NR<DisplayObject> last, number_t
 {
 	//Masks have been already checked along the way
 
-	if(CairoTokenRenderer::hitTest(tokens, scaling, x, y))
+	Locker l(hitPathMutex);
+	hitPath.update(tokens, scaling);
+	if(hitPath.contains(x, y))
 		return last;
 	return NullRef;
 }
@@ -265,74 +266,39 @@ bool TokenContainer::boundsRect(number_t& xmin, number_t& xmax, number_t& ymin,
 	bool hasContent = false;
 	double strokeWidth = 0;
 
-	for(unsigned int i=0;i<tokens.filltokens.size();i++)
+	const GeomTokenList* lists[2]={&tokens.filltokens,&tokens.stroketokens};
+	for(const GeomTokenList* list: lists)
 	{
-		switch(tokens.filltokens[i]->type)
+		for(unsigned int i=0;i<list->size();i++)
 		{
-			case CURVE_CUBIC:
+			const GeomToken& cmd=(*list)[i];
+			switch(cmd.cmd.type)
 			{
-				VECTOR_BOUNDS(tokens.filltokens[i]->p3);
+				case CURVE_CUBIC:
+				case CURVE_QUADRATIC:
+				case STRAIGHT:
+					hasContent = true;
+					// falls through
+				case MOVE:
+				{
+					uint32_t points=GeomTokenList::pointCount(cmd.cmd.type);
+					for(uint32_t j=0;j<points;j++)
+					{
+						Vector2 v=(*list)[++i].point();
+						VECTOR_BOUNDS(v);
+					}
+					break;
+				}
+				case CLEAR_FILL:
+				case CLEAR_STROKE:
+				case SET_FILL:
+				case FILL_KEEP_SOURCE:
+				case FILL_TRANSFORM_TEXTURE:
+					break;
+				case SET_STROKE:
+					strokeWidth = (double)(tokens.lineStyles[cmd.cmd.index].Width / 20.0);
+					break;
 			}
-			// falls through
-			case CURVE_QUADRATIC:
-			{
-				VECTOR_BOUNDS(tokens.filltokens[i]->p2);
-			}
-			// falls through
-			case STRAIGHT:
-			{
-				hasContent = true;
-			}
-			// falls through
-			case MOVE:
-			{
-				VECTOR_BOUNDS(tokens.filltokens[i]->p1);
-				break;
-			}
-			case CLEAR_FILL:
-			case CLEAR_STROKE:
-			case SET_FILL:
-			case FILL_KEEP_SOURCE:
-			case FILL_TRANSFORM_TEXTURE:
-				break;
-			case SET_STROKE:
-				strokeWidth = (double)(tokens.filltokens[i]->lineStyle.Width / 20.0);
-				break;
-		}
-	}
-	for(unsigned int i=0;i<tokens.stroketokens.size();i++)
-	{
-		switch(tokens.stroketokens[i]->type)
-		{
-			case CURVE_CUBIC:
-			{
-				VECTOR_BOUNDS(tokens.stroketokens[i]->p3);
-			}
-			// falls through
-			case CURVE_QUADRATIC:
-			{
-				VECTOR_BOUNDS(tokens.stroketokens[i]->p2);
-			}
-			// falls through
-			case STRAIGHT:
-			{
-				hasContent = true;
-			}
-			// falls through
-			case MOVE:
-			{
-				VECTOR_BOUNDS(tokens.stroketokens[i]->p1);
-				break;
-			}
-			case CLEAR_FILL:
-			case CLEAR_STROKE:
-			case SET_FILL:
-			case FILL_KEEP_SOURCE:
-			case FILL_TRANSFORM_TEXTURE:
-				break;
-			case SET_STROKE:
-				strokeWidth = (double)(tokens.stroketokens[i]->lineStyle.Width / 20.0);
-				break;
 		}
 	}
 	if(hasContent)
@@ -355,41 +321,44 @@ bool TokenContainer::boundsRect(number_t& xmin, number_t& xmax, number_t& ymin,
 }
 
 /* Find the size of the active texture (bitmap set by the latest SET_FILL). */
-void TokenContainer::getTextureSize(std::vector<_NR<GeomToken>, reporter_allocator<_NR<GeomToken>>>& tokens, int *width, int *height)
+void TokenContainer::getTextureSize(const tokensVector& tokens, const GeomTokenList& list, int *width, int *height)
 {
 	*width=0;
 	*height=0;
 
-	for(int i=tokens.size()-1;i>=0;i--)
+	const FILLSTYLE* style=nullptr;
+	for(uint32_t i=0;i<list.size();i++)
 	{
-		const FILLSTYLE& style=tokens[i]->fillStyle;
-		const FILL_STYLE_TYPE& fstype=style.FillStyleType;
-		if(tokens[i]->type==SET_FILL && 
-		   (fstype==REPEATING_BITMAP ||
-		    fstype==NON_SMOOTHED_REPEATING_BITMAP ||
-		    fstype==CLIPPED_BITMAP ||
-		    fstype==NON_SMOOTHED_CLIPPED_BITMAP))
+		const GeomToken& cmd=list[i];
+		if(cmd.cmd.type==SET_FILL)
 		{
-			if (style.bitmap.isNull())
-				return;
-
-			*width=style.bitmap->getWidth();
-			*height=style.bitmap->getHeight();
-			return;
+			const FILL_STYLE_TYPE& fstype=tokens.fillStyles[cmd.cmd.index].FillStyleType;
+			if(fstype==REPEATING_BITMAP ||
+			   fstype==NON_SMOOTHED_REPEATING_BITMAP ||
+			   fstype==CLIPPED_BITMAP ||
+			   fstype==NON_SMOOTHED_CLIPPED_BITMAP)
+				style=&tokens.fillStyles[cmd.cmd.index];
 		}
+		i+=GeomTokenList::pointCount(cmd.cmd.type);
 	}
+	if(style==nullptr || style->bitmap.isNull())
+		return;
+
+	style->bitmap->ensureDecoded();
+	*width=style->bitmap->getWidth();
+	*height=style->bitmap->getHeight();
 }
 
 /* Return the width of the latest SET_STROKE */
 uint16_t TokenContainer::getCurrentLineWidth() const
 {
-	for(int i=tokens.stroketokens.size()-1;i>=0;i--)
+	uint16_t ret=0;
+	for(uint32_t i=0;i<tokens.stroketokens.size();i++)
 	{
-		if(tokens.stroketokens[i]->type==SET_STROKE)
-		{
-			return tokens.stroketokens[i]->lineStyle.Width;
-		}
+		const GeomToken& cmd=tokens.stroketokens[i];
+		if(cmd.cmd.type==SET_STROKE)
+			ret=tokens.lineStyles[cmd.cmd.index].Width;
+		i+=GeomTokenList::pointCount(cmd.cmd.type);
 	}
-
-	return 0;
+	return ret;
 }
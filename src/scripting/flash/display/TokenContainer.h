@@ -55,9 +55,14 @@ public:
 					 const MATRIX& matrix = MATRIX(), const std::list<LINESTYLE2>& lineStyles = std::list<LINESTYLE2>());
 	static void FromDefineMorphShapeTagToShapeVector(SystemState *sys, DefineMorphShapeTag *tag,
 					 tokensVector& tokens, uint16_t ratio);
-	static void getTextureSize(std::vector<_NR<GeomToken>, reporter_allocator<_NR<GeomToken>>> &tokens, int *width, int *height);
+	static void getTextureSize(const tokensVector& tokens, const GeomTokenList& list, int *width, int *height);
 	uint16_t getCurrentLineWidth() const;
 	float scaling;
+private:
+	//Fill of the tokens used by hitTestImpl
+	mutable FlattenedPath hitPath;
+	//hitTestImpl runs in the input thread and in the VM thread for hitTestPoint
+	mutable Mutex hitPathMutex;
 protected:
 	TokenContainer(DisplayObject* _o, MemoryAccount* _m);
 	TokenContainer(DisplayObject* _o, MemoryAccount* _m, const tokensVector& _tokens, float _scaling);
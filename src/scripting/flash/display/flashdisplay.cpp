@@ -31,11 +31,13 @@
 #include "compat.h"
 #include "scripting/class.h"
 #include "backends/rendering.h"
+#include "backends/softwarerendering.h"
 #include "backends/geometry.h"
 #include "backends/input.h"
 #include "scripting/flash/accessibility/flashaccessibility.h"
 #include "scripting/flash/media/flashmedia.h"
 #include "scripting/flash/display/BitmapData.h"
+#include "scripting/flash/display3d/softwarecontext3d.h"
 #include "scripting/argconv.h"
 #include "scripting/toplevel/Vector.h"
 #include "scripting/avm1/avm1text.h"
@@ -1023,6 +1025,110 @@ bool Sprite::renderImpl(RenderContext& ctxt) const
 	return ret && ret2;
 }
 
+void DisplayObjectContainer::buildHitGrid()
+{
+	hitGridValid=true;
+	hitGridEpoch=childrenGeometryEpoch;
+	hitGridCells.clear();
+	hitGridUnbounded.clear();
+	const uint32_t count=dynamicDisplayList.size();
+	hitGridChildren.resize(count);
+	struct childBounds
+	{
+		number_t xmin,xmax,ymin,ymax;
+	};
+	std::vector<childBounds> bounds(count);
+	std::vector<bool> bounded(count,false);
+	number_t gxmin=numeric_limits<number_t>::infinity();
+	number_t gymin=numeric_limits<number_t>::infinity();
+	number_t gxmax=-numeric_limits<number_t>::infinity();
+	number_t gymax=-numeric_limits<number_t>::infinity();
+	for(uint32_t i=0;i<count;i++)
+	{
+		DisplayObject* child=dynamicDisplayList[i].getPtr();
+		hitGridChildren[i]=child;
+		//Buttons are hit through their hitTestState, not their current state
+		if(dynamic_cast<SimpleButton*>(child))
+			continue;
+		childBounds& r=bounds[i];
+		if(!child->getBounds(r.xmin,r.xmax,r.ymin,r.ymax,child->getMatrix()))
+			continue;
+		//Leave some room for the rounding of the hit tests
+		r.xmin-=1;
+		r.ymin-=1;
+		r.xmax+=1;
+		r.ymax+=1;
+		bounded[i]=true;
+		gxmin=min(gxmin,r.xmin);
+		gymin=min(gymin,r.ymin);
+		gxmax=max(gxmax,r.xmax);
+		gymax=max(gymax,r.ymax);
+	}
+	int32_t side=ceil(sqrt(number_t(count)));
+	side=min(side,HIT_GRID_MAX_SIDE);
+	hitGridColumns=gxmax>gxmin ? side : 0;
+	hitGridRows=gymax>gymin ? side : 0;
+	if(hitGridColumns)
+	{
+		hitGridX=gxmin;
+		hitGridY=gymin;
+		hitGridCellWidth=(gxmax-gxmin)/hitGridColumns;
+		hitGridCellHeight=(gymax-gymin)/hitGridRows;
+		hitGridCells.resize(hitGridColumns*hitGridRows);
+	}
+	//The children are visited in order, so the indices in the cells are ascending
+	for(uint32_t i=0;i<count;i++)
+	{
+		if(!bounded[i] || hitGridCells.empty())
+		{
+			hitGridUnbounded.push_back(i);
+			continue;
+		}
+		const childBounds& r=bounds[i];
+		int32_t x0=max(0,min(hitGridColumns-1,int32_t((r.xmin-hitGridX)/hitGridCellWidth)));
+		int32_t x1=max(0,min(hitGridColumns-1,int32_t((r.xmax-hitGridX)/hitGridCellWidth)));
+		int32_t y0=max(0,min(hitGridRows-1,int32_t((r.ymin-hitGridY)/hitGridCellHeight)));
+		int32_t y1=max(0,min(hitGridRows-1,int32_t((r.ymax-hitGridY)/hitGridCellHeight)));
+		if((x1-x0+1)*(y1-y0+1)>HIT_GRID_MAX_CELLS_PER_CHILD)
+		{
+			hitGridUnbounded.push_back(i);
+			continue;
+		}
+		for(int32_t y=y0;y<=y1;y++)
+		{
+			for(int32_t x=x0;x<=x1;x++)
+				hitGridCells[y*hitGridColumns+x].push_back(i);
+		}
+	}
+}
+
+const std::vector<uint32_t>* DisplayObjectContainer::getHitCandidates(number_t x, number_t y)
+{
+	//Only objects on the stage are invalidated, so only their changes advance the epoch
+	if(!isOnStage() || dynamicDisplayList.size()<HIT_GRID_MIN_CHILDREN)
+	{
+		hitGridValid=false;
+		return nullptr;
+	}
+	bool changed=!hitGridValid || hitGridEpoch!=childrenGeometryEpoch ||
+			hitGridChildren.size()!=dynamicDisplayList.size();
+	for(uint32_t i=0;!changed && i<dynamicDisplayList.size();i++)
+		changed=hitGridChildren[i]!=dynamicDisplayList[i].getPtr();
+	if(changed)
+		buildHitGrid();
+
+	int32_t column=floor((x-hitGridX)/hitGridCellWidth);
+	int32_t row=floor((y-hitGridY)/hitGridCellHeight);
+	if(column<0 || column>=hitGridColumns || row<0 || row>=hitGridRows)
+		return &hitGridUnbounded;
+	const std::vector<uint32_t>& cell=hitGridCells[row*hitGridColumns+column];
+	if(hitGridUnbounded.empty())
+		return &cell;
+	hitGridMerged.resize(cell.size()+hitGridUnbounded.size());
+	std::merge(cell.begin(),cell.end(),hitGridUnbounded.begin(),hitGridUnbounded.end(),hitGridMerged.begin());
+	return &hitGridMerged;
+}
+
 /*
 Subclasses of DisplayObjectContainer must still check
 isHittable() to see if they should send out events.
@@ -1032,20 +1138,22 @@ _NR<DisplayObject> DisplayObjectContainer::hitTestImpl(_NR<DisplayObject> last,
 	_NR<DisplayObject> ret = NullRef;
 	//Test objects added at runtime, in reverse order
 	Locker l(mutexDisplayList);
-	std::vector<_R<DisplayObject>>::const_reverse_iterator j=dynamicDisplayList.rbegin();
-	for(;j!=dynamicDisplayList.rend();++j)
+	const std::vector<uint32_t>* candidates=getHitCandidates(x,y);
+	int32_t count=candidates ? candidates->size() : dynamicDisplayList.size();
+	for(int32_t i=count-1;i>=0;i--)
 	{
+		const _R<DisplayObject>& child=dynamicDisplayList[candidates ? (*candidates)[i] : i];
 		//Don't check masks
-		if((*j)->isMask())
+		if(child->isMask())
 			continue;
 
-		if(!(*j)->getMatrix().isInvertible())
+		if(!child->getMatrix().isInvertible())
 			continue; /* The object is shrunk to zero size */
 
 		number_t localX, localY;
-		(*j)->getMatrix().getInverted().multiply2D(x,y,localX,localY);
+		child->getMatrix().getInverted().multiply2D(x,y,localX,localY);
 		this->incRef();
-		ret=(*j)->hitTest(_MR(this), localX,localY, mouseChildren ? type : GENERIC_HIT,interactiveObjectsOnly);
+		ret=child->hitTest(_MR(this), localX,localY, mouseChildren ? type : GENERIC_HIT,interactiveObjectsOnly);
 		if(!ret.isNull())
 		{
 			if (interactiveObjectsOnly && !ret->is<InteractiveObject>() && mouseChildren)
@@ -1823,7 +1931,7 @@ bool MovieClip::AVM1HandleKeyboardEvent(KeyboardEvent *e)
 				(e->type == "keyUp" && it->EventFlags.ClipEventKeyDown))
 		{
 			std::map<uint32_t,asAtom> m;
-			ACTIONRECORD::executeActions(this,this->getCurrentFrame()->getAVM1Context(),it->actions,it->startactionpos,m);
+			ACTIONRECORD::executeActions(this,this->getCurrentFrame()->getAVM1Context(),it->actions.getPtr(),m);
 		}
 	}
 	Sprite::AVM1HandleKeyboardEvent(e);
@@ -1854,7 +1962,7 @@ bool MovieClip::AVM1HandleMouseEvent(EventDispatcher *dispatcher, MouseEvent *e)
 					)
 			{
 				std::map<uint32_t,asAtom> m;
-				ACTIONRECORD::executeActions(this,this->getCurrentFrame()->getAVM1Context(),it->actions,it->startactionpos,m);
+				ACTIONRECORD::executeActions(this,this->getCurrentFrame()->getAVM1Context(),it->actions.getPtr(),m);
 			}
 		}
 		AVM1HandleMouseEventStandard(dispobj.getPtr(),e);
@@ -1870,18 +1978,18 @@ void MovieClip::AVM1HandleEvent(EventDispatcher *dispatcher, Event* e)
 		{
 			if (e->type == "complete" && it->EventFlags.ClipEventLoad)
 			{
-				ACTIONRECORD::executeActions(this,this->getCurrentFrame()->getAVM1Context(),it->actions,it->startactionpos,m);
+				ACTIONRECORD::executeActions(this,this->getCurrentFrame()->getAVM1Context(),it->actions.getPtr(),m);
 			}
 			if (e->type == "enterFrame" && it->EventFlags.ClipEventEnterFrame)
 			{
 				if (!this->isOnStage())
 					return;
 				if (!this->state.explicit_FP)
-					ACTIONRECORD::executeActions(this,this->getCurrentFrame()->getAVM1Context(),it->actions,it->startactionpos,m);
+					ACTIONRECORD::executeActions(this,this->getCurrentFrame()->getAVM1Context(),it->actions.getPtr(),m);
 			}
 			if (e->type == "load" && it->EventFlags.ClipEventLoad)
 			{
-				ACTIONRECORD::executeActions(this,this->getCurrentFrame()->getAVM1Context(),it->actions,it->startactionpos,m);
+				ACTIONRECORD::executeActions(this,this->getCurrentFrame()->getAVM1Context(),it->actions.getPtr(),m);
 			}
 		}
 		if (e->type == "enterFrame")
@@ -2262,7 +2370,9 @@ void DisplayObjectContainer::buildTraits(ASObject* o)
 {
 }
 
-DisplayObjectContainer::DisplayObjectContainer(Class_base* c):InteractiveObject(c),mouseChildren(true),tabChildren(true)
+DisplayObjectContainer::DisplayObjectContainer(Class_base* c):InteractiveObject(c),mouseChildren(true),
+	hitGridX(0),hitGridY(0),hitGridCellWidth(1),hitGridCellHeight(1),hitGridColumns(0),hitGridRows(0),
+	hitGridEpoch(0),hitGridValid(false),childrenGeometryEpoch(0),tabChildren(true)
 {
 	subtype=SUBTYPE_DISPLAYOBJECTCONTAINER;
 }
@@ -2460,9 +2570,46 @@ bool DisplayObjectContainer::destruct()
 	for (auto it = namedRemovedLegacyChildren.begin(); it != namedRemovedLegacyChildren.end(); it++)
 		(*it).second->decRef();
 	namedRemovedLegacyChildren.clear();
+	hitGridCells.clear();
+	hitGridUnbounded.clear();
+	hitGridChildren.clear();
+	hitGridValid = false;
 	return InteractiveObject::destruct();
 }
 
+void DisplayObjectContainer::collectReferences(gc_references& refs)
+{
+	{
+		Locker l(mutexDisplayList);
+		for (auto it = dynamicDisplayList.begin(); it != dynamicDisplayList.end(); it++)
+		{
+			refs.owned.push_back(it->getPtr());
+			//The children can reach this object through their parent pointer
+			refs.backrefs.push_back(it->getPtr());
+		}
+	}
+	for (auto it = namedRemovedLegacyChildren.begin(); it != namedRemovedLegacyChildren.end(); it++)
+		refs.owned.push_back((*it).second);
+	InteractiveObject::collectReferences(refs);
+}
+
+void DisplayObjectContainer::releaseReferences()
+{
+	{
+		Locker l(mutexDisplayList);
+		for (auto it = dynamicDisplayList.begin(); it != dynamicDisplayList.end(); it++)
+			(*it)->setParent(nullptr);
+		dynamicDisplayList.clear();
+		legacyChildrenMarkedForDeletion.clear();
+		mapDepthToLegacyChild.clear();
+		mapLegacyChildToDepth.clear();
+	}
+	for (auto it = namedRemovedLegacyChildren.begin(); it != namedRemovedLegacyChildren.end(); it++)
+		(*it).second->decRef();
+	namedRemovedLegacyChildren.clear();
+	InteractiveObject::releaseReferences();
+}
+
 void DisplayObjectContainer::resetLegacyState()
 {
 	auto i = mapDepthToLegacyChild.begin();
@@ -2695,6 +2842,8 @@ void DisplayObjectContainer::_addChildAt(_R<DisplayObject> child, unsigned int i
 			dynamicDisplayList.insert(it,child);
 		}
 	}
+	//The bounds of this container changed for its ancestors
+	geometryChanged();
 	if (!onStage || child.getPtr() != getSystemState()->mainClip)
 		child->setOnStage(onStage);
 }
@@ -2724,6 +2873,7 @@ bool DisplayObjectContainer::_removeChild(DisplayObject* child)
 
 		dynamicDisplayList.erase(it);
 	}
+	geometryChanged();
 	return true;
 }
 
@@ -2747,6 +2897,7 @@ void DisplayObjectContainer::_removeAllChildren()
 		}
 		it = dynamicDisplayList.erase(it);
 	}
+	geometryChanged();
 }
 
 bool DisplayObjectContainer::_contains(_R<DisplayObject> d)
@@ -3305,7 +3456,7 @@ bool Stage::renderImpl(RenderContext &ctxt) const
 		if (asAtomHandler::as<Stage3D>(a)->renderImpl(ctxt))
 			has3d = true;
 	}
-	if (has3d)
+	if (has3d && ctxt.contextType == RenderContext::GL)
 	{
 		// setup opengl state for additional 2d rendering
 		getSystemState()->getEngineData()->exec_glActiveTexture_GL_TEXTURE0(0);
@@ -3918,12 +4069,12 @@ void Bitmap::updatedData()
 	else
 		style.FillStyleType=NON_SMOOTHED_CLIPPED_BITMAP;
 	style.bitmap=bitmapData->getBitmapContainer();
-	tokens.filltokens.emplace_back(_MR(new GeomToken(SET_FILL, style)));
-	tokens.filltokens.emplace_back(_MR(new GeomToken(MOVE, Vector2(0, 0))));
-	tokens.filltokens.emplace_back(_MR(new GeomToken(STRAIGHT, Vector2(0, style.bitmap->getHeight()))));
-	tokens.filltokens.emplace_back(_MR(new GeomToken(STRAIGHT, Vector2(style.bitmap->getWidth(), style.bitmap->getHeight()))));
-	tokens.filltokens.emplace_back(_MR(new GeomToken(STRAIGHT, Vector2(style.bitmap->getWidth(), 0))));
-	tokens.filltokens.emplace_back(_MR(new GeomToken(STRAIGHT, Vector2(0, 0))));
+	tokens.setFill(tokens.filltokens, style);
+	tokens.filltokens.moveTo(Vector2(0, 0));
+	tokens.filltokens.lineTo(Vector2(0, style.bitmap->getHeight()));
+	tokens.filltokens.lineTo(Vector2(style.bitmap->getWidth(), style.bitmap->getHeight()));
+	tokens.filltokens.lineTo(Vector2(style.bitmap->getWidth(), 0));
+	tokens.filltokens.lineTo(Vector2(0, 0));
 	hasChanged=true;
 	if(onStage)
 		requestInvalidation(getSystemState());
@@ -4064,7 +4215,7 @@ bool SimpleButton::AVM1HandleMouseEvent(EventDispatcher* dispatcher, MouseEvent
 				if (c)
 				{
 					std::map<uint32_t,asAtom> m;
-					ACTIONRECORD::executeActions(c->as<MovieClip>(),c->as<MovieClip>()->getCurrentFrame()->getAVM1Context(),it->actions,it->startactionpos,m);
+					ACTIONRECORD::executeActions(c->as<MovieClip>(),c->as<MovieClip>()->getCurrentFrame()->getAVM1Context(),it->actions.getPtr(),m);
 					handled = true;
 				}
 				
@@ -4224,7 +4375,7 @@ bool SimpleButton::AVM1HandleKeyboardEvent(KeyboardEvent *e)
 			while (c && !c->is<MovieClip>())
 				c = c->getParent();
 			std::map<uint32_t,asAtom> m;
-			ACTIONRECORD::executeActions(c->as<MovieClip>(),c->as<MovieClip>()->getCurrentFrame()->getAVM1Context(),it->actions,it->startactionpos,m);
+			ACTIONRECORD::executeActions(c->as<MovieClip>(),c->as<MovieClip>()->getCurrentFrame()->getAVM1Context(),it->actions.getPtr(),m);
 			handled=true;
 		}
 	}
@@ -5048,6 +5199,16 @@ bool Stage3D::renderImpl(RenderContext &ctxt) const
 {
 	if (!visible || context3D.isNull())
 		return false;
+	if (ctxt.contextType == RenderContext::SOFTWARE)
+	{
+		//The back buffer is drawn below the display list like the OpenGL one
+		context3D->renderImpl(ctxt);
+		context3D->softwareContext->render((SoftwareRenderContext&)ctxt,int32_t(x),int32_t(y));
+		return true;
+	}
+	//Context3D replays its actions through OpenGL
+	if (ctxt.contextType != RenderContext::GL)
+		return false;
 	return context3D->renderImpl(ctxt);
 }
 
@@ -97,8 +97,16 @@ public:
 	_NR<InteractiveObject> getCurrentContextMenuItems(std::vector<Ref<NativeMenuItem> > &items);
 };
 
+//Containers with less children than this are hit tested without a grid
+#define HIT_GRID_MIN_CHILDREN 32
+//Highest number of cells on each side of the hit test grid
+#define HIT_GRID_MAX_SIDE 64
+//Children overlapping more cells than this are tested wherever the point is
+#define HIT_GRID_MAX_CELLS_PER_CHILD 16
+
 class DisplayObjectContainer: public InteractiveObject
 {
+friend class DisplayObject;
 private:
 	bool mouseChildren;
 	map<int32_t,DisplayObject*> mapDepthToLegacyChild;
@@ -107,6 +115,33 @@ private:
 	set<int32_t> legacyChildrenMarkedForDeletion;
 	bool _contains(_R<DisplayObject> child);
 	void getObjectsFromPoint(Point* point, Array* ar);
+	/*
+	 * Uniform grid over the bounds of the children, used by hitTestImpl
+	 * to only test the children that may contain the point. Each cell
+	 * holds the ascending indices in dynamicDisplayList of the children
+	 * overlapping it. It is built again when childrenGeometryEpoch or the
+	 * list of children change.
+	 */
+	std::vector<std::vector<uint32_t>> hitGridCells;
+	//Children tested wherever the point is: the ones without bounds and the large ones
+	std::vector<uint32_t> hitGridUnbounded;
+	//Candidates of a cell merged with hitGridUnbounded
+	std::vector<uint32_t> hitGridMerged;
+	//Children when the grid was built, only compared and never dereferenced
+	std::vector<DisplayObject*> hitGridChildren;
+	number_t hitGridX;
+	number_t hitGridY;
+	number_t hitGridCellWidth;
+	number_t hitGridCellHeight;
+	int32_t hitGridColumns;
+	int32_t hitGridRows;
+	int32_t hitGridEpoch;
+	bool hitGridValid;
+	//Incremented by geometryChanged when the matrix or the bounds of a descendant may have changed
+	ATOMIC_INT32(childrenGeometryEpoch);
+	void buildHitGrid();
+	//Ascending indices of the children to test, or NULL to test all of them
+	const std::vector<uint32_t>* getHitCandidates(number_t x, number_t y);
 protected:
 	//This is shared between RenderThread and VM
 	std::vector < _R<DisplayObject> > dynamicDisplayList;
@@ -132,6 +167,8 @@ public:
 	int getChildIndex(_R<DisplayObject> child);
 	DisplayObjectContainer(Class_base* c);
 	bool destruct() override;
+	void collectReferences(gc_references& refs) override;
+	void releaseReferences() override;
 	void resetLegacyState() override;
 	bool hasLegacyChildAt(int32_t depth);
 	// this does not test if a DisplayObject exists at the provided depth
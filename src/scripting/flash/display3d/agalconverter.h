@@ -10,6 +10,9 @@
 
 using namespace lightspark;
 
+// version of the output stored in the disk cache, has to be incremented whenever the generated GLSL or register maps change
+#define AGAL_CACHE_VERSION 1
+
 // routines to convert AGAL-Bytecode to GLSL shader language
 // AGAL bytecode format is documented in http://help.adobe.com/en_US/as3/dev/WSd6a006f2eb1dc31e-310b95831324724ec56-8000.html
 // conversion algorithm is taken from https://github.com/openfl/openfl/blob/develop/openfl/_internal/stage3D/AGALConverter.hx (converted to c++)
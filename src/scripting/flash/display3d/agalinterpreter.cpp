@@ -0,0 +1,571 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2017 Ludger Krämer <dbluelle@onlinehome.de>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "scripting/flash/display3d/agalinterpreter.h"
+#include "scripting/flash/display3d/flashdisplay3d.h"
+#include "scripting/class.h"
+#include "scripting/flash/utils/ByteArray.h"
+#include "logger.h"
+#include <cmath>
+#include <cstring>
+
+using namespace std;
+using namespace lightspark;
+
+namespace
+{
+
+//Texture coordinates are clamped to this range (in texels) before the conversion to integers
+const float AGAL_MAX_TEXEL=1048576.0f;
+
+uint64_t readSource(ByteArray* agal)
+{
+	uint32_t low=0;
+	uint32_t high=0;
+	agal->readUnsignedInt(low);
+	agal->readUnsignedInt(high);
+	return ((uint64_t)high)<<32 | low;
+}
+
+uint32_t registerCount(uint32_t type, bool isVertexProgram)
+{
+	switch(type)
+	{
+		case ATTRIBUTE:
+			return isVertexProgram ? AGAL_MAX_ATTRIBUTES : 0;
+		case CONSTANT:
+			return AGAL_MAX_CONSTANTS;
+		case TEMPORARY:
+			return AGAL_MAX_TEMPORARIES;
+		case OUTPUT:
+			return 1;
+		case VARYING:
+			return AGAL_MAX_VARYINGS;
+		default:
+			return 0;
+	}
+}
+
+//Constants are not stored in AGALRegisters, they are handled by the callers
+const AGALRegister* getRegister(const AGALState& state, uint32_t type, uint32_t n)
+{
+	switch(type)
+	{
+		case ATTRIBUTE:
+			return n<AGAL_MAX_ATTRIBUTES ? &state.attributes[n] : NULL;
+		case TEMPORARY:
+			return n<AGAL_MAX_TEMPORARIES ? &state.temporaries[n] : NULL;
+		case OUTPUT:
+			return n==0 ? &state.output : NULL;
+		case VARYING:
+			return n<AGAL_MAX_VARYINGS ? &state.varyings[n] : NULL;
+		default:
+			return NULL;
+	}
+}
+
+AGALRegister* getRegister(AGALState& state, uint32_t type, uint32_t n)
+{
+	return const_cast<AGALRegister*>(getRegister(const_cast<const AGALState&>(state),type,n));
+}
+
+inline float clampTexel(float f)
+{
+	//Also maps NaN to 0
+	if(!(f>-AGAL_MAX_TEXEL))
+		return f!=f ? 0 : -AGAL_MAX_TEXEL;
+	return f<AGAL_MAX_TEXEL ? f : AGAL_MAX_TEXEL;
+}
+
+inline uint32_t wrapTexel(int32_t i, uint32_t size, bool repeat)
+{
+	if(repeat)
+	{
+		int32_t m=i%int32_t(size);
+		return m<0 ? m+size : m;
+	}
+	return imin(imax(i,0),int32_t(size)-1);
+}
+
+inline void readTexel(const AGALTexture& t, uint32_t x, uint32_t y, float* out)
+{
+	const uint8_t* p=t.pixels+(y*t.width+x)*t.bytesPerPixel;
+	out[0]=p[0];
+	out[1]=p[1];
+	out[2]=p[2];
+	out[3]=t.bytesPerPixel==4 ? p[3] : 255.0f;
+}
+
+}
+
+void AGALProgram::clear()
+{
+	instructions.clear();
+	attributeMask=0;
+	varyingMask=0;
+}
+
+bool AGALProgram::checkSource(const source& s) const
+{
+	if(s.type==SAMPLER || registerCount(s.type,vertexProgram)==0)
+		return false;
+	if(s.indirect)
+		return s.indexType==ATTRIBUTE || s.indexType==CONSTANT || s.indexType==TEMPORARY;
+	return s.number<registerCount(s.type,vertexProgram);
+}
+
+bool AGALProgram::parse(ByteArray* agal, bool isVertexProgram)
+{
+	clear();
+	vertexProgram=isVertexProgram;
+	agal->setPosition(0);
+	uint8_t by=0;
+	agal->readByte(by);
+	if(by!=0xA0)
+	{
+		//Embedded GLSL shaders can't be interpreted
+		LOG(LOG_NOT_IMPLEMENTED,"AGAL interpreter: program is not AGAL bytecode");
+		return false;
+	}
+	uint32_t version=0;
+	agal->readUnsignedInt(version);
+	agal->readByte(by);
+	agal->readByte(by);
+	//Every instruction is 24 bytes long
+	while(agal->getPosition()+24<=agal->getLength())
+	{
+		uint32_t opcode=0;
+		uint32_t dest=0;
+		agal->readUnsignedInt(opcode);
+		agal->readUnsignedInt(dest);
+		uint64_t sources[2];
+		sources[0]=readSource(agal);
+		sources[1]=readSource(agal);
+
+		instruction ins;
+		ins.opcode=opcode;
+		ins.destType=(dest>>24)&0xF;
+		ins.destMask=(dest>>16)&0xF;
+		ins.destNumber=dest&0xFFFF;
+		for(uint32_t i=0;i<2;i++)
+		{
+			const uint64_t v=sources[i];
+			source& s=ins.src[i];
+			const uint32_t swizzle=(v>>24)&0xFF;
+			for(uint32_t j=0;j<4;j++)
+				s.swizzle[j]=(swizzle>>(j*2))&3;
+			s.type=(v>>32)&0xF;
+			s.indirect=(v>>63)&1;
+			s.indexType=(v>>40)&0xF;
+			s.indexComponent=(v>>48)&3;
+			if(s.indirect)
+			{
+				//The register number is the one of the index register, the offset is the base
+				s.indexNumber=v&0xFFFF;
+				s.number=(v>>16)&0xFF;
+			}
+			else
+			{
+				s.indexNumber=0;
+				s.number=v&0xFFFF;
+			}
+		}
+		//Sampler of tex
+		ins.sampler=sources[1]&0xFFFF;
+		ins.linear=((sources[1]>>60)&0xF)!=0;
+		ins.repeat=((sources[1]>>52)&0xF)!=0;
+
+		uint32_t sourceCount=2;
+		bool valid=true;
+		switch(opcode)
+		{
+			case 0x00: // mov
+			case 0x05: // rcp
+			case 0x08: // frc
+			case 0x09: // sqt
+			case 0x0A: // rsq
+			case 0x0C: // log
+			case 0x0D: // exp
+			case 0x0E: // nrm
+			case 0x0F: // sin
+			case 0x10: // cos
+			case 0x14: // abs
+			case 0x15: // neg
+			case 0x16: // sat
+				sourceCount=1;
+				break;
+			case 0x01: // add
+			case 0x02: // sub
+			case 0x03: // mul
+			case 0x04: // div
+			case 0x06: // min
+			case 0x07: // max
+			case 0x0B: // pow
+			case 0x11: // crs
+			case 0x12: // dp3
+			case 0x13: // dp4
+			case 0x29: // sge
+			case 0x2A: // slt
+			case 0x2C: // seq
+			case 0x2D: // sne
+				break;
+			case 0x17: // m33
+			case 0x18: // m44
+			case 0x19: // m34
+				//The rows of the matrix are the registers following the one of source 2
+				if(!ins.src[1].indirect)
+					valid=ins.src[1].number+(opcode==0x18 ? 3u : 2u)<registerCount(ins.src[1].type,vertexProgram);
+				if(opcode==0x19)
+					ins.destMask&=7;
+				break;
+			case 0x27: // kil
+				sourceCount=1;
+				valid=!vertexProgram;
+				break;
+			case 0x28: // tex
+			{
+				sourceCount=1;
+				//Only 2D textures are sampled
+				const uint32_t dimension=(sources[1]>>44)&0xF;
+				valid=!vertexProgram && dimension==0 && ins.sampler<AGAL_MAX_SAMPLERS;
+				break;
+			}
+			default:
+				valid=false;
+				break;
+		}
+		for(uint32_t i=0;i<sourceCount && valid;i++)
+			valid=checkSource(ins.src[i]);
+		if(valid && opcode!=0x27)
+		{
+			valid=(ins.destType==TEMPORARY || ins.destType==OUTPUT || (vertexProgram && ins.destType==VARYING))
+					&& ins.destNumber<registerCount(ins.destType,vertexProgram);
+		}
+		if(!valid)
+		{
+			LOG(LOG_NOT_IMPLEMENTED,"AGAL interpreter: unsupported instruction "<<hex<<opcode<<dec<<" in "<<(isVertexProgram ? "vertex" : "fragment")<<" program");
+			clear();
+			return false;
+		}
+		for(uint32_t i=0;i<sourceCount;i++)
+		{
+			const source& s=ins.src[i];
+			if(s.type==ATTRIBUTE)
+				attributeMask|=s.indirect ? 0xFF : 1<<s.number;
+			else if(s.type==VARYING)
+				varyingMask|=s.indirect ? (1<<AGAL_MAX_VARYINGS)-1 : 1<<s.number;
+			if(s.indirect && s.indexType==ATTRIBUTE)
+				attributeMask|=1<<s.indexNumber;
+		}
+		if(opcode!=0x27 && ins.destType==VARYING)
+			varyingMask|=1<<ins.destNumber;
+		instructions.push_back(ins);
+	}
+	return true;
+}
+
+void AGALProgram::fetch(const AGALState& state, const source& s, uint32_t offset, AGALRegister& out) const
+{
+	if(s.indirect)
+	{
+		//The register may be different in every lane
+		for(uint32_t l=0;l<AGAL_LANES;l++)
+		{
+			float index;
+			if(s.indexType==CONSTANT)
+				index=s.indexNumber<AGAL_MAX_CONSTANTS ? state.constants[s.indexNumber*4+s.indexComponent] : 0;
+			else
+			{
+				const AGALRegister* r=getRegister(state,s.indexType,s.indexNumber);
+				index=r ? r->c[s.indexComponent][l] : 0;
+			}
+			//Also rejects NaN
+			const int32_t n=(index>-65536.0f && index<65536.0f) ? int32_t(index)+s.number+offset : -1;
+			if(n<0 || uint32_t(n)>=registerCount(s.type,vertexProgram))
+			{
+				for(uint32_t i=0;i<4;i++)
+					out.c[i][l]=0;
+			}
+			else if(s.type==CONSTANT)
+			{
+				for(uint32_t i=0;i<4;i++)
+					out.c[i][l]=state.constants[n*4+s.swizzle[i]];
+			}
+			else
+			{
+				const AGALRegister* r=getRegister(state,s.type,n);
+				for(uint32_t i=0;i<4;i++)
+					out.c[i][l]=r->c[s.swizzle[i]][l];
+			}
+		}
+		return;
+	}
+	const uint32_t n=s.number+offset;
+	if(s.type==CONSTANT)
+	{
+		const float* c=state.constants+n*4;
+		for(uint32_t i=0;i<4;i++)
+		{
+			const float v=c[s.swizzle[i]];
+			for(uint32_t l=0;l<AGAL_LANES;l++)
+				out.c[i][l]=v;
+		}
+		return;
+	}
+	const AGALRegister* r=getRegister(state,s.type,n);
+	for(uint32_t i=0;i<4;i++)
+		memcpy(out.c[i],r->c[s.swizzle[i]],sizeof(out.c[i]));
+}
+
+void AGALProgram::sample(const AGALState& state, const instruction& ins, const AGALRegister& coords, AGALRegister& out) const
+{
+	const AGALTexture& t=state.textures[ins.sampler];
+	if(t.pixels==NULL)
+	{
+		memset(&out,0,sizeof(out));
+		return;
+	}
+	for(uint32_t l=0;l<AGAL_LANES;l++)
+	{
+		float u=clampTexel(coords.c[0][l]*t.width);
+		float v=clampTexel(coords.c[1][l]*t.height);
+		float texel[4];
+		if(ins.linear)
+		{
+			u-=0.5f;
+			v-=0.5f;
+			const float fu=floorf(u);
+			const float fv=floorf(v);
+			const float du=u-fu;
+			const float dv=v-fv;
+			const uint32_t x0=wrapTexel(int32_t(fu),t.width,ins.repeat);
+			const uint32_t x1=wrapTexel(int32_t(fu)+1,t.width,ins.repeat);
+			const uint32_t y0=wrapTexel(int32_t(fv),t.height,ins.repeat);
+			const uint32_t y1=wrapTexel(int32_t(fv)+1,t.height,ins.repeat);
+			float t00[4],t10[4],t01[4],t11[4];
+			readTexel(t,x0,y0,t00);
+			readTexel(t,x1,y0,t10);
+			readTexel(t,x0,y1,t01);
+			readTexel(t,x1,y1,t11);
+			for(uint32_t i=0;i<4;i++)
+			{
+				const float top=t00[i]+(t10[i]-t00[i])*du;
+				const float bottom=t01[i]+(t11[i]-t01[i])*du;
+				texel[i]=top+(bottom-top)*dv;
+			}
+		}
+		else
+		{
+			readTexel(t,wrapTexel(int32_t(floorf(u)),t.width,ins.repeat),
+				  wrapTexel(int32_t(floorf(v)),t.height,ins.repeat),texel);
+		}
+		for(uint32_t i=0;i<4;i++)
+			out.c[i][l]=texel[i]*(1.0f/255.0f);
+	}
+}
+
+//Component wise operations, x and y are the components of the sources
+#define AGAL_UNARY(expr) \
+	fetch(state,ins.src[0],0,a); \
+	for(uint32_t i=0;i<4;i++) \
+		for(uint32_t l=0;l<AGAL_LANES;l++) \
+		{ \
+			const float x=a.c[i][l]; \
+			r.c[i][l]=(expr); \
+		}
+#define AGAL_BINARY(expr) \
+	fetch(state,ins.src[0],0,a); \
+	fetch(state,ins.src[1],0,b); \
+	for(uint32_t i=0;i<4;i++) \
+		for(uint32_t l=0;l<AGAL_LANES;l++) \
+		{ \
+			const float x=a.c[i][l]; \
+			const float y=b.c[i][l]; \
+			r.c[i][l]=(expr); \
+		}
+
+void AGALProgram::execute(AGALState& state) const
+{
+	for(uint32_t l=0;l<AGAL_LANES;l++)
+		state.killed[l]=false;
+	AGALRegister a;
+	AGALRegister b;
+	AGALRegister r;
+	for(auto it=instructions.begin();it!=instructions.end();++it)
+	{
+		const instruction& ins=*it;
+		switch(ins.opcode)
+		{
+			case 0x00: // mov
+				fetch(state,ins.src[0],0,r);
+				break;
+			case 0x01: // add
+				AGAL_BINARY(x+y);
+				break;
+			case 0x02: // sub
+				AGAL_BINARY(x-y);
+				break;
+			case 0x03: // mul
+				AGAL_BINARY(x*y);
+				break;
+			case 0x04: // div
+				AGAL_BINARY(x/y);
+				break;
+			case 0x05: // rcp
+				AGAL_UNARY(1.0f/x);
+				break;
+			case 0x06: // min
+				AGAL_BINARY(x<y ? x : y);
+				break;
+			case 0x07: // max
+				AGAL_BINARY(x>y ? x : y);
+				break;
+			case 0x08: // frc
+				AGAL_UNARY(x-floorf(x));
+				break;
+			case 0x09: // sqt
+				AGAL_UNARY(sqrtf(x));
+				break;
+			case 0x0A: // rsq
+				AGAL_UNARY(1.0f/sqrtf(x));
+				break;
+			case 0x0B: // pow
+				AGAL_BINARY(powf(x,y));
+				break;
+			case 0x0C: // log
+				AGAL_UNARY(log2f(x));
+				break;
+			case 0x0D: // exp
+				AGAL_UNARY(exp2f(x));
+				break;
+			case 0x0E: // nrm
+				fetch(state,ins.src[0],0,a);
+				for(uint32_t l=0;l<AGAL_LANES;l++)
+				{
+					const float len=sqrtf(a.c[0][l]*a.c[0][l]+a.c[1][l]*a.c[1][l]+a.c[2][l]*a.c[2][l]);
+					const float scale=len>0 ? 1.0f/len : 0;
+					r.c[0][l]=a.c[0][l]*scale;
+					r.c[1][l]=a.c[1][l]*scale;
+					r.c[2][l]=a.c[2][l]*scale;
+					r.c[3][l]=0;
+				}
+				break;
+			case 0x0F: // sin
+				AGAL_UNARY(sinf(x));
+				break;
+			case 0x10: // cos
+				AGAL_UNARY(cosf(x));
+				break;
+			case 0x11: // crs
+				fetch(state,ins.src[0],0,a);
+				fetch(state,ins.src[1],0,b);
+				for(uint32_t l=0;l<AGAL_LANES;l++)
+				{
+					r.c[0][l]=a.c[1][l]*b.c[2][l]-a.c[2][l]*b.c[1][l];
+					r.c[1][l]=a.c[2][l]*b.c[0][l]-a.c[0][l]*b.c[2][l];
+					r.c[2][l]=a.c[0][l]*b.c[1][l]-a.c[1][l]*b.c[0][l];
+					r.c[3][l]=0;
+				}
+				break;
+			case 0x12: // dp3
+			case 0x13: // dp4
+			{
+				fetch(state,ins.src[0],0,a);
+				fetch(state,ins.src[1],0,b);
+				const uint32_t count=ins.opcode==0x12 ? 3 : 4;
+				for(uint32_t l=0;l<AGAL_LANES;l++)
+				{
+					float d=0;
+					for(uint32_t i=0;i<count;i++)
+						d+=a.c[i][l]*b.c[i][l];
+					for(uint32_t i=0;i<4;i++)
+						r.c[i][l]=d;
+				}
+				break;
+			}
+			case 0x14: // abs
+				AGAL_UNARY(fabsf(x));
+				break;
+			case 0x15: // neg
+				AGAL_UNARY(-x);
+				break;
+			case 0x16: // sat
+				AGAL_UNARY(x<0 ? 0 : (x>1 ? 1 : x));
+				break;
+			case 0x17: // m33
+			case 0x18: // m44
+			case 0x19: // m34
+			{
+				//Every row of the matrix is dotted with source 1
+				const uint32_t rows=ins.opcode==0x18 ? 4 : 3;
+				const uint32_t columns=ins.opcode==0x17 ? 3 : 4;
+				fetch(state,ins.src[0],0,a);
+				for(uint32_t row=0;row<rows;row++)
+				{
+					fetch(state,ins.src[1],row,b);
+					for(uint32_t l=0;l<AGAL_LANES;l++)
+					{
+						float d=0;
+						for(uint32_t i=0;i<columns;i++)
+							d+=a.c[i][l]*b.c[i][l];
+						r.c[row][l]=d;
+					}
+				}
+				if(rows==3)
+				{
+					for(uint32_t l=0;l<AGAL_LANES;l++)
+						r.c[3][l]=0;
+				}
+				break;
+			}
+			case 0x27: // kil
+				fetch(state,ins.src[0],0,a);
+				for(uint32_t l=0;l<AGAL_LANES;l++)
+				{
+					if(a.c[0][l]<0 || a.c[1][l]<0 || a.c[2][l]<0 || a.c[3][l]<0)
+						state.killed[l]=true;
+				}
+				//kil has no destination
+				continue;
+			case 0x28: // tex
+				fetch(state,ins.src[0],0,a);
+				sample(state,ins,a,r);
+				break;
+			case 0x29: // sge
+				AGAL_BINARY(x>=y ? 1.0f : 0.0f);
+				break;
+			case 0x2A: // slt
+				AGAL_BINARY(x<y ? 1.0f : 0.0f);
+				break;
+			case 0x2C: // seq
+				AGAL_BINARY(x==y ? 1.0f : 0.0f);
+				break;
+			case 0x2D: // sne
+				AGAL_BINARY(x!=y ? 1.0f : 0.0f);
+				break;
+		}
+		//The result is computed before the store, so the sources may be the destination
+		AGALRegister* dest=getRegister(state,ins.destType,ins.destNumber);
+		for(uint32_t i=0;i<4;i++)
+		{
+			if(ins.destMask&(1<<i))
+				memcpy(dest->c[i],r.c[i],sizeof(r.c[i]));
+		}
+	}
+}
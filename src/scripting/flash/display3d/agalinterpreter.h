@@ -0,0 +1,123 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2017 Ludger Krämer <dbluelle@onlinehome.de>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+#ifndef AGALINTERPRETER_H
+#define AGALINTERPRETER_H
+
+#include "compat.h"
+#include <vector>
+
+namespace lightspark
+{
+class ByteArray;
+
+//Number of invocations of a program that are executed together
+#define AGAL_LANES 4
+#define AGAL_MAX_ATTRIBUTES 8
+#define AGAL_MAX_CONSTANTS 128
+#define AGAL_MAX_TEMPORARIES 26
+#define AGAL_MAX_VARYINGS 10
+#define AGAL_MAX_SAMPLERS 8
+
+/*
+ * A register of all the lanes, stored component by component so that
+ * every operation is a loop over the lanes the compiler can vectorize
+ */
+struct AGALRegister
+{
+	float c[4][AGAL_LANES];
+};
+
+//Level 0 of a 2D texture, as uploaded to TextureBase
+struct AGALTexture
+{
+	//RGBA bytes, or RGB bytes if bytesPerPixel is 3, NULL if there is no texture
+	const uint8_t* pixels;
+	uint32_t width;
+	uint32_t height;
+	uint32_t bytesPerPixel;
+	AGALTexture():pixels(NULL),width(0),height(0),bytesPerPixel(4) {}
+};
+
+struct AGALState
+{
+	AGALRegister attributes[AGAL_MAX_ATTRIBUTES];
+	AGALRegister temporaries[AGAL_MAX_TEMPORARIES];
+	AGALRegister varyings[AGAL_MAX_VARYINGS];
+	AGALRegister output;
+	//4 floats per register, the same for all the lanes
+	const float* constants;
+	const AGALTexture* textures;
+	//Lanes discarded by kil
+	bool killed[AGAL_LANES];
+};
+
+/*
+ * Interpreter for the AGAL programs of Program3D, used by the software
+ * renderer of Stage3D. The bytecode is decoded once by parse, execute runs
+ * the program on AGAL_LANES vertices or fragments at a time.
+ */
+class AGALProgram
+{
+private:
+	struct source
+	{
+		uint8_t type;
+		bool indirect;
+		uint16_t number;
+		//Register component read by each component of the source
+		uint8_t swizzle[4];
+		//Indirect addressing: register type[index.component+number]
+		uint8_t indexType;
+		uint8_t indexComponent;
+		uint16_t indexNumber;
+	};
+	struct instruction
+	{
+		uint32_t opcode;
+		uint8_t destType;
+		uint8_t destMask;
+		uint16_t destNumber;
+		source src[2];
+		//tex only
+		uint8_t sampler;
+		bool linear;
+		bool repeat;
+	};
+	std::vector<instruction> instructions;
+	uint32_t attributeMask;
+	uint32_t varyingMask;
+	bool vertexProgram;
+	bool checkSource(const source& s) const;
+	void fetch(const AGALState& state, const source& s, uint32_t offset, AGALRegister& out) const;
+	void sample(const AGALState& state, const instruction& ins, const AGALRegister& coords, AGALRegister& out) const;
+public:
+	AGALProgram():attributeMask(0),varyingMask(0),vertexProgram(false) {}
+	//Decodes AGAL bytecode, returns false if it is not supported
+	bool parse(ByteArray* agal, bool isVertexProgram);
+	void clear();
+	bool empty() const { return instructions.empty(); }
+	//Bit i is set if the register va<i> (v<i>) is used by the program
+	uint32_t getAttributeMask() const { return attributeMask; }
+	uint32_t getVaryingMask() const { return varyingMask; }
+	//Runs the program on all the lanes of state
+	void execute(AGALState& state) const;
+};
+
+};
+#endif // AGALINTERPRETER_H
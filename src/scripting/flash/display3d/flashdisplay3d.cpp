@@ -25,7 +25,9 @@
 #include "scripting/argconv.h"
 #include "backends/rendering.h"
 #include "backends/rendering_context.h"
+#include "backends/diskcache.h"
 #include "scripting/flash/display3d/agalconverter.h"
+#include "scripting/flash/display3d/softwarecontext3d.h"
 
 SamplerRegister SamplerRegister::parse (uint64_t v, bool isVertexProgram)
 {
@@ -83,6 +85,7 @@ void Context3D::handleRenderAction(EngineData* engineData, renderaction& action)
 			break;
 		case RENDER_CONFIGUREBACKBUFFER:
 			//action.udata1 = enableDepthAndStencil
+			//action.udata2/udata3 = width/height, only used by the software renderer
 			//LOG(LOG_INFO,"RENDER_CONFIGUREBACKBUFFER:"<<action.udata1);
 			enableDepthAndStencilBackbuffer = action.udata1;
 			if (action.udata1)
@@ -345,49 +348,9 @@ void Context3D::handleRenderAction(EngineData* engineData, renderaction& action)
 			engineData->exec_glDeleteBuffers(1,&action.udata1);
 			break;
 		case RENDER_SETPROGRAMCONSTANTS_FROM_MATRIX:
-		{
-			//action.udata1 = firstRegister
-			//action.udata2 = 1, if vertex constants, 0 if fragment constants
-			//action.udata3 = 1, if transposed
-			//action.fdata = matrix (4*4)
-			for (uint32_t i = 0; i < 4 && i < CONTEXT3D_PROGRAM_REGISTERS-action.udata1; i++ )
-			{
-				float* data = action.udata2 ? vertexConstants[i+action.udata1].data : fragmentConstants[i+action.udata1].data;
-				if (action.udata3)
-				{
-					data[0] = action.fdata[i];
-					data[1] = action.fdata[i+4];
-					data[2] = action.fdata[i+8];
-					data[3] = action.fdata[i+12];
-				}
-				else
-				{
-					data[0] = action.fdata[i*4];
-					data[1] = action.fdata[i*4+1];
-					data[2] = action.fdata[i*4+2];
-					data[3] = action.fdata[i*4+3];
-				}
-			}
-			delete[] action.fdata;
-			break;
-		}
 		case RENDER_SETPROGRAMCONSTANTS_FROM_VECTOR:
-		{
-			//action.udata1 = firstRegister
-			//action.udata2 = 1, if vertex constants, 0 if fragment constants
-			//action.udata3 = numRegisters
-			//action.fdata = vector list (4*numRegisters)
-			for (uint32_t i = 0; i < action.udata3 && i < CONTEXT3D_PROGRAM_REGISTERS-action.udata1; i++ )
-			{
-				float* data = action.udata2 ? vertexConstants[i+action.udata1].data : fragmentConstants[i+action.udata1].data;
-				data[0] = action.fdata[i*4];
-				data[1] = action.fdata[i*4+1];
-				data[2] = action.fdata[i*4+2];
-				data[3] = action.fdata[i*4+3];
-			}
-			delete[] action.fdata;
+			setProgramConstants(action);
 			break;
-		}
 		case RENDER_SETTEXTUREAT:
 		{
 			//action.dataobject = TextureBase
@@ -450,6 +413,51 @@ void Context3D::handleRenderAction(EngineData* engineData, renderaction& action)
 	}
 }
 
+void Context3D::setProgramConstants(renderaction& action)
+{
+	if (action.action == RENDER_SETPROGRAMCONSTANTS_FROM_MATRIX)
+	{
+		//action.udata1 = firstRegister
+		//action.udata2 = 1, if vertex constants, 0 if fragment constants
+		//action.udata3 = 1, if transposed
+		//action.fdata = matrix (4*4)
+		for (uint32_t i = 0; i < 4 && i < CONTEXT3D_PROGRAM_REGISTERS-action.udata1; i++ )
+		{
+			float* data = action.udata2 ? vertexConstants[i+action.udata1].data : fragmentConstants[i+action.udata1].data;
+			if (action.udata3)
+			{
+				data[0] = action.fdata[i];
+				data[1] = action.fdata[i+4];
+				data[2] = action.fdata[i+8];
+				data[3] = action.fdata[i+12];
+			}
+			else
+			{
+				data[0] = action.fdata[i*4];
+				data[1] = action.fdata[i*4+1];
+				data[2] = action.fdata[i*4+2];
+				data[3] = action.fdata[i*4+3];
+			}
+		}
+	}
+	else
+	{
+		//action.udata1 = firstRegister
+		//action.udata2 = 1, if vertex constants, 0 if fragment constants
+		//action.udata3 = numRegisters
+		//action.fdata = vector list (4*numRegisters)
+		for (uint32_t i = 0; i < action.udata3 && i < CONTEXT3D_PROGRAM_REGISTERS-action.udata1; i++ )
+		{
+			float* data = action.udata2 ? vertexConstants[i+action.udata1].data : fragmentConstants[i+action.udata1].data;
+			data[0] = action.fdata[i*4];
+			data[1] = action.fdata[i*4+1];
+			data[2] = action.fdata[i*4+2];
+			data[3] = action.fdata[i*4+3];
+		}
+	}
+	delete[] action.fdata;
+}
+
 void Context3D::setRegisters(EngineData* engineData,std::vector<RegisterMapEntry>& registermap,constantregister* constants, bool isVertex)
 {
 	auto it = registermap.begin();
@@ -566,6 +574,21 @@ void Context3D::setPositionScale(EngineData *engineData)
 bool Context3D::renderImpl(RenderContext &ctxt)
 {
 	Locker l(rendermutex);
+	if (ctxt.contextType == RenderContext::SOFTWARE)
+	{
+		//The back buffer is kept by softwareContext, Stage3D composites it every frame
+		if (!softwareContext)
+			softwareContext = new SoftwareContext3D(this);
+		if (swapbuffers)
+		{
+			for (uint32_t i = 0; i < actions[1-currentactionvector].size(); i++)
+				softwareContext->handleRenderAction(actions[1-currentactionvector][i]);
+			softwareContext->endFrame();
+			actions[1-currentactionvector].clear();
+			swapbuffers = false;
+		}
+		return true;
+	}
 	if (!swapbuffers || actions[1-currentactionvector].size() == 0)
 		return false;
 	EngineData* engineData = getSystemState()->getEngineData();
@@ -672,7 +695,7 @@ void Context3D::loadCubeTexture(CubeTexture *tex)
 
 Context3D::Context3D(Class_base *c):EventDispatcher(c),samplers{UINT32_MAX,UINT32_MAX,UINT32_MAX,UINT32_MAX,UINT32_MAX,UINT32_MAX,UINT32_MAX,UINT32_MAX},currentactionvector(0)
   ,textureframebuffer(UINT32_MAX),textureframebufferID(UINT32_MAX),depthRenderBuffer(UINT32_MAX),stencilRenderBuffer(UINT32_MAX),currentprogram(NULL)
-  ,renderingToTexture(false),enableDepthAndStencilBackbuffer(true),enableDepthAndStencilTextureBuffer(true),swapbuffers(false),backBufferHeight(0),backBufferWidth(0),enableErrorChecking(false)
+  ,renderingToTexture(false),enableDepthAndStencilBackbuffer(true),enableDepthAndStencilTextureBuffer(true),swapbuffers(false),softwareContext(NULL),backBufferHeight(0),backBufferWidth(0),enableErrorChecking(false)
   ,maxBackBufferHeight(16384),maxBackBufferWidth(16384)
 {
 	subtype = SUBTYPE_CONTEXT3D;
@@ -681,6 +704,11 @@ Context3D::Context3D(Class_base *c):EventDispatcher(c),samplers{UINT32_MAX,UINT3
 	driverInfo = "Disposed";
 }
 
+Context3D::~Context3D()
+{
+	delete softwareContext;
+}
+
 void Context3D::addAction(RENDER_ACTION type, ASObject *dataobject)
 {
 	renderaction action;
@@ -777,6 +805,8 @@ ASFUNCTIONBODY_ATOM(Context3D,configureBackBuffer)
 	renderaction action;
 	action.action = RENDER_ACTION::RENDER_CONFIGUREBACKBUFFER;
 	action.udata1 = th->enableDepthAndStencilBackbuffer ? 1:0;
+	action.udata2 = th->backBufferWidth;
+	action.udata3 = th->backBufferHeight;
 	th->addAction(action);
 }
 ASFUNCTIONBODY_ATOM(Context3D,createCubeTexture)
@@ -1069,8 +1099,7 @@ ASFUNCTIONBODY_ATOM(Context3D,setProgramConstantsFromVector)
 		action.fdata= new float[action.udata3*4];
 		for (uint32_t i = 0; i < action.udata3*4; i++)
 		{
-			asAtom a = data->at(i);
-			action.fdata[i] = asAtomHandler::toNumber(a);
+			action.fdata[i] = data->getNumber(i);
 		}
 		th->addAction(action);
 	}
@@ -1424,8 +1453,7 @@ ASFUNCTIONBODY_ATOM(IndexBuffer3D,uploadFromVector)
 		th->data.resize(count+startOffset);
 	for (uint32_t i = 0; i< count; i++)
 	{
-		asAtom a = data->at(i);
-		th->data[startOffset+i] = asAtomHandler::toUInt(a);
+		th->data[startOffset+i] = data->getUInt(i);
 	}
 }
 
@@ -1441,6 +1469,102 @@ ASFUNCTIONBODY_ATOM(Program3D,dispose)
 	Program3D* th = asAtomHandler::as<Program3D>(obj);
 	th->context3D->addAction(RENDER_DELETEPROGRAM,th);
 }
+// the GLSL translations of AGAL programs are kept in the disk cache, so the same content doesn't translate them again on every start
+static void writeRegisterMap(DiskCacheWriter& w, const std::vector<RegisterMapEntry>& registermap)
+{
+	w.writeUInt(registermap.size());
+	for (auto it = registermap.begin(); it != registermap.end(); it++)
+	{
+		w.writeString(it->name);
+		w.writeUInt(it->number);
+		w.writeUInt(it->type);
+		w.writeUInt(it->usage);
+		w.writeUInt(it->arraycount);
+	}
+}
+static void readRegisterMap(DiskCacheReader& r, std::vector<RegisterMapEntry>& registermap)
+{
+	registermap.clear();
+	uint32_t count = r.readUInt();
+	for (uint32_t i = 0; i < count && !r.hasFailed(); i++)
+	{
+		RegisterMapEntry e;
+		e.name = r.readString();
+		e.number = r.readUInt();
+		e.type = (RegisterType)r.readUInt();
+		e.usage = (RegisterUsage)r.readUInt();
+		e.arraycount = r.readUInt();
+		registermap.push_back(e);
+	}
+}
+static tiny_string cachedAGALtoGLSL(ByteArray* agal,bool isVertexProgram,std::vector<SamplerRegister>& samplerState,std::vector<RegisterMapEntry>& constants,std::vector<RegisterMapEntry>& attributes)
+{
+	// only bytecode is translated, embedded GLSL is used directly
+	if (!DiskCache::enabled || agal->getLength() == 0 || agal->getBufferNoCheck()[0] != 0xA0)
+		return AGALtoGLSL(agal,isVertexProgram,samplerState,constants,attributes);
+	static DiskCache cache("agal",AGAL_CACHE_VERSION);
+	std::string key = DiskCache::getKey(agal->getBufferNoCheck(),agal->getLength(),isVertexProgram ? 1 : 0);
+	std::vector<uint8_t> entry;
+	if (cache.load(key,entry))
+	{
+		DiskCacheReader r(entry);
+		tiny_string glsl = r.readString();
+		std::vector<SamplerRegister> samplers(r.readUInt());
+		if (samplers.size() > CONTEXT3D_SAMPLER_COUNT*4)
+			samplers.clear();
+		for (auto it = samplers.begin(); it != samplers.end(); it++)
+		{
+			it->b = r.readUInt();
+			it->d = r.readUInt();
+			it->f = r.readUInt();
+			it->m = r.readUInt();
+			it->n = r.readUInt();
+			it->isVertexProgram = r.readUInt();
+			it->s = r.readUInt();
+			it->t = r.readUInt();
+			it->type = (RegisterType)r.readUInt();
+			it->w = r.readUInt();
+			it->program_sampler_id = UINT32_MAX;
+		}
+		std::vector<RegisterMapEntry> cachedconstants;
+		std::vector<RegisterMapEntry> cachedattributes;
+		readRegisterMap(r,cachedconstants);
+		readRegisterMap(r,cachedattributes);
+		if (r.isValid())
+		{
+			samplerState.insert(samplerState.end(),samplers.begin(),samplers.end());
+			constants = cachedconstants;
+			attributes = cachedattributes;
+			return glsl;
+		}
+	}
+	uint32_t firstsampler = samplerState.size();
+	tiny_string glsl = AGALtoGLSL(agal,isVertexProgram,samplerState,constants,attributes);
+	if (glsl.empty())
+		return glsl;
+	DiskCacheWriter w;
+	w.writeString(glsl);
+	w.writeUInt(samplerState.size()-firstsampler);
+	for (uint32_t i = firstsampler; i < samplerState.size(); i++)
+	{
+		const SamplerRegister& s = samplerState[i];
+		w.writeUInt(s.b);
+		w.writeUInt(s.d);
+		w.writeUInt(s.f);
+		w.writeUInt(s.m);
+		w.writeUInt(s.n);
+		w.writeUInt(s.isVertexProgram);
+		w.writeUInt(s.s);
+		w.writeUInt(s.t);
+		w.writeUInt(s.type);
+		w.writeUInt(s.w);
+	}
+	writeRegisterMap(w,constants);
+	writeRegisterMap(w,attributes);
+	cache.store(key,w.getData());
+	return glsl;
+}
+
 ASFUNCTIONBODY_ATOM(Program3D,upload)
 {
 	Program3D* th = asAtomHandler::as<Program3D>(obj);
@@ -1449,9 +1573,21 @@ ASFUNCTIONBODY_ATOM(Program3D,upload)
 	ARG_UNPACK_ATOM(vertexProgram)(fragmentProgram);
 	th->samplerState.clear();
 	if (!vertexProgram.isNull())
-		th->vertexprogram = AGALtoGLSL(vertexProgram.getPtr(),true,th->samplerState,th->vertexregistermap,th->vertexattributes);
+		th->vertexprogram = cachedAGALtoGLSL(vertexProgram.getPtr(),true,th->samplerState,th->vertexregistermap,th->vertexattributes);
 	if (!fragmentProgram.isNull())
-		th->fragmentprogram = AGALtoGLSL(fragmentProgram.getPtr(),false,th->samplerState,th->fragmentregistermap,th->fragmentattributes);
+		th->fragmentprogram = cachedAGALtoGLSL(fragmentProgram.getPtr(),false,th->samplerState,th->fragmentregistermap,th->fragmentattributes);
+	if (EngineData::softwarerendering)
+	{
+		// the software renderer interprets the bytecode, it may be running the previous one
+		if (!th->context3D.isNull())
+			th->context3D->rendermutex.lock();
+		if (!vertexProgram.isNull())
+			th->vertexAGAL.parse(vertexProgram.getPtr(),true);
+		if (!fragmentProgram.isNull())
+			th->fragmentAGAL.parse(fragmentProgram.getPtr(),false);
+		if (!th->context3D.isNull())
+			th->context3D->rendermutex.unlock();
+	}
 }
 
 VertexBuffer3D::VertexBuffer3D(Class_base *c, Context3D *ctx, int _numVertices, int32_t _data32PerVertex, tiny_string _bufferUsage)
@@ -1531,8 +1667,7 @@ ASFUNCTIONBODY_ATOM(VertexBuffer3D,uploadFromVector)
 		th->data.resize((numVertices+startVertex)* th->data32PerVertex);
 	for (uint32_t i = 0; i< numVertices* th->data32PerVertex; i++)
 	{
-		asAtom a = data->at(i);
-		th->data[startVertex*th->data32PerVertex+i] = asAtomHandler::toNumber(a);
+		th->data[startVertex*th->data32PerVertex+i] = data->getNumber(i);
 	}
 }
 
@@ -24,6 +24,7 @@
 #include "swftypes.h"
 #include "scripting/flash/events/flashevents.h"
 #include "scripting/flash/display3d/flashdisplay3dtextures.h"
+#include "scripting/flash/display3d/agalinterpreter.h"
 #include <map>
 #include "platforms/engineutils.h"
 
@@ -78,6 +79,7 @@ namespace lightspark
 class RenderContext;
 class VertexBuffer3D;
 class Program3D;
+class SoftwareContext3D;
 
 enum RENDER_ACTION { RENDER_CLEAR,RENDER_CONFIGUREBACKBUFFER,RENDER_SETPROGRAM,RENDER_RENDERTOBACKBUFFER,RENDER_TOTEXTURE,RENDER_DELETEPROGRAM,
 					 RENDER_SETVERTEXBUFFER,RENDER_DRAWTRIANGLES,RENDER_DELETEBUFFER,
@@ -113,6 +115,7 @@ struct attribregister
 class Context3D: public EventDispatcher
 {
 friend class Stage3D;
+friend class SoftwareContext3D;
 private:
 	std::vector<renderaction> actions[2];
 	constantregister vertexConstants[CONTEXT3D_PROGRAM_REGISTERS];
@@ -130,7 +133,10 @@ private:
 	bool enableDepthAndStencilBackbuffer;
 	bool enableDepthAndStencilTextureBuffer;
 	bool swapbuffers;
+	//Renders the actions when the stage is drawn without OpenGL
+	SoftwareContext3D* softwareContext;
 	void handleRenderAction(EngineData *engineData, renderaction &action);
+	void setProgramConstants(renderaction &action);
 	void setRegisters(EngineData *engineData, std::vector<RegisterMapEntry> &registermap, constantregister *constants, bool isVertex);
 	void setAttribs(EngineData* engineData, std::vector<RegisterMapEntry> &attributes);
 	void setSamplers(EngineData* engineData);
@@ -142,6 +148,7 @@ protected:
 public:
 	Mutex rendermutex;
 	Context3D(Class_base* c);
+	~Context3D();
 	static void sinit(Class_base* c);
 
 	void addAction(RENDER_ACTION type, ASObject* dataobject);
@@ -286,6 +293,7 @@ public:
 class IndexBuffer3D: public ASObject
 {
 friend class Context3D;
+friend class SoftwareContext3D;
 protected:
 	Context3D* context;
 	uint32_t bufferID;
@@ -304,6 +312,7 @@ public:
 class Program3D: public ASObject
 {
 friend class Context3D;
+friend class SoftwareContext3D;
 private:
 	_NR<Context3D> context3D;
 	uint32_t gpu_program;
@@ -316,6 +325,8 @@ protected:
 	std::vector<RegisterMapEntry> vertexattributes;
 	std::vector<RegisterMapEntry> fragmentregistermap;
 	std::vector<RegisterMapEntry> fragmentattributes;
+	AGALProgram vertexAGAL;
+	AGALProgram fragmentAGAL;
 public:
 	Program3D(Class_base* c):ASObject(c,T_OBJECT,SUBTYPE_PROGRAM3D),gpu_program(UINT32_MAX),vcPositionScale(UINT32_MAX){}
 	Program3D(Class_base* c,_NR<Context3D> _ct):ASObject(c,T_OBJECT,SUBTYPE_PROGRAM3D),context3D(_ct),gpu_program(UINT32_MAX),vcPositionScale(UINT32_MAX){}
@@ -326,6 +337,7 @@ public:
 class VertexBuffer3D: public ASObject
 {
 friend class Context3D;
+friend class SoftwareContext3D;
 protected:
 	Context3D* context;
 	uint32_t bufferID;
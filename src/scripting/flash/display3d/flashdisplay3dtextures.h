@@ -31,6 +31,7 @@ namespace lightspark
 class TextureBase: public EventDispatcher
 {
 friend class Context3D;
+friend class SoftwareContext3D;
 protected:
 	uint32_t textureID;
 	uint32_t width;
@@ -0,0 +1,814 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2017 Ludger Krämer <dbluelle@onlinehome.de>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "scripting/flash/display3d/softwarecontext3d.h"
+#include "backends/softwarerendering.h"
+#include "backends/rendering.h"
+#include "backends/bitmapfilters.h"
+#include "swf.h"
+#include "logger.h"
+#include <cmath>
+#include <cstring>
+
+using namespace std;
+using namespace lightspark;
+
+namespace
+{
+
+/*
+ * The clip volume of Stage3D is -w<=x<=w, -w<=y<=w, 0<=z<=w. The planes
+ * of x and y are moved out to STAGE3D_GUARD_BAND*w, the rasterizer only
+ * visits the pixels of the render target anyway
+ */
+#define STAGE3D_CLIP_PLANES 7
+//Vertices closer than this to the w=0 plane are clipped
+#define STAGE3D_MIN_W 1e-5f
+
+float planeDistance(const float* v, uint32_t plane)
+{
+	switch(plane)
+	{
+		case 0:
+			return v[3]-STAGE3D_MIN_W;
+		case 1:
+			return v[2];
+		case 2:
+			return v[3]-v[2];
+		case 3:
+			return STAGE3D_GUARD_BAND*v[3]+v[0];
+		case 4:
+			return STAGE3D_GUARD_BAND*v[3]-v[0];
+		case 5:
+			return STAGE3D_GUARD_BAND*v[3]+v[1];
+		default:
+			return STAGE3D_GUARD_BAND*v[3]-v[1];
+	}
+}
+
+uint8_t computeOutcode(const float* v)
+{
+	uint8_t ret=0;
+	for(uint32_t i=0;i<STAGE3D_CLIP_PLANES;i++)
+	{
+		//NaN is outside too
+		if(!(planeDistance(v,i)>=0))
+			ret|=1<<i;
+	}
+	return ret;
+}
+
+inline uint32_t packComponent(float f)
+{
+	if(!(f>0))
+		return 0;
+	if(f>=1)
+		return 255;
+	return uint32_t(f*255.0f+0.5f);
+}
+
+//ARGB from RGBA
+inline uint32_t packColor(const float* c)
+{
+	return (packComponent(c[3])<<24)|(packComponent(c[0])<<16)|(packComponent(c[1])<<8)|packComponent(c[2]);
+}
+
+inline void unpackColor(uint32_t p, float* c)
+{
+	c[0]=((p>>16)&0xff)*(1.0f/255.0f);
+	c[1]=((p>>8)&0xff)*(1.0f/255.0f);
+	c[2]=(p&0xff)*(1.0f/255.0f);
+	c[3]=(p>>24)*(1.0f/255.0f);
+}
+
+inline bool depthTest(DEPTH_FUNCTION f, float z, float d)
+{
+	switch(f)
+	{
+		case ALWAYS: return true;
+		case EQUAL: return z==d;
+		case GREATER: return z>d;
+		case GREATER_EQUAL: return z>=d;
+		case LESS: return z<d;
+		case LESS_EQUAL: return z<=d;
+		case NEVER: return false;
+		case NOT_EQUAL: return z!=d;
+	}
+	return true;
+}
+
+void blendFactor(BLEND_FACTOR f, const float* s, const float* d, float* out)
+{
+	for(uint32_t i=0;i<4;i++)
+	{
+		switch(f)
+		{
+			case BLEND_ONE: out[i]=1; break;
+			case BLEND_ZERO: out[i]=0; break;
+			case BLEND_SRC_ALPHA: out[i]=s[3]; break;
+			case BLEND_SRC_COLOR: out[i]=s[i]; break;
+			case BLEND_DST_ALPHA: out[i]=d[3]; break;
+			case BLEND_DST_COLOR: out[i]=d[i]; break;
+			case BLEND_ONE_MINUS_SRC_ALPHA: out[i]=1-s[3]; break;
+			case BLEND_ONE_MINUS_SRC_COLOR: out[i]=1-s[i]; break;
+			case BLEND_ONE_MINUS_DST_ALPHA: out[i]=1-d[3]; break;
+			case BLEND_ONE_MINUS_DST_COLOR: out[i]=1-d[i]; break;
+		}
+	}
+}
+
+//Fragments of a triangle waiting to be shaded together
+struct fragmentBatch
+{
+	uint32_t offset[AGAL_LANES];
+	float l[3][AGAL_LANES];
+	float z[AGAL_LANES];
+	uint32_t count;
+};
+
+}
+
+SoftwareContext3D::SoftwareContext3D(Context3D* c):context(c),target(&backBuffer)
+  ,sourceFactor(BLEND_ONE),destinationFactor(BLEND_ZERO),depthFunction(LESS),depthMask(true),culling(FACE_NONE)
+  ,scissorEnabled(false),scissorX(0),scissorY(0),scissorWidth(0),scissorHeight(0),colorMask(0xf)
+  ,clipXmin(0),clipXmax(0),clipYmin(0),clipYmax(0),drawStamp(0),backBufferChanged(false)
+{
+	for(uint32_t i=0;i<CONTEXT3D_ATTRIBUTE_COUNT;i++)
+	{
+		vertexOffsets[i]=0;
+		vertexFormats[i]=FLOAT_4;
+	}
+}
+
+SoftwareContext3D::~SoftwareContext3D()
+{
+	RenderThread* rt=context->getSystemState()->getRenderThread();
+	if(chunk.isValid() && rt)
+		rt->releaseTexture(chunk);
+}
+
+void SoftwareContext3D::resizeTarget(renderTarget& t, uint32_t w, uint32_t h, bool depth)
+{
+	t.width=w;
+	t.height=h;
+	t.color.resize(w*h);
+	t.depthEnabled=depth;
+	if(depth)
+		t.depth.assign(w*h,1.0f);
+	else
+		t.depth.clear();
+}
+
+void SoftwareContext3D::setTargetTexture(TextureBase* tex, bool depth)
+{
+	flushTargetTexture();
+	tex->incRef();
+	targetTexture=_MR(tex);
+	resizeTarget(textureBuffer,tex->width,tex->height,depth);
+	//Start from the current content of the texture
+	const uint32_t size=tex->width*tex->height;
+	if(tex->bitmaparray.size() && tex->bitmaparray[0].size()>=size*(tex->hasalpha ? 4 : 3))
+	{
+		const uint8_t* p=tex->bitmaparray[0].data();
+		const uint32_t bpp=tex->hasalpha ? 4 : 3;
+		for(uint32_t i=0;i<size;i++,p+=bpp)
+			textureBuffer.color[i]=((bpp==4 ? p[3] : 0xff)<<24)|(p[0]<<16)|(p[1]<<8)|p[2];
+	}
+	else
+		memset(textureBuffer.color.data(),0,size*4);
+	target=&textureBuffer;
+}
+
+void SoftwareContext3D::flushTargetTexture()
+{
+	if(targetTexture.isNull())
+		return;
+	TextureBase* tex=targetTexture.getPtr();
+	if(tex->width==textureBuffer.width && tex->height==textureBuffer.height)
+	{
+		const uint32_t size=textureBuffer.width*textureBuffer.height;
+		if(tex->bitmaparray.empty())
+			tex->bitmaparray.resize(1);
+		tex->bitmaparray[0].resize(size*4);
+		uint8_t* p=tex->bitmaparray[0].data();
+		for(uint32_t i=0;i<size;i++,p+=4)
+		{
+			const uint32_t c=textureBuffer.color[i];
+			p[0]=(c>>16)&0xff;
+			p[1]=(c>>8)&0xff;
+			p[2]=c&0xff;
+			p[3]=c>>24;
+		}
+		tex->hasalpha=true;
+		tex->needrefresh=true;
+	}
+	targetTexture.reset();
+	target=&backBuffer;
+}
+
+void SoftwareContext3D::clear(const renderaction& action)
+{
+	const uint32_t size=target->width*target->height;
+	if((action.udata2 & CLEARMASK::COLOR) != 0)
+	{
+		const uint32_t color=packColor(action.fdata);
+		uint32_t* p=target->color.data();
+		if(colorMask==0xf)
+			fill(p,p+size,color);
+		else
+		{
+			//The color mask applies to clear too
+			uint32_t mask=0;
+			if(colorMask&0x01)
+				mask|=0x00ff0000;
+			if(colorMask&0x02)
+				mask|=0x0000ff00;
+			if(colorMask&0x04)
+				mask|=0x000000ff;
+			if(colorMask&0x08)
+				mask|=0xff000000;
+			for(uint32_t i=0;i<size;i++)
+				p[i]=(p[i]&~mask)|(color&mask);
+		}
+	}
+	if((action.udata2 & CLEARMASK::DEPTH) != 0 && target->depthEnabled)
+	{
+		const float depth=action.fdata[4]<0 ? 0 : (action.fdata[4]>1 ? 1 : action.fdata[4]);
+		fill(target->depth.begin(),target->depth.end(),depth);
+	}
+	if((action.udata2 & CLEARMASK::STENCIL) != 0 && action.udata1)
+		LOG(LOG_NOT_IMPLEMENTED,"Stage3D software rendering: stencil buffer not supported");
+	if(target==&backBuffer)
+		backBufferChanged=true;
+}
+
+void SoftwareContext3D::handleRenderAction(renderaction& action)
+{
+	switch (action.action)
+	{
+		case RENDER_CLEAR:
+			clear(action);
+			delete[] action.fdata;
+			break;
+		case RENDER_CONFIGUREBACKBUFFER:
+			//action.udata1 = enableDepthAndStencil
+			//action.udata2 = width
+			//action.udata3 = height
+			resizeTarget(backBuffer,action.udata2,action.udata3,action.udata1);
+			memset(backBuffer.color.data(),0,backBuffer.color.size()*4);
+			backBufferChanged=true;
+			break;
+		case RENDER_SETPROGRAM:
+			//action.dataobject = Program3D
+			if(action.dataobject.isNull())
+				program.reset();
+			else
+			{
+				action.dataobject->incRef();
+				program=_MR(action.dataobject->as<Program3D>());
+			}
+			break;
+		case RENDER_RENDERTOBACKBUFFER:
+			flushTargetTexture();
+			break;
+		case RENDER_TOTEXTURE:
+			//action.dataobject = TextureBase
+			//action.udata1 = enableDepthAndStencil
+			setTargetTexture(action.dataobject->as<TextureBase>(),action.udata1);
+			break;
+		case RENDER_DELETEPROGRAM:
+			if(program.getPtr()==action.dataobject.getPtr())
+				program.reset();
+			break;
+		case RENDER_SETVERTEXBUFFER:
+			//action.dataobject = VertexBuffer3D, NULL to disable the attribute
+			//action.udata1 = index
+			//action.udata2 = bufferOffset
+			//action.udata3 = format
+			if(action.udata1<CONTEXT3D_ATTRIBUTE_COUNT)
+			{
+				if(action.dataobject.isNull())
+					vertexBuffers[action.udata1].reset();
+				else
+				{
+					action.dataobject->incRef();
+					vertexBuffers[action.udata1]=_MR(action.dataobject->as<VertexBuffer3D>());
+				}
+				vertexOffsets[action.udata1]=action.udata2;
+				vertexFormats[action.udata1]=(VERTEXBUFFER_FORMAT)action.udata3;
+			}
+			break;
+		case RENDER_DRAWTRIANGLES:
+		{
+			//action.dataobject = IndexBuffer3D
+			//action.udata1 = firstIndex
+			//action.udata2 = numTriangles
+			IndexBuffer3D* buffer=action.dataobject->as<IndexBuffer3D>();
+			uint32_t count=(action.udata2 == UINT32_MAX) ? buffer->data.size() : (action.udata2 * 3);
+			if(action.udata1>buffer->data.size())
+				break;
+			count=min(count,uint32_t(buffer->data.size()-action.udata1));
+			drawTriangles(buffer,action.udata1,count);
+			break;
+		}
+		case RENDER_DELETEBUFFER:
+			break;
+		case RENDER_SETPROGRAMCONSTANTS_FROM_MATRIX:
+		case RENDER_SETPROGRAMCONSTANTS_FROM_VECTOR:
+			context->setProgramConstants(action);
+			break;
+		case RENDER_SETTEXTUREAT:
+			//action.dataobject = TextureBase
+			//action.udata1 = sampler
+			if(action.udata1<CONTEXT3D_SAMPLER_COUNT)
+			{
+				if(action.dataobject.isNull())
+					textures[action.udata1].reset();
+				else
+				{
+					action.dataobject->incRef();
+					textures[action.udata1]=_MR(action.dataobject->as<TextureBase>());
+				}
+			}
+			break;
+		case RENDER_SETBLENDFACTORS:
+			sourceFactor=(BLEND_FACTOR)action.udata1;
+			destinationFactor=(BLEND_FACTOR)action.udata2;
+			break;
+		case RENDER_SETDEPTHTEST:
+			depthMask=action.udata1;
+			depthFunction=(DEPTH_FUNCTION)action.udata2;
+			break;
+		case RENDER_SETCULLING:
+			culling=(TRIANGLE_FACE)action.udata1;
+			break;
+		case RENDER_LOADTEXTURE:
+		case RENDER_LOADCUBETEXTURE:
+			//Textures are sampled from the uploaded data
+			break;
+		case RENDER_SETSCISSORRECTANGLE:
+			// action.fdata = x,y,width,height
+			scissorEnabled=true;
+			scissorX=action.fdata[0];
+			scissorY=action.fdata[1];
+			scissorWidth=action.fdata[2];
+			scissorHeight=action.fdata[3];
+			delete[] action.fdata;
+			break;
+		case RENDER_SETCOLORMASK:
+			// action.udata1 = red | green | blue | alpha
+			colorMask=action.udata1&0xf;
+			break;
+	}
+}
+
+void SoftwareContext3D::endFrame()
+{
+	flushTargetTexture();
+}
+
+void SoftwareContext3D::shadeVertices(int32_t begin, int32_t end)
+{
+	const AGALProgram& vertexProgram=program->vertexAGAL;
+	const uint32_t attributes=vertexProgram.getAttributeMask();
+	const uint32_t varyings=program->fragmentAGAL.getVaryingMask();
+	const uint32_t count=uniqueVertices.size();
+	AGALState state;
+	memset(&state,0,sizeof(state));
+	state.constants=context->vertexConstants[0].data;
+	state.textures=samplers;
+	for(int32_t batch=begin;batch<end;batch++)
+	{
+		const uint32_t first=batch*AGAL_LANES;
+		for(uint32_t i=0;i<CONTEXT3D_ATTRIBUTE_COUNT;i++)
+		{
+			if((attributes&(1<<i))==0)
+				continue;
+			const VertexBuffer3D* buffer=vertexBuffers[i].getPtr();
+			for(uint32_t l=0;l<AGAL_LANES;l++)
+			{
+				//The last lanes of the last batch repeat its last vertex
+				const uint32_t vertex=uniqueVertices[min(first+l,count-1)];
+				float v[4]={0,0,0,1};
+				if(buffer && vertex<buffer->numVertices)
+				{
+					const uint32_t pos=vertex*buffer->data32PerVertex+vertexOffsets[i];
+					const float* d=buffer->data.data()+pos;
+					switch(vertexFormats[i])
+					{
+						case BYTES_4:
+							if(pos<buffer->data.size())
+							{
+								//The 4 bytes of the slot are normalized
+								const uint8_t* b=(const uint8_t*)d;
+								for(uint32_t j=0;j<4;j++)
+									v[j]=b[j]*(1.0f/255.0f);
+							}
+							break;
+						default:
+						{
+							const uint32_t n=vertexFormats[i]-FLOAT_1+1;
+							if(pos+n<=buffer->data.size())
+							{
+								for(uint32_t j=0;j<n;j++)
+									v[j]=d[j];
+							}
+							break;
+						}
+					}
+				}
+				for(uint32_t j=0;j<4;j++)
+					state.attributes[i].c[j][l]=v[j];
+			}
+		}
+		vertexProgram.execute(state);
+		for(uint32_t l=0;l<AGAL_LANES && first+l<count;l++)
+		{
+			float* out=&shadedVertices[(first+l)*STAGE3D_VERTEX_SIZE];
+			for(uint32_t j=0;j<4;j++)
+				out[j]=state.output.c[j][l];
+			for(uint32_t r=0;r<AGAL_MAX_VARYINGS;r++)
+			{
+				if((varyings&(1<<r))==0)
+					continue;
+				for(uint32_t j=0;j<4;j++)
+					out[4+r*4+j]=state.varyings[r].c[j][l];
+			}
+		}
+	}
+}
+
+void SoftwareContext3D::project(const float* in, float* out) const
+{
+	//The top of the clip space is the first row of the render target
+	const float invw=1.0f/in[3];
+	out[0]=(in[0]*invw+1.0f)*0.5f*target->width;
+	out[1]=(1.0f-in[1]*invw)*0.5f*target->height;
+	out[2]=in[2]*invw;
+	out[3]=invw;
+	for(uint32_t i=4;i<STAGE3D_VERTEX_SIZE;i++)
+		out[i]=in[i]*invw;
+}
+
+void SoftwareContext3D::clipTriangle(uint32_t a, uint32_t b, uint32_t c, uint8_t planes)
+{
+	//Sutherland-Hodgman on the clip space vertices, every plane adds at most one vertex
+	vector<float> polygon[2];
+	polygon[0].reserve((3+STAGE3D_CLIP_PLANES)*STAGE3D_VERTEX_SIZE);
+	polygon[1].reserve((3+STAGE3D_CLIP_PLANES)*STAGE3D_VERTEX_SIZE);
+	const uint32_t vertices[3]={a,b,c};
+	for(uint32_t i=0;i<3;i++)
+	{
+		const float* v=&shadedVertices[vertices[i]*STAGE3D_VERTEX_SIZE];
+		polygon[0].insert(polygon[0].end(),v,v+STAGE3D_VERTEX_SIZE);
+	}
+	uint32_t current=0;
+	for(uint32_t p=0;p<STAGE3D_CLIP_PLANES;p++)
+	{
+		if((planes&(1<<p))==0)
+			continue;
+		const vector<float>& in=polygon[current];
+		vector<float>& out=polygon[1-current];
+		out.clear();
+		const uint32_t count=in.size()/STAGE3D_VERTEX_SIZE;
+		for(uint32_t i=0;i<count;i++)
+		{
+			const float* v0=&in[i*STAGE3D_VERTEX_SIZE];
+			const float* v1=&in[((i+1)%count)*STAGE3D_VERTEX_SIZE];
+			const float d0=planeDistance(v0,p);
+			const float d1=planeDistance(v1,p);
+			if(d0>=0)
+				out.insert(out.end(),v0,v0+STAGE3D_VERTEX_SIZE);
+			if((d0>=0)!=(d1>=0))
+			{
+				const float t=d0/(d0-d1);
+				for(uint32_t j=0;j<STAGE3D_VERTEX_SIZE;j++)
+					out.push_back(v0[j]+(v1[j]-v0[j])*t);
+			}
+		}
+		current=1-current;
+		if(polygon[current].size()<3*STAGE3D_VERTEX_SIZE)
+			return;
+	}
+	const vector<float>& result=polygon[current];
+	const uint32_t count=result.size()/STAGE3D_VERTEX_SIZE;
+	const uint32_t first=projectedVertices.size()/STAGE3D_VERTEX_SIZE;
+	projectedVertices.resize(projectedVertices.size()+result.size());
+	for(uint32_t i=0;i<count;i++)
+		project(&result[i*STAGE3D_VERTEX_SIZE],&projectedVertices[(first+i)*STAGE3D_VERTEX_SIZE]);
+	for(uint32_t i=1;i+1<count;i++)
+		addTriangle(first,first+i,first+i+1);
+}
+
+void SoftwareContext3D::addTriangle(uint32_t a, uint32_t b, uint32_t c)
+{
+	const float* v0=&projectedVertices[a*STAGE3D_VERTEX_SIZE];
+	const float* v1=&projectedVertices[b*STAGE3D_VERTEX_SIZE];
+	const float* v2=&projectedVertices[c*STAGE3D_VERTEX_SIZE];
+	const float area=(v1[0]-v0[0])*(v2[1]-v0[1])-(v2[0]-v0[0])*(v1[1]-v0[1]);
+	//Also rejects NaN
+	if(!(area>0) && !(area<0))
+		return;
+	//As in OpenGL with a clockwise front face, the area is positive for clockwise triangles on screen
+	if(culling==FACE_FRONT_AND_BACK || (culling==FACE_FRONT && area>0) || (culling==FACE_BACK && area<0))
+		return;
+	triangle t;
+	t.v[0]=a*STAGE3D_VERTEX_SIZE;
+	t.v[1]=(area>0 ? b : c)*STAGE3D_VERTEX_SIZE;
+	t.v[2]=(area>0 ? c : b)*STAGE3D_VERTEX_SIZE;
+	t.area=fabsf(area);
+	t.xmin=imax(int32_t(floorf(min(v0[0],min(v1[0],v2[0])))),clipXmin);
+	t.xmax=imin(int32_t(ceilf(max(v0[0],max(v1[0],v2[0])))),clipXmax);
+	t.ymin=imax(int32_t(floorf(min(v0[1],min(v1[1],v2[1])))),clipYmin);
+	t.ymax=imin(int32_t(ceilf(max(v0[1],max(v1[1],v2[1])))),clipYmax);
+	if(t.xmin>=t.xmax || t.ymin>=t.ymax)
+		return;
+	triangles.push_back(t);
+}
+
+void SoftwareContext3D::rasterizeRows(int32_t begin, int32_t end)
+{
+	const AGALProgram& fragmentProgram=program->fragmentAGAL;
+	const uint32_t varyings=fragmentProgram.getVaryingMask();
+	float* depthBuffer=target->depthEnabled ? target->depth.data() : NULL;
+	uint32_t* colorBuffer=target->color.data();
+	const bool blending=sourceFactor!=BLEND_ONE || destinationFactor!=BLEND_ZERO;
+	AGALState state;
+	memset(&state,0,sizeof(state));
+	state.constants=context->fragmentConstants[0].data;
+	state.textures=samplers;
+	fragmentBatch batch;
+	batch.count=0;
+
+	//Shades the fragments of the batch and writes the ones that are not killed
+	auto shade=[&](const float* const* v)
+	{
+		for(uint32_t l=batch.count;l<AGAL_LANES;l++)
+		{
+			for(uint32_t i=0;i<3;i++)
+				batch.l[i][l]=batch.l[i][0];
+		}
+		float correction[AGAL_LANES];
+		for(uint32_t l=0;l<AGAL_LANES;l++)
+			correction[l]=1.0f/(batch.l[0][l]*v[0][3]+batch.l[1][l]*v[1][3]+batch.l[2][l]*v[2][3]);
+		for(uint32_t r=0;r<AGAL_MAX_VARYINGS;r++)
+		{
+			if((varyings&(1<<r))==0)
+				continue;
+			for(uint32_t j=0;j<4;j++)
+			{
+				const uint32_t k=4+r*4+j;
+				for(uint32_t l=0;l<AGAL_LANES;l++)
+					state.varyings[r].c[j][l]=(batch.l[0][l]*v[0][k]+batch.l[1][l]*v[1][k]+batch.l[2][l]*v[2][k])*correction[l];
+			}
+		}
+		fragmentProgram.execute(state);
+		for(uint32_t l=0;l<batch.count;l++)
+		{
+			if(state.killed[l])
+				continue;
+			const uint32_t offset=batch.offset[l];
+			if(depthBuffer && depthMask)
+				depthBuffer[offset]=batch.z[l];
+			float s[4];
+			for(uint32_t j=0;j<4;j++)
+				s[j]=state.output.c[j][l];
+			uint32_t color;
+			if(blending)
+			{
+				float d[4];
+				unpackColor(colorBuffer[offset],d);
+				for(uint32_t j=0;j<4;j++)
+					s[j]=s[j]<0 ? 0 : (s[j]>1 ? 1 : s[j]);
+				float fs[4];
+				float fd[4];
+				blendFactor(sourceFactor,s,d,fs);
+				blendFactor(destinationFactor,s,d,fd);
+				float c[4];
+				for(uint32_t j=0;j<4;j++)
+					c[j]=s[j]*fs[j]+d[j]*fd[j];
+				color=packColor(c);
+			}
+			else
+				color=packColor(s);
+			if(colorMask!=0xf)
+			{
+				uint32_t mask=0;
+				if(colorMask&0x01)
+					mask|=0x00ff0000;
+				if(colorMask&0x02)
+					mask|=0x0000ff00;
+				if(colorMask&0x04)
+					mask|=0x000000ff;
+				if(colorMask&0x08)
+					mask|=0xff000000;
+				color=(colorBuffer[offset]&~mask)|(color&mask);
+			}
+			colorBuffer[offset]=color;
+		}
+		batch.count=0;
+	};
+
+	for(auto it=triangles.begin();it!=triangles.end();++it)
+	{
+		const triangle& t=*it;
+		if(t.ymax<=begin || t.ymin>=end)
+			continue;
+		const float* v[3];
+		for(uint32_t i=0;i<3;i++)
+			v[i]=&projectedVertices[t.v[i]];
+		//Edge function i is positive inside the triangle and equals area on the vertex i
+		float dx[3];
+		float dy[3];
+		bool topLeft[3];
+		for(uint32_t i=0;i<3;i++)
+		{
+			const float* vj=v[(i+1)%3];
+			const float* vk=v[(i+2)%3];
+			dx[i]=-(vk[1]-vj[1]);
+			dy[i]=vk[0]-vj[0];
+			topLeft[i]=(vk[1]==vj[1] && vk[0]>vj[0]) || vk[1]<vj[1];
+		}
+		const float invArea=1.0f/t.area;
+		const int32_t ymin=imax(t.ymin,begin);
+		const int32_t ymax=imin(t.ymax,end);
+		for(int32_t y=ymin;y<ymax;y++)
+		{
+			const float py=y+0.5f;
+			for(int32_t x=t.xmin;x<t.xmax;x++)
+			{
+				const float px=x+0.5f;
+				float e[3];
+				bool inside=true;
+				for(uint32_t i=0;i<3 && inside;i++)
+				{
+					const float* vj=v[(i+1)%3];
+					e[i]=dx[i]*(px-vj[0])+dy[i]*(py-vj[1]);
+					inside=e[i]>0 || (e[i]==0 && topLeft[i]);
+				}
+				if(!inside)
+					continue;
+				const float l0=e[0]*invArea;
+				const float l1=e[1]*invArea;
+				const float l2=e[2]*invArea;
+				float z=l0*v[0][2]+l1*v[1][2]+l2*v[2][2];
+				z=z<0 ? 0 : (z>1 ? 1 : z);
+				const uint32_t offset=y*target->width+x;
+				if(depthBuffer && !depthTest(depthFunction,z,depthBuffer[offset]))
+					continue;
+				const uint32_t l=batch.count++;
+				batch.offset[l]=offset;
+				batch.l[0][l]=l0;
+				batch.l[1][l]=l1;
+				batch.l[2][l]=l2;
+				batch.z[l]=z;
+				if(batch.count==AGAL_LANES)
+					shade(v);
+			}
+		}
+		if(batch.count)
+			shade(v);
+	}
+}
+
+void SoftwareContext3D::drawTriangles(IndexBuffer3D* buffer, uint32_t first, uint32_t count)
+{
+	if(program.isNull() || program->vertexAGAL.empty() || program->fragmentAGAL.empty())
+		return;
+	if(target->width==0 || target->height==0 || count<3)
+		return;
+	SystemState* sys=context->getSystemState();
+
+	clipXmin=0;
+	clipYmin=0;
+	clipXmax=target->width;
+	clipYmax=target->height;
+	if(scissorEnabled)
+	{
+		clipXmin=imax(clipXmin,scissorX);
+		clipYmin=imax(clipYmin,scissorY);
+		clipXmax=imin(clipXmax,scissorX+scissorWidth);
+		clipYmax=imin(clipYmax,scissorY+scissorHeight);
+		if(clipXmin>=clipXmax || clipYmin>=clipYmax)
+			return;
+	}
+
+	for(uint32_t i=0;i<AGAL_MAX_SAMPLERS;i++)
+	{
+		samplers[i]=AGALTexture();
+		const TextureBase* tex=textures[i].getPtr();
+		if(tex==NULL || tex->bitmaparray.empty())
+			continue;
+		const uint32_t bpp=tex->hasalpha ? 4 : 3;
+		if(tex->width && tex->height && tex->bitmaparray[0].size()>=tex->width*tex->height*bpp)
+		{
+			samplers[i].pixels=tex->bitmaparray[0].data();
+			samplers[i].width=tex->width;
+			samplers[i].height=tex->height;
+			samplers[i].bytesPerPixel=bpp;
+		}
+	}
+
+	//Every vertex is shaded once, even if it is used by many triangles
+	const uint16_t* indices=buffer->data.data()+first;
+	if(vertexSlots.empty())
+	{
+		vertexSlots.resize(UINT16_MAX+1);
+		vertexStamps.resize(UINT16_MAX+1,0);
+	}
+	if(++drawStamp==0)
+	{
+		fill(vertexStamps.begin(),vertexStamps.end(),0);
+		drawStamp=1;
+	}
+	uniqueVertices.clear();
+	for(uint32_t i=0;i<count;i++)
+	{
+		const uint16_t index=indices[i];
+		if(vertexStamps[index]!=drawStamp)
+		{
+			vertexStamps[index]=drawStamp;
+			vertexSlots[index]=uniqueVertices.size();
+			uniqueVertices.push_back(index);
+		}
+	}
+	const uint32_t vertexCount=uniqueVertices.size();
+	shadedVertices.resize(vertexCount*STAGE3D_VERTEX_SIZE);
+	parallelFilterRange(sys,(vertexCount+AGAL_LANES-1)/AGAL_LANES,[this](int32_t begin, int32_t end)
+	{
+		shadeVertices(begin,end);
+	},STAGE3D_VERTEX_GRAIN);
+
+	outcodes.resize(vertexCount);
+	projectedVertices.resize(vertexCount*STAGE3D_VERTEX_SIZE);
+	for(uint32_t i=0;i<vertexCount;i++)
+	{
+		const float* v=&shadedVertices[i*STAGE3D_VERTEX_SIZE];
+		outcodes[i]=computeOutcode(v);
+		if(outcodes[i]==0)
+			project(v,&projectedVertices[i*STAGE3D_VERTEX_SIZE]);
+	}
+
+	triangles.clear();
+	for(uint32_t i=0;i+2<count;i+=3)
+	{
+		const uint32_t a=vertexSlots[indices[i]];
+		const uint32_t b=vertexSlots[indices[i+1]];
+		const uint32_t c=vertexSlots[indices[i+2]];
+		const uint8_t outside=outcodes[a]|outcodes[b]|outcodes[c];
+		if(outside==0)
+			addTriangle(a,b,c);
+		else if((outcodes[a]&outcodes[b]&outcodes[c])==0)
+			clipTriangle(a,b,c,outside);
+	}
+	if(triangles.empty())
+		return;
+
+	//Every job owns a band of rows, the triangles are drawn in order in each band
+	parallelFilterRange(sys,clipYmax-clipYmin,[this](int32_t begin, int32_t end)
+	{
+		rasterizeRows(begin+clipYmin,end+clipYmin);
+	},STAGE3D_BAND_ROWS);
+	if(target==&backBuffer)
+		backBufferChanged=true;
+}
+
+void SoftwareContext3D::render(SoftwareRenderContext& ctxt, int32_t x, int32_t y)
+{
+	const uint32_t w=backBuffer.width;
+	const uint32_t h=backBuffer.height;
+	if(w==0 || h==0)
+		return;
+	if(backBufferChanged || !chunk.isValid())
+	{
+		if(!chunk.isValid() || !chunk.resizeIfLargeEnough(w,h))
+			chunk=context->getSystemState()->getRenderThread()->allocateTexture(w,h,true);
+		if(!chunk.isValid())
+			return;
+		//The back buffer is opaque on the stage
+		uploadPixels.resize(w*h);
+		for(uint32_t i=0;i<w*h;i++)
+			uploadPixels[i]=backBuffer.color[i]|0xff000000;
+		ctxt.loadChunkBGRA(chunk,w,h,(const uint8_t*)uploadPixels.data());
+		backBufferChanged=false;
+	}
+	ctxt.lsglLoadIdentity();
+	ctxt.setProperties(BLENDMODE_NORMAL);
+	ctxt.renderTextured(chunk,x,y,w,h,1.0,RenderContext::RGB_MODE);
+}
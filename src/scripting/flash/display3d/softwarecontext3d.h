@@ -0,0 +1,128 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2017 Ludger Krämer <dbluelle@onlinehome.de>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+#ifndef SOFTWARECONTEXT3D_H
+#define SOFTWARECONTEXT3D_H
+
+#include "compat.h"
+#include "backends/graphics.h"
+#include "scripting/flash/display3d/flashdisplay3d.h"
+#include "scripting/flash/display3d/agalinterpreter.h"
+#include <vector>
+
+namespace lightspark
+{
+class SoftwareRenderContext;
+
+//Floats of a vertex: the position followed by the varyings
+#define STAGE3D_VERTEX_SIZE (4+4*AGAL_MAX_VARYINGS)
+//Rows of the render target a job of the rasterizer works on
+#define STAGE3D_BAND_ROWS 16
+//Vertices are shaded in jobs of this many AGAL_LANES wide batches
+#define STAGE3D_VERTEX_GRAIN 64
+//Triangles are only clipped on the sides if they get this far out of the viewport
+#define STAGE3D_GUARD_BAND 4.0f
+
+/*
+ * Renders the actions of a Context3D on the CPU, used when Stage3D is
+ * displayed by the SoftwareRenderContext.
+ * The AGAL programs are run by AGALProgram, the vertices of a draw call and
+ * the rows of the render target are split across the thread pool. The
+ * render target is a buffer of non premultiplied ARGB pixels and one of
+ * depth values, the back buffer is composited by render, textures rendered
+ * to are copied back to the level 0 of the TextureBase.
+ * Stencil operations, mipmaps and cube textures are not supported.
+ */
+class SoftwareContext3D
+{
+private:
+	struct renderTarget
+	{
+		std::vector<uint32_t> color;
+		std::vector<float> depth;
+		uint32_t width;
+		uint32_t height;
+		bool depthEnabled;
+		renderTarget():width(0),height(0),depthEnabled(false) {}
+	};
+	struct triangle
+	{
+		//Vertices in projectedVertices
+		uint32_t v[3];
+		//Area covered in the render target
+		int32_t xmin,xmax,ymin,ymax;
+		float area;
+	};
+	Context3D* context;
+	renderTarget backBuffer;
+	renderTarget textureBuffer;
+	renderTarget* target;
+	_NR<TextureBase> targetTexture;
+	_NR<Program3D> program;
+	_NR<VertexBuffer3D> vertexBuffers[CONTEXT3D_ATTRIBUTE_COUNT];
+	uint32_t vertexOffsets[CONTEXT3D_ATTRIBUTE_COUNT];
+	VERTEXBUFFER_FORMAT vertexFormats[CONTEXT3D_ATTRIBUTE_COUNT];
+	_NR<TextureBase> textures[CONTEXT3D_SAMPLER_COUNT];
+	AGALTexture samplers[AGAL_MAX_SAMPLERS];
+	BLEND_FACTOR sourceFactor;
+	BLEND_FACTOR destinationFactor;
+	DEPTH_FUNCTION depthFunction;
+	bool depthMask;
+	TRIANGLE_FACE culling;
+	bool scissorEnabled;
+	int32_t scissorX,scissorY,scissorWidth,scissorHeight;
+	uint32_t colorMask;
+	//Area of the render target drawn by the current draw call
+	int32_t clipXmin,clipXmax,clipYmin,clipYmax;
+	//Slot of each vertex index in the shaded vertices, valid if its stamp is drawStamp
+	std::vector<uint32_t> vertexSlots;
+	std::vector<uint32_t> vertexStamps;
+	uint32_t drawStamp;
+	std::vector<uint16_t> uniqueVertices;
+	//Clip space vertices
+	std::vector<float> shadedVertices;
+	//Bit i is set if a shaded vertex is outside of the clip plane i
+	std::vector<uint8_t> outcodes;
+	//Screen space vertices, the varyings are divided by w for perspective correction
+	std::vector<float> projectedVertices;
+	std::vector<triangle> triangles;
+	std::vector<uint32_t> uploadPixels;
+	TextureChunk chunk;
+	bool backBufferChanged;
+	void resizeTarget(renderTarget& t, uint32_t w, uint32_t h, bool depth);
+	void setTargetTexture(TextureBase* tex, bool depth);
+	void flushTargetTexture();
+	void clear(const renderaction& action);
+	void shadeVertices(int32_t begin, int32_t end);
+	void project(const float* in, float* out) const;
+	void clipTriangle(uint32_t a, uint32_t b, uint32_t c, uint8_t planes);
+	void addTriangle(uint32_t a, uint32_t b, uint32_t c);
+	void rasterizeRows(int32_t begin, int32_t end);
+	void drawTriangles(IndexBuffer3D* buffer, uint32_t first, uint32_t count);
+public:
+	SoftwareContext3D(Context3D* c);
+	~SoftwareContext3D();
+	void handleRenderAction(renderaction& action);
+	//Called after the actions of a frame, rendering goes back to the back buffer
+	void endFrame();
+	//Composites the back buffer at (x,y)
+	void render(SoftwareRenderContext& ctxt, int32_t x, int32_t y);
+};
+
+};
+#endif // SOFTWARECONTEXT3D_H
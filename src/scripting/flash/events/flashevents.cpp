@@ -565,6 +565,33 @@ bool EventDispatcher::destruct()
 	return ASObject::destruct();
 }
 
+void EventDispatcher::collectReferences(gc_references& refs)
+{
+	Locker l(handlersMutex);
+	for(auto it=handlers.begin();it!=handlers.end();++it)
+	{
+		for(auto it2=it->second.begin();it2!=it->second.end();++it2)
+			refs.addOwned(it2->f);
+	}
+	ASObject::collectReferences(refs);
+}
+
+void EventDispatcher::releaseReferences()
+{
+	{
+		Locker l(handlersMutex);
+		for(auto it=handlers.begin();it!=handlers.end();++it)
+		{
+			for(auto it2=it->second.begin();it2!=it->second.end();++it2)
+			{
+				ASATOM_DECREF(it2->f);
+			}
+		}
+		handlers.clear();
+	}
+	ASObject::releaseReferences();
+}
+
 void EventDispatcher::sinit(Class_base* c)
 {
 	CLASS_SETUP(c, ASObject, _constructor, CLASS_SEALED);
@@ -1098,14 +1125,13 @@ ABCContextInitEvent::ABCContextInitEvent(ABCContext* c, bool l):Event(nullptr, "
 {
 }
 
-AVM1InitActionEvent::AVM1InitActionEvent(DefineSpriteTag* s, std::vector<uint8_t> a, uint32_t p, _NR<MovieClip> c):Event(nullptr, "AVM1InitActionEvent"),sprite(s),actions(a),startactionpos(p),clip(c)
+AVM1InitActionEvent::AVM1InitActionEvent(DefineSpriteTag* s, _NR<AVM1Program> a, _NR<MovieClip> c):Event(nullptr, "AVM1InitActionEvent"),sprite(s),actions(a),clip(c)
 {
 }
 void AVM1InitActionEvent::finalize()
 {
 	sprite = nullptr;
-	actions.clear();
-	startactionpos=0;
+	actions.reset();
 	clip.reset();
 	Event::finalize();
 }
@@ -1113,7 +1139,7 @@ void AVM1InitActionEvent::executeActions()
 {
 	std::map<uint32_t,asAtom> m;
 	LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<clip->state.FP<<" initActions "<< clip->toDebugString()<<" "<<sprite->getId());
-	ACTIONRECORD::executeActions(clip.getPtr(),sprite->getAVM1Context(),actions,startactionpos,m);
+	ACTIONRECORD::executeActions(clip.getPtr(),sprite->getAVM1Context(),actions.getPtr(),m);
 	LOG_CALL("AVM1:"<<clip->getTagID()<<" "<<clip->state.FP<<" initActions done "<< clip->toDebugString()<<" "<<sprite->getId());
 }
 
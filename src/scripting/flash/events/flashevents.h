@@ -374,6 +374,8 @@ public:
 	EventDispatcher(Class_base* c);
 	void finalize() override;
 	bool destruct() override;
+	void collectReferences(gc_references& refs) override;
+	void releaseReferences() override;
 	// is called when a new event is added to the event queue
 	virtual void onNewEvent(){}
 	// is called after an event was handled by the event queue
@@ -486,11 +488,10 @@ class AVM1InitActionEvent: public Event
 friend class ABCVm;
 private:
 	DefineSpriteTag* sprite;
-	std::vector<uint8_t> actions;
-	uint32_t startactionpos;
+	_NR<AVM1Program> actions;
 	_NR<MovieClip> clip;
 public:
-	AVM1InitActionEvent(DefineSpriteTag* s,std::vector<uint8_t> a, uint32_t p, _NR<MovieClip> c);
+	AVM1InitActionEvent(DefineSpriteTag* s,_NR<AVM1Program> a, _NR<MovieClip> c);
 	static void sinit(Class_base*);
 	EVENT_TYPE getEventType() const override { return AVM1INITACTION_EVENT; }
 	void executeActions();
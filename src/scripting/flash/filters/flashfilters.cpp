@@ -22,6 +22,7 @@
 #include "scripting/argconv.h"
 #include "scripting/flash/display/BitmapData.h"
 #include "scripting/flash/geom/flashgeom.h"
+#include "backends/bitmapfilters.h"
 
 using namespace std;
 using namespace lightspark;
@@ -37,6 +38,11 @@ BitmapFilter* BitmapFilter::cloneImpl() const
 	return Class<BitmapFilter>::getInstanceS(getSystemState());
 }
 
+void BitmapFilter::applyFilter(uint32_t* pixels, int32_t width, int32_t height)
+{
+	LOG(LOG_NOT_IMPLEMENTED,"applyFilter is not implemented for "<<getClass()->getQualifiedClassName());
+}
+
 ASFUNCTIONBODY_ATOM(BitmapFilter,clone)
 {
 	BitmapFilter* th=asAtomHandler::as<BitmapFilter>(obj);
@@ -88,7 +94,11 @@ ASFUNCTIONBODY_ATOM(GlowFilter,_constructor)
 		(th->quality, 1)
 		(th->inner, false)
 		(th->knockout, false);
-	LOG(LOG_NOT_IMPLEMENTED,"GlowFilter does nothing");
+}
+
+void GlowFilter::applyFilter(uint32_t* pixels, int32_t width, int32_t height)
+{
+	dropShadowFilter(getSystemState(),pixels,width,height,color,alpha,blurX,blurY,strength,quality,0,0,inner,knockout,false);
 }
 
 BitmapFilter* GlowFilter::cloneImpl() const
@@ -162,7 +172,14 @@ ASFUNCTIONBODY_ATOM(DropShadowFilter,_constructor)
 		(th->inner, false)
 		(th->knockout, false)
 		(th->hideObject, false);
-	LOG(LOG_NOT_IMPLEMENTED,"DropShadowFilter does nothing");
+}
+
+void DropShadowFilter::applyFilter(uint32_t* pixels, int32_t width, int32_t height)
+{
+	number_t radians=angle*M_PI/180.0;
+	int32_t offsetX=round(distance*cos(radians));
+	int32_t offsetY=round(distance*sin(radians));
+	dropShadowFilter(getSystemState(),pixels,width,height,color,alpha,blurX,blurY,strength,quality,offsetX,offsetY,inner,knockout,hideObject);
 }
 
 BitmapFilter* DropShadowFilter::cloneImpl() const
@@ -367,7 +384,19 @@ ASFUNCTIONBODY_ATOM(ColorMatrixFilter,_constructor)
 {
 	ColorMatrixFilter *th = asAtomHandler::as<ColorMatrixFilter>(obj);
 	ARG_UNPACK_ATOM(th->matrix,NullRef);
-	LOG(LOG_NOT_IMPLEMENTED,"ColorMatrixFilter does nothing");
+}
+
+void ColorMatrixFilter::applyFilter(uint32_t* pixels, int32_t width, int32_t height)
+{
+	//Missing elements are taken from the identity matrix
+	float m[20]={1,0,0,0,0, 0,1,0,0,0, 0,0,1,0,0, 0,0,0,1,0};
+	if (!matrix.isNull())
+	{
+		uint32_t size=imin(matrix->size(),20);
+		for (uint32_t i = 0; i < size; i++)
+			m[i]=asAtomHandler::toNumber(matrix->at(i));
+	}
+	colorMatrixFilter(getSystemState(),pixels,width,height,m);
 }
 
 BitmapFilter* ColorMatrixFilter::cloneImpl() const
@@ -405,7 +434,11 @@ ASFUNCTIONBODY_ATOM(BlurFilter,_constructor)
 {
 	BlurFilter *th = asAtomHandler::as<BlurFilter>(obj);
 	ARG_UNPACK_ATOM(th->blurX,4.0)(th->blurY,4.0)(th->quality,1);
-	LOG(LOG_NOT_IMPLEMENTED,"BlurFilter is not implemented");
+}
+
+void BlurFilter::applyFilter(uint32_t* pixels, int32_t width, int32_t height)
+{
+	boxBlurFilter(getSystemState(),pixels,width,height,blurX,blurY,quality);
 }
 
 BitmapFilter* BlurFilter::cloneImpl() const
@@ -466,20 +499,46 @@ void ConvolutionFilter::sinit(Class_base* c)
 	REGISTER_GETTER_SETTER(c,matrixY);
 	REGISTER_GETTER_SETTER(c,preserveAlpha);
 }
-ASFUNCTIONBODY_GETTER_SETTER_NOT_IMPLEMENTED(ConvolutionFilter,alpha);
-ASFUNCTIONBODY_GETTER_SETTER_NOT_IMPLEMENTED(ConvolutionFilter,bias);
-ASFUNCTIONBODY_GETTER_SETTER_NOT_IMPLEMENTED(ConvolutionFilter,clamp);
-ASFUNCTIONBODY_GETTER_SETTER_NOT_IMPLEMENTED(ConvolutionFilter,color);
-ASFUNCTIONBODY_GETTER_SETTER_NOT_IMPLEMENTED(ConvolutionFilter,divisor);
-ASFUNCTIONBODY_GETTER_SETTER_NOT_IMPLEMENTED(ConvolutionFilter,matrix);
-ASFUNCTIONBODY_GETTER_SETTER_NOT_IMPLEMENTED(ConvolutionFilter,matrixX);
-ASFUNCTIONBODY_GETTER_SETTER_NOT_IMPLEMENTED(ConvolutionFilter,matrixY);
-ASFUNCTIONBODY_GETTER_SETTER_NOT_IMPLEMENTED(ConvolutionFilter,preserveAlpha);
+ASFUNCTIONBODY_GETTER_SETTER(ConvolutionFilter,alpha);
+ASFUNCTIONBODY_GETTER_SETTER(ConvolutionFilter,bias);
+ASFUNCTIONBODY_GETTER_SETTER(ConvolutionFilter,clamp);
+ASFUNCTIONBODY_GETTER_SETTER(ConvolutionFilter,color);
+ASFUNCTIONBODY_GETTER_SETTER(ConvolutionFilter,divisor);
+ASFUNCTIONBODY_GETTER_SETTER(ConvolutionFilter,matrix);
+ASFUNCTIONBODY_GETTER_SETTER(ConvolutionFilter,matrixX);
+ASFUNCTIONBODY_GETTER_SETTER(ConvolutionFilter,matrixY);
+ASFUNCTIONBODY_GETTER_SETTER(ConvolutionFilter,preserveAlpha);
 
 ASFUNCTIONBODY_ATOM(ConvolutionFilter,_constructor)
 {
-	//ConvolutionFilter *th = obj.as<ConvolutionFilter>();
-	LOG(LOG_NOT_IMPLEMENTED,"ConvolutionFilter is not implemented");
+	ConvolutionFilter *th = asAtomHandler::as<ConvolutionFilter>(obj);
+	ARG_UNPACK_ATOM (th->matrixX, 0)
+		(th->matrixY, 0)
+		(th->matrix, NullRef)
+		(th->divisor, 1.0)
+		(th->bias, 0.0)
+		(th->preserveAlpha, true)
+		(th->clamp, true)
+		(th->color, 0)
+		(th->alpha, 0.0);
+}
+
+void ConvolutionFilter::applyFilter(uint32_t* pixels, int32_t width, int32_t height)
+{
+	int32_t mx=matrixX;
+	int32_t my=matrixY;
+	if (mx <= 0 || my <= 0)
+		return;
+	//Missing elements are 0
+	vector<float> m(mx*my,0.0f);
+	if (!matrix.isNull())
+	{
+		uint32_t size=imin(matrix->size(),m.size());
+		for (uint32_t i = 0; i < size; i++)
+			m[i]=asAtomHandler::toNumber(matrix->at(i));
+	}
+	uint32_t a=imin(imax(alpha*255,0),255);
+	convolutionFilter(getSystemState(),pixels,width,height,m.data(),mx,my,divisor,bias,preserveAlpha,clamp,(a<<24)|(color&0xffffff));
 }
 
 BitmapFilter* ConvolutionFilter::cloneImpl() const
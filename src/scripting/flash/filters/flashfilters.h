@@ -33,6 +33,8 @@ private:
 public:
 	BitmapFilter(Class_base* c, CLASS_SUBTYPE st=SUBTYPE_BITMAPFILTER):ASObject(c,T_OBJECT,st){}
 	static void sinit(Class_base* c);
+	// Filters width*height premultiplied ARGB pixels in place
+	virtual void applyFilter(uint32_t* pixels, int32_t width, int32_t height);
 	ASFUNCTION_ATOM(clone);
 };
 
@@ -52,6 +54,7 @@ public:
 	GlowFilter(Class_base* c);
 	GlowFilter(Class_base* c,const GLOWFILTER& filter);
 	static void sinit(Class_base* c);
+	void applyFilter(uint32_t* pixels, int32_t width, int32_t height) override;
 	ASFUNCTION_ATOM(_constructor);
 };
 
@@ -74,6 +77,7 @@ public:
 	DropShadowFilter(Class_base* c);
 	DropShadowFilter(Class_base* c,const DROPSHADOWFILTER& filter);
 	static void sinit(Class_base* c);
+	void applyFilter(uint32_t* pixels, int32_t width, int32_t height) override;
 	ASFUNCTION_ATOM(_constructor);
 };
 
@@ -129,6 +133,7 @@ public:
 	ColorMatrixFilter(Class_base* c);
 	ColorMatrixFilter(Class_base* c,const COLORMATRIXFILTER& filter);
 	static void sinit(Class_base* c);
+	void applyFilter(uint32_t* pixels, int32_t width, int32_t height) override;
 	ASFUNCTION_ATOM(_constructor);
 	ASPROPERTY_GETTER_SETTER(_NR<Array>, matrix);
 };
@@ -140,6 +145,7 @@ public:
 	BlurFilter(Class_base* c);
 	BlurFilter(Class_base* c,const BLURFILTER& filter);
 	static void sinit(Class_base* c);
+	void applyFilter(uint32_t* pixels, int32_t width, int32_t height) override;
 	ASFUNCTION_ATOM(_constructor);
 	ASPROPERTY_GETTER_SETTER(number_t, blurX);
 	ASPROPERTY_GETTER_SETTER(number_t, blurY);
@@ -153,6 +159,7 @@ public:
 	ConvolutionFilter(Class_base* c);
 	ConvolutionFilter(Class_base* c,const CONVOLUTIONFILTER& filter);
 	static void sinit(Class_base* c);
+	void applyFilter(uint32_t* pixels, int32_t width, int32_t height) override;
 	ASFUNCTION_ATOM(_constructor);
 	ASPROPERTY_GETTER_SETTER(number_t,alpha);
 	ASPROPERTY_GETTER_SETTER(number_t,bias);
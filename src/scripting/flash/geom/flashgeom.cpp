@@ -2054,8 +2054,7 @@ ASFUNCTIONBODY_ATOM(Matrix3D,_constructor)
 	{
 		for (uint32_t i = 0; i < v->size() && i < 4*4; i++)
 		{
-			asAtom a = v->at(i);
-			th->data[i] = asAtomHandler::toNumber(a);
+			th->data[i] = v->getNumber(i);
 		}
 	}
 }
@@ -2234,8 +2233,7 @@ ASFUNCTIONBODY_ATOM(Matrix3D,copyRawDataFrom)
 		LOG(LOG_NOT_IMPLEMENTED, "Matrix3D.copyRawDataFrom ignores parameter 'transpose'");
 	for (uint32_t i = 0; i < vector->size()-index && i < 16; i++)
 	{
-		asAtom a = vector->at(index+i);
-		th->data[i] = asAtomHandler::toNumber(a);
+		th->data[i] = vector->getNumber(index+i);
 	}
 }
 
@@ -2364,8 +2362,7 @@ ASFUNCTIONBODY_ATOM(Matrix3D,_set_rawData)
 	// TODO handle not invertible argument
 	for (uint32_t i = 0; i < data->size(); i++)
 	{
-		asAtom a = data->at(i);
-		th->data[i] = asAtomHandler::toNumber(a);
+		th->data[i] = data->getNumber(i);
 	}
 }
 ASFUNCTIONBODY_ATOM(Matrix3D,_get_position)
@@ -1236,26 +1236,26 @@ IDrawable* TextField::invalidate(DisplayObject* target, const MATRIX& initialMat
 			FILLSTYLE fillstyle(0xff);
 			fillstyle.FillStyleType=SOLID_FILL;
 			fillstyle.Color=this->backgroundColor;
-			tokens.filltokens.emplace_back(_MR(new GeomToken(SET_FILL, fillstyle)));
-			tokens.filltokens.emplace_back(_MR(new GeomToken(MOVE, Vector2(bxmin/scaling, bymin/scaling))));
-			tokens.filltokens.emplace_back(_MR(new GeomToken(STRAIGHT, Vector2(bxmin/scaling, (bymax-bymin)/scaling))));
-			tokens.filltokens.emplace_back(_MR(new GeomToken(STRAIGHT, Vector2((bxmax-bxmin)/scaling, (bymax-bymin)/scaling))));
-			tokens.filltokens.emplace_back(_MR(new GeomToken(STRAIGHT, Vector2((bxmax-bxmin)/scaling, bymin/scaling))));
-			tokens.filltokens.emplace_back(_MR(new GeomToken(STRAIGHT, Vector2(bxmin/scaling, bymin/scaling))));
-			tokens.filltokens.emplace_back(_MR(new GeomToken(CLEAR_FILL)));
+			tokens.setFill(tokens.filltokens, fillstyle);
+			tokens.filltokens.moveTo(Vector2(bxmin/scaling, bymin/scaling));
+			tokens.filltokens.lineTo(Vector2(bxmin/scaling, (bymax-bymin)/scaling));
+			tokens.filltokens.lineTo(Vector2((bxmax-bxmin)/scaling, (bymax-bymin)/scaling));
+			tokens.filltokens.lineTo(Vector2((bxmax-bxmin)/scaling, bymin/scaling));
+			tokens.filltokens.lineTo(Vector2(bxmin/scaling, bymin/scaling));
+			tokens.filltokens.command(CLEAR_FILL);
 		}
 		if (this->border)
 		{
 			LINESTYLE2 linestyle(0xff);
 			linestyle.Color=this->borderColor;
 			linestyle.Width=20;
-			tokens.stroketokens.emplace_back(_MR(new GeomToken(SET_STROKE, linestyle)));
-			tokens.stroketokens.emplace_back(_MR(new GeomToken(MOVE, Vector2(bxmin/scaling, bymin/scaling))));
-			tokens.stroketokens.emplace_back(_MR(new GeomToken(STRAIGHT, Vector2(bxmin/scaling, (bymax-bymin)/scaling))));
-			tokens.stroketokens.emplace_back(_MR(new GeomToken(STRAIGHT, Vector2((bxmax-bxmin)/scaling, (bymax-bymin)/scaling))));
-			tokens.stroketokens.emplace_back(_MR(new GeomToken(STRAIGHT, Vector2((bxmax-bxmin)/scaling, bymin/scaling))));
-			tokens.stroketokens.emplace_back(_MR(new GeomToken(STRAIGHT, Vector2(bxmin/scaling, bymin/scaling))));
-			tokens.stroketokens.emplace_back(_MR(new GeomToken(CLEAR_STROKE)));
+			tokens.setStroke(tokens.stroketokens, linestyle);
+			tokens.stroketokens.moveTo(Vector2(bxmin/scaling, bymin/scaling));
+			tokens.stroketokens.lineTo(Vector2(bxmin/scaling, (bymax-bymin)/scaling));
+			tokens.stroketokens.lineTo(Vector2((bxmax-bxmin)/scaling, (bymax-bymin)/scaling));
+			tokens.stroketokens.lineTo(Vector2((bxmax-bxmin)/scaling, bymin/scaling));
+			tokens.stroketokens.lineTo(Vector2(bxmin/scaling, bymin/scaling));
+			tokens.stroketokens.command(CLEAR_STROKE);
 		}
 		if (this->caretblinkstate)
 		{
@@ -1283,10 +1283,10 @@ IDrawable* TextField::invalidate(DisplayObject* target, const MATRIX& initialMat
 			linestyle.Color=RGB(0,0,0);
 			linestyle.Width=40;
 			int ypadding = (bymax-bymin-2)/scaling;
-			tokens.stroketokens.emplace_back(_MR(new GeomToken(SET_STROKE, linestyle)));
-			tokens.stroketokens.emplace_back(_MR(new GeomToken(MOVE, Vector2(tw, bymin/scaling+ypadding))));
-			tokens.stroketokens.emplace_back(_MR(new GeomToken(STRAIGHT, Vector2(tw, (bymax-bymin)/scaling-ypadding))));
-			tokens.stroketokens.emplace_back(_MR(new GeomToken(CLEAR_STROKE)));
+			tokens.setStroke(tokens.stroketokens, linestyle);
+			tokens.stroketokens.moveTo(Vector2(tw, bymin/scaling+ypadding));
+			tokens.stroketokens.lineTo(Vector2(tw, (bymax-bymin)/scaling-ypadding));
+			tokens.stroketokens.command(CLEAR_STROKE);
 		}
 		uint32_t tokencount = tokens.size();
 		embeddedfont->fillTextTokens(tokens,text,fontSize,textColor,leading,autosizeposition);
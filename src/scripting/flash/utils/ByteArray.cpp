@@ -25,6 +25,7 @@
 #include "parsing/amf3_generator.h"
 #include "scripting/argconv.h"
 #include "scripting/flash/errors/flasherrors.h"
+#include "backends/bitmapfilters.h"
 #include <sstream>
 #include <zlib.h>
 #include <glib.h>
@@ -1370,6 +1371,11 @@ void ByteArray::compress_zlib()
 {
 	if(len==0)
 		return;
+	if(len>=2*BYTEARRAY_COMPRESS_BLOCK)
+	{
+		compress_zlib_parallel();
+		return;
+	}
 
 	unsigned long buflen=compressBound(len);
 	uint8_t *compressed=(uint8_t*) malloc(buflen);
@@ -1385,6 +1391,87 @@ void ByteArray::compress_zlib()
 	position=buflen;
 }
 
+/*
+ * The blocks are compressed to raw deflate data, all but the last one end
+ * with a sync flush so that they are byte aligned and can be concatenated.
+ * The result is wrapped in the zlib header and the combined adler32.
+ */
+void ByteArray::compress_zlib_parallel()
+{
+	const int32_t blocks=(len+BYTEARRAY_COMPRESS_BLOCK-1)/BYTEARRAY_COMPRESS_BLOCK;
+	vector<vector<uint8_t>> compressed(blocks);
+	vector<uLong> checksums(blocks);
+	//Not a vector<bool>, the jobs write the flags concurrently
+	vector<uint8_t> failed(blocks,false);
+	parallelFilterRange(getSystemState(),blocks,[&](int32_t begin, int32_t end)
+	{
+		for(int32_t i=begin;i<end;i++)
+		{
+			const uint32_t start=i*BYTEARRAY_COMPRESS_BLOCK;
+			const uint32_t blockLen=min<uint32_t>(BYTEARRAY_COMPRESS_BLOCK,len-start);
+			const bool last=(i==blocks-1);
+			checksums[i]=adler32(adler32(0,Z_NULL,0),bytes+start,blockLen);
+			z_stream strm;
+			strm.zalloc=Z_NULL;
+			strm.zfree=Z_NULL;
+			strm.opaque=Z_NULL;
+			if(deflateInit2(&strm,Z_DEFAULT_COMPRESSION,Z_DEFLATED,-15,8,Z_DEFAULT_STRATEGY)!=Z_OK)
+			{
+				failed[i]=true;
+				continue;
+			}
+			if(i>0)
+				deflateSetDictionary(&strm,bytes+start-BYTEARRAY_COMPRESS_WINDOW,BYTEARRAY_COMPRESS_WINDOW);
+			vector<uint8_t>& out=compressed[i];
+			//The sync flush marker is not included in the bound
+			out.resize(deflateBound(&strm,blockLen)+16);
+			strm.next_in=bytes+start;
+			strm.avail_in=blockLen;
+			int status;
+			do
+			{
+				if(strm.total_out==out.size())
+					out.resize(out.size()*2);
+				strm.next_out=&out[strm.total_out];
+				strm.avail_out=out.size()-strm.total_out;
+				status=deflate(&strm,last ? Z_FINISH : Z_SYNC_FLUSH);
+			}
+			while(status==Z_OK && strm.avail_out==0);
+			if(last ? status!=Z_STREAM_END : status!=Z_OK)
+				failed[i]=true;
+			out.resize(strm.total_out);
+			deflateEnd(&strm);
+		}
+	},1);
+
+	//zlib header of the default compression level
+	uint32_t buflen=2+4;
+	uLong checksum=checksums[0];
+	for(int32_t i=0;i<blocks;i++)
+	{
+		if(failed[i])
+			throw RunTimeException("zlib compress failed");
+		buflen+=compressed[i].size();
+		if(i>0)
+			checksum=adler32_combine(checksum,checksums[i],min<uint32_t>(BYTEARRAY_COMPRESS_BLOCK,len-i*BYTEARRAY_COMPRESS_BLOCK));
+	}
+	uint8_t* buf=(uint8_t*) malloc(buflen);
+	assert_and_throw(buf);
+	uint8_t* p=buf;
+	*p++=0x78;
+	*p++=0x9c;
+	for(int32_t i=0;i<blocks;i++)
+	{
+		memcpy(p,compressed[i].data(),compressed[i].size());
+		p+=compressed[i].size();
+	}
+	for(int32_t i=3;i>=0;i--)
+		*p++=(checksum>>(i*8))&0xff;
+
+	acquireBuffer(buf, buflen);
+	position=buflen;
+}
+
 void ByteArray::uncompress_zlib()
 {
 	z_stream strm;
@@ -1418,8 +1505,9 @@ void ByteArray::uncompress_zlib()
 			throw Class<IOError>::getInstanceS(getSystemState(),"not valid compressed data");
 		}
 
+		//Grow geometrically, highly compressed data would be copied over and over
 		if(strm.avail_out==0)
-			buf.resize(buf.size()+len);
+			buf.resize(buf.size()*2);
 	} while(status!=Z_STREAM_END);
 
 	inflateEnd(&strm);
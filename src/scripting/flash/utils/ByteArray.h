@@ -24,6 +24,11 @@
 #include "swftypes.h"
 #include "scripting/flash/utils/flashutils.h"
 
+//Data of at least two blocks of this size is compressed in parallel, one block per job
+#define BYTEARRAY_COMPRESS_BLOCK (256*1024)
+//Window of the previous block used as dictionary, so that the blocks compress as well as the whole data
+#define BYTEARRAY_COMPRESS_WINDOW (32*1024)
+
 namespace lightspark
 {
 
@@ -43,6 +48,7 @@ protected:
 	uint32_t real_len;
 	uint32_t len;
 	void compress_zlib();
+	void compress_zlib_parallel();
 	void uncompress_zlib();
 	Mutex mutex;
 	uint8_t* getBufferIntern(unsigned int size, bool enableResize);
@@ -29,11 +29,31 @@
 using namespace std;
 using namespace lightspark;
 
-Dictionary::Dictionary(Class_base* c):ASObject(c),
+Dictionary::Dictionary(Class_base* c):ASObject(c,T_OBJECT,SUBTYPE_DICTIONARY),
 	data(std::less<dictType::key_type>(), reporter_allocator<dictType::value_type>(c->memoryAccount)),weakkeys(false)
 {
 }
 
+void Dictionary::collectReferences(gc_references& refs)
+{
+	for(auto it=data.begin();it!=data.end();++it)
+	{
+		refs.owned.push_back(it->first.getPtr());
+		refs.addOwned(it->second);
+	}
+	ASObject::collectReferences(refs);
+}
+
+void Dictionary::releaseReferences()
+{
+	for(auto it=data.begin();it!=data.end();++it)
+	{
+		ASATOM_DECREF(it->second);
+	}
+	data.clear();
+	ASObject::releaseReferences();
+}
+
 void Dictionary::sinit(Class_base* c)
 {
 	CLASS_SETUP(c, ASObject, _constructor, CLASS_DYNAMIC_NOT_FINAL);
@@ -49,6 +49,8 @@ public:
 		data.clear();
 		return destructIntern();
 	}
+	void collectReferences(gc_references& refs) override;
+	void releaseReferences() override;
 	
 	static void sinit(Class_base*);
 	static void buildTraits(ASObject* o);
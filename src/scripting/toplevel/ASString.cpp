@@ -481,6 +481,37 @@ ASFUNCTIONBODY_ATOM(ASString,substring)
 	ret = asAtomHandler::fromObject(abstract_s(sys,data.substr(start,end-start)));
 }
 
+bool ASString::takeData(tiny_string& s)
+{
+	if (!datafilled || !data.isUniqueBuffer())
+		return false;
+	s = data;
+	prefixBytes = data.numBytes();
+	data = tiny_string();
+	//The iterator points into the buffer given away
+	currentpos = CharIterator();
+	currentindex = 0;
+	hasId = false;
+	datafilled = false;
+	return true;
+}
+
+void ASString::setPrefixOf(ASString* res)
+{
+	res->incRef();
+	prefixOf = _MR(res);
+}
+
+void ASString::fillFromPrefix()
+{
+	//The result may have given its buffer to a longer string as well
+	ASString* s = prefixOf.getPtr();
+	while (!s->datafilled && !s->prefixOf.isNull())
+		s = s->prefixOf.getPtr();
+	data = s->getData().substr_bytes(0,prefixBytes);
+	prefixOf.reset();
+}
+
 number_t ASString::toNumber()
 {
 	assert_and_throw(implEnable);
@@ -45,6 +45,14 @@ private:
 	// speeds up iterating over all chars in the string
 	CharIterator currentpos;
 	uint32_t currentindex;
+	/*
+	 * Set when takeData gave the buffer of data to a concatenation:
+	 * this string is then the first prefixBytes bytes of prefixOf,
+	 * and getData copies them back only if it is still read.
+	 */
+	_NR<ASString> prefixOf;
+	uint32_t prefixBytes;
+	void fillFromPrefix();
 public:
 	ASString(Class_base* c);
 	ASString(Class_base* c, const std::string& s);
@@ -58,7 +66,10 @@ public:
 	{
 		if (!datafilled)
 		{
-			data = getSystemState()->getStringFromUniqueId(stringId);
+			if (!prefixOf.isNull())
+				fillFromPrefix();
+			else
+				data = getSystemState()->getStringFromUniqueId(stringId);
 			datafilled = true;
 		}
 		return data;
@@ -67,8 +78,17 @@ public:
 	{
 		if (hasId)
 			return stringId == BUILTIN_STRINGS::EMPTY || stringId == UINT32_MAX;
+		if (!prefixOf.isNull())
+			return prefixBytes == 0;
 		return data.empty();
 	}
+	/*
+	 * Moves data to s if this string is the only user of its buffer, so
+	 * that appending to s doesn't copy it. The caller must then pass the
+	 * ASString holding the result to setPrefixOf.
+	 */
+	bool takeData(tiny_string& s);
+	void setPrefixOf(ASString* res);
 
 	static void sinit(Class_base* c);
 	static void buildTraits(ASObject* o);
@@ -112,6 +132,7 @@ public:
 	inline bool destruct() 
 	{ 
 		data.clear(); 
+		prefixOf.reset();
 		hasId = false;
 		datafilled=false; 
 		if (!destructIntern())
@@ -49,6 +49,31 @@ bool Array::destruct()
 	return destructIntern();
 }
 
+void Array::collectReferences(gc_references& refs)
+{
+	for (auto it=data_first.begin() ; it != data_first.end(); ++it)
+		refs.addOwned(*it);
+	for (auto it=data_second.begin() ; it != data_second.end(); ++it)
+		refs.addOwned(it->second);
+	ASObject::collectReferences(refs);
+}
+
+void Array::releaseReferences()
+{
+	for (auto it=data_first.begin() ; it != data_first.end(); ++it)
+	{
+		ASATOM_DECREF_POINTER(it);
+	}
+	for (auto it=data_second.begin() ; it != data_second.end(); ++it)
+	{
+		ASATOM_DECREF(it->second);
+	}
+	data_first.clear();
+	data_second.clear();
+	currentsize=0;
+	ASObject::releaseReferences();
+}
+
 void Array::sinit(Class_base* c)
 {
 	CLASS_SETUP(c, ASObject, _constructor, CLASS_DYNAMIC_NOT_FINAL);
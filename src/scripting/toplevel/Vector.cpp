@@ -100,8 +100,10 @@ void Vector::sinit(Class_base* c)
 	c->prototype->setVariableByQName("unshift",AS3,Class<IFunction>::getFunction(c->getSystemState(),unshift),CONSTANT_TRAIT);
 }
 
-Vector::Vector(Class_base* c, const Type *vtype):ASObject(c,T_OBJECT,SUBTYPE_VECTOR),vec_type(vtype),fixed(false),vec(reporter_allocator<asAtom>(c->memoryAccount))
+Vector::Vector(Class_base* c, const Type *vtype):ASObject(c,T_OBJECT,SUBTYPE_VECTOR),vec_type(vtype),fixed(false),storage(STORAGE_ATOM),
+	vec(reporter_allocator<asAtom>(c->memoryAccount))
 {
+	setStorageType();
 }
 
 Vector::~Vector()
@@ -112,18 +114,63 @@ bool Vector::destruct()
 {
 	for(unsigned int i=0;i<size();i++)
 	{
-		ASATOM_DECREF(vec[i]);
+		releaseSlot(vec[i]);
 	}
 	vec.clear();
 	vec_type=nullptr;
+	storage=STORAGE_ATOM;
 	return destructIntern();
 }
 
+void Vector::collectReferences(gc_references& refs)
+{
+	if (storage == STORAGE_ATOM)
+	{
+		for(unsigned int i=0;i<size();i++)
+			refs.addOwned(vec[i]);
+	}
+	ASObject::collectReferences(refs);
+}
+
+void Vector::releaseReferences()
+{
+	for(unsigned int i=0;i<size();i++)
+	{
+		releaseSlot(vec[i]);
+	}
+	vec.clear();
+	ASObject::releaseReferences();
+}
+
 void Vector::setTypes(const std::vector<const Type *> &types)
 {
 	assert(vec_type == NULL);
 	if(types.size() == 1)
 		vec_type = types[0];
+	setStorageType();
+}
+
+void Vector::setStorageType()
+{
+	assert(vec.empty());
+	storage = STORAGE_ATOM;
+	if (!vec_type)
+		return;
+#ifdef LIGHTSPARK_64
+	if (vec_type == Class<Integer>::getClass(getSystemState()))
+		storage = STORAGE_INT;
+	else if (vec_type == Class<UInteger>::getClass(getSystemState()))
+		storage = STORAGE_UINT;
+	else if (vec_type == Class<Number>::getClass(getSystemState()))
+		storage = STORAGE_NUMBER;
+#endif
+}
+
+tiny_string Vector::slotToString(uint32_t index)
+{
+	if (storage == STORAGE_NUMBER)
+		return Number::toString(slotToNumber(vec[index]));
+	return asAtomHandler::toString(vec[index],getSystemState());
 }
 bool Vector::sameType(const Class_base *cls) const
 {
@@ -154,7 +201,7 @@ void Vector::generator(asAtom& ret,SystemState *sys, asAtom &o_class, asAtom* ar
 			//Convert the elements of the array to the type of this vector
 			if (!type->coerce(sys,obj))
 				ASATOM_INCREF(obj);
-			res->vec.push_back(obj);
+			res->vec.push_back(res->toSlot(obj));
 		}
 	}
 	else if(asAtomHandler::getObject(args[0])->getClass()->getTemplate() == Template<Vector>::getTemplate(sys))
@@ -176,10 +223,12 @@ void Vector::generator(asAtom& ret,SystemState *sys, asAtom &o_class, asAtom* ar
 			res = asAtomHandler::as<Vector>(ret);
 			for(auto i = arg->vec.begin(); i != arg->vec.end(); ++i)
 			{
-				asAtom v = *i;
-				if (!type->coerce(sys,v))
-					ASATOM_INCREF(v);
-				res->vec.push_back(v);
+				asAtom v=asAtomHandler::invalidAtom;
+				arg->slotToAtom(v,*i);
+				asAtom o = v;
+				if (type->coerce(sys,v))
+					ASATOM_DECREF(o);
+				res->vec.push_back(res->toSlot(v));
 			}
 		}
 	}
@@ -214,7 +263,7 @@ ASFUNCTIONBODY_ATOM(Vector,_concat)
 	for(;it != th->vec.end();++it)
 	{
 		res->vec[index]=*it;
-		ASATOM_INCREF(res->vec[index]);
+		res->acquireSlot(res->vec[index]);
 		index++;
 	}
 	//Insert the arguments in the vector
@@ -225,16 +274,26 @@ ASFUNCTIONBODY_ATOM(Vector,_concat)
 		{
 			Vector* arg=asAtomHandler::as<Vector>(args[pos]);
 			res->vec.resize(index+arg->size(), th->getDefaultValue());
-			auto it=arg->vec.begin();
-			for(;it != arg->vec.end();++it)
+			if (arg->storage == res->storage && res->storage != STORAGE_ATOM)
 			{
-				if (asAtomHandler::isValid(*it))
+				//Same unboxed representation, the values can be copied directly
+				std::copy(arg->vec.begin(),arg->vec.end(),res->vec.begin()+index);
+				index+=arg->size();
+			}
+			else
+			{
+				auto it=arg->vec.begin();
+				for(;it != arg->vec.end();++it)
 				{
-					res->vec[index]= *it;
-					th->vec_type->coerceForTemplate(sys,res->vec[index]);
-					ASATOM_INCREF(res->vec[index]);
+					if (arg->storage != STORAGE_ATOM || asAtomHandler::isValid(*it))
+					{
+						asAtom v=asAtomHandler::invalidAtom;
+						arg->slotToAtom(v,*it);
+						th->vec_type->coerceForTemplate(sys,v);
+						res->vec[index] = res->toSlot(v);
+					}
+					index++;
 				}
-				index++;
 			}
 		}
 		else
@@ -242,7 +301,7 @@ ASFUNCTIONBODY_ATOM(Vector,_concat)
 			asAtom v = args[pos];
 			if (!th->vec_type->coerce(sys,v))
 				ASATOM_INCREF(v);
-			res->vec[index] = v;
+			res->vec.push_back(res->toSlot(v));
 			index++;
 		}
 		pos += (sys->getSwfVersion() < 11 ?-1 : 1);
@@ -266,7 +325,9 @@ ASFUNCTIONBODY_ATOM(Vector,filter)
 
 	for(unsigned int i=0;i<th->size();i++)
 	{
-		params[0] = th->vec[i];
+		asAtom element=asAtomHandler::invalidAtom;
+		th->slotToAtom(element,th->vec[i]);
+		params[0] = element;
 		params[1] = asAtomHandler::fromUInt(i);
 		params[2] = asAtomHandler::fromObject(th);
 
@@ -278,15 +339,16 @@ ASFUNCTIONBODY_ATOM(Vector,filter)
 		{
 			asAtomHandler::callFunction(f,funcRet,args[1], params, 3,false);
 		}
+		bool keep=false;
 		if(asAtomHandler::isValid(funcRet))
 		{
-			if(asAtomHandler::Boolean_concrete(funcRet))
-			{
-				ASATOM_INCREF(th->vec[i]);
-				res->vec.push_back(th->vec[i]);
-			}
+			keep=asAtomHandler::Boolean_concrete(funcRet);
 			ASATOM_DECREF(funcRet);
 		}
+		if (keep)
+			res->vec.push_back(res->toSlot(element));
+		else
+			ASATOM_DECREF(element);
 	}
 }
 
@@ -303,7 +365,9 @@ ASFUNCTIONBODY_ATOM(Vector, some)
 
 	for(unsigned int i=0; i < th->size(); i++)
 	{
-		params[0] = th->vec[i];
+		asAtom element=asAtomHandler::invalidAtom;
+		th->slotToAtom(element,th->vec[i]);
+		params[0] = element;
 		params[1] = asAtomHandler::fromUInt(i);
 		params[2] = asAtomHandler::fromObject(th);
 
@@ -315,6 +379,7 @@ ASFUNCTIONBODY_ATOM(Vector, some)
 		{
 			asAtomHandler::callFunction(f,ret,args[1], params, 3,false);
 		}
+		ASATOM_DECREF(element);
 		if(asAtomHandler::isValid(ret))
 		{
 			if(asAtomHandler::Boolean_concrete(ret))
@@ -340,8 +405,10 @@ ASFUNCTIONBODY_ATOM(Vector, every)
 
 	for(unsigned int i=0; i < th->size(); i++)
 	{
-		if (asAtomHandler::isValid(th->vec[i]))
-			params[0] = th->vec[i];
+		asAtom element=asAtomHandler::invalidAtom;
+		th->slotToAtom(element,th->vec[i]);
+		if (asAtomHandler::isValid(element))
+			params[0] = element;
 		else
 			params[0] = asAtomHandler::nullAtom;
 		params[1] = asAtomHandler::fromUInt(i);
@@ -355,6 +422,7 @@ ASFUNCTIONBODY_ATOM(Vector, every)
 		{
 			asAtomHandler::callFunction(f,ret,args[1], params, 3,false);
 		}
+		ASATOM_DECREF(element);
 		if(asAtomHandler::isValid(ret))
 		{
 			if (asAtomHandler::isUndefined(ret) || asAtomHandler::isNull(ret))
@@ -378,12 +446,14 @@ void Vector::append(asAtom &o)
 	}
 	asAtom v = o;
 	if (vec_type->coerce(getSystemState(),v))
-		ASATOM_DECREF(v);
-	vec.push_back(o);
+		ASATOM_DECREF(o);
+	vec.push_back(toSlot(v));
 }
 
 void Vector::remove(ASObject *o)
 {
+	if (storage != STORAGE_ATOM)
+		return;
 	for (auto it = vec.begin(); it != vec.end(); it++)
 	{
 		if (asAtomHandler::getObject(*it) == o)
@@ -427,14 +497,23 @@ ASFUNCTIONBODY_ATOM(Vector,push)
 	Vector* th=static_cast<Vector*>(asAtomHandler::getObject(obj));
 	if (th->fixed)
 		throwError<RangeError>(kVectorFixedError);
-	for(size_t i = 0; i < argslen; ++i)
+	if (th->storage != STORAGE_ATOM)
+	{
+		//Unboxed values need neither coercion nor references
+		for(size_t i = 0; i < argslen; ++i)
+			th->vec.push_back(th->copyToSlot(args[i]));
+	}
+	else
 	{
-		//The proprietary player violates the specification and allows elements of any type to be pushed;
-		//they are converted to the vec_type
-		asAtom v = args[i];
-		if (!th->vec_type->coerce(sys,v))
-			ASATOM_INCREF(v);
-		th->vec.push_back(v);
+		for(size_t i = 0; i < argslen; ++i)
+		{
+			//The proprietary player violates the specification and allows elements of any type to be pushed;
+			//they are converted to the vec_type
+			asAtom v = args[i];
+			if (!th->vec_type->coerce(sys,v))
+				ASATOM_INCREF(v);
+			th->vec.push_back(v);
+		}
 	}
 	asAtomHandler::setUInt(ret,sys,(uint32_t)th->vec.size());
 }
@@ -451,7 +530,7 @@ ASFUNCTIONBODY_ATOM(Vector,_pop)
 		th->vec_type->coerce(th->getSystemState(),ret);
 		return;
 	}
-	ret = th->vec[size-1];
+	th->takeSlot(ret,th->vec[size-1]);
 	th->vec.pop_back();
 }
 
@@ -470,7 +549,7 @@ ASFUNCTIONBODY_ATOM(Vector,setLength)
 	if(len <= th->vec.size())
 	{
 		for(size_t i=len; i< th->vec.size(); ++i)
-			ASATOM_DECREF(th->vec[i]);
+			th->releaseSlot(th->vec[i]);
 	}
 	th->vec.resize(len, th->getDefaultValue());
 }
@@ -501,7 +580,9 @@ ASFUNCTIONBODY_ATOM(Vector,forEach)
 
 	for(unsigned int i=0; i < th->size(); i++)
 	{
-		params[0] = th->vec[i];
+		asAtom element=asAtomHandler::invalidAtom;
+		th->slotToAtom(element,th->vec[i]);
+		params[0] = element;
 		params[1] = asAtomHandler::fromUInt(i);
 		params[2] = asAtomHandler::fromObject(th);
 
@@ -514,6 +595,7 @@ ASFUNCTIONBODY_ATOM(Vector,forEach)
 		{
 			asAtomHandler::callFunction(f,funcret,args[1], params, 3,false);
 		}
+		ASATOM_DECREF(element);
 		ASATOM_DECREF(funcret);
 	}
 }
@@ -576,6 +658,25 @@ ASFUNCTIONBODY_ATOM(Vector,lastIndexOf)
 				i = j;
 		}
 	}
+	if (th->storage != STORAGE_ATOM)
+	{
+		//Only numbers are strictly equal to the elements, compare the raw values
+		if (asAtomHandler::isNumeric(arg0))
+		{
+			number_t n = asAtomHandler::toNumber(arg0);
+			do
+			{
+				if (th->getNumber(i) == n)
+				{
+					res=i;
+					break;
+				}
+			}
+			while(i--);
+		}
+		asAtomHandler::setInt(ret,sys,res);
+		return;
+	}
 	do
 	{
 		if (asAtomHandler::isEqualStrict(th->vec[i],th->getSystemState(),arg0))
@@ -600,8 +701,8 @@ ASFUNCTIONBODY_ATOM(Vector,shift)
 		th->vec_type->coerce(th->getSystemState(),ret);
 		return;
 	}
-	if(asAtomHandler::isValid(th->vec[0]))
-		ret=th->vec[0];
+	if(th->storage != STORAGE_ATOM || asAtomHandler::isValid(th->vec[0]))
+		th->takeSlot(ret,th->vec[0]);
 	else
 	{
 		asAtomHandler::setNull(ret);
@@ -640,7 +741,7 @@ asAtom Vector::getDefaultValue()
 	else if (vec_type == Class<UInteger>::getClass(getSystemState()))
 		return asAtomHandler::fromUInt(0);
 	else if (vec_type == Class<Number>::getClass(getSystemState()))
-		return asAtomHandler::fromInt(0);
+		return storage == STORAGE_NUMBER ? numberToSlot(0) : asAtomHandler::fromInt(0);
 	else
 		return asAtomHandler::nullAtom;
 }
@@ -661,14 +762,19 @@ ASFUNCTIONBODY_ATOM(Vector,slice)
 	th->getClass()->getInstance(ret,true,NULL,0);
 	Vector* res= asAtomHandler::as<Vector>(ret);
 	res->vec.resize(endIndex-startIndex, th->getDefaultValue());
+	if (th->storage != STORAGE_ATOM)
+	{
+		std::copy(th->vec.begin()+startIndex,th->vec.begin()+endIndex,res->vec.begin());
+		return;
+	}
 	int j = 0;
 	for(int i=startIndex; i<endIndex; i++) 
 	{
 		if (asAtomHandler::isValid(th->vec[i]))
 		{
 			res->vec[j] =th->vec[i];
-			if (!th->vec_type->coerce(th->getSystemState(),th->vec[j]))
-				ASATOM_INCREF(th->vec[j]);
+			if (!th->vec_type->coerce(th->getSystemState(),res->vec[j]))
+				ASATOM_INCREF(res->vec[j]);
 		}
 		j++;
 	}
@@ -713,7 +819,7 @@ ASFUNCTIONBODY_ATOM(Vector,splice)
 	tmp.resize(totalSize- (startIndex+deleteCount), th->getDefaultValue());
 	for (int i = startIndex+deleteCount; i < totalSize ; i++)
 	{
-		if (asAtomHandler::isValid(th->vec[i]))
+		if (th->storage != STORAGE_ATOM || asAtomHandler::isValid(th->vec[i]))
 		{
 			tmp[i-(startIndex+deleteCount)] = th->vec[i];
 			th->vec[i] = th->getDefaultValue();
@@ -725,8 +831,13 @@ ASFUNCTIONBODY_ATOM(Vector,splice)
 	//Insert requested values starting at startIndex
 	for(unsigned int i=2;i<argslen;i++)
 	{
-		ASATOM_INCREF(args[i]);
-		th->vec.push_back(args[i]);
+		if (th->storage != STORAGE_ATOM)
+			th->vec.push_back(th->copyToSlot(args[i]));
+		else
+		{
+			ASATOM_INCREF(args[i]);
+			th->vec.push_back(args[i]);
+		}
 	}
 	// move remembered items to new position
 	th->vec.resize((totalSize-deleteCount)+(argslen > 2 ? argslen-2 : 0), th->getDefaultValue());
@@ -746,8 +857,8 @@ ASFUNCTIONBODY_ATOM(Vector,join)
 	string res;
 	for(uint32_t i=0;i<th->size();i++)
 	{
-		if (asAtomHandler::isValid(th->vec[i]))
-			res+=asAtomHandler::toString(th->vec[i],sys).raw_buf();
+		if (th->storage != STORAGE_ATOM || asAtomHandler::isValid(th->vec[i]))
+			res+=th->slotToString(i).raw_buf();
 		if(i!=th->size()-1)
 			res+=del.raw_buf();
 	}
@@ -767,6 +878,24 @@ ASFUNCTIONBODY_ATOM(Vector,indexOf)
 		i = asAtomHandler::toInt(args[1]);
 	}
 
+	if (th->storage != STORAGE_ATOM)
+	{
+		//Only numbers are strictly equal to the elements, compare the raw values
+		if (asAtomHandler::isNumeric(arg0))
+		{
+			number_t n = asAtomHandler::toNumber(arg0);
+			for(;i<th->size();i++)
+			{
+				if(th->getNumber(i) == n)
+				{
+					res=i;
+					break;
+				}
+			}
+		}
+		asAtomHandler::setInt(ret,sys,res);
+		return;
+	}
 	for(;i<th->size();i++)
 	{
 		if(asAtomHandler::isEqualStrict(th->vec[i],th->getSystemState(),arg0))
@@ -907,11 +1036,21 @@ ASFUNCTIONBODY_ATOM(Vector,_sort)
 		if(options&(~(Array::NUMERIC|Array::CASEINSENSITIVE|Array::DESCENDING)))
 			throw UnsupportedException("Vector::sort not completely implemented");
 	}
+	if(asAtomHandler::isInvalid(comp) && isNumeric && th->storage != STORAGE_ATOM)
+	{
+		th->sortNumeric(isDescending);
+		ASATOM_INCREF(obj);
+		ret = obj;
+		return;
+	}
 	std::vector<asAtom> tmp = vector<asAtom>(th->vec.size());
 	int i = 0;
 	for(auto it=th->vec.begin();it != th->vec.end();++it)
 	{
-		tmp[i++]= *it;
+		if (th->storage == STORAGE_NUMBER)
+			th->takeSlot(tmp[i++],*it);
+		else
+			tmp[i++]= *it;
 	}
 	
 	if(asAtomHandler::isValid(comp))
@@ -925,12 +1064,45 @@ ASFUNCTIONBODY_ATOM(Vector,_sort)
 	th->vec.clear();
 	for(auto ittmp=tmp.begin();ittmp != tmp.end();++ittmp)
 	{
-		th->vec.push_back(*ittmp);
+		th->vec.push_back(th->toSlot(*ittmp));
 	}
 	ASATOM_INCREF(obj);
 	ret = obj;
 }
 
+void Vector::sortNumeric(bool isDescending)
+{
+	switch (storage)
+	{
+		case STORAGE_INT:
+			if (isDescending)
+				std::sort(vec.begin(),vec.end(),[](const asAtom& a, const asAtom& b) { return asAtomHandler::getInt(b) < asAtomHandler::getInt(a); });
+			else
+				std::sort(vec.begin(),vec.end(),[](const asAtom& a, const asAtom& b) { return asAtomHandler::getInt(a) < asAtomHandler::getInt(b); });
+			break;
+		case STORAGE_UINT:
+			if (isDescending)
+				std::sort(vec.begin(),vec.end(),[](const asAtom& a, const asAtom& b) { return asAtomHandler::getUInt(b) < asAtomHandler::getUInt(a); });
+			else
+				std::sort(vec.begin(),vec.end(),[](const asAtom& a, const asAtom& b) { return asAtomHandler::getUInt(a) < asAtomHandler::getUInt(b); });
+			break;
+		case STORAGE_NUMBER:
+			for(auto it=vec.begin();it != vec.end();++it)
+			{
+				if (std::isnan(slotToNumber(*it)))
+					throw RunTimeException("Cannot sort non number with Array.NUMERIC option");
+			}
+			if (isDescending)
+				std::sort(vec.begin(),vec.end(),[](const asAtom& a, const asAtom& b) { return slotToNumber(b) < slotToNumber(a); });
+			else
+				std::sort(vec.begin(),vec.end(),[](const asAtom& a, const asAtom& b) { return slotToNumber(a) < slotToNumber(b); });
+			break;
+		default:
+			assert(false);
+			break;
+	}
+}
+
 ASFUNCTIONBODY_ATOM(Vector,unshift)
 {
 	Vector* th=asAtomHandler::as<Vector>(obj);
@@ -948,6 +1120,11 @@ ASFUNCTIONBODY_ATOM(Vector,unshift)
 		
 		for(uint32_t i=0;i<argslen;i++)
 		{
+			if (th->storage != STORAGE_ATOM)
+			{
+				th->vec[i] = th->copyToSlot(args[i]);
+				continue;
+			}
 			th->vec[i] = args[i];
 			if (!th->vec_type->coerce(th->getSystemState(),th->vec[i]))
 				ASATOM_INCREF(th->vec[i]);
@@ -972,14 +1149,25 @@ ASFUNCTIONBODY_ATOM(Vector,_map)
 	for(uint32_t i=0;i<th->size();i++)
 	{
 		asAtom funcArgs[3];
-		funcArgs[0]=th->vec[i];
+		asAtom element=asAtomHandler::invalidAtom;
+		th->slotToAtom(element,th->vec[i]);
+		funcArgs[0]=element;
 		funcArgs[1]=asAtomHandler::fromUInt(i);
 		funcArgs[2]=asAtomHandler::fromObject(th);
 		asAtom funcRet=asAtomHandler::invalidAtom;
 		asAtomHandler::callFunction(func,funcRet,thisObject, funcArgs, 3,false);
+		ASATOM_DECREF(element);
 		assert_and_throw(asAtomHandler::isValid(funcRet));
-		ASATOM_INCREF(funcRet);
-		res->vec.push_back(funcRet);
+		if (res->storage != STORAGE_ATOM)
+		{
+			res->vec.push_back(res->copyToSlot(funcRet));
+			ASATOM_DECREF(funcRet);
+		}
+		else
+		{
+			ASATOM_INCREF(funcRet);
+			res->vec.push_back(funcRet);
+		}
 	}
 
 	ret = asAtomHandler::fromObject(res);
@@ -991,8 +1179,8 @@ ASFUNCTIONBODY_ATOM(Vector,_toString)
 	Vector* th = asAtomHandler::as<Vector>(obj);
 	for(size_t i=0; i < th->vec.size(); ++i)
 	{
-		if (asAtomHandler::isValid(th->vec[i]))
-			res += asAtomHandler::toString(th->vec[i],sys);
+		if (th->storage != STORAGE_ATOM || asAtomHandler::isValid(th->vec[i]))
+			res += th->slotToString(i);
 		else
 		{
 			// use the type's default value
@@ -1020,16 +1208,15 @@ ASFUNCTIONBODY_ATOM(Vector,insertAt)
 		index = th->vec.size()+(index);
 	if (index < 0)
 		index = 0;
+	asAtom s = o;
+	if (th->storage != STORAGE_ATOM)
+		s = th->copyToSlot(o);
+	else
+		ASATOM_INCREF(s);
 	if ((uint32_t)index >= th->vec.size())
-	{
-		ASATOM_INCREF(o);
-		th->vec.push_back(o);
-	}
+		th->vec.push_back(s);
 	else
-	{
-		ASATOM_INCREF(o);
-		th->vec.insert(th->vec.begin()+index,o);
-	}
+		th->vec.insert(th->vec.begin()+index,s);
 }
 
 ASFUNCTIONBODY_ATOM(Vector,removeAt)
@@ -1045,7 +1232,7 @@ ASFUNCTIONBODY_ATOM(Vector,removeAt)
 		index = 0;
 	if ((uint32_t)index < th->vec.size())
 	{
-		ret = th->vec[index];
+		th->takeSlot(ret,th->vec[index]);
 		th->vec.erase(th->vec.begin()+index);
 	}
 	else
@@ -1127,9 +1314,7 @@ GET_VARIABLE_RESULT Vector::getVariableByMultiname(asAtom& ret, const multiname&
 	}
 	if(index < vec.size())
 	{
-		ret = vec[index];
-		if (!(opt & NO_INCREF))
-			ASATOM_INCREF(ret);
+		return getSlotValue(ret,index,opt);
 	}
 	else
 	{
@@ -1143,10 +1328,7 @@ GET_VARIABLE_RESULT Vector::getVariableByInteger(asAtom &ret, int index, GET_VAR
 {
 	if (index >=0 && uint32_t(index) < size())
 	{
-		ret = vec[index];
-		if (!(opt & NO_INCREF))
-			ASATOM_INCREF(ret);
-		return GET_VARIABLE_RESULT::GETVAR_NORMAL;
+		return getSlotValue(ret,index,opt);
 	}
 	else
 		return getVariableByIntegerIntern(ret,index,opt);
@@ -1188,6 +1370,17 @@ multiname *Vector::setVariableByMultiname(const multiname& name, asAtom& o, CONS
 			throwError<ReferenceError>(kWriteSealedError, name.normalizedName(getSystemState()), this->getClass()->getQualifiedClassName());
 		return ASObject::setVariableByMultiname(name, o, allowConst,alreadyset);
 	}
+	if (storage != STORAGE_ATOM)
+	{
+		//The conversion to the unboxed value already is the coercion
+		if(index < vec.size())
+			setSlot(index,o);
+		else if(!fixed && index == vec.size())
+			vec.push_back(toSlot(o));
+		else
+			throwRangeError(index);
+		return nullptr;
+	}
 	asAtom v = o;
 	if (this->vec_type->coerce(getSystemState(), v))
 		ASATOM_DECREF(v);
@@ -1226,20 +1419,19 @@ void Vector::setVariableByInteger(int index, asAtom &o, ASObject::CONST_ALLOWED_
 		setVariableByInteger_intern(index,o,allowConst);
 		return;
 	}
-	asAtom v = o;
-	if (this->vec_type->coerce(getSystemState(), v))
-		ASATOM_DECREF(v);
+	if (storage == STORAGE_ATOM)
+	{
+		asAtom v = o;
+		if (this->vec_type->coerce(getSystemState(), v))
+			ASATOM_DECREF(v);
+	}
 	if(size_t(index) < vec.size())
 	{
-		if (vec[index].uintval != o.uintval)
-		{
-			ASATOM_DECREF(vec[index]);
-			vec[index] = o;
-		}
+		setSlot(index,o);
 	}
 	else if(!fixed && size_t(index) == vec.size())
 	{
-		vec.push_back( o );
+		vec.push_back(toSlot(o));
 	}
 	else
 	{
@@ -1268,7 +1460,7 @@ tiny_string Vector::toString()
 	{
 		if( i )
 			t += ",";
-		t += asAtomHandler::toString(vec[i],getSystemState());
+		t += slotToString(i);
 	}
 	return t;
 }
@@ -1292,10 +1484,7 @@ void Vector::nextName(asAtom& ret,uint32_t index)
 void Vector::nextValue(asAtom& ret,uint32_t index)
 {
 	if(index<=vec.size())
-	{
-		ASATOM_INCREF(vec[index-1]);
-		ret = vec[index-1];
-	}
+		slotToAtom(ret,vec[index-1]);
 	else
 		throw RunTimeException("Vector::nextValue out of bounds");
 }
@@ -1331,7 +1520,8 @@ tiny_string Vector::toJSON(std::vector<ASObject *> &path, asAtom replacer, const
 	for (unsigned int i =0;  i < vec.size(); i++)
 	{
 		tiny_string subres;
-		asAtom o = vec[i];
+		asAtom o=asAtomHandler::invalidAtom;
+		slotToAtom(o,vec[i]);
 		if (asAtomHandler::isValid(replacer))
 		{
 			asAtom params[2];
@@ -1347,6 +1537,7 @@ tiny_string Vector::toJSON(std::vector<ASObject *> &path, asAtom replacer, const
 		{
 			subres = asAtomHandler::toObject(o,getSystemState())->toJSON(path,replacer,spaces,filter);
 		}
+		ASATOM_DECREF(o);
 		if (!subres.empty())
 		{
 			if (!bfirst)
@@ -1364,14 +1555,6 @@ tiny_string Vector::toJSON(std::vector<ASObject *> &path, asAtom replacer, const
 	return res;
 }
 
-asAtom Vector::at(unsigned int index, asAtom defaultValue) const
-{
-	if (index < vec.size())
-		return vec.at(index);
-	else
-		return defaultValue;
-}
-
 void Vector::serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap,
 				std::map<const ASObject*, uint32_t>& objMap,
 				std::map<const Class_base*, uint32_t>& traitsMap)
@@ -1414,7 +1597,7 @@ void Vector::serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMa
 		}
 		for(uint32_t i=0;i<count;i++)
 		{
-			if (asAtomHandler::isInvalid(vec[i]))
+			if (storage == STORAGE_ATOM && asAtomHandler::isInvalid(vec[i]))
 			{
 				//TODO should we write a null_marker here?
 				LOG(LOG_NOT_IMPLEMENTED,"serialize unset vector objects");
@@ -1423,13 +1606,13 @@ void Vector::serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMa
 			switch (marker)
 			{
 				case vector_int_marker:
-					out->writeUnsignedInt(out->endianIn((uint32_t)asAtomHandler::toInt(vec[i])));
+					out->writeUnsignedInt(out->endianIn((uint32_t)getInt(i)));
 					break;
 				case vector_uint_marker:
-					out->writeUnsignedInt(out->endianIn(asAtomHandler::toUInt(vec[i])));
+					out->writeUnsignedInt(out->endianIn(getUInt(i)));
 					break;
 				case vector_double_marker:
-					out->serializeDouble(asAtomHandler::toNumber(vec[i]));
+					out->serializeDouble(getNumber(i));
 					break;
 				case vector_object_marker:
 					asAtomHandler::toObject(vec[i],getSystemState())->serialize(out, stringMap, objMap, traitsMap);
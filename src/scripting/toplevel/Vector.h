@@ -21,6 +21,7 @@
 #define SCRIPTING_TOPLEVEL_VECTOR_H 1
 
 #include "asobject.h"
+#include "scripting/toplevel/Number.h"
 
 namespace lightspark
 {
@@ -28,10 +29,144 @@ namespace lightspark
 template<class T> class TemplatedClass;
 class Vector: public ASObject
 {
+public:
+	/*
+	 * How the elements are kept in vec. Vectors of int, uint and Number never
+	 * hold references, so their slots store unboxed values:
+	 * STORAGE_INT/STORAGE_UINT slots always contain inline int/uint atoms,
+	 * STORAGE_NUMBER slots contain the raw bits of a double.
+	 * Atoms for Numbers are only created when an element leaves the Vector.
+	 * The unboxed stores need 64 bit atoms, 32 bit builds always use STORAGE_ATOM
+	 */
+	enum STORAGE_TYPE { STORAGE_ATOM=0, STORAGE_INT, STORAGE_UINT, STORAGE_NUMBER };
+private:
 	const Type* vec_type;
 	bool fixed;
+	STORAGE_TYPE storage;
 	std::vector<asAtom, reporter_allocator<asAtom>> vec;
 	int capIndex(int i) const;
+	void setStorageType();
+	void sortNumeric(bool isDescending);
+	tiny_string slotToString(uint32_t index);
+	static FORCE_INLINE number_t slotToNumber(const asAtom& s)
+	{
+		number_t d=0;
+#ifdef LIGHTSPARK_64
+		memcpy(&d,&s,sizeof(d));
+#else
+		assert(false);
+#endif
+		return d;
+	}
+	static FORCE_INLINE asAtom numberToSlot(number_t d)
+	{
+		asAtom s;
+#ifdef LIGHTSPARK_64
+		memcpy(&s,&d,sizeof(d));
+#else
+		assert(false);
+		s.uintval=0;
+#endif
+		return s;
+	}
+	//Converts an already coerced value to the representation used in vec, takes ownership of v
+	FORCE_INLINE asAtom toSlot(asAtom& v) const
+	{
+		switch (storage)
+		{
+			case STORAGE_INT:
+				if ((v.uintval&0x7) != ATOM_INTEGER)
+				{
+					int32_t i = asAtomHandler::toInt(v);
+					ASATOM_DECREF(v);
+					return asAtomHandler::fromInt(i);
+				}
+				return v;
+			case STORAGE_UINT:
+				if ((v.uintval&0x7) != ATOM_UINTEGER)
+				{
+					uint32_t u = asAtomHandler::toUInt(v);
+					ASATOM_DECREF(v);
+					return asAtomHandler::fromUInt(u);
+				}
+				return v;
+			case STORAGE_NUMBER:
+			{
+				number_t d = asAtomHandler::toNumber(v);
+				ASATOM_DECREF(v);
+				return numberToSlot(d);
+			}
+			default:
+				return v;
+		}
+	}
+	//Converts a borrowed value to an unboxed slot, only valid if storage is not STORAGE_ATOM
+	FORCE_INLINE asAtom copyToSlot(asAtom v) const
+	{
+		switch (storage)
+		{
+			case STORAGE_INT:
+				return (v.uintval&0x7) == ATOM_INTEGER ? v : asAtomHandler::fromInt(asAtomHandler::toInt(v));
+			case STORAGE_UINT:
+				return (v.uintval&0x7) == ATOM_UINTEGER ? v : asAtomHandler::fromUInt(asAtomHandler::toUInt(v));
+			default:
+				assert(storage == STORAGE_NUMBER);
+				return numberToSlot(asAtomHandler::toNumber(v));
+		}
+	}
+	FORCE_INLINE void acquireSlot(asAtom& s) const
+	{
+		if (storage == STORAGE_ATOM)
+			ASATOM_INCREF(s);
+	}
+	FORCE_INLINE void releaseSlot(asAtom& s) const
+	{
+		if (storage == STORAGE_ATOM)
+			ASATOM_DECREF(s);
+	}
+	//Gets a new reference to the element in slot s
+	FORCE_INLINE void slotToAtom(asAtom& ret, const asAtom& s) const
+	{
+		if (storage == STORAGE_NUMBER)
+			asAtomHandler::setNumber(ret,getSystemState(),slotToNumber(s));
+		else
+		{
+			ret = s;
+			ASATOM_INCREF(ret);
+		}
+	}
+	//Gets the element at index for getVariable, NO_INCREF gets a borrowed reference.
+	//Unboxed Numbers have nothing to borrow from, they are always returned as a new reference
+	FORCE_INLINE GET_VARIABLE_RESULT getSlotValue(asAtom& ret, uint32_t index, GET_VARIABLE_OPTION opt) const
+	{
+		if (storage == STORAGE_NUMBER)
+		{
+			asAtomHandler::setNumber(ret,getSystemState(),slotToNumber(vec[index]));
+			return (opt & NO_INCREF) ? GET_VARIABLE_RESULT::GETVAR_ISNEWOBJECT : GET_VARIABLE_RESULT::GETVAR_NORMAL;
+		}
+		ret = vec[index];
+		if (!(opt & NO_INCREF))
+			ASATOM_INCREF(ret);
+		return GET_VARIABLE_RESULT::GETVAR_NORMAL;
+	}
+	//Moves the reference held by slot s, which is removed from vec, to ret
+	FORCE_INLINE void takeSlot(asAtom& ret, const asAtom& s) const
+	{
+		if (storage == STORAGE_NUMBER)
+			asAtomHandler::setNumber(ret,getSystemState(),slotToNumber(s));
+		else
+			ret = s;
+	}
+	//Stores an already coerced value at index, takes ownership of o
+	FORCE_INLINE void setSlot(uint32_t index, asAtom& o)
+	{
+		asAtom s = toSlot(o);
+		if (vec[index].uintval != s.uintval)
+		{
+			releaseSlot(vec[index]);
+			vec[index] = s;
+		}
+	}
 	class sortComparatorDefault
 	{
 	private:
@@ -55,6 +190,8 @@ public:
 	Vector(Class_base* c, const Type *vtype=NULL);
 	~Vector();
 	bool destruct() override;
+	void collectReferences(gc_references& refs) override;
+	void releaseReferences() override;
 	
 	
 	static void sinit(Class_base* c);
@@ -77,15 +214,11 @@ public:
 		}
 		if(size_t(index) < vec.size())
 		{
-			if (vec[index].uintval != o.uintval)
-			{
-				ASATOM_DECREF(vec[index]);
-				vec[index] = o;
-			}
+			setSlot(index,o);
 		}
 		else if(!fixed && size_t(index) == vec.size())
 		{
-			vec.push_back( o );
+			vec.push_back(toSlot(o));
 		}
 		else
 		{
@@ -109,18 +242,38 @@ public:
 	{
 		return vec.size();
 	}
+	//Get value at index as a borrowed reference.
+	//Not available for Vectors of Numbers, use getNumber for them
 	asAtom at(unsigned int index) const
 	{
+		assert(storage != STORAGE_NUMBER);
 		return vec.at(index);
 	}
-	void set(uint32_t index, asAtom v)
+	//Get the numeric value at index without creating any atom
+	number_t getNumber(unsigned int index) const
+	{
+		if (storage == STORAGE_NUMBER)
+			return slotToNumber(vec.at(index));
+		return asAtomHandler::toNumber(vec.at(index));
+	}
+	int32_t getInt(unsigned int index) const
+	{
+		if (storage == STORAGE_NUMBER)
+			return Number::toInt(slotToNumber(vec.at(index)));
+		return asAtomHandler::toInt(vec.at(index));
+	}
+	uint32_t getUInt(unsigned int index) const
+	{
+		if (storage == STORAGE_NUMBER)
+			return (uint32_t)Number::toInt(slotToNumber(vec.at(index)));
+		asAtom a = vec.at(index);
+		return asAtomHandler::toUInt(a);
+	}
+	//Get the numeric value at index, or return defaultValue if index is out-of-range
+	number_t getNumber(unsigned int index, number_t defaultValue) const
 	{
-		if (index < size())
-			vec[index] = v;
+		return index < vec.size() ? getNumber(index) : defaultValue;
 	}
-	//Get value at index, or return defaultValue (a borrowed
-	//reference) if index is out-of-range
-	asAtom at(unsigned int index, asAtom defaultValue) const;
 
 	//Appends an object to the Vector. o is coerced to vec_type.
 	//Takes ownership of o.
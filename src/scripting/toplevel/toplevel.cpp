@@ -143,6 +143,22 @@ IFunction::IFunction(Class_base* c,CLASS_SUBTYPE st):ASObject(c,T_FUNCTION,st),l
 {
 }
 
+void IFunction::collectReferences(gc_references& refs)
+{
+	if(!closure_this.isNull())
+		refs.owned.push_back(closure_this.getPtr());
+	if(!prototype.isNull())
+		refs.owned.push_back(prototype.getPtr());
+	ASObject::collectReferences(refs);
+}
+
+void IFunction::releaseReferences()
+{
+	closure_this.reset();
+	prototype.reset();
+	ASObject::releaseReferences();
+}
+
 void IFunction::sinit(Class_base* c)
 {
 	c->isReusable=true;
@@ -367,13 +383,23 @@ void SyntheticFunction::call(asAtom& ret, asAtom& obj, asAtom *args, uint32_t nu
 		throwError<ArgumentError>(kWrongArgumentCountError,getSystemState()->getStringFromUniqueId(functionname),Integer::toString(mi->numArgs()),Integer::toString(numArgs));
 
 #ifdef LLVM_ENABLED
-	//Temporarily disable JITting
-	const uint32_t jit_hit_threshold=20;
-	if(getSystemState()->useJit && mi->body->exceptions.size()==0 && ((hit_count>=jit_hit_threshold && codeStatus==method_body_info::OPTIMIZED) || getSystemState()->useInterpreter==false))
+	if(getSystemState()->useJit && val==nullptr && mi->body->exceptions.size()==0)
 	{
-		//We passed the hot function threshold, synt the function
-		val=mi->synt_method(getSystemState());
-		assert(val);
+		if(getSystemState()->useTieredJit && getSystemState()->useInterpreter)
+		{
+			//Interpret the method until it gets hot, then let the vm compile it in the
+			//background and switch over as soon as the compiled code is published
+			const uint16_t jit_hit_threshold=1000;
+			if(mi->jitRequest)
+				val=ACQUIRE_READ(mi->jitRequest->code);
+			else if(++mi->body->hit_count>=jit_hit_threshold)
+				getVm(getSystemState())->requestJitCompilation(mi);
+		}
+		else if(getSystemState()->useInterpreter==false)
+		{
+			val=mi->synt_method(getSystemState());
+			assert(val);
+		}
 	}
 #endif
 
@@ -3138,14 +3164,9 @@ const multiname* ActivationType::resolveSlotTypeName(uint32_t slotId) const
 	}
 	return nullptr;
 }
-void AVM1context::AVM1ClearConstants()
-{
-	avm1strings.clear();
-}
-
-void AVM1context::AVM1AddConstant(uint32_t nameID)
+void AVM1context::AVM1SetConstants(const std::vector<uint32_t>& nameIDs)
 {
-	avm1strings.push_back(nameID);
+	avm1strings.assign(nameIDs.begin(),nameIDs.end());
 }
 
 asAtom AVM1context::AVM1GetConstant(uint16_t index)
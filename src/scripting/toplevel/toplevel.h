@@ -425,6 +425,8 @@ public:
 		prototype.reset();
 		return destructIntern();
 	}
+	void collectReferences(gc_references& refs) override;
+	void releaseReferences() override;
 	IFunction* bind(_NR<ASObject> c)
 	{
 		IFunction* ret=nullptr;
@@ -628,8 +630,7 @@ private:
 	std::vector<uint32_t> avm1strings;
 public:
 	AVM1context():keepLocals(true) {}
-	void AVM1ClearConstants();
-	void AVM1AddConstant(uint32_t nameID);
+	void AVM1SetConstants(const std::vector<uint32_t>& nameIDs);
 	asAtom AVM1GetConstant(uint16_t index);
 	bool keepLocals;
 };
@@ -641,7 +642,7 @@ class AVM1Function : public IFunction
 protected:
 	DisplayObject* clip;
 	AVM1context context;
-	std::vector<uint8_t> actionlist;
+	_R<AVM1Program> program;
 	std::vector<uint32_t> paramnames;
 	std::vector<uint8_t> paramregisternumbers;
 	std::map<uint32_t, asAtom> scopevariables;
@@ -654,8 +655,8 @@ protected:
 	bool suppressThis;
 	bool preloadThis;
 	bool preloadGlobal;
-	AVM1Function(Class_base* c,DisplayObject* cl,AVM1context* ctx, std::vector<uint32_t>& p, std::vector<uint8_t>& a,std::map<uint32_t,asAtom> scope,std::vector<uint8_t> _registernumbers=std::vector<uint8_t>(), bool _preloadParent=false, bool _preloadRoot=false, bool _suppressSuper=false, bool _preloadSuper=false, bool _suppressArguments=false, bool _preloadArguments=false,bool _suppressThis=false, bool _preloadThis=false, bool _preloadGlobal=false)
-		:IFunction(c,SUBTYPE_AVM1FUNCTION),clip(cl),actionlist(a),paramnames(p), paramregisternumbers(_registernumbers),scopevariables(scope),
+	AVM1Function(Class_base* c,DisplayObject* cl,AVM1context* ctx, const std::vector<uint32_t>& p, _R<AVM1Program> a,std::map<uint32_t,asAtom> scope,std::vector<uint8_t> _registernumbers=std::vector<uint8_t>(), bool _preloadParent=false, bool _preloadRoot=false, bool _suppressSuper=false, bool _preloadSuper=false, bool _suppressArguments=false, bool _preloadArguments=false,bool _suppressThis=false, bool _preloadThis=false, bool _preloadGlobal=false)
+		:IFunction(c,SUBTYPE_AVM1FUNCTION),clip(cl),program(a),paramnames(p), paramregisternumbers(_registernumbers),scopevariables(scope),
 		  preloadParent(_preloadParent),preloadRoot(_preloadRoot),suppressSuper(_suppressSuper),preloadSuper(_preloadSuper),suppressArguments(_suppressArguments),preloadArguments(_preloadArguments),suppressThis(_suppressThis), preloadThis(_preloadThis), preloadGlobal(_preloadGlobal) 
 	{
 		if (ctx)
@@ -671,12 +672,12 @@ protected:
 public:
 	FORCE_INLINE void call(asAtom* ret, asAtom* obj, asAtom *args, uint32_t num_args, AVM1Function* caller=nullptr)
 	{
-		ACTIONRECORD::executeActions(clip,&context,this->actionlist,0,this->scopevariables,ret,obj, args, num_args, paramnames,paramregisternumbers, preloadParent,preloadRoot,suppressSuper,preloadSuper,suppressArguments,preloadArguments,suppressThis,preloadThis,preloadGlobal,caller,this);
+		ACTIONRECORD::executeActions(clip,&context,this->program.getPtr(),this->scopevariables,ret,obj, args, num_args, paramnames,paramregisternumbers, preloadParent,preloadRoot,suppressSuper,preloadSuper,suppressArguments,preloadArguments,suppressThis,preloadThis,preloadGlobal,caller,this);
 	}
 	FORCE_INLINE multiname* callGetter(asAtom& ret, ASObject* target) override
 	{
 		asAtom obj = asAtomHandler::fromObject(target);
-		ACTIONRECORD::executeActions(clip,&context,this->actionlist,0,this->scopevariables,&ret,&obj, nullptr, 0, paramnames,paramregisternumbers, preloadParent,preloadRoot,suppressSuper,preloadSuper,suppressArguments,preloadArguments,suppressThis,preloadThis,preloadGlobal,nullptr,this);
+		ACTIONRECORD::executeActions(clip,&context,this->program.getPtr(),this->scopevariables,&ret,&obj, nullptr, 0, paramnames,paramregisternumbers, preloadParent,preloadRoot,suppressSuper,preloadSuper,suppressArguments,preloadArguments,suppressThis,preloadThis,preloadGlobal,nullptr,this);
 		return nullptr;
 	}
 	FORCE_INLINE Class_base* getReturnType() override
@@ -742,7 +743,7 @@ public:
 		c->handleConstruction(obj,nullptr,0,true);
 		return ret;
 	}
-	static AVM1Function* getAVM1Function(SystemState* sys,DisplayObject* clip, AVM1context* ctx,std::vector<uint32_t>& params, std::vector<uint8_t>& actions,std::map<uint32_t,asAtom> scope, std::vector<uint8_t> paramregisternumbers=std::vector<uint8_t>(), bool preloadParent=false, bool preloadRoot=false, bool suppressSuper=true, bool preloadSuper=false, bool suppressArguments=false, bool preloadArguments=false, bool suppressThis=true, bool preloadThis=false, bool preloadGlobal=false)
+	static AVM1Function* getAVM1Function(SystemState* sys,DisplayObject* clip, AVM1context* ctx,const std::vector<uint32_t>& params, _R<AVM1Program> actions,std::map<uint32_t,asAtom> scope, std::vector<uint8_t> paramregisternumbers=std::vector<uint8_t>(), bool preloadParent=false, bool preloadRoot=false, bool suppressSuper=true, bool preloadSuper=false, bool suppressArguments=false, bool preloadArguments=false, bool suppressThis=true, bool preloadThis=false, bool preloadGlobal=false)
 	{
 		Class<IFunction>* c=Class<IFunction>::getClass(sys);
 		AVM1Function*  ret =new (c->memoryAccount) AVM1Function(c, clip, ctx, params,actions,scope,paramregisternumbers,preloadParent,preloadRoot,suppressSuper,preloadSuper,suppressArguments,preloadArguments,suppressThis,preloadThis,preloadGlobal);
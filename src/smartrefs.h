@@ -21,11 +21,16 @@
 #define SMARTREFS_H 1
 
 #include <stdexcept>
+#include <atomic>
 #include "compat.h"
 
 namespace lightspark
 {
 
+//Values of RefCountable::cycleRootSlot, the others are slots in the root buffers of the CycleCollector
+#define CYCLE_ROOT_NONE UINT32_MAX
+#define CYCLE_ROOT_PENDING (UINT32_MAX-1)
+
 class RefCountable {
 private:
 	ATOMIC_INT32(ref_count);
@@ -33,8 +38,22 @@ private:
 	bool isConstant:1;
 	bool inDestruction:1;
 	bool cached:1;
+	//Set for objects that may be part of a reference cycle
+	bool cycleCandidate:1;
+	/*
+	   Where the object is buffered as a possible cycle root. Not a bitfield,
+	   it is changed by any thread dropping a reference
+	*/
+	std::atomic<uint32_t> cycleRootSlot;
 protected:
-	RefCountable() : ref_count(1),activation_refcount(1),isConstant(false),inDestruction(false),cached(false) {}
+	RefCountable() : ref_count(1),activation_refcount(1),isConstant(false),inDestruction(false),cached(false),cycleCandidate(false),cycleRootSlot(CYCLE_ROOT_NONE) {}
+	inline void setCycleCandidate() { cycleCandidate=true; }
+	/*
+	 * Called when a reference to a cycle candidate that is not the last one
+	 * is dropped, until the object is buffered. Returns true if the root
+	 * buffer of the cycle collector took over the dropped reference
+	 */
+	virtual bool possibleCycleRoot() { return false; }
 
 public:
 	virtual ~RefCountable() {}
@@ -50,6 +69,15 @@ public:
 	inline bool getCached() const { return cached; }
 	inline void setCached() { cached=true; }
 	inline void resetCached() { cached=false; }
+	inline bool getCycleBuffered() const { return cycleRootSlot.load(std::memory_order_relaxed)!=CYCLE_ROOT_NONE; }
+	inline uint32_t getCycleRootSlot() const { return cycleRootSlot.load(std::memory_order_acquire); }
+	inline void setCycleRootSlot(uint32_t s) { cycleRootSlot.store(s,std::memory_order_release); }
+	//Only one of the threads dropping references at the same time buffers the object
+	inline bool claimCycleRootSlot()
+	{
+		uint32_t expected=CYCLE_ROOT_NONE;
+		return cycleRootSlot.compare_exchange_strong(expected,CYCLE_ROOT_PENDING,std::memory_order_acq_rel);
+	}
 	inline void incActivationCount() { activation_refcount++; }
 	inline void decActivationCount() { activation_refcount--; }
 	inline void setActivationCount(int32_t c) { activation_refcount=c; }
@@ -84,10 +112,23 @@ public:
 			assert(ref_count>0);
 			if (ref_count == activation_refcount)
 				return handleDestruction();
+			if (cycleCandidate && cycleRootSlot.load(std::memory_order_relaxed)==CYCLE_ROOT_NONE && possibleCycleRoot())
+				return cached;
+			--ref_count;
+		}
+		return cached;
+	}
+	//Drops a reference held by the cycle collector, without buffering the object again
+	inline void decRefNoCycleRoot()
+	{
+		if (!isConstant && !cached)
+		{
+			assert(ref_count>0);
+			if (ref_count == activation_refcount)
+				handleDestruction();
 			else
 				--ref_count;
 		}
-		return cached;
 	}
 	virtual bool destruct()
 	{
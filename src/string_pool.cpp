@@ -0,0 +1,178 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "string_pool.h"
+#include "exceptions.h"
+
+using namespace lightspark;
+
+#define NOT_FOUND 0xffffffff
+
+StringPool::HashTable::HashTable(uint32_t size):mask(size-1),used(0)
+{
+	slots=new std::atomic<uint64_t>[size];
+	for(uint32_t i=0;i<size;i++)
+		slots[i].store(0,std::memory_order_relaxed);
+}
+
+StringPool::HashTable::~HashTable()
+{
+	delete[] slots;
+}
+
+StringPool::StringPool():count(0),migratePos(0)
+{
+	for(uint32_t i=0;i<STRINGPOOL_MAX_CHUNKS;i++)
+		chunks[i].store(nullptr,std::memory_order_relaxed);
+	table.store(new HashTable(STRINGPOOL_INITIAL_SLOTS),std::memory_order_relaxed);
+	oldTable.store(nullptr,std::memory_order_relaxed);
+}
+
+StringPool::~StringPool()
+{
+	for(uint32_t i=0;i<STRINGPOOL_MAX_CHUNKS;i++)
+		delete[] chunks[i].load();
+	delete table.load();
+	delete oldTable.load();
+	for(auto it=retiredTables.begin();it!=retiredTables.end();++it)
+		delete *it;
+}
+
+uint32_t StringPool::lookup(const HashTable* t, const tiny_string& s, uint32_t hash) const
+{
+	uint32_t index=hash&t->mask;
+	while(1)
+	{
+		uint64_t slot=t->slots[index].load(std::memory_order_acquire);
+		if(slot==0)
+			return NOT_FOUND;
+		if((slot>>32)==hash)
+		{
+			uint32_t id=(slot&0xffffffff)-1;
+			if(getString(id)==s)
+				return id;
+		}
+		index=(index+1)&t->mask;
+	}
+}
+
+uint32_t StringPool::lookup(const tiny_string& s, uint32_t hash) const
+{
+	uint32_t ret=lookup(table.load(std::memory_order_acquire),s,hash);
+	if(ret!=NOT_FOUND)
+		return ret;
+	/* The entry may not have been migrated yet. A miss caused by racing
+	 * with the end of the migration is fine, as the caller repeats the
+	 * lookup with writeMutex held */
+	const HashTable* old=oldTable.load(std::memory_order_acquire);
+	if(old)
+		ret=lookup(old,s,hash);
+	return ret;
+}
+
+void StringPool::insertSlot(HashTable* t, uint32_t hash, uint32_t id)
+{
+	uint32_t index=hash&t->mask;
+	while(t->slots[index].load(std::memory_order_relaxed)!=0)
+		index=(index+1)&t->mask;
+	t->slots[index].store((uint64_t(hash)<<32)|(id+1),std::memory_order_release);
+	t->used++;
+}
+
+void StringPool::migrate(uint32_t numSlots)
+{
+	HashTable* old=oldTable.load(std::memory_order_relaxed);
+	if(!old)
+		return;
+	HashTable* cur=table.load(std::memory_order_relaxed);
+	uint32_t remaining=old->mask+1-migratePos;
+	uint32_t end=migratePos+(numSlots<remaining ? numSlots : remaining);
+	for(;migratePos<end;migratePos++)
+	{
+		uint64_t slot=old->slots[migratePos].load(std::memory_order_relaxed);
+		if(slot)
+			insertSlot(cur,slot>>32,(slot&0xffffffff)-1);
+	}
+	if(migratePos==old->mask+1)
+	{
+		oldTable.store(nullptr,std::memory_order_release);
+		retiredTables.push_back(old);
+	}
+}
+
+uint32_t StringPool::appendString(const tiny_string& s)
+{
+	uint32_t id=count.load(std::memory_order_relaxed);
+	uint32_t chunk=id>>STRINGPOOL_CHUNK_BITS;
+	if(chunk>=STRINGPOOL_MAX_CHUNKS)
+		throw RunTimeException("StringPool: too many strings");
+	tiny_string* c=chunks[chunk].load(std::memory_order_relaxed);
+	if(!c)
+	{
+		c=new tiny_string[STRINGPOOL_CHUNK_SIZE];
+		chunks[chunk].store(c,std::memory_order_release);
+	}
+	c[id&(STRINGPOOL_CHUNK_SIZE-1)]=s;
+	//Pooled strings live as long as the pool, drop the room left for appends
+	c[id&(STRINGPOOL_CHUNK_SIZE-1)].compact();
+	count.store(id+1,std::memory_order_release);
+	return id;
+}
+
+void StringPool::mapString(uint32_t hash, uint32_t id)
+{
+	HashTable* cur=table.load(std::memory_order_relaxed);
+	insertSlot(cur,hash,id);
+	migrate(STRINGPOOL_MIGRATE_STEP);
+	//Keep the load factor under 1/2
+	if(cur->used*2>cur->mask+1)
+	{
+		//Finish a pending migration before starting a new one
+		migrate(0xffffffff);
+		oldTable.store(cur,std::memory_order_release);
+		table.store(new HashTable((cur->mask+1)*2),std::memory_order_release);
+		migratePos=0;
+	}
+}
+
+uint32_t StringPool::getId(const tiny_string& s)
+{
+	uint32_t hash=s.hash();
+	uint32_t ret=lookup(s,hash);
+	if(ret!=NOT_FOUND)
+		return ret;
+	Locker l(writeMutex);
+	ret=lookup(s,hash);
+	if(ret!=NOT_FOUND)
+		return ret;
+	ret=appendString(s);
+	mapString(hash,ret);
+	return ret;
+}
+
+uint32_t StringPool::addString(const tiny_string& s)
+{
+	uint32_t hash=s.hash();
+	Locker l(writeMutex);
+	bool alreadyMapped=(lookup(s,hash)!=NOT_FOUND);
+	uint32_t ret=appendString(s);
+	if(!alreadyMapped)
+		mapString(hash,ret);
+	return ret;
+}
@@ -0,0 +1,97 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef STRING_POOL_H
+#define STRING_POOL_H 1
+
+#include "compat.h"
+#include <vector>
+#include "tiny_string.h"
+#include "threading.h"
+
+namespace lightspark
+{
+
+//Interned strings are stored in chunks that are never moved
+#define STRINGPOOL_CHUNK_BITS 12
+#define STRINGPOOL_CHUNK_SIZE (1<<STRINGPOOL_CHUNK_BITS)
+#define STRINGPOOL_MAX_CHUNKS 4096
+//Initial number of slots of the hash table, must be a power of 2
+#define STRINGPOOL_INITIAL_SLOTS 4096
+//Number of slots moved to the new table on every insertion while growing
+#define STRINGPOOL_MIGRATE_STEP 64
+
+/*
+ * Concurrent string interning table.
+ * Strings are mapped to consecutive ids starting from 0. Lookups of
+ * already interned strings and id to string conversions don't take any
+ * lock. Insertions are serialized by a mutex. When the open addressing
+ * table needs to grow the entries are moved incrementally to the new
+ * table, so no single insertion has to rehash the whole pool.
+ */
+class StringPool
+{
+private:
+	struct HashTable
+	{
+		uint32_t mask;
+		uint32_t used;
+		//Each slot packs (hash<<32)|(id+1), 0 marks an empty slot
+		std::atomic<uint64_t>* slots;
+		HashTable(uint32_t size);
+		~HashTable();
+	};
+	std::atomic<tiny_string*> chunks[STRINGPOOL_MAX_CHUNKS];
+	std::atomic<uint32_t> count;
+	std::atomic<HashTable*> table;
+	//The table being migrated into table, if any
+	std::atomic<HashTable*> oldTable;
+	uint32_t migratePos;
+	//Readers may still be probing replaced tables, so they are only freed on destruction
+	std::vector<HashTable*> retiredTables;
+	Mutex writeMutex;
+	uint32_t lookup(const HashTable* t, const tiny_string& s, uint32_t hash) const;
+	uint32_t lookup(const tiny_string& s, uint32_t hash) const;
+	static void insertSlot(HashTable* t, uint32_t hash, uint32_t id);
+	uint32_t appendString(const tiny_string& s);
+	void mapString(uint32_t hash, uint32_t id);
+	void migrate(uint32_t numSlots);
+public:
+	StringPool();
+	~StringPool();
+	//Returns the id of the string, interning it if needed
+	uint32_t getId(const tiny_string& s);
+	/*
+	 * Always allocates the next id for the string, even if an equal string
+	 * was already interned. Lookups will keep returning the first id.
+	 */
+	uint32_t addString(const tiny_string& s);
+	inline const tiny_string& getString(uint32_t id) const
+	{
+		assert(id < count.load(std::memory_order_acquire));
+		return chunks[id>>STRINGPOOL_CHUNK_BITS].load(std::memory_order_acquire)[id&(STRINGPOOL_CHUNK_SIZE-1)];
+	}
+	inline uint32_t size() const
+	{
+		return count.load(std::memory_order_acquire);
+	}
+};
+
+};
+#endif /* STRING_POOL_H */
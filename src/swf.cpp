@@ -207,32 +207,21 @@ SystemState::SystemState(uint32_t fileSize, FLASH_MODE mode):
 	renderThread(nullptr),inputThread(nullptr),engineData(nullptr),dumpedSWFPathAvailable(0),
 	vmVersion(VMNONE),childPid(0),
 	parameters(NullRef),
-	invalidateQueueHead(NullRef),invalidateQueueTail(NullRef),lastUsedStringId(0),lastUsedNamespaceId(0x7fffffff),
+	invalidateQueueHead(NullRef),invalidateQueueTail(NullRef),lastUsedNamespaceId(0x7fffffff),
 	showProfilingData(false),allowFullscreen(false),flashMode(mode),swffilesize(fileSize),avm1global(nullptr),
-	currentVm(nullptr),builtinClasses(nullptr),useInterpreter(true),useFastInterpreter(false),useJit(false),ignoreUnhandledExceptions(false),exitOnError(ERROR_NONE),singleworker(true),
+	currentVm(nullptr),builtinClasses(nullptr),useInterpreter(true),useFastInterpreter(false),useJit(false),useTieredJit(false),ignoreUnhandledExceptions(false),exitOnError(ERROR_NONE),
+	offlineCapture(false),captureFrameCount(0),capturedFrames(0),singleworker(true),
 	downloadManager(nullptr),extScriptObject(nullptr),scaleMode(SHOW_ALL),currentflushstep(1),nextflushstep(0),unaccountedMemory(nullptr),tagsMemory(nullptr),stringMemory(nullptr),textTokenMemory(nullptr),shapeTokenMemory(nullptr),morphShapeTokenMemory(nullptr),bitmapTokenMemory(nullptr),spriteTokenMemory(nullptr),
 	static_SoundMixer_bufferTime(0),isinitialized(false)
 {
 	//Forge the builtin strings
-	uniqueStringIDMap.reserve(LAST_BUILTIN_STRING);
 	tiny_string sempty;
-	uniqueStringMap.emplace(make_pair(sempty,lastUsedStringId));
-	uniqueStringIDMap.push_back(sempty);
-	lastUsedStringId++;
+	uniqueStrings.addString(sempty);
 	for(uint32_t i=1;i<BUILTIN_STRINGS_CHAR_MAX;i++)
-	{
-		tiny_string s = tiny_string::fromChar(i);
-		uniqueStringMap.emplace(make_pair(s,lastUsedStringId));
-		uniqueStringIDMap.push_back(s);
-		lastUsedStringId++;
-	}
+		uniqueStrings.addString(tiny_string::fromChar(i));
 	for(uint32_t i=BUILTIN_STRINGS_CHAR_MAX;i<LAST_BUILTIN_STRING;i++)
-	{
-		tiny_string s(builtinStrings[i-BUILTIN_STRINGS_CHAR_MAX]);
-		uniqueStringMap.emplace(make_pair(s,lastUsedStringId));
-		uniqueStringIDMap.push_back(s);
-		lastUsedStringId++;
-	}
+		uniqueStrings.addString(tiny_string(builtinStrings[i-BUILTIN_STRINGS_CHAR_MAX]));
+	assert(uniqueStrings.size()==LAST_BUILTIN_STRING);
 	//Forge the empty namespace and make sure it gets id 0
 	nsNameAndKindImpl emptyNs(BUILTIN_STRINGS::EMPTY, NAMESPACE);
 	uint32_t nsId;
@@ -259,6 +248,8 @@ SystemState::SystemState(uint32_t fileSize, FLASH_MODE mode):
 	morphShapeTokenMemory = allocateMemoryAccount("Tokens.MorphShape");
 	bitmapTokenMemory = allocateMemoryAccount("Tokens.Bitmap");
 	spriteTokenMemory = allocateMemoryAccount("Tokens.Sprite");
+	cycleCollector.setMemoryAccount(allocateMemoryAccount("Cycle_collector"));
+	rasterCache.setMemoryAccount(allocateMemoryAccount("Raster_cache"));
 
 	null=_MR(new (unaccountedMemory) Null);
 	null->setSystemState(this);
@@ -560,11 +551,20 @@ void SystemState::saveMemoryUsageInformation(ofstream& out, int snapshotCount) c
 		if(it->bytes>0)
 			out << " n0: " << it->bytes << " " << it->name << endl;
 	}
+	it=memoryAccounts.begin();
+	for(;it!=memoryAccounts.end();++it)
+	{
+		if(it->collectedObjects>0)
+			out << "#" << it->name << " collected_objects=" << it->collectedObjects << endl;
+	}
 }
 #endif
 
 void SystemState::systemFinalize()
 {
+	//Everything is released from here on, no need to look for cycles
+	cycleCollector.setEnabled(false);
+	rasterCache.clear();
 	invalidateQueueHead.reset();
 	invalidateQueueTail.reset();
 	parameters.reset();
@@ -764,6 +764,8 @@ void SystemState::addWorker(ASWorker *w)
 	w->incRef();
 	workerDomain->workerlist->append(a);
 	singleworker=workerDomain->workerlist->size() <= 1;
+	//Objects may be shared between the vm threads of the workers
+	cycleCollector.setEnabled(singleworker);
 }
 
 void SystemState::removeWorker(ASWorker *w)
@@ -771,6 +773,7 @@ void SystemState::removeWorker(ASWorker *w)
 	Locker l(workerMutex);
 	workerDomain->workerlist->remove(w);
 	singleworker=workerDomain->workerlist->size() <= 1;
+	cycleCollector.setEnabled(singleworker);
 
 }
 
@@ -778,6 +781,9 @@ void SystemState::startRenderTicks()
 {
 	assert(renderThread);
 	assert(renderRate);
+	//The offline capture renders on the ticks of the main clip
+	if(offlineCapture)
+		return;
 	removeJob(renderThread);
 	addTick(1000/renderRate,renderThread);
 }
@@ -802,14 +808,21 @@ void SystemState::delayedCreation(SystemState* sys)
 	int32_t reqWidth=sys->mainClip->getFrameSize().Xmax/20;
 	int32_t reqHeight=sys->mainClip->getFrameSize().Ymax/20;
 
-	if (EngineData::enablerendering)
+	if (EngineData::enablerendering && !EngineData::softwarerendering)
 		sys->engineData->showWindow(reqWidth, reqHeight);
 
 	sys->inputThread->start(sys->engineData);
 
 	if(EngineData::enablerendering && Config::getConfig()->isRenderingEnabled())
 	{
-		if (sys->engineData->needrenderthread)
+		if (EngineData::softwarerendering)
+		{
+			//There is no window, frames are composited at the size of the movie
+			sys->getRenderThread()->windowWidth = reqWidth;
+			sys->getRenderThread()->windowHeight = reqHeight;
+			sys->renderThread->start(sys->engineData);
+		}
+		else if (sys->engineData->needrenderthread)
 			sys->renderThread->start(sys->engineData);
 	}
 	else
@@ -1134,6 +1147,7 @@ ThreadProfile* SystemState::allocateProfiler(const lightspark::RGB& color)
 
 void SystemState::addToInvalidateQueue(_R<DisplayObject> d)
 {
+	d->geometryChanged();
 	Locker l(invalidateQueueLock);
 	//Check if the object is already in the queue
 	if(!d->invalidateQueueNext.isNull() || d==invalidateQueueTail)
@@ -1299,7 +1313,7 @@ void ThreadProfile::plot(uint32_t maxTime, cairo_t *cr)
 
 ParseThread::ParseThread(istream& in, _R<ApplicationDomain> appDomain, _R<SecurityDomain> secDomain, Loader *_loader, tiny_string srcurl)
   : version(0),applicationDomain(appDomain),securityDomain(secDomain),
-    f(in),uncompressingFilter(NULL),backend(NULL),loader(_loader),
+    f(in),uncompressingFilter(NULL),backend(NULL),pipelinedFilter(NULL),loader(_loader),
     parsedObject(NullRef),url(srcurl),fileType(FT_UNKNOWN)
 {
 	f.exceptions ( istream::eofbit | istream::failbit | istream::badbit );
@@ -1307,7 +1321,7 @@ ParseThread::ParseThread(istream& in, _R<ApplicationDomain> appDomain, _R<Securi
 
 ParseThread::ParseThread(std::istream& in, RootMovieClip *root)
   : version(0),applicationDomain(NullRef),securityDomain(NullRef), //The domains are not needed since the system state create them itself
-    f(in),uncompressingFilter(NULL),backend(NULL),loader(NULL),
+    f(in),uncompressingFilter(NULL),backend(NULL),pipelinedFilter(NULL),loader(NULL),
     parsedObject(NullRef),url(),fileType(FT_UNKNOWN)
 {
 	f.exceptions ( istream::eofbit | istream::failbit | istream::badbit );
@@ -1320,6 +1334,7 @@ ParseThread::~ParseThread()
 	{
 		//Restore the istream
 		f.rdbuf(backend);
+		delete pipelinedFilter;
 		delete uncompressingFilter;
 	}
 	parsedObject.reset();
@@ -1378,7 +1393,10 @@ void ParseThread::parseSWFHeader(RootMovieClip *root, UI8 ver)
 			// not reached
 			assert(false);
 		}
-		f.rdbuf(uncompressingFilter);
+		//Decompression runs in the thread pool while the tags are parsed
+		pipelinedFilter = new pipelined_filter(uncompressingFilter, root->getSystemState());
+		//Tags copy their data out of the inflated stream, only uncompressed local files are parsed from a mapping
+		f.rdbuf(pipelinedFilter);
 		// the first 8 bytes from the header are always uncompressed (magic bytes + FileLength)
 		root->loaderInfo->setBytesTotal(FileLength-8);
 	}
@@ -1573,6 +1591,8 @@ void ParseThread::parseSWF(UI8 ver)
 				{
 					DictionaryTag* d=static_cast<DictionaryTag*>(tag);
 					root->addToDictionary(d);
+					//Assets of the first frame are needed before anything can be shown
+					d->startDecoding(root->frames.size()==1 ? THREAD_JOB_PRIORITY_NORMAL : THREAD_JOB_PRIORITY_LOW);
 					break;
 				}
 				case DISPLAY_LIST_TAG:
@@ -2015,6 +2035,23 @@ void SystemState::tick()
 	/* TODO: Step 7: dispatch render event (Assuming stage.invalidate() has been called) */
 
 	/* Step 9: we are idle now, so we can handle all input events */
+	waitForVmIdle();
+
+	if(offlineCapture && !isShuttingDown() && renderThread->captureFrame())
+	{
+		capturedFrames++;
+		if(captureFrameCount && capturedFrames>=captureFrameCount)
+		{
+			LOG(LOG_INFO,"captured " << capturedFrames << " frames");
+			setShutdownFlag();
+		}
+	}
+}
+
+void SystemState::waitForVmIdle()
+{
+	if(currentVm==nullptr)
+		return;
 	_R<IdleEvent> idle = _MR(new (unaccountedMemory) IdleEvent());
 	if (currentVm->addEvent(NullRef, idle))
 		idle->wait();
@@ -2041,24 +2078,12 @@ void SystemState::resizeCompleted()
 
 const tiny_string& SystemState::getStringFromUniqueId(uint32_t id) const
 {
-	Locker l(poolMutex);
-	assert(uniqueStringIDMap.size() > id);
-	return uniqueStringIDMap[id];
+	return uniqueStrings.getString(id);
 }
 
 uint32_t SystemState::getUniqueStringId(const tiny_string& s)
 {
-	Locker l(poolMutex);
-	auto it=uniqueStringMap.find(s);
-	if(it==uniqueStringMap.end())
-	{
-		auto ret=uniqueStringMap.insert(make_pair(s,lastUsedStringId));
-		uniqueStringIDMap.push_back(s);
-		assert(ret.second);
-		it=ret.first;
-		lastUsedStringId++;
-	}
-	return it->second;
+	return uniqueStrings.getId(s);
 }
 
 const nsNameAndKindImpl& SystemState::getNamespaceFromUniqueId(uint32_t id) const
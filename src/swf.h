@@ -33,9 +33,13 @@
 #include "scripting/flash/utils/IntervalManager.h"
 #include "timer.h"
 #include "memory_support.h"
+#include "string_pool.h"
+#include "cycle_collector.h"
+#include "backends/rastercache.h"
 #include "platforms/engineutils.h"
 
 class uncompressing_filter;
+class pipelined_filter;
 
 namespace lightspark
 {
@@ -280,9 +284,7 @@ private:
 	 * Pooling support
 	 */
 	mutable Mutex poolMutex;
-	map<tiny_string, uint32_t> uniqueStringMap;
-	vector<tiny_string> uniqueStringIDMap;
-	uint32_t lastUsedStringId;
+	StringPool uniqueStrings;
 	map<nsNameAndKindImpl, uint32_t> uniqueNamespaceImplMap;
 	unordered_map<uint32_t,nsNameAndKindImpl> uniqueNamespaceIDMap;
 	//This needs to be atomic because it's decremented without the mutex held
@@ -322,6 +324,10 @@ public:
 	void setShutdownFlag() DLL_PUBLIC;
 	void tick() override;
 	void tickFence() override;
+	/*
+	 * Waits until the vm has handled the events queued so far
+	 */
+	void waitForVmIdle();
 	RenderThread* getRenderThread() const { return renderThread; }
 	InputThread* getInputThread() const { return inputThread; }
 	void setParamsAndEngine(EngineData* e, bool s) DLL_PUBLIC;
@@ -394,8 +400,22 @@ public:
 	bool useInterpreter;
 	bool useFastInterpreter;
 	bool useJit;
+	//Start methods in the interpreter and compile them in the background once they are hot
+	bool useTieredJit;
+	//Frees reference cycles of ActionScript objects, a slice runs at the end of every frame
+	CycleCollector cycleCollector;
+	//Surfaces drawn by CairoRenderer, shared by all the objects
+	RasterCache rasterCache;
 	bool ignoreUnhandledExceptions;
 	ERROR_TYPE exitOnError;
+	/*
+	 * Runs the movie on the simulated clock (compat_enable_virtual_clock) as
+	 * fast as possible and writes a frame on every tick of the main clip
+	 */
+	bool offlineCapture;
+	//Number of frames captured before quitting, 0 for no limit
+	uint32_t captureFrameCount;
+	uint32_t capturedFrames;
 
 	//Parameters/FlashVars
 	void parseParametersFromFile(const char* f) DLL_PUBLIC;
@@ -559,6 +579,8 @@ private:
 	std::istream& f;
 	uncompressing_filter* uncompressingFilter;
 	std::streambuf* backend;
+	//Reads uncompressingFilter ahead in the thread pool
+	pipelined_filter* pipelinedFilter;
 	Loader *loader;
 	_NR<DisplayObject> parsedObject;
 	Mutex objectSpinlock;
@@ -884,8 +884,8 @@ std::istream& lightspark::operator>>(std::istream& s, FILLSTYLE& v)
 		{
 			try
 			{
-				const DictionaryTag* dict=getParseThread()->getRootMovie()->dictionaryLookup(bitmapId);
-				const BitmapTag* b = dynamic_cast<const BitmapTag*>(dict);
+				DictionaryTag* dict=getParseThread()->getRootMovie()->dictionaryLookup(bitmapId);
+				BitmapTag* b = dynamic_cast<BitmapTag*>(dict);
 				if(!b)
 				{
 					LOG(LOG_ERROR,"Invalid bitmap ID " << bitmapId);
@@ -893,7 +893,10 @@ std::istream& lightspark::operator>>(std::istream& s, FILLSTYLE& v)
 					//throw ParseException("Invalid ID for bitmap");
 				}
 				else
-					v.bitmap = b->getBitmap();
+				{
+					//Decoded when the style is first rendered, not on the parser thread
+					v.bitmap = b->getUndecodedBitmap();
+				}
 			}
 			catch(RunTimeException& e)
 			{
@@ -1484,15 +1487,18 @@ std::istream& lightspark::operator>>(std::istream& s, CLIPACTIONRECORD& v)
 		s >> v.KeyCode;
 		len -= 1;
 	}
+	uint32_t startactionpos=0;
+	std::vector<uint8_t> actions;
 	if (v.datatag)
 	{
-		v.startactionpos=v.datatag->numbytes;//+datatagskipbytes;
-		v.actions.resize(len+v.startactionpos);
-		memcpy(v.actions.data(),v.datatag->bytes,v.datatag->numbytes);
+		startactionpos=v.datatag->numbytes;//+datatagskipbytes;
+		actions.resize(len+startactionpos);
+		memcpy(actions.data(),v.datatag->bytes,v.datatag->numbytes);
 	}
 	else
-		v.actions.resize(len);
-	s.read((char*)(v.actions.data()+v.startactionpos),len);
+		actions.resize(len);
+	s.read((char*)(actions.data()+startactionpos),len);
+	v.actions=_MR(new AVM1Program(actions,startactionpos));
 	return s;
 }
 
@@ -63,7 +63,7 @@ enum CLASS_SUBTYPE { SUBTYPE_NOT_SET, SUBTYPE_PROXY, SUBTYPE_REGEXP, SUBTYPE_XML
 					 ,SUBTYPE_CONTEXT3D,SUBTYPE_TEXTUREBASE,SUBTYPE_TEXTURE,SUBTYPE_CUBETEXTURE,SUBTYPE_RECTANGLETEXTURE,SUBTYPE_VIDEOTEXTURE,SUBTYPE_VECTOR3D,SUBTYPE_NETSTREAM
 					 ,SUBTYPE_WORKER,SUBTYPE_WORKERDOMAIN,SUBTYPE_MUTEX,SUBTYPE_AVM1FUNCTION,SUBTYPE_SAMPLEDATA_EVENT
 					 ,SUBTYPE_BITMAPFILTER,SUBTYPE_GLOWFILTER,SUBTYPE_DROPSHADOWFILTER,SUBTYPE_GRADIENTGLOWFILTER,SUBTYPE_BEVELFILTER,SUBTYPE_COLORMATRIXFILTER,SUBTYPE_BLURFILTER,SUBTYPE_CONVOLUTIONFILTER,SUBTYPE_DISPLACEMENTFILTER,SUBTYPE_GRADIENTBEVELFILTER,SUBTYPE_SHADERFILTER
-					 ,SUBTYPE_THROTTLE_EVENT,SUBTYPE_CONTEXTMENUEVENT,SUBTYPE_GAMEINPUTEVENT, SUBTYPE_GAMEINPUTDEVICE
+					 ,SUBTYPE_THROTTLE_EVENT,SUBTYPE_CONTEXTMENUEVENT,SUBTYPE_GAMEINPUTEVENT, SUBTYPE_GAMEINPUTDEVICE,SUBTYPE_DICTIONARY
 				   };
  
 enum STACK_TYPE{STACK_NONE=0,STACK_OBJECT,STACK_INT,STACK_UINT,STACK_NUMBER,STACK_BOOLEAN};
@@ -1425,16 +1425,16 @@ public:
 
 class AdditionalDataTag;
 class ACTIONRECORD;
+class AVM1Program;
 class CLIPACTIONRECORD
 {
 public:
-	CLIPACTIONRECORD(uint32_t v, AdditionalDataTag* _datatag):EventFlags(v),startactionpos(0),datatag( _datatag) {}
+	CLIPACTIONRECORD(uint32_t v, AdditionalDataTag* _datatag):EventFlags(v),datatag( _datatag) {}
 	CLIPEVENTFLAGS EventFlags;
 	UI32_SWF ActionRecordSize;
 	UI8 KeyCode;
-	std::vector<uint8_t> actions;
+	_NR<AVM1Program> actions;
 	bool isLast();
-	uint32_t startactionpos;
 	AdditionalDataTag* datatag;
 };
 class CLIPACTIONS
@@ -1493,13 +1493,76 @@ public:
 	}
 };
 
+/*
+ * An action block (DoAction, DoInitAction, clip and button actions and
+ * function bodies). The action bytes are decoded only once, on the first
+ * execution, into a compact instruction array with resolved branch targets,
+ * string ids and push values. Nested function bodies become child programs
+ * that are decoded when they are first called.
+ */
+class AVM1Program: public RefCountable
+{
+friend class ACTIONRECORD;
+public:
+	struct instruction
+	{
+		//Offset of the action in the action bytes
+		uint32_t pos;
+		//Index of the following instruction
+		uint32_t next;
+		//Index of the branch target of ActionJump and ActionIf
+		uint32_t target;
+		//Decoded operands, their meaning depends on the opcode
+		uint32_t arg;
+		uint32_t arg2;
+		//0 for ActionEnd and the end of the actions
+		uint8_t opcode;
+	};
+	enum PUSHVALUE_TYPE { PUSH_STRING=0, PUSH_NUMBER, PUSH_INT, PUSH_BOOL, PUSH_NULL, PUSH_UNDEFINED, PUSH_REGISTER, PUSH_CONSTANT };
+	struct pushvalue
+	{
+		PUSHVALUE_TYPE type;
+		//String id, integer, boolean, register number or constant pool index
+		uint32_t value;
+		//Constant Number for PUSH_NUMBER
+		ASObject* number;
+	};
+	struct function
+	{
+		//Lowercased name, empty for anonymous functions
+		uint32_t nameID;
+		std::vector<uint32_t> paramnames;
+		std::vector<uint8_t> paramregisternumbers;
+		uint8_t flags;
+		bool preloadGlobal;
+		_NR<AVM1Program> code;
+	};
+private:
+	std::vector<uint8_t> actions;
+	uint32_t startactionpos;
+	std::vector<instruction> code;
+	std::vector<pushvalue> pushvalues;
+	std::vector<std::vector<uint32_t>> constantpools;
+	std::vector<function> functions;
+	//Constant pool the program starts with, the one of the defining block for function bodies
+	std::vector<uint32_t> constants;
+	bool hasconstants;
+	uint32_t numregisters;
+	uint32_t stacksize;
+	bool decoded;
+	void decode(SystemState* sys);
+	uint32_t decodeAction(SystemState* sys, uint32_t pos, instruction& ins);
+	void resolveConstants();
+public:
+	//The action bytes are taken from a, execution starts at startpos
+	AVM1Program(std::vector<uint8_t>& a, uint32_t startpos);
+	bool empty() const { return actions.empty() && code.empty(); }
+};
+
 class ACTIONRECORD
 {
 public:
-	static void PushStack(std::stack<asAtom>& stack,const asAtom& a);
-	static asAtom PopStack(std::stack<asAtom>& stack);
-	static asAtom PeekStack(std::stack<asAtom>& stack);
-	static void executeActions(DisplayObject* clip, AVM1context* context, const std::vector<uint8_t> &actionlist, uint32_t startactionpos, std::map<uint32_t, union asAtom> &scopevariables, asAtom *result = nullptr, asAtom* obj = nullptr, asAtom *args = nullptr, uint32_t num_args=0, const std::vector<uint32_t>& paramnames=std::vector<uint32_t>(), const std::vector<uint8_t>& paramregisternumbers=std::vector<uint8_t>(),
+	static void executeActions(DisplayObject* clip, AVM1context* context, AVM1Program* program, std::map<uint32_t, union asAtom> &scopevariables, asAtom *result = nullptr, asAtom* obj = nullptr, asAtom *args = nullptr, uint32_t num_args=0, const std::vector<uint32_t>& paramnames=std::vector<uint32_t>(), const std::vector<uint8_t>& paramregisternumbers=std::vector<uint8_t>(),
 			bool preloadParent=false, bool preloadRoot=false, bool suppressSuper=true, bool preloadSuper=false, bool suppressArguments=false, bool preloadArguments=false, bool suppressThis=true, bool preloadThis=false, bool preloadGlobal=false,AVM1Function *caller = nullptr, AVM1Function *callee = nullptr);
 };
 class BUTTONCONDACTION
@@ -1508,7 +1571,7 @@ friend std::istream& operator>>(std::istream& s, BUTTONCONDACTION& v);
 public:
 	BUTTONCONDACTION():CondActionSize(0)
 	  ,CondIdleToOverDown(false),CondOutDownToIdle(false),CondOutDownToOverDown(false),CondOverDownToOutDown(false)
-	  ,CondOverDownToOverUp(false),CondOverUpToOverDown(false),CondOverUpToIdle(false),CondIdleToOverUp(false),CondOverDownToIdle(false),startactionpos(0)
+	  ,CondOverDownToOverUp(false),CondOverUpToOverDown(false),CondOverUpToIdle(false),CondIdleToOverUp(false),CondOverDownToIdle(false)
 	{}
 	UI16_SWF CondActionSize;
 	bool CondIdleToOverDown;
@@ -1521,8 +1584,7 @@ public:
 	bool CondIdleToOverUp;
 	bool CondOverDownToIdle;
 	uint32_t CondKeyPress;
-	uint32_t startactionpos;
-	std::vector<uint8_t> actions;
+	_NR<AVM1Program> actions;
 };
 
 ASObject* abstract_i(SystemState *sys, int32_t i);
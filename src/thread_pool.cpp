@@ -24,50 +24,159 @@
 #include "logger.h"
 #include "swf.h"
 
+#include <SDL2/SDL_cpuinfo.h>
+
 using namespace lightspark;
 
-ThreadPool::ThreadPool(SystemState* s):num_jobs(0),stopFlag(false)
+//The worker running on the current thread, if any
+DEFINE_AND_INITIALIZE_TLS(current_worker);
+
+WorkStealingDeque::WorkStealingDeque():top(0),bottom(0)
 {
-	m_sys=s;
-	for(uint32_t i=0;i<NUM_THREADS;i++)
+	for(uint32_t i=0;i<WORKER_DEQUE_SIZE;i++)
+		buffer[i].store(nullptr,std::memory_order_relaxed);
+}
+
+bool WorkStealingDeque::push(IThreadJob* j)
+{
+	int64_t b=bottom.load(std::memory_order_relaxed);
+	int64_t t=top.load(std::memory_order_acquire);
+	if(b-t>=WORKER_DEQUE_SIZE)
+		return false;
+	buffer[b&(WORKER_DEQUE_SIZE-1)].store(j,std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	bottom.store(b+1,std::memory_order_relaxed);
+	return true;
+}
+
+IThreadJob* WorkStealingDeque::pop()
+{
+	int64_t b=bottom.load(std::memory_order_relaxed)-1;
+	bottom.store(b,std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t t=top.load(std::memory_order_relaxed);
+	if(t>b)
+	{
+		//The deque was already empty
+		bottom.store(b+1,std::memory_order_relaxed);
+		return nullptr;
+	}
+	IThreadJob* ret=buffer[b&(WORKER_DEQUE_SIZE-1)].load(std::memory_order_relaxed);
+	if(t==b)
 	{
-		curJobs[i]=nullptr;
-		data[i].index=i;
-		data[i].pool = this;
-		threads[i] = SDL_CreateThread(job_worker,"ThreadPool",&data[i]);
+		//Last element, race against the thieves
+		if(!top.compare_exchange_strong(t,t+1,std::memory_order_seq_cst,std::memory_order_relaxed))
+			ret=nullptr;
+		bottom.store(b+1,std::memory_order_relaxed);
 	}
+	return ret;
+}
+
+IThreadJob* WorkStealingDeque::steal()
+{
+	int64_t t=top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t b=bottom.load(std::memory_order_acquire);
+	if(t>=b)
+		return nullptr;
+	IThreadJob* ret=buffer[t&(WORKER_DEQUE_SIZE-1)].load(std::memory_order_relaxed);
+	if(!top.compare_exchange_strong(t,t+1,std::memory_order_seq_cst,std::memory_order_relaxed))
+		return nullptr;
+	return ret;
+}
+
+bool WorkStealingDeque::empty() const
+{
+	return top.load(std::memory_order_acquire)>=bottom.load(std::memory_order_acquire);
+}
+
+ThreadPool::ThreadPool(SystemState* s):numWorkers(0),nextInbox(0),pendingJobs(0),idleWorkers(0),stopFlag(false)
+{
+	m_sys=s;
+	for(uint32_t i=0;i<MAX_THREADS;i++)
+		workers[i]=nullptr;
+	int initialWorkers=SDL_GetCPUCount();
+	if(initialWorkers<MIN_THREADS)
+		initialWorkers=MIN_THREADS;
+	if(initialWorkers>MAX_THREADS)
+		initialWorkers=MAX_THREADS;
+	for(int i=0;i<initialWorkers;i++)
+		spawnWorker();
+}
+
+void ThreadPool::spawnWorker()
+{
+	Locker l(workersMutex);
+	uint32_t index=numWorkers.load(std::memory_order_relaxed);
+	if(stopFlag || index>=MAX_THREADS)
+		return;
+	Worker* w=new Worker(this,index);
+	workers[index]=w;
+	//The new worker is idle until it claims a job
+	queueMutex.lock();
+	idleWorkers++;
+	queueMutex.unlock();
+	w->thread=SDL_CreateThread(job_worker,"ThreadPool",w);
+	numWorkers.store(index+1,std::memory_order_release);
 }
 
 void ThreadPool::forceStop()
 {
 	if(!stopFlag)
 	{
+		//Wake up all the idle threads
+		queueMutex.lock();
 		stopFlag=true;
-		//Signal an event for all the threads
-		for(int i=0;i<NUM_THREADS;i++)
-			num_jobs.signal();
+		jobsCond.broadcast();
+		queueMutex.unlock();
+		//No worker can be spawned after this point
+		workersMutex.lock();
+		uint32_t n=numWorkers.load(std::memory_order_acquire);
+		workersMutex.unlock();
 
+		//Now abort any job that is still executing
+		for(uint32_t i=0;i<n;i++)
 		{
-			Locker l(mutex);
-			//Now abort any job that is still executing
-			for(int i=0;i<NUM_THREADS;i++)
+			Locker lj(workers[i]->curJobMutex);
+			if(workers[i]->curJob)
 			{
-				if(curJobs[i])
-				{
-					curJobs[i]->threadAborting = true;
-					curJobs[i]->threadAbort();
-				}
+				workers[i]->curJob->threadAborting = true;
+				workers[i]->curJob->threadAbort();
 			}
-			//Fence all the non executed jobs
-			std::deque<IThreadJob*>::iterator it=jobs.begin();
-			for(;it!=jobs.end();++it)
-				(*it)->jobFence();
-			jobs.clear();
 		}
+		//Fence all the non executed jobs
+		fenceQueuedJobs();
+
+		for(uint32_t i=0;i<n;i++)
+		{
+			SDL_WaitThread(workers[i]->thread,nullptr);
+		}
+		//Jobs may have been added by the aborted jobs while stopping
+		fenceQueuedJobs();
+	}
+}
 
-		for(int i=0;i<NUM_THREADS;i++)
+void ThreadPool::fenceQueuedJobs()
+{
+	uint32_t n=numWorkers.load(std::memory_order_acquire);
+	for(uint32_t i=0;i<n;i++)
+	{
+		Worker* w=workers[i];
+		for(uint32_t p=0;p<THREAD_JOB_PRIORITY_COUNT;p++)
 		{
-			SDL_WaitThread(threads[i],nullptr);
+			//steal() may fail spuriously if it races with the owner
+			while(!w->deque[p].empty())
+			{
+				IThreadJob* j=w->deque[p].steal();
+				if(j)
+					j->jobFence();
+			}
+			std::deque<IThreadJob*> pending;
+			w->inboxMutex.lock();
+			pending.swap(w->inbox[p]);
+			w->inboxMutex.unlock();
+			for(auto it=pending.begin();it!=pending.end();++it)
+				(*it)->jobFence();
 		}
 	}
 }
@@ -75,36 +184,127 @@ void ThreadPool::forceStop()
 ThreadPool::~ThreadPool()
 {
 	forceStop();
+	fenceQueuedJobs();
+	for(uint32_t i=0;i<MAX_THREADS;i++)
+		delete workers[i];
+}
+
+IThreadJob* ThreadPool::tryTakeJob(Worker* self, uint32_t priority, bool blocking)
+{
+	IThreadJob* ret=self->deque[priority].pop();
+	if(ret)
+		return ret;
+	self->inboxMutex.lock();
+	if(!self->inbox[priority].empty())
+	{
+		ret=self->inbox[priority].front();
+		self->inbox[priority].pop_front();
+	}
+	self->inboxMutex.unlock();
+	if(ret)
+		return ret;
+	//Steal from the other workers, starting from our neighbour
+	uint32_t n=numWorkers.load(std::memory_order_acquire);
+	for(uint32_t i=1;i<n;i++)
+	{
+		Worker* victim=workers[(self->index+i)%n];
+		ret=victim->deque[priority].steal();
+		//steal() fails if it races with the owner or another thief
+		while(!ret && blocking && !victim->deque[priority].empty())
+			ret=victim->deque[priority].steal();
+		if(ret)
+			return ret;
+		//Don't wait on a busy inbox on the first pass
+		if(blocking)
+			victim->inboxMutex.lock();
+		else if(!victim->inboxMutex.trylock())
+			continue;
+		if(!victim->inbox[priority].empty())
+		{
+			ret=victim->inbox[priority].front();
+			victim->inbox[priority].pop_front();
+		}
+		victim->inboxMutex.unlock();
+		if(ret)
+			return ret;
+	}
+	return nullptr;
+}
+
+IThreadJob* ThreadPool::takeJob(Worker* self)
+{
+	/*
+	 * Jobs are counted in pendingJobs after they are queued and every
+	 * worker takes one job for each one it claims, so the queues hold at
+	 * least a job for every worker in here. A pass that doesn't skip
+	 * anything always finds one.
+	 */
+	for(uint32_t pass=0;pass<2;pass++)
+	{
+		for(uint32_t p=0;p<THREAD_JOB_PRIORITY_COUNT;p++)
+		{
+			IThreadJob* ret=tryTakeJob(self,p,pass==1);
+			if(ret)
+				return ret;
+		}
+	}
+	return nullptr;
 }
 
 int ThreadPool::job_worker(void *d)
 {
-	ThreadPoolData* data = (ThreadPoolData*)d;
-	setTLSSys(data->pool->m_sys);
+	Worker* self = (Worker*)d;
+	ThreadPool* pool = self->pool;
+	setTLSSys(pool->m_sys);
+	tls_set(current_worker,self);
 
-	ThreadProfile* profile=data->pool->m_sys->allocateProfiler(RGB(200,200,0));
+	ThreadProfile* profile=pool->m_sys->allocateProfiler(RGB(200,200,0));
 	char buf[16];
-	snprintf(buf,16,"Thread %u",data->index);
+	snprintf(buf,16,"Thread %u",self->index);
 	profile->setTag(buf);
 
 	Chronometer chronometer;
 	while(1)
 	{
-		data->pool->num_jobs.wait();
-		if(data->pool->stopFlag)
+		pool->queueMutex.lock();
+		while(pool->pendingJobs==0 && !pool->stopFlag)
+			pool->jobsCond.wait(pool->queueMutex);
+		if(pool->stopFlag)
+		{
+			pool->queueMutex.unlock();
 			return 0;
-		Locker l(data->pool->mutex);
-		IThreadJob* myJob=data->pool->jobs.front();
-		data->pool->jobs.pop_front();
-		data->pool->curJobs[data->index]=myJob;
-		l.release();
+		}
+		pool->pendingJobs--;
+		pool->idleWorkers--;
+		pool->queueMutex.unlock();
+		IThreadJob* myJob=pool->takeJob(self);
+		if(!myJob)
+		{
+			LOG(LOG_ERROR,"ThreadPool: claimed job not found");
+			//Give the claim back, the job must still be queued somewhere
+			pool->queueMutex.lock();
+			pool->pendingJobs++;
+			pool->idleWorkers++;
+			pool->jobsCond.signal();
+			pool->queueMutex.unlock();
+			continue;
+		}
+		self->curJobMutex.lock();
+		self->curJob=myJob;
+		self->curJobMutex.unlock();
 
 		chronometer.checkpoint();
 		try
 		{
 			// it's possible that a job was added and will be executed while forcestop() has been called
-			if(data->pool->stopFlag)
+			if(pool->stopFlag)
+			{
+				self->curJobMutex.lock();
+				self->curJob=nullptr;
+				self->curJobMutex.unlock();
+				myJob->jobFence();
 				return 0;
+			}
 			myJob->execute();
 		}
 		catch(JobTerminationException& ex)
@@ -114,36 +314,56 @@ int ThreadPool::job_worker(void *d)
 		catch(LightsparkException& e)
 		{
 			LOG(LOG_ERROR,_("Exception in ThreadPool ") << e.what());
-			data->pool->m_sys->setError(e.cause);
+			pool->m_sys->setError(e.cause);
 		}
 		catch(std::exception& e)
 		{
 			LOG(LOG_ERROR,"std Exception in ThreadPool:"<<myJob<<" "<<e.what());
-			data->pool->m_sys->setError(e.what());
+			pool->m_sys->setError(e.what());
 		}
 		
 		profile->accountTime(chronometer.checkpoint());
 
-		l.acquire();
-		data->pool->curJobs[data->index]=nullptr;
-		l.release();
+		self->curJobMutex.lock();
+		self->curJob=nullptr;
+		self->curJobMutex.unlock();
 
 		//jobFencing is allowed to happen outside the mutex
 		myJob->jobFence();
+
+		pool->queueMutex.lock();
+		pool->idleWorkers++;
+		pool->queueMutex.unlock();
 	}
 	return 0;
 }
 
 void ThreadPool::addJob(IThreadJob* j)
 {
-	Locker l(mutex);
+	assert(j);
 	if(stopFlag)
 	{
 		j->jobFence();
 		return;
 	}
-	assert(j);
-	jobs.push_back(j);
-	num_jobs.signal();
+	uint32_t priority=j->jobPriority;
+	Worker* self=(Worker*)tls_get(current_worker);
+	//Jobs spawned by our own workers go to the lock-free local deque
+	if(!self || self->pool!=this || !self->deque[priority].push(j))
+	{
+		uint32_t n=numWorkers.load(std::memory_order_acquire);
+		Worker* w=workers[nextInbox.fetch_add(1,std::memory_order_relaxed)%n];
+		w->inboxMutex.lock();
+		w->inbox[priority].push_back(j);
+		w->inboxMutex.unlock();
+	}
+	queueMutex.lock();
+	pendingJobs++;
+	//Each idle worker claims one job, spawn a new one if the others are
+	//busy, they may be blocked by long running jobs or wait for this one
+	bool spawn=pendingJobs>idleWorkers && numWorkers.load(std::memory_order_relaxed)<MAX_THREADS;
+	jobsCond.signal();
+	queueMutex.unlock();
+	if(spawn)
+		spawnWorker();
 }
-
@@ -28,27 +28,81 @@
 namespace lightspark
 {
 
-#define NUM_THREADS 20
+// The pool starts with one worker per CPU (but at least MIN_THREADS) and
+// grows up to MAX_THREADS when all workers are busy, as many jobs
+// (sound streams, loaders) block for a long time
+#define MIN_THREADS 4
+#define MAX_THREADS 64
+// Capacity of the per worker lock-free deques, must be a power of 2
+#define WORKER_DEQUE_SIZE 256
 
 class SystemState;
 
+/*
+ * Fixed size Chase-Lev work stealing deque.
+ * push() and pop() may only be called by the owning worker, steal() may
+ * be called concurrently by any thread.
+ */
+class WorkStealingDeque
+{
+private:
+	std::atomic<int64_t> top;
+	std::atomic<int64_t> bottom;
+	std::atomic<IThreadJob*> buffer[WORKER_DEQUE_SIZE];
+public:
+	WorkStealingDeque();
+	// Returns false if the deque is full
+	bool push(IThreadJob* j);
+	IThreadJob* pop();
+	IThreadJob* steal();
+	bool empty() const;
+};
+
 class ThreadPool
 {
 private:
-	struct ThreadPoolData
+	struct Worker
 	{
 		ThreadPool* pool;
-		int index;
+		uint32_t index;
+		SDL_Thread* thread;
+		// Jobs added by the job running on this worker
+		WorkStealingDeque deque[THREAD_JOB_PRIORITY_COUNT];
+		// Jobs added from threads outside the pool
+		Mutex inboxMutex;
+		std::deque<IThreadJob*> inbox[THREAD_JOB_PRIORITY_COUNT];
+		// Protects curJob against concurrent aborts from forceStop
+		Mutex curJobMutex;
+		IThreadJob* curJob;
+		Worker(ThreadPool* p, uint32_t i):pool(p),index(i),thread(nullptr),curJob(nullptr){}
 	};
-	Mutex mutex;
-	SDL_Thread* threads[NUM_THREADS];
-	ThreadPoolData data[NUM_THREADS];
-	IThreadJob* volatile curJobs[NUM_THREADS];
-	std::deque<IThreadJob*> jobs;
-	Semaphore num_jobs;
+	Worker* workers[MAX_THREADS];
+	// Number of workers that have been published in workers
+	std::atomic<uint32_t> numWorkers;
+	// Used to distribute external jobs over the workers inboxes
+	std::atomic<uint32_t> nextInbox;
+	// Only taken when spawning workers and stopping
+	Mutex workersMutex;
+	// Protects pendingJobs and idleWorkers, idle workers wait on jobsCond
+	Mutex queueMutex;
+	Cond jobsCond;
+	// Jobs that have been queued but not yet claimed by any worker
+	uint32_t pendingJobs;
+	// Workers not running a job, each of them will claim one of pendingJobs
+	uint32_t idleWorkers;
 	static int job_worker(void* d);
 	SystemState* m_sys;
 	volatile bool stopFlag;
+	void spawnWorker();
+	/*
+	 * Scan the local deque, the inboxes and the other workers deques
+	 * for the highest priority job. Must only be called after one of
+	 * pendingJobs has been claimed, so there is at least one job to find.
+	 */
+	IThreadJob* takeJob(Worker* self);
+	// If blocking is false busy inboxes are skipped and steals may fail spuriously
+	IThreadJob* tryTakeJob(Worker* self, uint32_t priority, bool blocking);
+	void fenceQueuedJobs();
 public:
 	ThreadPool(SystemState* s);
 	~ThreadPool();
@@ -64,7 +64,7 @@ void Semaphore::signal()
 CondTime::CondTime(long milliseconds)
 {
 	// round to full milliseconds
-	timepoint=((g_get_monotonic_time()+G_TIME_SPAN_MILLISECOND/2)/G_TIME_SPAN_MILLISECOND+milliseconds)*G_TIME_SPAN_MILLISECOND;
+	timepoint=((compat_usectiming()+G_TIME_SPAN_MILLISECOND/2)/G_TIME_SPAN_MILLISECOND+milliseconds)*G_TIME_SPAN_MILLISECOND;
 }
 
 bool CondTime::operator<(CondTime& c) const
@@ -79,7 +79,7 @@ bool CondTime::operator>(CondTime& c) const
 
 bool CondTime::isInTheFuture() const
 {
-	gint64 now=g_get_monotonic_time();
+	gint64 now=compat_usectiming();
 	return timepoint>now;
 }
 
@@ -87,13 +87,19 @@ void CondTime::addMilliseconds(long ms)
 {
 	timepoint+=(gint64)ms*G_TIME_SPAN_MILLISECOND;
 	// don't allow that next timepoint will be in the past
-	gint64 now=g_get_monotonic_time();
+	gint64 now=compat_usectiming();
 	if (timepoint < now)
 		timepoint= now + (gint64)ms*G_TIME_SPAN_MILLISECOND;
 }
 
 bool CondTime::wait(Mutex& mutex, Cond& cond)
 {
-	gint64 now=g_get_monotonic_time();
+	//The simulated clock does not need to wait, it just jumps to the timepoint
+	if(compat_virtual_clock_enabled())
+	{
+		compat_advance_virtual_clock(timepoint);
+		return false;
+	}
+	gint64 now=compat_usectiming();
 	return cond.wait_until(mutex, (timepoint > now ? (timepoint-now)/G_TIME_SPAN_MILLISECOND : 0));
 }
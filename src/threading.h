@@ -144,6 +144,13 @@ public:
 	}
 };
 
+/*
+ * Scheduling class of an IThreadJob. The ThreadPool always prefers
+ * queued jobs of a higher priority, so short latency sensitive jobs
+ * (like rasterization) are not stuck behind slow downloads.
+ */
+enum THREAD_JOB_PRIORITY { THREAD_JOB_PRIORITY_HIGH=0, THREAD_JOB_PRIORITY_NORMAL, THREAD_JOB_PRIORITY_LOW, THREAD_JOB_PRIORITY_COUNT };
+
 class IThreadJob
 {
 friend class ThreadPool;
@@ -154,6 +161,11 @@ public:
 	 * to poll threadAborted and not implement threadAbort().
 	 */
 	volatile bool threadAborting;
+	/*
+	 * The priority used by the ThreadPool to pick this job. It must
+	 * not be changed after the job has been added to the pool.
+	 */
+	THREAD_JOB_PRIORITY jobPriority;
 	/*
 	 * Called in a dedicated thread to do the actual
 	 * work. You may throw a JobTerminationException
@@ -177,7 +189,7 @@ public:
 	 * 'delete this'.
 	 */
 	virtual void jobFence()=0;
-	IThreadJob() : threadAborting(false) {}
+	IThreadJob() : threadAborting(false),jobPriority(THREAD_JOB_PRIORITY_NORMAL) {}
 	virtual ~IThreadJob() {}
 };
 
@@ -37,6 +37,7 @@ int main(int argc, char* argv[])
 	std::vector<char*> fileNames;
 	bool useInterpreter=true;
 	bool useJit=false;
+	bool useTieredJit=false;
 	LOG_LEVEL log_level=LOG_INFO;
 	bool error=false;
 
@@ -52,6 +53,12 @@ int main(int argc, char* argv[])
 		{
 			useJit=true;
 		}
+		else if(strcmp(argv[i],"-tj")==0 || 
+			strcmp(argv[i],"--enable-tiered-jit")==0)
+		{
+			useJit=true;
+			useTieredJit=true;
+		}
 		else if(strcmp(argv[i],"-l")==0 || 
 			strcmp(argv[i],"--log-level")==0)
 		{
@@ -73,7 +80,7 @@ int main(int argc, char* argv[])
 
 	if(fileNames.empty() || error)
 	{
-		LOG(LOG_ERROR, "Usage: " << argv[0] << " [--disable-interpreter|-ni] [--enable-jit|-j] [--log-level|-l 0-4] <file.abc> [<file2.abc>]");
+		LOG(LOG_ERROR, "Usage: " << argv[0] << " [--disable-interpreter|-ni] [--enable-jit|-j] [--enable-tiered-jit|-tj] [--log-level|-l 0-4] <file.abc> [<file2.abc>]");
 		exit(-1);
 	}
 #ifdef HAVE_G_THREAD_INIT
@@ -94,6 +101,7 @@ int main(int argc, char* argv[])
 	}
 	sys->useInterpreter=useInterpreter;
 	sys->useJit=useJit;
+	sys->useTieredJit=useTieredJit;
 
 	sys->mainClip->setOrigin(string("file://") + fileNames[0]);
 
@@ -27,7 +27,7 @@
 using namespace lightspark;
 using namespace std;
 
-TimerThread::TimerThread(SystemState* s):m_sys(s),stopped(false),joined(false)
+TimerThread::TimerThread(SystemState* s):nextSeq(0),m_sys(s),stopped(false),joined(false)
 {
 	t = SDL_CreateThread(&TimerThread::worker,"TimerThread",this);
 }
@@ -54,33 +54,75 @@ void TimerThread::wait()
 TimerThread::~TimerThread()
 {
 	stop();
-	list<TimingEvent*>::iterator it=pendingEvents.begin();
+	vector<TimingEvent*>::iterator it=pendingEvents.begin();
 	for(;it!=pendingEvents.end();++it)
 		delete *it;
 }
 
-void TimerThread::insertNewEvent_nolock(TimingEvent* e)
+bool TimerThread::eventBefore(TimingEvent* a, TimingEvent* b) const
+{
+	if(a->wakeUpTime < b->wakeUpTime)
+		return true;
+	if(a->wakeUpTime > b->wakeUpTime)
+		return false;
+	return a->seq < b->seq;
+}
+
+void TimerThread::heapSet(uint32_t index, TimingEvent* e)
 {
-	list<TimingEvent*>::iterator it=pendingEvents.begin();
-	//If there are no events pending, or this is earlier than the first, signal newEvent
-	if(pendingEvents.empty() || (*it)->wakeUpTime > e->wakeUpTime)
+	pendingEvents[index]=e;
+	e->heapIndex=index;
+}
+
+void TimerThread::heapSiftUp(uint32_t index)
+{
+	TimingEvent* e=pendingEvents[index];
+	while(index>0)
 	{
-		pendingEvents.insert(it, e);
-		newEvent.signal();
-		return;
+		uint32_t parent=(index-1)/TIMER_HEAP_ARITY;
+		if(!eventBefore(e,pendingEvents[parent]))
+			break;
+		heapSet(index,pendingEvents[parent]);
+		index=parent;
 	}
-	++it;
+	heapSet(index,e);
+}
 
-	for(;it!=pendingEvents.end();++it)
+void TimerThread::heapSiftDown(uint32_t index)
+{
+	TimingEvent* e=pendingEvents[index];
+	uint32_t size=pendingEvents.size();
+	while(1)
 	{
-		if((*it)->wakeUpTime > e->wakeUpTime)
+		uint32_t first=index*TIMER_HEAP_ARITY+1;
+		if(first>=size)
+			break;
+		uint32_t last=first+TIMER_HEAP_ARITY;
+		if(last>size)
+			last=size;
+		uint32_t smallest=first;
+		for(uint32_t i=first+1;i<last;i++)
 		{
-			pendingEvents.insert(it, e);
-			return;
+			if(eventBefore(pendingEvents[i],pendingEvents[smallest]))
+				smallest=i;
 		}
+		if(!eventBefore(pendingEvents[smallest],e))
+			break;
+		heapSet(index,pendingEvents[smallest]);
+		index=smallest;
 	}
-	//Event has to be inserted after all the others
-	pendingEvents.insert(pendingEvents.end(), e);
+	heapSet(index,e);
+}
+
+void TimerThread::insertNewEvent_nolock(TimingEvent* e)
+{
+	e->seq=nextSeq++;
+	pendingEvents.push_back(e);
+	heapSiftUp(pendingEvents.size()-1);
+	jobEvents.insert(make_pair(e->job,e));
+	//If this is earlier than the first, signal newEvent
+	if(pendingEvents.front()==e)
+		newEvent.signal();
 }
 
 void TimerThread::insertNewEvent(TimingEvent* e)
@@ -89,11 +131,36 @@ void TimerThread::insertNewEvent(TimingEvent* e)
 	insertNewEvent_nolock(e);
 }
 
+void TimerThread::removeEvent_nolock(TimingEvent* e)
+{
+	auto range=jobEvents.equal_range(e->job);
+	for(auto it=range.first;it!=range.second;++it)
+	{
+		if(it->second==e)
+		{
+			jobEvents.erase(it);
+			break;
+		}
+	}
+
+	uint32_t index=e->heapIndex;
+	assert(pendingEvents[index]==e);
+	TimingEvent* last=pendingEvents.back();
+	pendingEvents.pop_back();
+	if(last==e)
+		return;
+	//Move the last event into the hole and restore the heap property
+	heapSet(index,last);
+	if(index>0 && eventBefore(last,pendingEvents[(index-1)/TIMER_HEAP_ARITY]))
+		heapSiftUp(index);
+	else
+		heapSiftDown(index);
+}
+
 //Unsafe debugging routine
 void TimerThread::dumpJobs()
 {
-	list<TimingEvent*>::iterator it=pendingEvents.begin();
-	//Find if the job is in the list
+	vector<TimingEvent*>::iterator it=pendingEvents.begin();
 	for(;it!=pendingEvents.end();++it)
 		LOG(LOG_INFO, (*it)->job );
 }
@@ -106,6 +173,8 @@ void TimerThread::dumpJobs()
  *   2. while executing e->job->tick() (during this time inExectution == e->job)
  * The pendingEvents queue may be altered by another thread with "mutex"
  * An event may be deleted by another thread with "mutex" only if inExectution != jobToDelete
+ * All the events that are due when the worker wakes up are executed
+ * in a single batch, without waiting on newEvent in between.
  */
 int TimerThread::worker(void *d)
 {
@@ -123,6 +192,19 @@ int TimerThread::worker(void *d)
 				return 0;
 		}
 
+		/* The simulated clock jumps to the next event, the events queued
+		 * by the previous jobs have to be handled before time moves */
+		if(compat_virtual_clock_enabled() && th->pendingEvents.front()->wakeUpTime.isInTheFuture())
+		{
+			l.release();
+			th->m_sys->waitForVmIdle();
+			l.acquire();
+			if(th->stopped)
+				return 0;
+			if(th->pendingEvents.empty())
+				continue;
+		}
+
 		/* Get expiration of first event */
 		CondTime timing=th->pendingEvents.front()->wakeUpTime;
 		/* Wait for the absolute time or a newEvent signal
@@ -133,50 +215,53 @@ int TimerThread::worker(void *d)
 		if(th->stopped)
 			return 0;
 
-		if(th->pendingEvents.empty())
-			continue;
-
-		TimingEvent* e=th->pendingEvents.front();
-
+		/* Events re-enqueued during this batch run in the next one */
+		uint64_t batchEnd=th->nextSeq;
 		/* check if the top event is due now. It could be have been removed/inserted
 		 * while we slept */
-		if(e->wakeUpTime.isInTheFuture())
-			continue;
-
-		th->pendingEvents.pop_front();
-
-		if(e->job->stopMe)
+		while(!th->pendingEvents.empty() && !th->pendingEvents.front()->wakeUpTime.isInTheFuture())
 		{
-			e->job->tickFence();
-			delete e;
-			continue;
-		}
-
-		if(e->isTick)
-		{
-			/* re-enqueue*/
-			e->wakeUpTime.addMilliseconds(e->tickTime);
-			th->insertNewEvent_nolock(e);
-		}
+			TimingEvent* e=th->pendingEvents.front();
+			if(e->seq>=batchEnd)
+				break;
+			th->removeEvent_nolock(e);
+
+			if(e->job->stopMe)
+			{
+				e->job->tickFence();
+				delete e;
+				continue;
+			}
+
+			if(e->isTick)
+			{
+				/* re-enqueue*/
+				e->wakeUpTime.addMilliseconds(e->tickTime);
+				th->insertNewEvent_nolock(e);
+			}
+
+			/* If e->isTick == false, e is not in pendingQueue anymore and this function has the only reference to it.
+			 * If e->isTick == true, we just enqueued e another time. If removeJob() is called on e->job from
+			 * job->tick() or another thread, then this will remove e from pendingQueue and delete e after we release the mutex.
+			 * In that case we may not access e after 'l.release()'.
+			 */
+			ITickJob* job = e->job;
+			bool isTick = e->isTick;
+			l.release();
+
+			job->tick();
+
+			l.acquire();
+
+			/* Cleanup */
+			if(!isTick)
+			{
+				e->job->tickFence();
+				delete e;
+			}
 
-		/* If e->isTick == false, e is not in pendingQueue anymore and this function has the only reference to it.
-		 * If e->isTick == true, we just enqueued e another time. If removeJob() is called on e->job from
-		 * job->tick() or another thread, then this will remove e from pendingQueue and delete e after we release the mutex.
-		 * In that case we may not access e after 'l.release()'.
-		 */
-		ITickJob* job = e->job;
-		bool isTick = e->isTick;
-		l.release();
-
-		job->tick();
-
-		l.acquire();
-
-		/* Cleanup */
-		if(!isTick)
-		{
-			e->job->tickFence();
-			delete e;
+			if(th->stopped)
+				return 0;
 		}
 	}
 	return 0;
@@ -203,22 +288,19 @@ void TimerThread::removeJob(ITickJob* job)
 {
 	Locker l(mutex);
 
-	/* See if that job is currently pending */
-	list<TimingEvent*>::iterator it=pendingEvents.begin();
-	bool first=true;
-	//Find if the job is in the list
-	for(;it!=pendingEvents.end();++it)
-	{
-		if((*it)->job==job)
-			break;
-		first=false;
-	}
-
-	if(it==pendingEvents.end())
+	/* See if that job is currently pending, remove its earliest event like the sorted list did */
+	auto range=jobEvents.equal_range(job);
+	if(range.first==range.second)
 		return;
 
-	TimingEvent* e=*it;
-	pendingEvents.erase(it);
+	TimingEvent* e=range.first->second;
+	for(auto it=std::next(range.first);it!=range.second;++it)
+	{
+		if(eventBefore(it->second,e))
+			e=it->second;
+	}
+	bool first=(e->heapIndex==0);
+	removeEvent_nolock(e);
 	delete e;
 
 	/* the worker is waiting on this job, wake him up */
@@ -21,7 +21,8 @@
 #define TIMER_H 1
 
 #include "compat.h"
-#include <list>
+#include <vector>
+#include <unordered_map>
 #include <ctime>
 #include "threading.h"
 
@@ -49,29 +50,49 @@ public:
 	virtual void tickFence() = 0;
 };
 
-class TimerThread
+//Arity of the heap of pending events
+#define TIMER_HEAP_ARITY 4
+
+class DLL_PUBLIC TimerThread
 {
 private:
 	class TimingEvent
 	{
 	public:
 		TimingEvent(ITickJob* _job, bool _isTick, uint32_t _tickTime, uint32_t _waitTime) 
-			: job(_job),wakeUpTime(_isTick ? _tickTime : _waitTime),tickTime(_tickTime),isTick(_isTick) {}
+			: job(_job),wakeUpTime(_isTick ? _tickTime : _waitTime),tickTime(_tickTime),isTick(_isTick),heapIndex(0),seq(0) {}
 		ITickJob* job;
 		CondTime wakeUpTime;
 		uint32_t tickTime;
 		bool isTick;
+		//Position in pendingEvents, used as handle to remove the event
+		uint32_t heapIndex;
+		//Insertion order, keeps events due at the same time in FIFO order
+		uint64_t seq;
 	};
 	Mutex mutex;
 	Cond newEvent;
 	SDL_Thread* t;
-	std::list<TimingEvent*> pendingEvents;
+	/*
+	 * d-ary min heap of the pending events ordered by wakeUpTime,
+	 * giving O(log n) insertion and removal
+	 */
+	std::vector<TimingEvent*> pendingEvents;
+	//Maps each job to its pending events to make removeJob O(1) to find
+	std::unordered_multimap<ITickJob*, TimingEvent*> jobEvents;
+	uint64_t nextSeq;
 	SystemState* m_sys;
 	volatile bool stopped;
 	bool joined;
 	static int worker(void* d);
 	void insertNewEvent(TimingEvent* e);
 	void insertNewEvent_nolock(TimingEvent* e);
+	bool eventBefore(TimingEvent* a, TimingEvent* b) const;
+	void heapSet(uint32_t index, TimingEvent* e);
+	void heapSiftUp(uint32_t index);
+	void heapSiftDown(uint32_t index);
+	//Removes the event from pendingEvents and jobEvents, does not delete it
+	void removeEvent_nolock(TimingEvent* e);
 	void dumpJobs();
 public:
 	TimerThread(SystemState* s);
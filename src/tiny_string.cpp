@@ -45,7 +45,7 @@ tiny_string::tiny_string(const char* s,bool copy):_buf_static(),buf(_buf_static)
 }
 
 tiny_string::tiny_string(const tiny_string& r):
-	_buf_static(),buf(_buf_static),stringSize(r.stringSize),numchars(r.numchars),type(STATIC),isASCII(r.isASCII),hasNull(r.hasNull)
+	_buf_static(),buf(_buf_static),stringSize(r.stringSize),numchars(r.numchars),hashValue(r.hashValue),type(STATIC),isASCII(r.isASCII),hasNull(r.hasNull)
 {
 	//Fast path for static read-only strings
 	if(r.type==READONLY)
@@ -54,8 +54,14 @@ tiny_string::tiny_string(const tiny_string& r):
 		buf=r.buf;
 		return;
 	}
-	if(stringSize > STATIC_SIZE)
-		createBuffer(stringSize);
+	//Dynamic buffers are shared
+	if(r.type==DYNAMIC)
+	{
+		type=DYNAMIC;
+		buf=r.buf;
+		++getBuffer()->refs;
+		return;
+	}
 	memcpy(buf,r.buf,stringSize);
 }
 
@@ -74,6 +80,8 @@ tiny_string::~tiny_string()
 
 tiny_string& tiny_string::operator=(const tiny_string& s)
 {
+	if(this==&s)
+		return *this;
 	resetToStatic();
 	stringSize=s.stringSize;
 	//Fast path for static read-only strings
@@ -82,15 +90,18 @@ tiny_string& tiny_string::operator=(const tiny_string& s)
 		type=READONLY;
 		buf=s.buf;
 	}
-	else
+	else if(s.type==DYNAMIC)
 	{
-		if(stringSize > STATIC_SIZE)
-			createBuffer(stringSize);
-		memcpy(buf,s.buf,stringSize);
+		type=DYNAMIC;
+		buf=s.buf;
+		++getBuffer()->refs;
 	}
+	else
+		memcpy(buf,s.buf,stringSize);
 	this->isASCII = s.isASCII;
 	this->hasNull = s.hasNull;
 	this->numchars = s.numchars;
+	this->hashValue = s.hashValue;
 	return *this;
 }
 
@@ -114,52 +125,18 @@ tiny_string& tiny_string::operator=(const char* s)
 
 tiny_string& tiny_string::operator+=(const char* s)
 {	//deprecated, cannot handle '\0' inside string
-	if(type==READONLY)
-	{
-		char* tmp=buf;
-		makePrivateCopy(tmp);
-	}
-	uint32_t addedLen=strlen(s);
-	uint32_t newStringSize=stringSize + addedLen;
-	if(type==STATIC && newStringSize > STATIC_SIZE)
-	{
-		createBuffer(newStringSize);
-		//don't copy trailing \0
-		memcpy(buf,_buf_static,stringSize-1);
-	}
-	else if(type==DYNAMIC && addedLen!=0)
-		resizeBuffer(newStringSize);
-	//also copy \0 at the end
-	memcpy(buf+stringSize-1,s,addedLen+1);
-	stringSize=newStringSize;
-	init();
-	return *this;
+	return *this += tiny_string(s);
 }
 
 tiny_string& tiny_string::operator+=(const tiny_string& r)
 {
-	if(type==READONLY)
-	{
-		char* tmp=buf;
-		makePrivateCopy(tmp);
-	}
-	uint32_t newStringSize=stringSize + r.stringSize-1;
-	if(type==STATIC && newStringSize > STATIC_SIZE)
-	{
-		createBuffer(newStringSize);
-		//don't copy trailing \0
-		memcpy(buf,_buf_static,stringSize-1);
-	}
-	else if(type==DYNAMIC && r.stringSize>1)
-		resizeBuffer(newStringSize);
-	//start position is where the \0 was
-	memcpy(buf+stringSize-1,r.buf,r.stringSize);
-	stringSize=newStringSize;
+	appendBytes(r.buf,r.numBytes());
 	if (this->isASCII)
 		this->isASCII = r.isASCII;
 	if (!this->hasNull)
 		this->hasNull = r.hasNull;
 	this->numchars += r.numchars;
+	this->hashValue = 0;
 	return *this;
 }
 
@@ -291,12 +268,12 @@ bool tiny_string::endsWith(const char* o) const
 uint32_t tiny_string::find(const tiny_string& needle, uint32_t start) const
 {
 	//TODO: omit copy into std::string
-	size_t bytestart = g_utf8_offset_to_pointer(buf,start) - buf;
+	size_t bytestart = charToByte(start);
 	size_t bytepos = std::string(*this).find(needle.raw_buf(),bytestart,needle.numBytes());
 	if(bytepos == std::string::npos)
 		return npos;
 	else
-		return g_utf8_pointer_to_offset(buf,buf+bytepos);
+		return byteToChar(bytepos);
 }
 
 uint32_t tiny_string::rfind(const tiny_string& needle, uint32_t start) const
@@ -306,13 +283,13 @@ uint32_t tiny_string::rfind(const tiny_string& needle, uint32_t start) const
 	if(start == npos)
 		bytestart = std::string::npos;
 	else
-		bytestart = g_utf8_offset_to_pointer(buf,start) - buf;
+		bytestart = charToByte(start);
 
 	size_t bytepos = std::string(*this).rfind(needle.raw_buf(),bytestart,needle.numBytes());
 	if(bytepos == std::string::npos)
 		return npos;
 	else
-		return g_utf8_pointer_to_offset(buf,buf+bytepos);
+		return byteToChar(bytepos);
 }
 
 void tiny_string::makePrivateCopy(const char* s)
@@ -324,39 +301,190 @@ void tiny_string::makePrivateCopy(const char* s)
 	strcpy(buf,s);
 }
 
+char* tiny_string::allocateBuffer(uint32_t capacity) const
+{
+	reportMemoryChange(capacity);
+	char* mem=new char[sizeof(dynamic_buffer)+capacity];
+	dynamic_buffer* b=new (mem) dynamic_buffer;
+	b->refs=1;
+	b->capacity=capacity;
+	b->index=NULL;
+	return mem+sizeof(dynamic_buffer);
+}
+
+void tiny_string::releaseBuffer(char* bytes) const
+{
+	dynamic_buffer* b=reinterpret_cast<dynamic_buffer*>(bytes-sizeof(dynamic_buffer));
+	if(--b->refs==0)
+	{
+		reportMemoryChange(-b->capacity);
+		char_index* index=b->index;
+		if(index)
+		{
+			reportMemoryChange(-index->size*sizeof(uint32_t));
+			delete index;
+		}
+		b->~dynamic_buffer();
+		delete[] reinterpret_cast<char*>(b);
+	}
+}
+
 void tiny_string::createBuffer(uint32_t s)
 {
 	type=DYNAMIC;
-	reportMemoryChange(s);
-	buf=new char[s];
+	buf=allocateBuffer(s);
+}
+
+void tiny_string::appendBytes(const char* s, uint32_t len)
+{
+	if(len==0)
+		return;
+	uint32_t oldLen=stringSize-1;
+	uint32_t newStringSize=stringSize+len;
+	bool inPlace=false;
+	if(type==STATIC)
+		inPlace=(newStringSize <= STATIC_SIZE);
+	else if(type==DYNAMIC)
+	{
+		//Other strings may be reading a shared buffer from other threads
+		inPlace=(getBuffer()->refs==1 && newStringSize <= getBuffer()->capacity);
+	}
+	if(inPlace)
+	{
+		//s may be inside this string, it is not overwritten
+		memcpy(buf+oldLen,s,len);
+	}
+	else
+	{
+		//Leave room to append more without copying again
+		char* newBuf=allocateBuffer(std::max(newStringSize,2*stringSize));
+		memcpy(newBuf,buf,oldLen);
+		memcpy(newBuf+oldLen,s,len);
+		if(type==DYNAMIC)
+			releaseBuffer(buf);
+		buf=newBuf;
+		type=DYNAMIC;
+	}
+	buf[oldLen+len]='\0';
+	stringSize=newStringSize;
 }
 
-void tiny_string::resizeBuffer(uint32_t s)
+void tiny_string::compact()
 {
-	assert(type==DYNAMIC);
+	if(type!=DYNAMIC)
+		return;
+	if(getBuffer()->capacity==stringSize)
+		return;
 	char* oldBuf=buf;
-	reportMemoryChange(s-stringSize);
-	buf=new char[s];
-	assert(s >= stringSize);
-	memcpy(buf,oldBuf,stringSize);
-	delete[] oldBuf;
+	buf=allocateBuffer(stringSize);
+	memcpy(buf,oldBuf,stringSize-1);
+	buf[stringSize-1]='\0';
+	releaseBuffer(oldBuf);
 }
 
-void tiny_string::resetToStatic()
+tiny_string::char_index* tiny_string::getCharIndex() const
 {
-	if(type==DYNAMIC)
+	if(type!=DYNAMIC || isASCII || numchars<UTF8_INDEX_MIN_CHARS)
+		return NULL;
+	dynamic_buffer* b=getBuffer();
+	char_index* index=b->index.load(std::memory_order_acquire);
+	if(index==NULL)
+	{
+		//Every character is at least a byte, so the capacity bounds the offsets of all the strings in the buffer
+		char_index* newIndex=new char_index((b->capacity-1)/UTF8_INDEX_STRIDE+1);
+		newIndex->offsets[0].store(0,std::memory_order_relaxed);
+		newIndex->entries.store(1,std::memory_order_relaxed);
+		if(b->index.compare_exchange_strong(index,newIndex,std::memory_order_acq_rel))
+		{
+			reportMemoryChange(newIndex->size*sizeof(uint32_t));
+			index=newIndex;
+		}
+		else
+			delete newIndex;
+	}
+	//Offsets are needed up to the end of the string, for the end of substrings
+	const uint32_t needed=numchars/UTF8_INDEX_STRIDE+1;
+	uint32_t entries=index->entries.load(std::memory_order_acquire);
+	if(entries<needed)
+	{
+		const char* end=buf+numBytes();
+		const char* p=buf+index->offsets[entries-1].load(std::memory_order_relaxed);
+		for(uint32_t i=entries;i<needed;i++)
+		{
+			for(uint32_t j=0;j<UTF8_INDEX_STRIDE;j++)
+				p=g_utf8_next_char(p);
+			//Don't run past the end on invalid UTF-8
+			if(p>end)
+				p=end;
+			index->offsets[i].store(p-buf,std::memory_order_relaxed);
+		}
+		while(entries<needed && !index->entries.compare_exchange_weak(entries,needed,std::memory_order_release,std::memory_order_relaxed));
+	}
+	return index;
+}
+
+uint32_t tiny_string::charToByte(uint32_t idx) const
+{
+	if(isASCII)
+		return idx;
+	const char_index* index=getCharIndex();
+	if(index==NULL || idx>numchars)
+		return g_utf8_offset_to_pointer(buf,idx)-buf;
+	const uint32_t entry=idx/UTF8_INDEX_STRIDE;
+	const char* p=buf+index->offsets[entry].load(std::memory_order_relaxed);
+	for(uint32_t i=entry*UTF8_INDEX_STRIDE;i<idx;i++)
+		p=g_utf8_next_char(p);
+	return p-buf;
+}
+
+uint32_t tiny_string::byteToChar(uint32_t bytepos) const
+{
+	if(isASCII)
+		return bytepos;
+	const char_index* index=getCharIndex();
+	if(index==NULL)
+		return g_utf8_pointer_to_offset(buf,buf+bytepos);
+	//Last offset not after bytepos, offsets[0] is always 0
+	uint32_t low=0;
+	uint32_t high=numchars/UTF8_INDEX_STRIDE;
+	while(low<high)
 	{
-		reportMemoryChange(-stringSize);
-		delete[] buf;
+		uint32_t mid=(low+high+1)/2;
+		if(index->offsets[mid].load(std::memory_order_relaxed)<=bytepos)
+			low=mid;
+		else
+			high=mid-1;
 	}
+	return low*UTF8_INDEX_STRIDE+g_utf8_pointer_to_offset(buf+index->offsets[low].load(std::memory_order_relaxed),buf+bytepos);
+}
+
+void tiny_string::resetToStatic()
+{
+	if(type==DYNAMIC)
+		releaseBuffer(buf);
 	stringSize=1;
 	_buf_static[0] = '\0';
 	buf=_buf_static;
 	type=STATIC;
+	hashValue=0;
+}
+
+void tiny_string::computeHash() const
+{
+	//32 bit FNV-1a, strings may contain \0 so we can't use g_str_hash
+	uint32_t h=2166136261u;
+	for (uint32_t i = 0; i < stringSize-1; i++)
+	{
+		h ^= (unsigned char)buf[i];
+		h *= 16777619u;
+	}
+	//0 marks a hash that was not computed yet
+	hashValue = h ? h : 1;
 }
 
 void tiny_string::init()
 {
+	hashValue = 0;
 	numchars = 0;
 	isASCII = true;
 	hasNull = false;
@@ -412,8 +540,8 @@ tiny_string& tiny_string::replace(uint32_t pos1, uint32_t n1, const tiny_string&
 		n1 = numChars()-pos1;
 	if (isASCII)
 		return replace_bytes(pos1, n1, o);
-	uint32_t bytestart = g_utf8_offset_to_pointer(buf,pos1)-buf;
-	uint32_t byteend = g_utf8_offset_to_pointer(buf,pos1+n1)-buf;
+	uint32_t bytestart = charToByte(pos1);
+	uint32_t byteend = charToByte(pos1+n1);
 	return replace_bytes(bytestart, byteend-bytestart, o);
 }
 
@@ -448,8 +576,8 @@ tiny_string tiny_string::substr(uint32_t start, uint32_t len) const
 		len = numChars()-start;
 	if (isASCII)
 		return substr_bytes(start, len);
-	uint32_t bytestart = g_utf8_offset_to_pointer(buf,start) - buf;
-	uint32_t byteend = g_utf8_offset_to_pointer(buf,start+len) - buf;
+	uint32_t bytestart = charToByte(start);
+	uint32_t byteend = charToByte(start+len);
 	return substr_bytes(bytestart, byteend-bytestart);
 }
 
@@ -458,7 +586,7 @@ tiny_string tiny_string::substr(uint32_t start, const CharIterator& end) const
 	if (isASCII)
 		return substr_bytes(start, (end.buf_ptr - buf)-start);
 	assert_and_throw(start < numChars());
-	uint32_t bytestart = g_utf8_offset_to_pointer(buf,start) - buf;
+	uint32_t bytestart = charToByte(start);
 	uint32_t byteend = end.buf_ptr - buf;
 	return substr_bytes(bytestart, byteend-bytestart);
 }
@@ -1134,7 +1262,7 @@ uint32_t tiny_string::bytePosToIndex(uint32_t bytepos) const
 	if (isASCII)
 		return bytepos;
 
-	return g_utf8_pointer_to_offset(raw_buf(), raw_buf() + bytepos);
+	return byteToChar(bytepos);
 }
 
 CharIterator tiny_string::begin()
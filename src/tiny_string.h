@@ -24,6 +24,7 @@
 #include <cstdint>
 #include <ostream>
 #include <list>
+#include <atomic>
 /* for utf8 handling */
 #include <glib.h>
 #include "compat.h"
@@ -83,6 +84,16 @@ public:
  * String class.
  * The string can contain '\0's, so don't use raw_buf().
  * Use len() to determine actual size.
+ *
+ * DYNAMIC buffers are shared by the copies of a string and never change
+ * while they are shared. A string that is the only user of its buffer
+ * appends in place, the capacity grows geometrically so building a
+ * string by repeated concatenation is linear.
+ *
+ * Long non ASCII strings in DYNAMIC buffers get an index of the byte
+ * offset of every UTF8_INDEX_STRIDE-th character the first time a
+ * character index is converted, so random access doesn't scan from the
+ * start of the string.
  */
 class DLL_PUBLIC tiny_string
 {
@@ -91,6 +102,34 @@ private:
 	enum TYPE { READONLY=0, STATIC, DYNAMIC };
 	/*must be at least 6 bytes for tiny_string(uint32_t c) constructor */
 	#define STATIC_SIZE 64
+	#define UTF8_INDEX_STRIDE 64
+	//Shorter strings are scanned from the start
+	#define UTF8_INDEX_MIN_CHARS 256
+	/*
+	   Offsets of the characters of a DYNAMIC buffer, shared like the bytes.
+	   Strings sharing the buffer may extend it concurrently, they store
+	   the same values since the bytes of a shared buffer never change.
+	   Appending in place keeps the offsets, the characters before the
+	   old end don't move.
+	*/
+	struct char_index
+	{
+		//offsets[i] is the byte offset of character i*UTF8_INDEX_STRIDE
+		std::atomic<uint32_t>* offsets;
+		//Number of valid offsets, they don't change anymore
+		std::atomic<uint32_t> entries;
+		uint32_t size;
+		char_index(uint32_t s):offsets(new std::atomic<uint32_t>[s]),entries(0),size(s) {}
+		~char_index() { delete[] offsets; }
+	};
+	//Header of DYNAMIC buffers, placed right before the bytes
+	struct dynamic_buffer
+	{
+		ATOMIC_INT32(refs);
+		uint32_t capacity;
+		//Created on demand by getCharIndex
+		std::atomic<char_index*> index;
+	};
 	char _buf_static[STATIC_SIZE];
 	char* buf;
 	/*
@@ -98,6 +137,10 @@ private:
 	*/
 	uint32_t stringSize;
 	uint32_t numchars;
+	/*
+	   Cached result of hash(), 0 if not computed yet
+	*/
+	mutable uint32_t hashValue;
 	TYPE type;
 #ifdef MEMORY_USAGE_PROFILING
 	//Implemented in memory_support.cpp
@@ -108,16 +151,29 @@ private:
 #endif
 	//TODO: use static buffer again if reassigning to short string
 	void makePrivateCopy(const char* s);
+	dynamic_buffer* getBuffer() const
+	{
+		return reinterpret_cast<dynamic_buffer*>(buf-sizeof(dynamic_buffer));
+	}
+	//Returns the bytes of a new DYNAMIC buffer of capacity bytes
+	char* allocateBuffer(uint32_t capacity) const;
+	void releaseBuffer(char* bytes) const;
 	void createBuffer(uint32_t s);
-	void resizeBuffer(uint32_t s);
+	void appendBytes(const char* s, uint32_t len);
+	//Returns the index covering this string, NULL if it is not worth one
+	char_index* getCharIndex() const;
+	//Byte offset of the character idx, idx may be numChars()
+	uint32_t charToByte(uint32_t idx) const;
+	uint32_t byteToChar(uint32_t bytepos) const;
 	void resetToStatic();
 	void init();
+	void computeHash() const;
 	bool isASCII:1;
 	bool hasNull:1;
 public:
 	static const uint32_t npos = (uint32_t)(-1);
 
-	tiny_string():_buf_static(),buf(_buf_static),stringSize(1),numchars(0),type(STATIC),isASCII(true),hasNull(false){buf[0]=0;}
+	tiny_string():_buf_static(),buf(_buf_static),stringSize(1),numchars(0),hashValue(0),type(STATIC),isASCII(true),hasNull(false){buf[0]=0;}
 	/* construct from utf character */
 	static tiny_string fromChar(uint32_t c);
 	tiny_string(const char* s,bool copy=false);
@@ -148,6 +204,11 @@ public:
 	{
 		return buf;
 	}
+	//True if no other string shares the buffer, appending to it is then done in place
+	inline bool isUniqueBuffer() const
+	{
+		return type==DYNAMIC && getBuffer()->refs==1;
+	}
 	inline bool empty() const
 	{
 		return stringSize == 1;
@@ -174,6 +235,18 @@ public:
 	{
 		return isASCII;
 	}
+	/*
+	 * Moves the string to an exactly sized buffer, dropping the room
+	 * left for appends in place (see StringPool).
+	 */
+	void compact();
+	/* returns a hash of the string contents, it is computed only once */
+	inline uint32_t hash() const
+	{
+		if(hashValue==0)
+			computeHash();
+		return hashValue;
+	}
 	
 	/* start and len are indices of utf8-characters */
 	tiny_string substr(uint32_t start, uint32_t len) const;
@@ -192,7 +265,7 @@ public:
 	{
 		if (isASCII)
 			return buf[idx];
-		return g_utf8_get_char(g_utf8_offset_to_pointer(buf,idx));
+		return g_utf8_get_char(buf+charToByte(idx));
 	}
 	/* start is an index of characters.
 	 * returns index of character */
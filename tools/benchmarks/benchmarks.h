@@ -0,0 +1,41 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef TOOLS_BENCHMARKS_BENCHMARKS_H
+#define TOOLS_BENCHMARKS_BENCHMARKS_H 1
+
+#include <cstdint>
+#include <functional>
+
+//Each benchmark runs for at least this many seconds
+#define BENCHMARK_MIN_TIME 0.5
+
+/*
+ * Calls f repeatedly and prints the average time of a call.
+ * ops is the number of operations done by one call, they are
+ * reported per second in millions of unit.
+ */
+void runBenchmark(const char* name, uint64_t ops, const char* unit, const std::function<void()>& f);
+
+//Suites of benchmarks, see main.cpp
+void benchmarkFilters();
+void benchmarkProperties();
+void benchmarkTimers();
+
+#endif /* TOOLS_BENCHMARKS_BENCHMARKS_H */
@@ -0,0 +1,113 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "benchmarks.h"
+#include "backends/bitmapfilters.h"
+#include <vector>
+
+using namespace std;
+using namespace lightspark;
+
+//Side of the filtered bitmaps
+#define FILTER_BENCHMARK_SIZE 1024
+
+/*
+ * Premultiplied ARGB picture like a sprite: colored gradients with an
+ * alpha that fades out towards the border
+ */
+static void fillPicture(vector<uint32_t>& pixels)
+{
+	const int32_t size=FILTER_BENCHMARK_SIZE;
+	pixels.resize(size*size);
+	for(int32_t y=0;y<size;y++)
+	{
+		for(int32_t x=0;x<size;x++)
+		{
+			const int32_t border=min(min(x,size-1-x),min(y,size-1-y));
+			const uint32_t a=min(border*4,255);
+			const uint32_t r=(x*255/size)*a/255;
+			const uint32_t g=(y*255/size)*a/255;
+			const uint32_t b=((x^y)&0xff)*a/255;
+			pixels[y*size+x]=(a<<24)|(r<<16)|(g<<8)|b;
+		}
+	}
+}
+
+/*
+ * The filters run on the calling thread only (there is no SystemState,
+ * so no thread pool), this measures the kernels themselves
+ */
+void benchmarkFilters()
+{
+	vector<uint32_t> pixels;
+	fillPicture(pixels);
+	uint32_t* p=pixels.data();
+	const int32_t size=FILTER_BENCHMARK_SIZE;
+	const uint64_t ops=uint64_t(size)*size;
+
+	runBenchmark("blur 4x4, 1 pass",ops,"pixel",[p]()
+	{
+		boxBlurFilter(nullptr,p,size,size,4,4,1);
+	});
+	runBenchmark("blur 8x8, 2 passes",ops,"pixel",[p]()
+	{
+		boxBlurFilter(nullptr,p,size,size,8,8,2);
+	});
+	runBenchmark("blur 16x16, 3 passes",ops,"pixel",[p]()
+	{
+		boxBlurFilter(nullptr,p,size,size,16,16,3);
+	});
+	runBenchmark("glow 6x6, 1 pass",ops,"pixel",[p]()
+	{
+		dropShadowFilter(nullptr,p,size,size,0xff0000,1,6,6,2,1,0,0,false,false,false);
+	});
+	runBenchmark("drop shadow 4x4, 1 pass",ops,"pixel",[p]()
+	{
+		dropShadowFilter(nullptr,p,size,size,0x000000,0.8,4,4,1,1,3,3,false,false,false);
+	});
+	runBenchmark("inner glow 6x6, 1 pass",ops,"pixel",[p]()
+	{
+		dropShadowFilter(nullptr,p,size,size,0x00ff00,1,6,6,2,1,0,0,true,false,false);
+	});
+	//Grayscale
+	const float grayscale[20]={
+		0.3f,0.59f,0.11f,0,0,
+		0.3f,0.59f,0.11f,0,0,
+		0.3f,0.59f,0.11f,0,0,
+		0,0,0,1,0 };
+	runBenchmark("color matrix",ops,"pixel",[p,&grayscale]()
+	{
+		colorMatrixFilter(nullptr,p,size,size,grayscale);
+	});
+	const float sharpen[9]={
+		0,-1,0,
+		-1,5,-1,
+		0,-1,0 };
+	runBenchmark("convolution 3x3",ops,"pixel",[p,&sharpen]()
+	{
+		convolutionFilter(nullptr,p,size,size,sharpen,3,3,1,0,false,true,0);
+	});
+	float box5[25];
+	for(int i=0;i<25;i++)
+		box5[i]=1;
+	runBenchmark("convolution 5x5",ops,"pixel",[p,&box5]()
+	{
+		convolutionFilter(nullptr,p,size,size,box5,5,5,25,0,true,false,0);
+	});
+}
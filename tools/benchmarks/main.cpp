@@ -0,0 +1,89 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "benchmarks.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+using namespace std;
+
+/*
+ * Microbenchmarks of the hot paths of liblightspark. They are built when
+ * COMPILE_BENCHMARKS is enabled and are not installed. Usage:
+ *   lightspark-benchmarks [suite...]
+ * All the suites are run if none is given.
+ */
+static const struct
+{
+	const char* name;
+	void (*run)();
+} suites[] = {
+	{ "filters", benchmarkFilters },
+	{ "properties", benchmarkProperties },
+	{ "timers", benchmarkTimers },
+};
+
+void runBenchmark(const char* name, uint64_t ops, const char* unit, const function<void()>& f)
+{
+	//The first call warms up the caches and the allocators
+	f();
+	uint32_t calls=0;
+	chrono::steady_clock::time_point start=chrono::steady_clock::now();
+	double elapsed=0;
+	do
+	{
+		f();
+		calls++;
+		elapsed=chrono::duration<double>(chrono::steady_clock::now()-start).count();
+	}
+	while(elapsed<BENCHMARK_MIN_TIME || calls<3);
+	const double perCall=elapsed/calls;
+	printf("  %-36s %12.3f ms %12.2f M%s/s\n",name,perCall*1000,ops/perCall/1000000,unit);
+}
+
+int main(int argc, char* argv[])
+{
+	const size_t numSuites=sizeof(suites)/sizeof(suites[0]);
+	for(int i=1;i<argc;i++)
+	{
+		size_t j=0;
+		while(j<numSuites && strcmp(argv[i],suites[j].name)!=0)
+			j++;
+		if(j==numSuites)
+		{
+			fprintf(stderr,"Usage: %s [suite...]\nSuites:",argv[0]);
+			for(j=0;j<numSuites;j++)
+				fprintf(stderr," %s",suites[j].name);
+			fprintf(stderr,"\n");
+			return 1;
+		}
+	}
+	for(size_t j=0;j<numSuites;j++)
+	{
+		bool selected=(argc==1);
+		for(int i=1;i<argc && !selected;i++)
+			selected=(strcmp(argv[i],suites[j].name)==0);
+		if(!selected)
+			continue;
+		printf("%s\n",suites[j].name);
+		suites[j].run();
+	}
+	return 0;
+}
@@ -0,0 +1,117 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "benchmarks.h"
+#include "asobject.h"
+#include <cstdio>
+#include <random>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+using namespace lightspark;
+
+//Number of property accesses of the getprop and setprop benchmarks
+#define PROPERTY_BENCHMARK_ACCESSES 65536
+//Number of instances of the benchmarked class
+#define PROPERTY_BENCHMARK_INSTANCES 1000
+
+namespace
+{
+
+//The layout variables_map used before property_map
+typedef unordered_multimap<uint32_t,variable> hashLayout;
+
+volatile uint64_t sink;
+
+//Not inlined, like variables_map::findObjVar, so that both layouts are looked up through a call
+template<class M>
+__attribute__((noinline)) variable* findVariable(M& map, uint32_t name, const nsNameAndKind& ns)
+{
+	for(auto it=map.find(name);it!=map.end() && it->first==name;++it)
+	{
+		if(it->second.ns==ns)
+			return &it->second;
+	}
+	return nullptr;
+}
+
+template<class M>
+void benchmarkLayout(const char* layout, uint32_t traits)
+{
+	//Name ids are spread over the string pool of a typical movie
+	mt19937 random(traits);
+	set<uint32_t> nameSet;
+	while(nameSet.size()<traits)
+		nameSet.insert(1000+random()%100000);
+	vector<uint32_t> names(nameSet.begin(),nameSet.end());
+	M shape;
+	for(uint32_t i=0;i<names.size();i++)
+		shape.insert(make_pair(names[i],variable(DECLARED_TRAIT,nsNameAndKind())));
+	vector<M> instances;
+	instances.reserve(PROPERTY_BENCHMARK_INSTANCES);
+	for(uint32_t i=0;i<PROPERTY_BENCHMARK_INSTANCES;i++)
+		instances.push_back(shape);
+	//Random variables of random instances, like the accesses of a movie to its objects
+	vector<pair<M*,uint32_t>> accesses(PROPERTY_BENCHMARK_ACCESSES);
+	for(uint32_t i=0;i<accesses.size();i++)
+		accesses[i]=make_pair(&instances[random()%instances.size()],names[random()%names.size()]);
+	nsNameAndKind ns;
+	char name[64];
+
+	snprintf(name,sizeof(name),"getprop %u traits, %s",traits,layout);
+	runBenchmark(name,PROPERTY_BENCHMARK_ACCESSES,"op",[&]()
+	{
+		uint64_t sum=0;
+		for(uint32_t i=0;i<accesses.size();i++)
+			sum+=findVariable(*accesses[i].first,accesses[i].second,ns)->var.uintval;
+		sink=sum;
+	});
+	snprintf(name,sizeof(name),"setprop %u traits, %s",traits,layout);
+	runBenchmark(name,PROPERTY_BENCHMARK_ACCESSES,"op",[&]()
+	{
+		for(uint32_t i=0;i<accesses.size();i++)
+			findVariable(*accesses[i].first,accesses[i].second,ns)->var=asAtomHandler::fromInt(i);
+	});
+	//New instances copy the variables of the instance factory of their class
+	snprintf(name,sizeof(name),"instantiate %u traits, %s",traits,layout);
+	runBenchmark(name,PROPERTY_BENCHMARK_INSTANCES,"instance",[&]()
+	{
+		uint64_t sum=0;
+		for(uint32_t i=0;i<PROPERTY_BENCHMARK_INSTANCES;i++)
+		{
+			M instance(shape);
+			sum+=instance.size();
+		}
+		sink=sum;
+	});
+}
+
+};
+
+void benchmarkProperties()
+{
+	const uint32_t traits[] = { 4, 16, 64 };
+	for(uint32_t t: traits)
+	{
+		benchmarkLayout<property_map>("property_map",t);
+		benchmarkLayout<hashLayout>("multimap",t);
+	}
+}
@@ -0,0 +1,97 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "benchmarks.h"
+#include "timer.h"
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace lightspark;
+
+//Number of timers of every benchmark
+#define TIMER_BENCHMARK_COUNT 10000
+
+namespace
+{
+
+class CountingJob: public ITickJob
+{
+public:
+	atomic<uint32_t>* counter;
+	Semaphore* done;
+	CountingJob():counter(nullptr),done(nullptr) {}
+	void tick()
+	{
+		if(counter->fetch_add(1)+1==TIMER_BENCHMARK_COUNT)
+			done->signal();
+	}
+	void tickFence() {}
+};
+
+};
+
+void benchmarkTimers()
+{
+	TimerThread timer(nullptr);
+	vector<CountingJob> jobs(TIMER_BENCHMARK_COUNT);
+	atomic<uint32_t> counter(0);
+	Semaphore done(0);
+	for(uint32_t i=0;i<jobs.size();i++)
+	{
+		jobs[i].counter=&counter;
+		jobs[i].done=&done;
+	}
+	//Jobs are cancelled in a different order than they were added
+	vector<CountingJob*> cancelOrder(jobs.size());
+	for(uint32_t i=0;i<jobs.size();i++)
+		cancelOrder[i]=&jobs[i];
+	shuffle(cancelOrder.begin(),cancelOrder.end(),mt19937(42));
+	//Timeouts like the ones of Timers and setTimeout, far enough to never expire
+	vector<uint32_t> delays(jobs.size());
+	mt19937 random(7);
+	for(uint32_t i=0;i<delays.size();i++)
+		delays[i]=3600000+random()%60000;
+
+	runBenchmark("add and cancel 10k waits",2*TIMER_BENCHMARK_COUNT,"op",[&]()
+	{
+		for(uint32_t i=0;i<jobs.size();i++)
+			timer.addWait(delays[i],&jobs[i]);
+		for(uint32_t i=0;i<cancelOrder.size();i++)
+			timer.removeJob(cancelOrder[i]);
+	});
+	runBenchmark("add and cancel 10k ticks",2*TIMER_BENCHMARK_COUNT,"op",[&]()
+	{
+		for(uint32_t i=0;i<jobs.size();i++)
+			timer.addTick(delays[i],&jobs[i]);
+		for(uint32_t i=0;i<cancelOrder.size();i++)
+			timer.removeJob(cancelOrder[i]);
+	});
+	//All the timers are due at once, the worker runs them in a single batch
+	runBenchmark("run 10k due waits",TIMER_BENCHMARK_COUNT,"timer",[&]()
+	{
+		counter=0;
+		for(uint32_t i=0;i<jobs.size();i++)
+			timer.addWait(0,&jobs[i]);
+		done.wait();
+	});
+	timer.wait();
+}